@@ -33,5 +33,8 @@ make_importer(rveskc)
 target_link_libraries(rveskc PRIVATE assimp cxxopts simdjson fmt glm rve_importlib)
 
 make_importer(rveac)
-target_link_libraries(rveac PRIVATE assimp cxxopts simdjson fmt glm rve_importlib)
+target_link_libraries(rveac PRIVATE assimp cxxopts simdjson fmt glm rve_importlib ozz_animation_offline ozz_animation ozz_base)
+
+make_importer(rvepack)
+target_link_libraries(rvepack PRIVATE cxxopts)
 
@@ -1,6 +1,6 @@
 # pack resources
 function(pack_resources)
-	set(optional )
+	set(optional MAPPED_PACK)	# MAPPED_PACK: write an uncompressed .rvepack that is memory-mapped at runtime, instead of a .rvedata archive
 	set(args TARGET OUTPUT_FILE STREAMING_INPUT_ROOT)
 	set(list_args SHADERS MESHES OBJECTS SKELETONS ANIMATIONS TEXTURES UIS FONTS SOUNDS STREAMING_ASSETS)
 	cmake_parse_arguments(
@@ -123,13 +123,20 @@ function(pack_resources)
 		get_filename_component(outname "${MESHCONF}" NAME_WE)
 		get_filename_component(indir "${MESHCONF}" DIRECTORY)
 		set(outfilename "${outdir}/${outname}.rvem")
+		# rvemc also writes a LOD chain if the description asks for one
+		string(JSON lods_type ERROR_VARIABLE lods_err TYPE "${desc_STR}" lods)
+		if (lods_type STREQUAL "ARRAY")
+			set(lodfilename "${outdir}/${outname}.rvelod")
+		else()
+			set(lodfilename "")
+		endif()
 		add_custom_command(PRE_BUILD 
-			OUTPUT "${outfilename}"
+			OUTPUT "${outfilename}" ${lodfilename}
 			COMMAND ${RVEMC_PATH} -f "${MESHCONF}" -o "${outdir}"
 			DEPENDS "${MESHCONF}" "${indir}/${inmeshfile}" "${RVEMC_PATH}"
 			COMMENT "Importing Mesh ${MESHCONF}"
 		)
-		set_property(GLOBAL APPEND PROPERTY COPY_DEPENDS "${outfilename}")
+		set_property(GLOBAL APPEND PROPERTY COPY_DEPENDS "${outfilename}" ${lodfilename})
 		target_sources(${ARGS_TARGET} PUBLIC "${indir}/${inmeshfile}")
 		source_group("Meshes" FILES  "${indir}/${inmeshfile}")
 		set_source_files_properties("${indir}/${inmeshfile}" PROPERTIES 
@@ -261,7 +268,11 @@ function(pack_resources)
 	set_source_files_properties(${ARGS_SOUNDS} PROPERTIES XCODE_EXPLICIT_FILE_TYPE "audio.wav")
 	source_group("Shaders" FILES ${all_shader_sources})
 
-	set(outpack "${CMAKE_BINARY_DIR}/${ARGS_TARGET}.rvedata")
+	if (ARGS_MAPPED_PACK)
+		set(outpack "${CMAKE_BINARY_DIR}/${ARGS_TARGET}.rvepack")
+	else()
+		set(outpack "${CMAKE_BINARY_DIR}/${ARGS_TARGET}.rvedata")
+	endif()
 
 	# allow inserting into the mac / ios resource bundle
 	set_target_properties(${ARGS_TARGET} PROPERTIES 
@@ -277,15 +288,26 @@ function(pack_resources)
 
 	set(assets ${ARGS_OBJECTS} ${ARGS_TEXTURES} ${copy_depends})
 
-	# the command to pack into a zip
-	add_custom_command(
-		POST_BUILD 
-		OUTPUT "${outpack}"
-		DEPENDS ${assets}
-		COMMENT "Packing resources for ${ARGS_TARGET}"
-		COMMAND ${CMAKE_COMMAND} -E tar "cfv" "${outpack}" --format=zip "${CMAKE_CURRENT_BINARY_DIR}/${ARGS_TARGET}"
-		VERBATIM
-	)
+	if (ARGS_MAPPED_PACK)
+		add_custom_command(
+			POST_BUILD 
+			OUTPUT "${outpack}"
+			DEPENDS ${assets} "${RVEPACK_PATH}"
+			COMMENT "Packing resources for ${ARGS_TARGET}"
+			COMMAND ${RVEPACK_PATH} -f "${CMAKE_CURRENT_BINARY_DIR}/${ARGS_TARGET}" -o "${outpack}"
+			VERBATIM
+		)
+	else()
+		# the command to pack into a zip
+		add_custom_command(
+			POST_BUILD 
+			OUTPUT "${outpack}"
+			DEPENDS ${assets}
+			COMMENT "Packing resources for ${ARGS_TARGET}"
+			COMMAND ${CMAKE_COMMAND} -E tar "cfv" "${outpack}" --format=zip "${CMAKE_CURRENT_BINARY_DIR}/${ARGS_TARGET}"
+			VERBATIM
+		)
+	endif()
 
 	# make part of the target, and add to the resources folder if applicable
 	target_sources("${ARGS_TARGET}" PRIVATE "${outpack}")
@@ -28,7 +28,9 @@ namespace RGL {
 #if RGL_WEBGPU_AVAILABLE
 		API::WebGPU,
 #endif
+#if RGL_NOOP_AVAILABLE
 		API::Noop,
+#endif
 	};
 
 	bool CanInitAPI(API api);
@@ -1,8 +1,8 @@
 #pragma once
 #include <memory>
 
-#define RGL_NBACKENDS (RGL_MTL_AVAILABLE + RGL_VK_AVAILABLE + RGL_DX12_AVAILABLE)
-#define RGL_SINGLE_BACKEND RGL_NBACKENDS == 1
+#define RGL_NBACKENDS (RGL_MTL_AVAILABLE + RGL_VK_AVAILABLE + RGL_DX12_AVAILABLE + RGL_NOOP_AVAILABLE)
+#define RGL_SINGLE_BACKEND (RGL_NBACKENDS == 1 && !RGL_NOOP_AVAILABLE)	// the Noop backend always goes through the interfaces
 
 namespace RGL {
 	struct ISwapchain;
@@ -0,0 +1,33 @@
+#if RGL_NOOP_AVAILABLE
+#include "NoopBuffer.hpp"
+#include "RGLCommon.hpp"
+#include <cstring>
+
+namespace RGL {
+	BufferNoop::BufferNoop(const BufferConfig& config) : size(config.nElements * config.stride) {
+		if (config.access == BufferAccess::Shared) {
+			memory.resize(size);
+		}
+	}
+
+	void BufferNoop::UpdateBufferData(untyped_span data, decltype(BufferConfig::nElements) offset) {
+		Assert(data.size() + offset <= size, "Attempting to write more data than the buffer can hold");
+		if (!memory.empty()) {
+			std::memcpy(memory.data() + offset, data.data(), data.size());
+		}
+	}
+
+	void BufferNoop::SetBufferData(untyped_span data, decltype(BufferConfig::nElements) offset) {
+		UpdateBufferData(data, offset);
+	}
+
+	decltype(BufferConfig::nElements) BufferNoop::getBufferSize() const {
+		return size;
+	}
+
+	void* BufferNoop::GetMappedDataPtr() {
+		return memory.empty() ? nullptr : memory.data();
+	}
+}
+
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+#include <RGL/Types.hpp>
+#include <RGL/Buffer.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace RGL {
+	struct BufferNoop : public IBuffer {
+		std::vector<std::byte> memory;	// only shared buffers are backed, so that the CPU can write to them
+		decltype(BufferConfig::nElements) size = 0;
+		BufferNoop(const BufferConfig&);
+
+		//IBuffer
+		void MapMemory() final {}
+		void UnmapMemory() final {}
+		void UpdateBufferData(untyped_span newData, decltype(BufferConfig::nElements) offset = 0) final;
+		void SetBufferData(untyped_span data, decltype(BufferConfig::nElements) offset = 0) final;
+		decltype(BufferConfig::nElements) getBufferSize() const final;
+		void* GetMappedDataPtr() final;
+
+		void SignalRangeChanged(const Range&) final {}
+		virtual ~BufferNoop() {}
+	};
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <RGL/CommandQueue.hpp>
+#include "NoopCommandBuffer.hpp"
+#include <memory>
+
+namespace RGL {
+	struct CommandQueueNoop : public ICommandQueue {
+		RGLCommandBufferPtr CreateCommandBuffer() final {
+			return std::make_shared<CommandBufferNoop>();
+		}
+		void WaitUntilCompleted() final {}
+		QueueData GetQueueData() final {
+			return {};
+		}
+		virtual ~CommandQueueNoop() {}
+	};
+}
@@ -0,0 +1,103 @@
+#if RGL_NOOP_AVAILABLE
+#include "NoopDevice.hpp"
+#include "NoopBuffer.hpp"
+#include "NoopTexture.hpp"
+#include "NoopSwapchain.hpp"
+#include "NoopCommandQueue.hpp"
+#include "NoopPipeline.hpp"
+#include "NoopShaderLibrary.hpp"
+#include "NoopSampler.hpp"
+#include "NoopSynchronization.hpp"
+
+namespace RGL {
+	RGLDevicePtr CreateDefaultDeviceNoop() {
+		return std::make_shared<DeviceNoop>();
+	}
+
+	std::string DeviceNoop::GetBrandString() {
+		return "Noop device";
+	}
+
+	RGLSwapchainPtr DeviceNoop::CreateSwapchain(RGLSurfacePtr surface, RGLCommandQueuePtr presentQueue, int width, int height) {
+		return std::make_shared<SwapchainNoop>(width, height);
+	}
+
+	RGLPipelineLayoutPtr DeviceNoop::CreatePipelineLayout(const PipelineLayoutDescriptor&) {
+		return std::make_shared<PipelineLayoutNoop>();
+	}
+
+	RGLRenderPipelinePtr DeviceNoop::CreateRenderPipeline(const RenderPipelineDescriptor&) {
+		return std::make_shared<RenderPipelineNoop>();
+	}
+
+	RGLComputePipelinePtr DeviceNoop::CreateComputePipeline(const ComputePipelineDescriptor&) {
+		return std::make_shared<ComputePipelineNoop>();
+	}
+
+	// shaders are never run, so their code is not needed
+	RGLShaderLibraryPtr DeviceNoop::CreateShaderLibraryFromName(const std::string_view& name) {
+		return std::make_shared<ShaderLibraryNoop>();
+	}
+
+	RGLShaderLibraryPtr DeviceNoop::CreateDefaultShaderLibrary() {
+		return std::make_shared<ShaderLibraryNoop>();
+	}
+
+	RGLShaderLibraryPtr DeviceNoop::CreateShaderLibraryFromBytes(const std::span<const uint8_t>) {
+		return std::make_shared<ShaderLibraryNoop>();
+	}
+
+	RGLShaderLibraryPtr DeviceNoop::CreateShaderLibrarySourceCode(const std::string_view, const FromSourceConfig& config) {
+		return std::make_shared<ShaderLibraryNoop>();
+	}
+
+	RGLShaderLibraryPtr DeviceNoop::CreateShaderLibraryFromPath(const std::filesystem::path&) {
+		return std::make_shared<ShaderLibraryNoop>();
+	}
+
+	RGLBufferPtr DeviceNoop::CreateBuffer(const BufferConfig& config) {
+		return std::make_shared<BufferNoop>(config);
+	}
+
+	RGLTexturePtr DeviceNoop::CreateTextureWithData(const TextureConfig& config, untyped_span) {
+		return std::make_shared<TextureNoop>(config);
+	}
+
+	RGLTexturePtr DeviceNoop::CreateTexture(const TextureConfig& config) {
+		return std::make_shared<TextureNoop>(config);
+	}
+
+	RGLSamplerPtr DeviceNoop::CreateSampler(const SamplerConfig&) {
+		return std::make_shared<SamplerNoop>();
+	}
+
+	RGLCommandQueuePtr DeviceNoop::CreateCommandQueue(QueueType type) {
+		return std::make_shared<CommandQueueNoop>();
+	}
+
+	TextureView DeviceNoop::GetGlobalBindlessTextureHeap() const {
+		return {};
+	}
+
+	size_t DeviceNoop::GetTotalVRAM() const {
+		return 0;
+	}
+
+	size_t DeviceNoop::GetCurrentVRAMInUse() const {
+		return 0;
+	}
+
+	DeviceData DeviceNoop::GetDeviceData() {
+		return {};
+	}
+
+	RGLFencePtr DeviceNoop::CreateFence(bool preSignaled) {
+		return std::make_shared<FenceNoop>();
+	}
+
+	void DeviceNoop::BlockUntilIdle() {
+
+	}
+}
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+#include <RGL/Types.hpp>
+#include <RGL/Device.hpp>
+#include <span>
+
+namespace RGL {
+	/**
+	A device that accepts every call and does no GPU work, for running the CPU side of a renderer headlessly
+	*/
+	struct DeviceNoop : public IDevice, public std::enable_shared_from_this<DeviceNoop> {
+		std::string GetBrandString() final;
+
+		RGLSwapchainPtr CreateSwapchain(RGLSurfacePtr, RGLCommandQueuePtr presentQueue, int width, int height) final;
+
+		RGLPipelineLayoutPtr CreatePipelineLayout(const PipelineLayoutDescriptor&) final;
+		RGLRenderPipelinePtr CreateRenderPipeline(const RenderPipelineDescriptor&) final;
+		RGLComputePipelinePtr CreateComputePipeline(const struct ComputePipelineDescriptor&) final;
+
+		RGLShaderLibraryPtr CreateShaderLibraryFromName(const std::string_view& name) final;
+		RGLShaderLibraryPtr CreateDefaultShaderLibrary() final;
+		RGLShaderLibraryPtr CreateShaderLibraryFromBytes(const std::span<const uint8_t>) final;
+		RGLShaderLibraryPtr CreateShaderLibrarySourceCode(const std::string_view, const FromSourceConfig& config) final;
+		RGLShaderLibraryPtr CreateShaderLibraryFromPath(const std::filesystem::path&) final;
+
+		RGLBufferPtr CreateBuffer(const BufferConfig&) final;
+		RGLTexturePtr CreateTextureWithData(const TextureConfig&, untyped_span) final;
+		RGLTexturePtr CreateTexture(const TextureConfig&) final;
+		RGLSamplerPtr CreateSampler(const SamplerConfig&) final;
+
+		RGLCommandQueuePtr CreateCommandQueue(QueueType type) final;
+
+		TextureView GetGlobalBindlessTextureHeap() const final;
+
+		size_t GetTotalVRAM() const final;
+		size_t GetCurrentVRAMInUse() const final;
+		DeviceData GetDeviceData() final;
+
+		RGLFencePtr CreateFence(bool preSignaled) final;
+		void BlockUntilIdle() final;
+
+		virtual ~DeviceNoop() {}
+	};
+
+	RGLDevicePtr CreateDefaultDeviceNoop();
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <RGL/Types.hpp>
+#include <RGL/Pipeline.hpp>
+
+namespace RGL {
+	struct PipelineLayoutNoop : public IPipelineLayout {
+
+	};
+
+	struct RenderPipelineNoop : public IRenderPipeline {
+
+	};
+
+	struct ComputePipelineNoop : public IComputePipeline {
+
+	};
+}
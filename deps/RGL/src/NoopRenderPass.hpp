@@ -0,0 +1,11 @@
+#pragma once
+#include <RGL/RenderPass.hpp>
+
+namespace RGL {
+	struct RenderPassNoop : public IRenderPass {
+		void SetAttachmentTexture(uint32_t index, const TextureView& texture) final {}
+		void SetDepthAttachmentTexture(const TextureView& texture) final {}
+		void SetStencilAttachmentTexture(const TextureView& texture) final {}
+		virtual ~RenderPassNoop() {}
+	};
+}
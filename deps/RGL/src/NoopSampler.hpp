@@ -0,0 +1,9 @@
+#pragma once
+#include <RGL/Types.hpp>
+#include <RGL/Sampler.hpp>
+
+namespace RGL {
+	struct SamplerNoop : public ISampler {
+
+	};
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <RGL/Types.hpp>
+#include <RGL/ShaderLibrary.hpp>
+
+namespace RGL {
+	struct ShaderLibraryNoop : public IShaderLibrary {
+
+	};
+}
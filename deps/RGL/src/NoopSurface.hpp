@@ -0,0 +1,11 @@
+#pragma once
+#include <RGL/Types.hpp>
+#include <RGL/Surface.hpp>
+
+namespace RGL {
+	struct SurfaceNoop : public ISurface {
+
+	};
+
+	RGLSurfacePtr CreateNoopSurfaceFromPlatformHandle(const CreateSurfaceConfig&);
+}
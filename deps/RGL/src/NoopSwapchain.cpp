@@ -0,0 +1,29 @@
+#if RGL_NOOP_AVAILABLE
+#include "NoopSwapchain.hpp"
+
+namespace RGL {
+	SwapchainNoop::SwapchainNoop(uint32_t width, uint32_t height) {
+		Resize(width, height);
+	}
+
+	void SwapchainNoop::Resize(uint32_t width, uint32_t height) {
+		constexpr uint32_t numImages = 3;
+		images.clear();
+		images.reserve(numImages);
+		for (uint32_t i = 0; i < numImages; i++) {
+			images.emplace_back(Dimension{ width, height });
+		}
+		idx = 0;
+	}
+
+	void SwapchainNoop::GetNextImage(uint32_t* index) {
+		*index = idx;
+		idx = (idx + 1) % images.size();
+	}
+
+	ITexture* SwapchainNoop::ImageAtIndex(uint32_t index) {
+		return &images[index];
+	}
+}
+
+#endif
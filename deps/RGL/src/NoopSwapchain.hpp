@@ -0,0 +1,20 @@
+#pragma once
+#include <RGL/Types.hpp>
+#include <RGL/Swapchain.hpp>
+#include "NoopTexture.hpp"
+#include <vector>
+
+namespace RGL {
+	struct SwapchainNoop : public ISwapchain {
+		std::vector<TextureNoop> images;
+		uint32_t idx = 0;
+
+		SwapchainNoop(uint32_t width, uint32_t height);
+		void Resize(uint32_t width, uint32_t height) final;
+		void GetNextImage(uint32_t* index) final;
+		ITexture* ImageAtIndex(uint32_t index) final;
+		void Present(const SwapchainPresentConfig&) final {}
+		void SetVsyncMode(bool mode) final {}
+		virtual ~SwapchainNoop() {}
+	};
+}
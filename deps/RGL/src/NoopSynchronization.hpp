@@ -0,0 +1,12 @@
+#pragma once
+#include <RGL/Types.hpp>
+#include <RGL/Synchronization.hpp>
+
+namespace RGL {
+	struct FenceNoop : public IFence {
+		void Wait() final {}
+		void Reset() final {}
+		void Signal() final {}
+		virtual ~FenceNoop() {}
+	};
+}
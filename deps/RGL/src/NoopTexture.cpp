@@ -0,0 +1,28 @@
+#if RGL_NOOP_AVAILABLE
+#include "NoopTexture.hpp"
+#include "RGLCommon.hpp"
+
+namespace RGL {
+	TextureNoop::TextureNoop(const TextureConfig& config) : ITexture({ config.width, config.height }), mipLevels(config.mipLevels) {}
+
+	TextureNoop::TextureNoop(const Dimension& size) : ITexture(size) {}
+
+	Dimension TextureNoop::GetSize() const {
+		return size;
+	}
+
+	TextureView TextureNoop::GetDefaultView() const {
+		return {};
+	}
+
+	TextureView TextureNoop::GetViewForMip(uint32_t mip) const {
+		Assert(mip < mipLevels, "Texture does not have that many mips");
+		return {};
+	}
+
+	RGLCustomTextureViewPtr TextureNoop::MakeCustomTextureView(const CustomTextureViewConfig& config) const {
+		return std::make_shared<CustomTextureViewNoop>();
+	}
+}
+
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+#include <RGL/Types.hpp>
+#include <RGL/Texture.hpp>
+
+namespace RGL {
+	struct TextureNoop : public ITexture {
+		uint32_t mipLevels = 1;
+		TextureNoop(const TextureConfig& config);
+		TextureNoop(const Dimension& size);
+
+		Dimension GetSize() const final;
+		TextureView GetDefaultView() const final;
+		TextureView GetViewForMip(uint32_t mip) const final;
+		RGLCustomTextureViewPtr MakeCustomTextureView(const CustomTextureViewConfig& config) const final;
+		virtual ~TextureNoop() {}
+	};
+
+	struct CustomTextureViewNoop : public ICustomTextureView {
+		TextureView GetView() const final {
+			return {};
+		}
+	};
+}
@@ -24,6 +24,11 @@
 #include "WGDevice.hpp"
 #endif
 
+#if RGL_NOOP_AVAILABLE
+#include "RGLNoop.hpp"
+#include "NoopDevice.hpp"
+#endif
+
 #include <iostream>
 
 #ifdef _WIN32
@@ -91,6 +96,10 @@ namespace RGL {
 #if RGL_WEBGPU_AVAILABLE
         case API::WebGPU:
             return CreateDefaultDeviceWG();
+#endif
+#if RGL_NOOP_AVAILABLE
+        case API::Noop:
+            return CreateDefaultDeviceNoop();
 #endif
         default:
             FatalError("Invalid API");
@@ -117,10 +126,12 @@ namespace RGL {
             InitD3D12(options);
 #elif __APPLE__
             InitMTL(options);
-#elif __linux__ || RGL_VK_AVAILABLE
+#elif RGL_VK_AVAILABLE
             InitVk(options);
 #elif RGL_WEBGPU_AVAILABLE
             InitWebGPU(options);
+#elif RGL_NOOP_AVAILABLE
+            InitNoop(options);     // only when no real backend was built
 #else   
 
 #endif
@@ -147,8 +158,11 @@ namespace RGL {
                 break;
 #endif
 #endif
+#if RGL_NOOP_AVAILABLE
             case API::Noop:
+                InitNoop(options);
                 break;
+#endif
             default:
                 FatalError("Cannot load invalid API");
                 break;
@@ -177,6 +191,11 @@ namespace RGL {
             DeinitWebGPU();
             break;
 #endif
+#endif
+#if RGL_NOOP_AVAILABLE
+        case API::Noop:
+            DeinitNoop();
+            break;
 #endif
         default:
             FatalError("not implemented for this API");
@@ -255,6 +274,10 @@ namespace RGL {
         case API::WebGPU:
             return CreateRenderPassWG(config);
         break;
+#endif
+#if RGL_NOOP_AVAILABLE
+        case API::Noop:
+            return CreateRenderPassNoop(config);
 #endif
         default:
             FatalError("not implemented for this API");
@@ -0,0 +1,9 @@
+#pragma once
+#include "RGLCommon.hpp"
+#include <RGL/Types.hpp>
+
+namespace RGL {
+	void InitNoop(const RGL::InitOptions&);
+	void DeinitNoop();
+	RGLRenderPassPtr CreateRenderPassNoop(const RenderPassConfig&);
+}
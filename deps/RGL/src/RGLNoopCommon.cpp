@@ -0,0 +1,25 @@
+#if RGL_NOOP_AVAILABLE
+#include "RGLNoop.hpp"
+#include "NoopRenderPass.hpp"
+#include "NoopSurface.hpp"
+
+namespace RGL {
+	void InitNoop(const RGL::InitOptions& options) {
+		Assert(CanInitAPI(RGL::API::Noop), "Noop cannot be initialized on this platform.");
+		RGL::currentAPI = API::Noop;
+	}
+
+	void DeinitNoop() {
+
+	}
+
+	RGLRenderPassPtr CreateRenderPassNoop(const RenderPassConfig& config) {
+		return std::make_shared<RenderPassNoop>();
+	}
+
+	RGLSurfacePtr CreateNoopSurfaceFromPlatformHandle(const CreateSurfaceConfig&) {
+		return std::make_shared<SurfaceNoop>();
+	}
+}
+
+#endif
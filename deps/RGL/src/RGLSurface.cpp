@@ -18,6 +18,10 @@
 #include "WGSurface.hpp"
 #endif
 
+#if RGL_NOOP_AVAILABLE
+#include "NoopSurface.hpp"
+#endif
+
 using namespace RGL;
 
 RGLSurfacePtr RGL::CreateSurfaceFromPlatformHandle(const CreateSurfaceConfig& pointer, bool createSurfaceObject)
@@ -38,6 +42,10 @@ RGLSurfacePtr RGL::CreateSurfaceFromPlatformHandle(const CreateSurfaceConfig& po
 #if RGL_WEBGPU_AVAILABLE
     case API::WebGPU:
         return CreateWGSurfaceFromPlatformHandle(pointer.pointer);
+#endif
+#if RGL_NOOP_AVAILABLE
+    case API::Noop:
+        return CreateNoopSurfaceFromPlatformHandle(pointer);
 #endif
     default:
         FatalError("Invalid API");
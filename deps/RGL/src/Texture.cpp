@@ -24,6 +24,10 @@ namespace RGL {
 #if RGL_MTL_AVAILABLE
         case API::Metal:
             return static_cast<const TextureMTL*>(texture.mtl.texture)->globalIndex;
+#endif
+#if RGL_NOOP_AVAILABLE
+		case API::Noop:
+			return 0;	// nothing is ever sampled
 #endif
 		default:
 			FatalError("Current backend does not support bindless texturing.");
@@ -28,17 +28,37 @@ namespace RavEngine {
         float ticksPerSecond = 0;
 	};
 
-	struct SerializedJointAnimationHeader {
+	/**
+	 Header for a compiled animation. It is followed by archiveSize bytes of an ozz runtime animation archive,
+	 then rootMotionArchiveSize bytes of an ozz archive holding the extracted root motion as a Float3Track (translation)
+	 followed by a QuaternionTrack (rotation). Animations without root motion have a rootMotionArchiveSize of 0.
+	 */
+	struct SerializedCompiledAnimationHeader {
+		constexpr static uint32_t currentVersion = 3;
 		const Array<char, 4> header = { 'r','v','e','a' };
-		float duration = 0;
-        float ticksPerSecond = 0;
-		uint32_t numTracks = 0;
-		uint16_t nameLength = 0;
+		uint32_t version = currentVersion;
+		float ticksPerSecond = 0;
+		uint32_t archiveSize = 0;
+		uint32_t rootMotionArchiveSize = 0;
+	};
+
+	/**
+	 Header for a serialized AnimBlendTree layout. It is followed by numNodes SerializedBlendTreeNode records,
+	 each immediately followed by its numMaskWeights float joint weights.
+	 */
+	struct SerializedBlendTreeHeader {
+		constexpr static uint32_t currentVersion = 1;
+		const Array<char, 4> header = { 'r','v','b','t' };
+		uint32_t version = currentVersion;
+		float threshold = 0;
+		uint32_t numNodes = 0;
 	};
 
-	struct SerializedJointAnimationTrackHeader {
-		uint32_t numTranslations = 0;
-		uint32_t numRotations = 0;
-		uint32_t numScales = 0;
+	struct SerializedBlendTreeNode {
+		uint8_t id = 0;
+		uint8_t layer = 0;
+		float x = 0, y = 0;
+		float maxInfluence = 1;
+		uint32_t numMaskWeights = 0;
 	};
 }
@@ -2,13 +2,17 @@
 #include "Ref.hpp"
 #include "Map.hpp"
 #include "SpinLock.hpp"
+#include "mathtypes.hpp"
 #include <ozz/base/containers/vector.h>
 #include <ozz/animation/runtime/sampling_job.h>
 #include <ozz/base/memory/unique_ptr.h>
+#include <deque>
 
 namespace ozz::animation {
 	struct Skeleton;
 	struct Animation;
+	class Float3Track;
+	class QuaternionTrack;
 }
 
 namespace ozz::math {
@@ -19,6 +23,31 @@ namespace RavEngine{
 
 	class SkeletonAsset;
 
+/**
+ Movement of an animation's root between two playheads, relative to the root at the earlier playhead
+ */
+struct RootMotionDelta{
+	vector3 translation{0, 0, 0};
+	quaternion rotation{1, 0, 0, 0};
+	
+	/**
+	 @return this motion followed by another
+	 */
+	RootMotionDelta Then(const RootMotionDelta& next) const;
+	
+	/**
+	 Weighted average of several deltas, in the same way that poses are blended
+	 */
+	struct Accumulator{
+		vector3 translation{0, 0, 0};
+		quaternion rotation{0, 0, 0, 0};
+		float totalWeight = 0;
+		
+		void Add(const RootMotionDelta& delta, float weight);
+		RootMotionDelta Result() const;
+	};
+};
+
 struct IAnimGraphable{
 	/**
 	 Sample the animation curves
@@ -35,17 +64,105 @@ struct IAnimGraphable{
 						const ozz::animation::Skeleton* skeleton) const = 0;
 	
 	
+	/**
+	 Sample the root motion between two playheads, with the same timing rules as Sample
+	 @param from the time of the previous sample
+	 @param to the time to sample
+	 @param delta receives the motion. Graphables without root motion write no motion.
+	 @return true if any animation in this graphable has root motion
+	 */
+	virtual bool SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const{
+		delta = {};
+		return false;
+	}
+	
     void SampleDirect(float t, const ozz::animation::Animation* anim, ozz::animation::SamplingJob::Context& cache, ozz::vector<ozz::math::SoaTransform>& locals) const;
 };
 
+/**
+ Per-thread pool of SoA pose buffers for graph nodes that need temporaries while sampling.
+ Buffers are leased in stack order and keep their capacity between ticks, so sampling does not allocate once warmed up.
+ */
+class AnimationScratch{
+	std::deque<ozz::vector<ozz::math::SoaTransform>> buffers;	// deque so that outstanding leases stay valid when the pool grows
+	size_t top = 0;
+public:
+	class Lease{
+		friend class AnimationScratch;
+		AnimationScratch& owner;
+		size_t begin, count;
+		Lease(AnimationScratch& owner, size_t begin, size_t count) : owner(owner), begin(begin), count(count){}
+	public:
+		Lease(const Lease&) = delete;
+		~Lease(){
+			owner.top -= count;
+		}
+		
+		inline ozz::vector<ozz::math::SoaTransform>& operator[](size_t i){
+			return owner.buffers[begin + i];
+		}
+		
+		inline size_t size() const{
+			return count;
+		}
+	};
+	
+	/**
+	 Lease buffers sized for a skeleton. Leases must be released in the reverse order they were acquired, which scoping does automatically.
+	 @param count the number of buffers
+	 @param num_soa_joints the SoA joint count of the skeleton being sampled
+	 */
+	Lease Acquire(size_t count, size_t num_soa_joints);
+	
+	/**
+	 @return the scratch pool for the calling worker thread
+	 */
+	static AnimationScratch& ForCurrentThread();
+};
+
 
 class AnimationAsset : public IAnimGraphable{
 	//duration
 	//clip data
 	ozz::unique_ptr<ozz::animation::Animation> anim;
+	// root motion extracted by rveac, relative to the first frame
+	ozz::unique_ptr<ozz::animation::Float3Track> rootMotionTranslation;
+	ozz::unique_ptr<ozz::animation::QuaternionTrack> rootMotionRotation;
 public:
 	AnimationAsset(const std::string& name);
 	
+	/**
+	 Create an animation from an in-memory runtime animation, for clips built at runtime
+	 @param anim the animation, with its duration in ticks
+	 @param tps the ticks per second of the animation
+	 */
+	AnimationAsset(ozz::unique_ptr<ozz::animation::Animation>&& anim, float tps);
+	
+	~AnimationAsset();
+	
+	/**
+	 Attach root motion to an animation built at runtime. rveac does this for compiled animations.
+	 @param translation the root translation at each ratio, relative to ratio 0
+	 @param rotation the root rotation at each ratio, relative to ratio 0
+	 */
+	void SetRootMotion(ozz::unique_ptr<ozz::animation::Float3Track>&& translation, ozz::unique_ptr<ozz::animation::QuaternionTrack>&& rotation);
+	
+	inline bool HasRootMotion() const{
+		return rootMotionTranslation != nullptr;
+	}
+	
+	/**
+	 Root motion between two playheads measured in loops of a region of the animation. Whole loops crossed between them are included.
+	 @param from the earlier playhead, where 1 is one loop of the region
+	 @param to the later playhead
+	 @param looping if false, playheads are clamped to the region
+	 @param begin the start of the region, as a ratio of the animation
+	 @param end the end of the region, as a ratio of the animation
+	 */
+	RootMotionDelta ExtractRootMotion(float from, float to, bool looping, float begin = 0, float end = 1) const;
+	
+	bool SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const override;
+	
 	/**
 	 Sample the animation curves
 	 @param t the time to sample
@@ -75,12 +192,19 @@ public:
 	AnimationAssetSegment(decltype(anim_asset) asset, float start, float end = 0) : anim_asset(asset), start_ticks(start), end_ticks(end){}
 	
 	bool Sample(float global_time, float last_globalplaytime, float speed, bool looping, ozz::vector<ozz::math::SoaTransform>&, ozz::animation::SamplingJob::Context& cache, const ozz::animation::Skeleton* skeleton) const override;
+	
+	bool SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const override;
+	
+private:
+	/**
+	 @return the playhead in loops of the segment
+	 */
+	float SegmentPlayhead(float global_time, float last_globalplaytime, float speed) const;
 };
 
 class AnimationClip : public IAnimGraphable{
 	struct Sampler{
 		float influence;
-		ozz::vector<ozz::math::SoaTransform> locals;
 	};
 	locked_hashmap<Ref<IAnimGraphable>,Sampler, SpinLock> influence;
 public:
@@ -116,5 +240,9 @@ public:
 	 */
 	bool Sample(float t, float start, float speed, bool looping, ozz::vector<ozz::math::SoaTransform>&, ozz::animation::SamplingJob::Context& cache, const ozz::animation::Skeleton* skeleton) const override;
 	
+	/**
+	 Root motion of the clips, averaged by influence
+	 */
+	bool SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const override;
 };
 }
@@ -0,0 +1,75 @@
+#pragma once
+#include <ozz/base/maths/simd_math.h>
+#include <ozz/base/maths/simd_quaternion.h>
+#include <ozz/base/maths/soa_transform.h>
+#include <span>
+#include "mathtypes.hpp"
+
+namespace RavEngine{
+
+/**
+ Write an ozz matrix into a float glm matrix without going through an intermediate array
+ @param in the SIMD matrix
+ @param out destination matrix
+ */
+inline void StoreMatrix(const ozz::math::Float4x4& in, glm::mat4& out){
+	for(int c = 0; c < 4; c++){
+		ozz::math::StorePtrU(in.cols[c], &out[c][0]);
+	}
+}
+
+/**
+ @param in a float glm matrix
+ @return the matrix as an ozz SIMD matrix
+ */
+inline ozz::math::Float4x4 LoadMatrix(const glm::mat4& in){
+	return {{
+		ozz::math::simd_float4::LoadPtrU(&in[0][0]),
+		ozz::math::simd_float4::LoadPtrU(&in[1][0]),
+		ozz::math::simd_float4::LoadPtrU(&in[2][0]),
+		ozz::math::simd_float4::LoadPtrU(&in[3][0]),
+	}};
+}
+
+/**
+ Compute one skinning matrix (model-space joint * inverse bind pose)
+ @param model the model-space joint matrix
+ @param inverseBindpose the inverse bind pose of the joint
+ @param out destination in the GPU upload layout
+ */
+inline void SkinningMatrix(const ozz::math::Float4x4& model, const ozz::math::Float4x4& inverseBindpose, glm::mat4& out){
+	StoreMatrix(model * inverseBindpose, out);
+}
+
+/**
+ Compute skinning matrices for a whole pose
+ @param models model-space joint matrices
+ @param inverseBindposes inverse bind poses, one per joint
+ @param out destination, one per joint. This is in the layout the GPU skinning pass reads.
+ */
+void ComputeSkinningMatrices(std::span<const ozz::math::Float4x4> models, std::span<const ozz::math::Float4x4> inverseBindposes, std::span<glm::mat4> out);
+
+/**
+ Convert model-space joint matrices to engine matrices
+ @param models model-space joint matrices
+ @param out destination, one per joint
+ */
+void ConvertPose(std::span<const ozz::math::Float4x4> models, std::span<matrix4> out);
+
+/**
+ Convert model-space joint matrices to world-space engine matrices
+ @param models model-space joint matrices
+ @param world the world matrix of the owning object
+ @param out destination, one per joint
+ */
+void ConvertPose(std::span<const ozz::math::Float4x4> models, const matrix4& world, std::span<matrix4> out);
+
+/**
+ Rotate one joint of a local-space SoA pose, for applying IK corrections
+ @param pose the local-space pose
+ @param joint the joint index
+ @param rotation the rotation to apply after the joint's existing local rotation
+ */
+void MultiplyJointRotation(std::span<ozz::math::SoaTransform> pose, int joint, const ozz::math::SimdQuaternion& rotation);
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "Map.hpp"
+#include <array>
+#include <mutex>
+#include <cstdint>
+
+namespace RavEngine{
+
+struct IAnimGraphable;
+class SkeletonAsset;
+class AnimatorComponent;
+
+/**
+ Lets AnimatorComponents that play the same states of the same skeleton at the same time share one evaluated pose.
+ The first animator to claim a key in a tick evaluates it, and the others copy its model-space pose and skinning matrices
+ instead of sampling, blending, and skinning themselves. Entries only live for one tick.
+ */
+class AnimationPoseCache{
+public:
+	struct Key{
+		const SkeletonAsset* skeleton = nullptr;
+		std::array<const IAnimGraphable*, 2> clips{nullptr, nullptr};	// the current state, or both states of a transition
+		std::array<float, 2> elapsed{0, 0};								// playhead of each state in seconds, scaled by state speed
+		float blend = 0;
+		std::array<bool, 2> looping{false, false};
+		uint8_t maxJointDepth = 0;
+
+		bool operator==(const Key&) const = default;
+
+		friend size_t hash_value(const Key& k){
+			return phmap::HashState().combine(0, k.skeleton, k.clips[0], k.clips[1], k.elapsed[0], k.elapsed[1], k.blend, k.looping[0], k.looping[1], k.maxJointDepth);
+		}
+	};
+
+	struct Entry{
+		AnimatorComponent* producer = nullptr;	// the animator that evaluates this pose
+		std::array<bool, 2> done{false, false};		// whether each state finished, written by the producer while sampling
+	};
+
+	/**
+	 Find or create the entry for a key
+	 @param key the evaluation inputs
+	 @param claimant the animator asking. If the key is new this tick, the claimant becomes its producer.
+	 @return the entry. Entries stay valid until the next Reset.
+	 */
+	Entry& Claim(const Key& key, AnimatorComponent* claimant);
+
+	/**
+	 Forget all entries. Called once per tick before animators are evaluated.
+	 */
+	void Reset();
+
+	/**
+	 Round state playheads so that animators started at slightly different times can share a pose.
+	 Quantized animators are sampled at the rounded time, so this trades timing accuracy for hit rate.
+	 @param seconds the quantization step. 0 disables quantization, which only shares exactly matching playheads.
+	 */
+	inline void SetTimeQuantization(float seconds){
+		timeQuantization = seconds;
+	}
+
+	inline float GetTimeQuantization() const{
+		return timeQuantization;
+	}
+
+	/**
+	 @param elapsed a playhead in seconds
+	 @return the playhead rounded to the quantization step
+	 */
+	float QuantizeTime(double elapsed) const;
+
+	/**
+	 @return the number of distinct poses evaluated on the last tick
+	 */
+	inline uint32_t GetNumUniquePoses() const{
+		return uniquePoses;
+	}
+
+	/**
+	 @return the number of animators that reused another animator's pose on the last tick
+	 */
+	inline uint32_t GetNumSharedPoses() const{
+		return sharedPoses;
+	}
+
+private:
+	std::mutex mtx;
+	UnorderedNodeMap<Key, Entry> entries;	// node map so that claimed entries do not move while others insert
+	float timeQuantization = 0;
+	uint32_t uniquePoses = 0, sharedPoses = 0;
+};
+
+}
@@ -9,6 +9,12 @@
 #include "App.hpp"
 #include "Function.hpp"
 #include "Queryable.hpp"
+#include "Vector.hpp"
+#include "AnimationPoseCache.hpp"
+#include "SpinLock.hpp"
+#include <limits>
+#include <span>
+#include <atomic>
 
 namespace RavEngine{
 
@@ -31,16 +37,28 @@ public:
 
 struct AnimBlendTree : public IAnimGraphable{
 	struct Node : public IAnimGraphable{
+		enum class Layer : uint8_t{
+			Blend,		// weighted by the distance from the tree's blend position
+			Additive	// applied on top of the blended pose with weight max_influence. The state must sample a delta (additive) animation.
+		};
+		
 		Ref<IAnimGraphable> state;
 		clamped_vec2 graph_pos;
 		float max_influence = 1;
+		Layer layer = Layer::Blend;
+		
+		/**
+		 Per-joint weights in [0,1], indexed by skeleton joint. Joints past the end of the mask are not affected.
+		 Leave empty to affect every joint.
+		 */
+		Vector<float> joint_mask;
 		
 		Node(){}
 		
-		Node(const Node& other) : state(other.state), graph_pos(other.graph_pos), max_influence(other.max_influence){}
+		Node(const Node& other) : state(other.state), graph_pos(other.graph_pos), max_influence(other.max_influence), layer(other.layer), joint_mask(other.joint_mask){}
 		
 		template<typename T>
-		Node(Ref<T> s, const clamped_vec2& pos, float i = 1) : state(std::static_pointer_cast<IAnimGraphable>(s)), graph_pos(pos), max_influence(i){}
+		Node(Ref<T> s, const clamped_vec2& pos, float i = 1, Layer layer = Layer::Blend) : state(std::static_pointer_cast<IAnimGraphable>(s)), graph_pos(pos), max_influence(i), layer(layer){}
 		
 		/**
 		 Sample the animation curves in this tree
@@ -49,9 +67,24 @@ struct AnimBlendTree : public IAnimGraphable{
 		 @param cache a sampling cache, modified when used
 		 */
 		bool Sample(float t, float start, float speed, bool looping, ozz::vector<ozz::math::SoaTransform>&, ozz::animation::SamplingJob::Context& cache, const ozz::animation::Skeleton* skeleton) const override;
+		
+		bool SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const override;
+		
+		/**
+		 @param blend_pos the tree's blend position
+		 @return the weight of this node. Nodes with weight of 0 or less are not sampled.
+		 */
+		float GetWeight(const clamped_vec2& blend_pos) const;
 	};
-
-	static constexpr uint16_t kmax_nodes = 64;
+	
+	AnimBlendTree(){}
+	
+	/**
+	 Create a tree from the output of Serialize
+	 @param data the serialized layout
+	 @param resolve returns the state for each node ID, since states reference assets and are not serialized
+	 */
+	AnimBlendTree(std::span<const uint8_t> data, const Function<Ref<IAnimGraphable>(uint8_t)>& resolve);
 	
 	/**
 	 Insert a node into the tree at the id. If a node already exists at that ID, it is replaced.
@@ -60,6 +93,7 @@ struct AnimBlendTree : public IAnimGraphable{
 	 */
     inline void InsertNode(uint8_t id, const Node& node){
 		states[id].node = node;
+		dirty = true;
 	}
 	
 	/**
@@ -68,10 +102,12 @@ struct AnimBlendTree : public IAnimGraphable{
 	 */
     inline void DeleteNode(uint8_t id){
 		states.erase(id);
+		dirty = true;
 	}
 	
 	/**
-	 Get a node reference to make modifications to it
+	 Get a node reference to change its position or influence, which are read on every sample.
+	 Use EditNode to change anything else.
 	 @param id the ID to get a node for
 	 @returns node reference
 	 @throws if no node exists at id
@@ -80,12 +116,29 @@ struct AnimBlendTree : public IAnimGraphable{
 		return states.at(id).node;
 	}
 	
+    const Node& GetNode(const uint8_t id) const{
+		return states.at(id).node;
+	}
+	
+	/**
+	 Get a node reference to change its layer, state, or joint mask. The tree is recompiled on the next sample,
+	 so avoid calling this every tick.
+	 @param id the ID to get a node for
+	 @returns node reference
+	 @throws if no node exists at id
+	 */
+    Node& EditNode(const uint8_t id){
+		dirty = true;
+		return states.at(id).node;
+	}
+	
     inline bool IsEmpty() const{
 		return states.empty();
 	}
 	
     inline void Clear(){
 		states.clear();
+		dirty = true;
 	}
 	
 	/**
@@ -96,17 +149,84 @@ struct AnimBlendTree : public IAnimGraphable{
 	 */
 	bool Sample(float t, float start, float speed, bool looping, ozz::vector<ozz::math::SoaTransform>&, ozz::animation::SamplingJob::Context& cache, const ozz::animation::Skeleton* skeleton) const override;
 	
+	/**
+	 Root motion of the blend nodes, weighted the same way as their poses. Additive nodes do not move the root.
+	 */
+	bool SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const override;
+	
     constexpr inline void SetBlendPos(const clamped_vec2& newPos){
 		blend_pos = newPos;
 	}
 	
+	/**
+	 @param threshold joints whose accumulated blend weight is below this are blended with the rest pose. Must be positive.
+	 */
+	inline void SetBlendThreshold(float threshold){
+		blend_threshold = std::max(threshold, std::numeric_limits<float>::epsilon());
+	}
+	
+	inline float GetBlendThreshold() const{
+		return blend_threshold;
+	}
+	
+	/**
+	 Flatten the nodes into the evaluation program. This happens automatically on the first sample after the tree changes,
+	 call it ahead of time to keep it off the animation threads.
+	 */
+	void Compile() const;
+	
+	/**
+	 Serialize the layout of this tree: node IDs, positions, influences, layers, joint masks, and the blend threshold.
+	 States are not included, see the deserializing constructor.
+	 @return the serialized bytes
+	 */
+	Vector<uint8_t> Serialize() const;
+	
 private:
 	struct Sampler{
-		ozz::vector<ozz::math::SoaTransform> locals;
 		Node node;
 	};
 	locked_node_hashmap<uint8_t,Sampler,SpinLock> states;
 	clamped_vec2 blend_pos;
+	float blend_threshold = 0.1;
+	
+	// flat evaluation order: blend layers first, then additive layers
+	struct Instruction{
+		const Node* node = nullptr;	// nodes live in a node map, so they do not move
+		uint32_t maskBegin = 0, maskSize = 0;	// range in programMasks, in SoA joints
+	};
+	// the SIMD type loses its alignment attributes as a template argument, so the masks hold it in a struct
+	struct MaskWeights{
+		ozz::math::SimdFloat4 weights;
+	};
+	mutable Vector<Instruction> program;
+	mutable ozz::vector<MaskWeights> programMasks;
+	mutable uint16_t numBlendInstructions = 0;
+	mutable std::atomic<bool> dirty = true;
+	mutable SpinLock compileLock;
+	
+	void CompileIfDirty() const;
+};
+
+/**
+ World-space poses of the joints added with AddSocket. They live outside of the component, so that
+ SocketConstraints can hold on to them instead of looking up the animator every tick.
+ See AnimatorComponent::AddSocket.
+ */
+struct AnimatorSocketPoses{
+	const SkeletonAsset* skeleton = nullptr;	// the skeleton the joint indices refer to
+	Vector<uint16_t> joints;					// may contain duplicates, one per Add
+	Vector<matrix4> poses;						// indexed by joint, only socket joints are updated
+	
+	void Add(uint16_t joint);
+	void Remove(uint16_t joint);
+	
+	/**
+	 Move a transform to a socket
+	 @param joint a joint passed to Add
+	 @param t the transform to move
+	 */
+	void UpdateTransform(uint16_t joint, Transform& t) const;
 };
 
 #if !RVE_SERVER
@@ -247,11 +367,42 @@ public:
     void Pause();
 
 	/**
-	Process one frame of this animator.
+	Process one frame of this animator. This runs all of the stages below in order.
+	Ground probes are not raycast, so chains with probes keep their animated pose, and the pose is never shared.
 	@param t the transform component on the object
 	*/
     void Tick(const Transform& t);
 	
+	/**
+	 Evaluation stages of Tick. AnimatorSystem runs each stage across all animators before starting the next one.
+	 Stages must run in order, and each stage must run once per tick.
+	 */
+	// select the LOD and sample the active states. Animators with pose sharing on claim their pose in poseCache,
+	// which the caller must Reset before each tick's SampleStage. Pass null to evaluate without sharing.
+	void SampleStage(const Transform& t, AnimationPoseCache* poseCache = nullptr);
+	// blend transitioning states and LOD poses
+	void BlendStage();
+	// convert the local pose to model space, and compute skinning matrices unless IK chains will change the pose
+	void LocalToModelStage();
+	// compute the origins of ground probe rays, see GetIKProbes
+	void IKProbeStage(const Transform& t);
+	// solve IK chains on the model-space pose, then compute skinning matrices
+	void IKStage(const Transform& t);
+	// copy shared poses and compute the world-space pose
+	void SkinningStage(const Transform& t);
+	
+	/**
+	 @return the number of joints in this animator's skeleton. Used to balance work between threads.
+	 */
+	inline uint32_t GetNumJoints() const{
+		return static_cast<uint32_t>(models.size());
+	}
+	
+	/**
+	 @return the number of bytes allocated for this animator's pose buffers
+	 */
+	size_t GetMemoryUsage() const;
+	
     inline decltype(skeleton) GetSkeleton() const{
 		return skeleton;
 	}
@@ -260,7 +411,219 @@ public:
     virtual void DebugDraw(RavEngine::DebugDrawer& dbg, const Transform&) const override;
 #endif
 	
-	void UpdateSocket(const std::string&, Transform&) const;
+	/**
+	 Keep the world-space pose of a joint up to date every tick, for sockets and attachments.
+	 Only these joints are converted to world space while ticking, GetPose converts the whole skeleton on demand.
+	 Each call must be paired with a RemoveSocket.
+	 @param joint the joint index, see SkeletonAsset::FindBone
+	 */
+	inline void AddSocket(uint16_t joint){
+		sockets->Add(joint);
+	}
+	
+	/**
+	 Stop updating a joint added with AddSocket
+	 @param joint the joint index
+	 */
+	inline void RemoveSocket(uint16_t joint){
+		sockets->Remove(joint);
+	}
+	
+	/**
+	 @param joint a joint passed to AddSocket
+	 @return the world-space matrix of the joint, as of the last tick
+	 */
+	inline const matrix4& GetSocketPose(uint16_t joint) const{
+		return sockets->poses[joint];
+	}
+	
+	/**
+	 Move a transform to a socket
+	 @param joint a joint passed to AddSocket
+	 @param t the transform to move
+	 */
+	inline void UpdateSocket(uint16_t joint, Transform& t) const{
+		sockets->UpdateTransform(joint, t);
+	}
+	
+	/**
+	 @return the socket poses of this animator. They stay valid, and keep being updated, when the component storage moves.
+	 */
+	inline const Ref<AnimatorSocketPoses>& GetSocketPoses() const{
+		return sockets;
+	}
+	
+	/**
+	 A two-bone IK chain, such as hip-knee-ankle or shoulder-elbow-wrist. The end joint is pulled towards the target,
+	 and the chain bends at the mid joint towards the pole vector.
+	 */
+	struct TwoBoneIK{
+		uint16_t startJoint = 0, midJoint = 0, endJoint = 0;	// see SkeletonAsset::FindBone
+		vector3 target{0, 0, 0};		// in world space. Ground probes overwrite this when they hit.
+		vector3 poleVector{0, 1, 0};	// the direction the chain bends towards, in model space
+		vector3 midAxis{0, 0, 1};		// the axis the mid joint bends around, in the mid joint's local space
+		float weight = 1;				// 0 disables the chain, 1 fully reaches the target
+		float soften = 1;				// below 1, the chain slows down before full extension to avoid popping
+		float twistAngle = 0;			// rotation around the start-to-target axis, in radians
+		
+		/**
+		 Place the end joint on the ground under it, for foot placement. AnimatorSystem raycasts probes against the
+		 World's physics scene in batches. When a probe misses, the chain keeps its animated pose for that tick.
+		 */
+		struct GroundProbe{
+			bool enabled = false;
+			float castHeight = 0.5;		// how far above the animated end joint the ray starts
+			float castDistance = 1;		// how far below the animated end joint the ray reaches
+			float footHeight = 0.1;		// the height of the end joint above the ground it stands on
+		} groundProbe;
+	};
+	
+	/**
+	 An aim chain, which turns one joint so that a point on it faces the target, such as a head looking at something.
+	 */
+	struct AimIK{
+		uint16_t joint = 0;
+		vector3 target{0, 0, 0};		// in world space
+		vector3 forward{0, 0, 1};		// the aiming axis, in the joint's local space
+		vector3 up{0, 1, 0};			// in the joint's local space
+		vector3 offset{0, 0, 0};		// the point that aims, such as the eyes of a head, in the joint's local space
+		vector3 poleVector{0, 1, 0};	// where up should point, in model space
+		float weight = 1;
+		float twistAngle = 0;
+	};
+	
+	/**
+	 Add an IK chain. Chains are solved on the evaluated pose every tick, aim chains first and then two-bone chains,
+	 each in the order they were added. Animators with IK chains do not share poses.
+	 @return the index of the chain
+	 */
+	uint16_t AddTwoBoneIK(const TwoBoneIK& chain);
+	uint16_t AddAimIK(const AimIK& chain);
+	
+	inline TwoBoneIK& GetTwoBoneIK(uint16_t index){
+		return twoBoneChains.at(index);
+	}
+	
+	inline AimIK& GetAimIK(uint16_t index){
+		return aimChains.at(index);
+	}
+	
+	/**
+	 Remove all IK chains
+	 */
+	void ClearIK();
+	
+	inline bool HasIK() const{
+		return !twoBoneChains.empty() || !aimChains.empty();
+	}
+	
+	/**
+	 A downward ground probe ray of a two-bone chain
+	 */
+	struct IKProbe{
+		vector3 origin{0, 0, 0};	// in world space
+		decimalType distance = 0;
+		vector3 hitPosition{0, 0, 0};
+		bool hit = false;
+		uint16_t chain = 0;
+	};
+	
+	/**
+	 @return the ground probes for this tick. IKProbeStage sets their rays, and the caller fills in the hits before IKStage.
+	 */
+	inline std::span<IKProbe> GetIKProbes(){
+		return ikProbes;
+	}
+	
+	/**
+	 A level of detail for animation evaluation. Animators far from the LOD origin can evaluate
+	 their graph less often and skin fewer joints.
+	 */
+	struct LODLevel{
+		float minDistance = 0;			// the minimum distance from the world's animation LOD origin for this level to be used
+		uint16_t updateInterval = 1;	// evaluate the animation graph once every N ticks
+		uint8_t maxJointDepth = std::numeric_limits<uint8_t>::max();	// joints deeper than this in the hierarchy rigidly follow their ancestor
+	};
+	
+	/**
+	 Set the LOD levels for this animator. Levels are selected by distance from World::GetAnimationLODOrigin, unless a selector is set.
+	 @param levels the LOD levels. Pass an empty vector to evaluate at full detail every tick.
+	 */
+	void SetLODLevels(const Vector<LODLevel>& levels);
+	
+	inline const auto& GetLODLevels() const{
+		return lodLevels;
+	}
+	
+	/**
+	 Override distance-based LOD selection with a user callback
+	 @param selector function returning the index into the LOD levels to use for this tick. Out-of-range indices are clamped. Pass an empty function to return to distance-based selection.
+	 */
+	inline void SetLODSelector(const Function<uint8_t(const Transform&)>& selector){
+		lodSelector = selector;
+	}
+	
+	/**
+	 @param interpolate if true, ticks between LOD updates blend between the two most recent evaluated poses instead of holding the last one. This adds one update interval of latency.
+	 */
+	inline void SetLODInterpolation(bool interpolate){
+		lodInterpolate = interpolate;
+	}
+	
+	/**
+	 @return the index of the LOD level used on the most recent tick
+	 */
+	inline uint8_t GetCurrentLOD() const{
+		return currentLOD;
+	}
+	
+	/**
+	 Allow this animator to share evaluated poses with other animators through World::GetAnimationPoseCache.
+	 When another animator plays the same states of the same skeleton at the same playheads, only one of them evaluates the pose.
+	 Ticks that interpolate between LOD updates are never shared. Poses are shared by AnimatorSystem, not by Tick.
+	 @param share true to enable sharing
+	 */
+	inline void SetPoseSharing(bool share){
+		sharePoses = share;
+	}
+	
+	inline bool GetPoseSharing() const{
+		return sharePoses;
+	}
+	
+	/**
+	 How the root motion of the playing animations is applied. See rveac's root_motion option.
+	 */
+	enum class RootMotionMode : uint8_t{
+		Ignore,			// discard root motion
+		Manual,			// record it for GetRootMotionDelta, without moving anything
+		Transform,		// move the owning entity's Transform
+		PhysicsBody		// drive the owning entity's RigidBodyDynamicComponent. Kinematic bodies get a kinematic target, others get velocities.
+	};
+	
+	inline void SetRootMotionMode(RootMotionMode mode){
+		rootMotionMode = mode;
+		rootMotionTime = -1;
+	}
+	
+	inline RootMotionMode GetRootMotionMode() const{
+		return rootMotionMode;
+	}
+	
+	/**
+	 @return the root motion of the last tick, in the entity's local space before the motion. Ticks skipped by LOD have no motion,
+	 the next evaluated tick includes it.
+	 */
+	inline const RootMotionDelta& GetRootMotionDelta() const{
+		return rootMotion;
+	}
+	
+	/**
+	 Apply the root motion of the last tick according to the root motion mode. AnimatorSystem calls this for every animator
+	 after sampling, call it after Tick when ticking manually.
+	 @param t the transform of the owning entity
+	 */
+	void ApplyRootMotion(Transform& t) const;
 
 protected:
 	locked_node_hashmap<id_t,State> states;
@@ -272,12 +635,65 @@ protected:
 		
 	id_t currentState = 0;
 	
-	ozz::vector<ozz::math::SoaTransform> transforms, transformsSecondaryBlending;
+	ozz::vector<ozz::math::SoaTransform> transforms, transformsSecondaryBlending, transformsPreviousLOD, transformsInterpolatedLOD, transformsIK;
     std::shared_ptr<ozz::animation::SamplingJob::Context> cache = std::make_shared<ozz::animation::SamplingJob::Context>();
 	ozz::vector<ozz::math::Float4x4> models;
     mutable ozz::vector<matrix4> glm_pose;
 	ozz::vector<matrix4> local_pose;
-	ozz::vector<matrix4> skinningmats;
+	ozz::vector<glm::mat4> skinningmats;	// in the layout of the GPU skinning buffer
+	
+	Vector<LODLevel> lodLevels;
+	Function<uint8_t(const Transform&)> lodSelector;
+	Vector<uint8_t> jointDepths;
+	Ref<AnimatorSocketPoses> sockets = std::make_shared<AnimatorSocketPoses>();
+	Vector<TwoBoneIK> twoBoneChains;
+	Vector<AimIK> aimChains;
+	Vector<IKProbe> ikProbes;
+	uint32_t lodTickCounter = 0;
+	float lodPendingTimeScale = 0;
+	uint16_t lodPhase = 0;
+	uint8_t currentLOD = 0;
+	bool lodInterpolate = true;
+	bool hasPreviousLODPose = false;
+	bool sharePoses = false;
+	
+	RootMotionMode rootMotionMode = RootMotionMode::Ignore;
+	RootMotionDelta rootMotion;
+	double rootMotionTime = -1;		// the time of the last root motion sample, or negative if there is none
+	float rootMotionSeconds = 0;	// the time that rootMotion covers
+	
+	// results of the stages for the current tick
+	struct TickState{
+		const ozz::vector<ozz::math::SoaTransform>* ltmSource = nullptr;	// the pose to convert to model space, or null to hold the last one
+		uint16_t lodStep = 0;
+		uint16_t lodInterval = 1;
+		uint8_t maxJointDepth = std::numeric_limits<uint8_t>::max();
+		bool active = false;
+		bool evaluated = false;
+		bool stateBlend = false;
+		bool solveIK = false;
+		const AnimationPoseCache::Entry* sharedPose = nullptr;	// the pose this animator copies instead of evaluating its own
+		std::array<bool, 2> done{false, false};						// whether each sampled state finished
+		int8_t endIndex = -1;										// which sampled state ends when done, or -1
+		id_t endState = 0, endNext = 0;
+	} tickState;
+	
+	/**
+	 Choose the LOD level for this tick
+	 */
+	uint8_t SelectLOD(const Transform& t) const;
+	
+	/**
+	 Sample the state machine into transforms, and into transformsSecondaryBlending if transitioning
+	 @param timeScale the tick scale elapsed since the last evaluation
+	 @param poseCache the cache to share the result through, or null to always sample
+	 */
+	void SampleGraph(float timeScale, AnimationPoseCache* poseCache);
+	
+	/**
+	 Compute the skinning matrices from the model-space pose
+	 */
+	void UpdateSkinningMatrices();
 	
 	/**
 	 Update buffer sizes for current skeleton
@@ -1,12 +1,75 @@
 #pragma once
 #include "AnimatorComponent.hpp"
+#include "AnimationPoseCache.hpp"
 #include "GetApp.hpp"
+#include "Types.hpp"
+#include "Vector.hpp"
+
+namespace tf{
+	class Subflow;
+}
+
+namespace physx{
+	class PxRigidActor;
+}
 
 namespace RavEngine{
+class World;
+struct Transform;
+class PhysicsSolver;
+
+/**
+ Evaluates all AnimatorComponents in a World. Animators are grouped into batches of roughly equal joint count,
+ and each stage of AnimatorComponent::Tick runs over every batch before the next stage begins.
+ Root motion is applied in its own serial pass once sampling finishes, alongside blending and before skinning, so sockets see the moved entities.
+ IK ground probes of each batch are raycast together between the local-to-model and IK stages.
+ */
 class AnimatorSystem : public AutoCTTI{
+	struct Entry{
+		AnimatorComponent* animator = nullptr;
+		Transform* transform = nullptr;
+		const physx::PxRigidActor* body = nullptr;	// the animated entity's own collider, which its ground probes skip
+	};
+	struct Batch{
+		pos_t begin = 0, end = 0;
+	};
+	Vector<Entry> entries;
+	Vector<Batch> batches;
+	AnimationPoseCache poseCache;
+	PhysicsSolver* solver = nullptr;
+	
+	/**
+	 Raycast the IK ground probes of a range of animators in one batch
+	 */
+	void RaycastProbes(const Batch& batch);
 public:
-    inline void operator()(AnimatorComponent& c, const Transform& t) const {
-		c.Tick(t);
+	// batches are not split below this many joints, so that tiny rigs do not become one task each
+	constexpr static uint32_t minJointsPerBatch = 512;
+	
+	/**
+	 Gather the animators to evaluate this tick and split them into batches
+	 @param world the world to gather from
+	 @param numWorkers the number of threads the batches will be spread across
+	 */
+	void UpdateBatches(World& world, uint32_t numWorkers);
+	
+	/**
+	 Create the stage tasks for the current batches
+	 @param subflow the subflow to create the tasks in
+	 */
+	void Schedule(tf::Subflow& subflow);
+	
+	/**
+	 Run all stages on the calling thread, for use outside of the task graph
+	 */
+	void RunSerial();
+	
+	inline auto NumBatches() const{
+		return batches.size();
+	}
+	
+	inline AnimationPoseCache& GetPoseCache(){
+		return poseCache;
 	}
 };
 }
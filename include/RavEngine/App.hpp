@@ -106,7 +106,7 @@ struct AudioPlayer;
 #if SINGLE_THREADED
         1 // use main thread only on emscripten
 #else
-            std::max<size_t>(std::thread::hardware_concurrency() - 2, 2)    // for audio - TODO: make configurable
+            size_t(std::max<int>(int(std::thread::hardware_concurrency()) - 2, 2))    // for audio - TODO: make configurable. Signed so that 1-2 core machines do not underflow
 #endif
         };
 		
@@ -158,6 +158,14 @@ struct AudioPlayer;
         float GetCurrentFPSScale() const{
             return currentScale;
         }
+#if !RVE_SERVER
+		/**
+		@return how long the render engine took to encode the last frame, not counting swapchain waits or presentation
+		*/
+        timeDiff GetLastDrawTime() const{
+            return lastDrawTime;
+        }
+#endif
 #if !RVE_SERVER
 		Ref<InputManager> inputManager;
 #endif
@@ -240,6 +248,7 @@ struct AudioPlayer;
 #if !RVE_SERVER
         AudioSnapshot a1, a2, a3, *acurrent = &a1, *ainactive = &a2, *arender = &a3;
         SpinLock audiomtx1, audiomtx2;
+        timeDiff lastDrawTime{0};
 #endif
 	protected:
 #if !RVE_SERVER
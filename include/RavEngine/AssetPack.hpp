@@ -0,0 +1,157 @@
+#pragma once
+#include "Array.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace RavEngine{
+
+/**
+ Header for an asset pack. It is followed by numEntries SerializedAssetPackEntry records sorted by name,
+ then namesSize bytes of entry names, then the file data. Data is stored uncompressed, and each file starts
+ on a multiple of dataAlignment from the start of the pack, so that a memory-mapped pack can be read in place.
+ */
+struct SerializedAssetPackHeader{
+    constexpr static uint32_t currentVersion = 1;
+    constexpr static uint32_t dataAlignment = 64;
+    const Array<char, 4> header = { 'r','v','e','p' };
+    uint32_t version = currentVersion;
+    uint32_t numEntries = 0;
+    uint32_t namesSize = 0;
+};
+
+struct SerializedAssetPackEntry{
+    uint64_t dataOffset = 0;    // from the start of the pack
+    uint64_t dataSize = 0;
+    uint32_t nameOffset = 0;    // from the start of the name table
+    uint32_t nameLength = 0;
+};
+
+/**
+ Collects files and writes them as an asset pack. Used by rvepack.
+ */
+struct AssetPackBuilder{
+    std::vector<std::pair<std::string, std::filesystem::path>> files;   // name in the pack, and where to read it from
+
+    /**
+     Add every file under a directory. Names start with the directory's own name, like an archive of the directory.
+     */
+    void AddDirectory(std::filesystem::path dir){
+        if (!dir.has_filename()){
+            dir = dir.parent_path();    // trailing separator
+        }
+        const auto root = dir.parent_path();
+        for(const auto& entry : std::filesystem::recursive_directory_iterator(dir)){
+            if (entry.is_regular_file()){
+                files.emplace_back(std::filesystem::relative(entry.path(), root).generic_string(), entry.path());
+            }
+        }
+    }
+
+    void Write(std::ostream& out){
+        std::sort(files.begin(), files.end(), [](const auto& a, const auto& b){
+            return a.first < b.first;
+        });
+
+        SerializedAssetPackHeader header;
+        header.numEntries = static_cast<uint32_t>(files.size());
+        std::vector<SerializedAssetPackEntry> entries(files.size());
+        std::string names;
+        for(size_t i = 0; i < files.size(); i++){
+            entries[i].nameOffset = static_cast<uint32_t>(names.size());
+            entries[i].nameLength = static_cast<uint32_t>(files[i].first.size());
+            entries[i].dataSize = std::filesystem::file_size(files[i].second);
+            names += files[i].first;
+        }
+        header.namesSize = static_cast<uint32_t>(names.size());
+
+        auto align = [](uint64_t offset){
+            return (offset + SerializedAssetPackHeader::dataAlignment - 1) / SerializedAssetPackHeader::dataAlignment * SerializedAssetPackHeader::dataAlignment;
+        };
+        uint64_t offset = align(sizeof(header) + sizeof(SerializedAssetPackEntry) * entries.size() + names.size());
+        for(auto& entry : entries){
+            entry.dataOffset = offset;
+            offset = align(offset + entry.dataSize);
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), sizeof(SerializedAssetPackEntry) * entries.size());
+        out.write(names.data(), names.size());
+        std::vector<char> buffer;
+        for(size_t i = 0; i < files.size(); i++){
+            const std::vector<char> padding(entries[i].dataOffset - static_cast<uint64_t>(out.tellp()), 0);
+            out.write(padding.data(), padding.size());
+            std::ifstream in(files[i].second, std::ios::binary);
+            buffer.resize(entries[i].dataSize);
+            if (!in.read(buffer.data(), buffer.size())){
+                throw std::runtime_error("Could not read " + files[i].second.string());
+            }
+            out.write(buffer.data(), buffer.size());
+        }
+    }
+};
+
+/**
+ A memory-mapped asset pack. Files are returned as views into the mapping, which stays valid for the lifetime of the pack.
+ Opening a pack does not read its contents, and files are found by binary search over the sorted table of contents.
+ */
+class AssetPack{
+public:
+    /**
+     Map a pack. Fatal if the file is missing or is not an asset pack.
+     */
+    AssetPack(const std::filesystem::path& path);
+    ~AssetPack();
+    AssetPack(const AssetPack&) = delete;
+
+    /**
+     @param path the name of the file in the pack. Leading and repeated slashes are ignored.
+     @return a view of the file data, with a null data pointer if the pack does not contain the file
+     */
+    std::span<const uint8_t> Find(std::string_view path) const;
+
+    /**
+     @return true if the pack contains a file or directory at the path
+     */
+    bool Exists(std::string_view path) const;
+
+    /**
+     Invoke a function with the name of each file and directory directly inside a directory
+     */
+    void IterateDirectory(std::string_view path, const std::function<void(std::string_view)>& callback) const;
+
+    uint32_t NumEntries() const{
+        return numEntries;
+    }
+
+private:
+    std::string_view NameAt(uint32_t i) const{
+        return std::string_view(names + entries[i].nameOffset, entries[i].nameLength);
+    }
+
+    /**
+     @return the index of the first entry whose name is not less than the path
+     */
+    uint32_t LowerBound(std::string_view path) const;
+
+    const uint8_t* base = nullptr;
+    size_t size = 0;
+    const SerializedAssetPackEntry* entries = nullptr;
+    const char* names = nullptr;
+    uint32_t numEntries = 0;
+#if _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+}
@@ -1,9 +1,12 @@
 #pragma once
 #include "ComponentWithOwner.hpp"
 #include "ComponentHandle.hpp"
+#include "Ref.hpp"
 #include "Queryable.hpp"
 
 namespace RavEngine{
+struct AnimatorSocketPoses;
+class SkeletonAsset;
 
 /**
  Constraints are bound to a ConstraintTarget component
@@ -53,9 +56,21 @@ public:
 };
 
 struct SocketConstraint : public Constraint, public QueryableDelta<Constraint,SocketConstraint>{
+	friend struct SocketSystem;
 	using QueryableDelta<Constraint,SocketConstraint>::GetQueryTypes;
 	std::string boneTarget;
 	SocketConstraint(Entity id, decltype(target), const decltype(boneTarget)& );
+	// invoked by the world on component removal or owner destruction, do not invoke manually
+	void Destroy();
+	
+	inline uint16_t GetJointIndex() const{
+		return jointIndex;
+	}
+private:
+	// resolved once, so that ticking does not search the skeleton or look up the animator
+	Ref<AnimatorSocketPoses> sockets;
+	const SkeletonAsset* skeleton = nullptr;	// the skeleton jointIndex was resolved against
+	uint16_t jointIndex = 0;
 };
 
 /**
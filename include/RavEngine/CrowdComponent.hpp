@@ -0,0 +1,110 @@
+#pragma once
+#include "Queryable.hpp"
+#include "mathtypes.hpp"
+#include <memory>
+
+namespace RavEngine{
+
+    class NavMeshComponent;
+    struct Transform;
+
+    /**
+     Steers agents over a navmesh with local avoidance, using DetourCrowd.
+     Agents are CrowdAgentComponents that refer to this crowd. Requests made through agents are queued,
+     and applied together when CrowdSystem advances the crowd once per tick. CrowdAgentSystem then
+     writes agent positions back to their Transforms in parallel.
+     */
+    class CrowdComponent : public AutoCTTI, public Queryable<CrowdComponent>{
+        struct State;
+        struct Slot;
+        friend class CrowdAgentComponent;
+        // shared so that agents can outlive a moved or destroyed crowd
+        std::shared_ptr<State> state;
+    public:
+        /**
+         @param navMesh the navmesh to walk on. Positions are in its local coordinates.
+         @param maxAgents the most agents that can be in the crowd at once
+         @param maxAgentRadius the largest radius of any agent in the crowd
+         */
+        CrowdComponent(const NavMeshComponent& navMesh, uint16_t maxAgents = 256, float maxAgentRadius = 1);
+
+        /**
+         Apply queued agent requests and advance the simulation. Called by CrowdSystem every tick.
+         @param deltaSeconds the time to advance by
+         @param worldMatrix the world matrix of the navmesh, used to write agent Transforms
+         */
+        void Update(float deltaSeconds, const matrix4& worldMatrix);
+
+        /**
+         @return the number of agents simulated by the last update
+         */
+        uint32_t GetNumAgents() const;
+    };
+
+    class CrowdAgentComponent : public AutoCTTI, public Queryable<CrowdAgentComponent>{
+    public:
+        struct Params{
+            float radius = 0.6f;
+            float height = 2.0f;
+            float maxSpeed = 3.5f;
+            float maxAcceleration = 8.0f;
+            float separationWeight = 2.0f;
+            uint8_t avoidanceQuality = 3;   // 0 to 3, higher samples more velocities when avoiding other agents
+            bool anticipateTurns = true;
+            bool avoidObstacles = true;
+            bool separate = true;
+            bool optimizePath = true;
+            bool faceVelocity = true;       // whether CrowdAgentSystem also rotates the Transform to face the direction of travel
+        };
+
+        /**
+         Join a crowd. The agent is placed on the navmesh on the next crowd update.
+         @param crowd the crowd to join
+         @param position the starting position, in local coordinates to the navmesh
+         */
+        CrowdAgentComponent(const CrowdComponent& crowd, const vector3& position, const Params& params);
+        CrowdAgentComponent(const CrowdComponent& crowd, const vector3& position) : CrowdAgentComponent(crowd, position, Params{}){}
+
+        /**
+         Walk to a point. Pathfinding happens on the next crowd update.
+         @param target in local coordinates to the navmesh
+         */
+        void MoveTo(const vector3& target);
+
+        /**
+         Walk at a velocity instead of towards a target
+         */
+        void SetVelocity(const vector3& velocity);
+
+        /**
+         Stop walking
+         */
+        void Stop();
+
+        void SetParams(const Params& params);
+        Params GetParams() const;
+
+        /**
+         @return the position after the last crowd update, in local coordinates to the navmesh
+         */
+        vector3 GetPosition() const;
+
+        /**
+         @return the velocity after the last crowd update, in local coordinates to the navmesh
+         */
+        vector3 GetVelocity() const;
+
+        /**
+         Move a Transform to the agent's position, and optionally face it along the agent's velocity. Called by CrowdAgentSystem every tick.
+         Does nothing before the agent has been placed on the navmesh.
+         */
+        void WriteTransform(Transform& transform) const;
+
+        // invoked by the world on component removal or owner destruction, do not invoke manually
+        void Destroy();
+
+    private:
+        std::shared_ptr<CrowdComponent::State> crowd;
+        CrowdComponent::Slot* slot = nullptr;  // owned by the crowd, with a stable address
+    };
+}
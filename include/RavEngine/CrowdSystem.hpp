@@ -0,0 +1,27 @@
+#pragma once
+#include "CrowdComponent.hpp"
+#include "Transform.hpp"
+#include "App.hpp"
+#include "CTTI.hpp"
+
+namespace RavEngine {
+	/**
+	 Advances every crowd. Agents of a crowd are simulated together, so requests made by scripts this tick take effect at once.
+	 */
+	class CrowdSystem : public AutoCTTI{
+	public:
+		inline void operator()(CrowdComponent& crowd, const Transform& transform) const{
+			crowd.Update(GetApp()->GetCurrentFPSScale() / App::evalNormal, transform.GetWorldMatrix());
+		}
+	};
+
+	/**
+	 Writes crowd agent positions back to their Transforms, in parallel once every crowd has been advanced
+	 */
+	class CrowdAgentSystem : public AutoCTTI{
+	public:
+		inline void operator()(const CrowdAgentComponent& agent, Transform& transform) const{
+			agent.WriteTransform(transform);
+		}
+	};
+}
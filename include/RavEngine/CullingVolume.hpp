@@ -0,0 +1,104 @@
+#pragma once
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+namespace RavEngine{
+
+/**
+ Axis-aligned bounding box, in world space
+ */
+struct AABB{
+    glm::vec3 min{0,0,0};
+    glm::vec3 max{0,0,0};
+
+    /**
+     @return a box larger than any scene, for objects that must never be culled
+     */
+    static AABB Unbounded(){
+        constexpr float extent = 1e30f;     // small enough that sums of extents do not overflow
+        return {glm::vec3(-extent), glm::vec3(extent)};
+    }
+
+    /**
+     @return the box around a sphere
+     */
+    static AABB FromSphere(const glm::vec3& center, float radius){
+        return {center - radius, center + radius};
+    }
+
+    bool Contains(const AABB& other) const;
+
+    bool Overlaps(const AABB& other) const;
+
+    AABB Union(const AABB& other) const;
+
+    /**
+     @return the sum of the edge lengths, used as the cost of a box when building a tree
+     */
+    float Perimeter() const;
+};
+
+/**
+ Frustum planes, pointing inwards. Built the same way as the GPU culling shader, so CPU and GPU culling agree.
+ */
+struct Frustum{
+    glm::vec4 planes[6];
+
+    Frustum() = default;
+    Frustum(const glm::mat4& viewProj);
+
+    /**
+     @return true if the sphere is at least partially inside the frustum
+     */
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+
+    /**
+     @return true if the box may be partially inside the frustum. Boxes near a corner of the frustum can pass
+     without intersecting it, which is conservative.
+     */
+    bool Intersects(const AABB& box) const;
+};
+
+struct BoundingSphere{
+    glm::vec3 center{0,0,0};
+    float radius = 0;
+
+    /**
+     @return a sphere larger than any scene. Its radius squared still fits in a float.
+     */
+    static BoundingSphere Unbounded(){
+        return {{0,0,0}, 1e18f};
+    }
+
+    bool Intersects(const AABB& box) const;
+};
+
+/**
+ A frustum limited to a sphere, such as a light's shadow view limited to the light's range
+ */
+struct BoundedFrustum{
+    Frustum frustum;
+    BoundingSphere bound = BoundingSphere::Unbounded();
+
+    bool Intersects(const AABB& box) const{
+        return bound.Intersects(box) && frustum.Intersects(box);
+    }
+};
+
+/**
+ A cone with a flat cap, such as the volume lit by a spot light
+ */
+struct BoundingCone{
+    glm::vec3 apex{0,0,0};
+    glm::vec3 axis{0,0,1};      // normalized
+    float range = 0;            // distance from the apex to the cap
+    float halfAngle = 0;        // in radians, less than 90 degrees
+
+    /**
+     Tests the box against planes that enclose the cone, so boxes just outside the cone can pass, which is conservative.
+     */
+    bool Intersects(const AABB& box) const;
+};
+
+}
@@ -0,0 +1,409 @@
+#pragma once
+#include "CullingVolume.hpp"
+#include "Vector.hpp"
+#include "Array.hpp"
+#include "Debug.hpp"
+#include <span>
+#include <cstdint>
+#include <algorithm>
+#include <bit>
+
+namespace RavEngine{
+
+/**
+ A bounding volume hierarchy over boxes that are added, moved and removed over time, such as the bounds of
+ renderables and lights. It only stores boxes and a user value per leaf, so it can be tested without a GPU.
+
+ Leaves are inserted next to the sibling that grows the tree the least, and the tree is kept balanced with
+ rotations. Leaf boxes are enlarged by a margin, so small movements change nothing. Larger movements mark the leaf
+ dirty, and Refit then grows its ancestors in one pass. A leaf that moves away from its old box entirely is
+ reinserted instead, so that refitting does not stretch its ancestors across the scene.
+
+ Queries take any volume with `bool Intersects(const AABB&) const`, such as Frustum, BoundingSphere and
+ BoundingCone. A batched query tests up to 32 volumes in one traversal, and reports which of them reach each leaf.
+ */
+template<typename T>
+class DynamicBVH{
+public:
+    constexpr static uint32_t Null = 0xffffffff;
+    constexpr static uint32_t MaxBatchSize = 32;
+
+    /**
+     @param margin the distance that leaf boxes are enlarged by
+     */
+    DynamicBVH(float margin = 0) : margin(margin){}
+
+    /**
+     @return the proxy of the new leaf, which stays valid until it is removed
+     */
+    uint32_t Insert(const AABB& box, const T& userData){
+        const auto proxy = AllocateNode();
+        auto& node = nodes[proxy];
+        node.box = Fatten(box);
+        node.userData = userData;
+        node.height = 0;
+        InsertLeaf(proxy);
+        numLeaves++;
+        return proxy;
+    }
+
+    void Remove(uint32_t proxy){
+        Debug::Assert(IsLeaf(proxy), "Invalid proxy {}", proxy);
+        RemoveLeaf(proxy);
+        FreeNode(proxy);
+        numLeaves--;
+    }
+
+    /**
+     Move a leaf. Parts of the tree may be out of date until the next Refit, so call that before querying.
+     @return false if the box was still inside the leaf's enlarged box, and nothing changed
+     */
+    bool Update(uint32_t proxy, const AABB& box){
+        Debug::Assert(IsLeaf(proxy), "Invalid proxy {}", proxy);
+        auto& node = nodes[proxy];
+        if (node.box.Contains(box)){
+            return false;
+        }
+        const auto fatBox = Fatten(box);
+        if (!fatBox.Overlaps(node.box)){
+            RemoveLeaf(proxy);
+            nodes[proxy].box = fatBox;
+            InsertLeaf(proxy);
+        }
+        else{
+            node.box = fatBox;
+            if (!node.dirty){
+                node.dirty = true;
+                dirtyLeaves.push_back(proxy);
+            }
+        }
+        return true;
+    }
+
+    /**
+     Grow the ancestors of every leaf moved by Update since the last call. Stops climbing as soon as an ancestor
+     already contains the new box, so the cost is proportional to the number of moved leaves, not the size of the tree.
+     */
+    void Refit(){
+        for (const auto proxy : dirtyLeaves){
+            // the leaf may have been removed, and its node reused, since it was marked
+            if (!IsLeaf(proxy) || !nodes[proxy].dirty){
+                continue;
+            }
+            nodes[proxy].dirty = false;
+            for (auto index = nodes[proxy].parent; index != Null; index = nodes[index].parent){
+                auto& node = nodes[index];
+                const auto refit = nodes[node.child1].box.Union(nodes[node.child2].box);
+                if (node.box.Contains(refit)){
+                    break;
+                }
+                node.box = node.box.Union(refit);
+            }
+        }
+        dirtyLeaves.clear();
+    }
+
+    T& GetUserData(uint32_t proxy){
+        return nodes[proxy].userData;
+    }
+
+    const T& GetUserData(uint32_t proxy) const{
+        return nodes[proxy].userData;
+    }
+
+    /**
+     @return the enlarged box of a leaf
+     */
+    const AABB& GetFatBox(uint32_t proxy) const{
+        return nodes[proxy].box;
+    }
+
+    uint32_t GetNumLeaves() const{
+        return numLeaves;
+    }
+
+    /**
+     @return the number of levels below the root, or 0 if the tree is empty
+     */
+    uint32_t GetHeight() const{
+        return root == Null ? 0 : nodes[root].height;
+    }
+
+    /**
+     Invoke callback(const T&) for each leaf whose box intersects the volume
+     */
+    template<typename Volume, typename Callback>
+    void Query(const Volume& volume, Callback&& callback) const{
+        QueryBatch(std::span<const Volume>(&volume, 1), [&callback](const T& userData, uint32_t){
+            callback(userData);
+        });
+    }
+
+    /**
+     Invoke callback(const T&, uint32_t mask) once for each leaf whose box intersects at least one of the volumes.
+     Bit i of the mask is set if the leaf intersects volumes[i]. A subtree is only tested against the volumes
+     that reached its parent.
+     */
+    template<typename Volume, typename Callback>
+    void QueryBatch(std::span<const Volume> volumes, Callback&& callback) const{
+        Debug::Assert(volumes.size() <= MaxBatchSize, "Cannot query more than {} volumes at once", MaxBatchSize);
+        if (root == Null || volumes.empty()){
+            return;
+        }
+        struct StackEntry{
+            uint32_t node, mask;
+        };
+        Array<StackEntry, MaxStackSize> stack;
+        uint32_t stackSize = 0;
+        stack[stackSize++] = {root, uint32_t((uint64_t(1) << volumes.size()) - 1)};
+
+        while (stackSize > 0){
+            const auto entry = stack[--stackSize];
+            const auto& node = nodes[entry.node];
+
+            uint32_t mask = 0;
+            for (auto remaining = entry.mask; remaining != 0; remaining &= remaining - 1){
+                const auto i = std::countr_zero(remaining);
+                if (volumes[i].Intersects(node.box)){
+                    mask |= 1u << i;
+                }
+            }
+            if (mask == 0){
+                continue;
+            }
+
+            if (node.IsLeaf()){
+                callback(node.userData, mask);
+            }
+            else{
+                Debug::Assert(stackSize + 2 <= MaxStackSize, "DynamicBVH is too deep to query");
+                stack[stackSize++] = {node.child1, mask};
+                stack[stackSize++] = {node.child2, mask};
+            }
+        }
+    }
+
+private:
+    // the tree is balanced, so this is far deeper than any tree that fits in memory
+    constexpr static uint32_t MaxStackSize = 128;
+
+    struct Node{
+        AABB box;
+        T userData{};
+        uint32_t parent = Null;     // the next free node, while on the free list
+        uint32_t child1 = Null;
+        uint32_t child2 = Null;
+        int32_t height = -1;        // 0 for leaves, -1 for free nodes
+        bool dirty = false;
+
+        bool IsLeaf() const{
+            return child1 == Null;
+        }
+    };
+
+    bool IsLeaf(uint32_t index) const{
+        return index < nodes.size() && nodes[index].height == 0;
+    }
+
+    AABB Fatten(const AABB& box) const{
+        return {box.min - margin, box.max + margin};
+    }
+
+    uint32_t AllocateNode(){
+        uint32_t index;
+        if (freeList == Null){
+            nodes.emplace_back();
+            index = uint32_t(nodes.size() - 1);
+        }
+        else{
+            index = freeList;
+            freeList = nodes[index].parent;
+            nodes[index] = {};
+        }
+        return index;
+    }
+
+    void FreeNode(uint32_t index){
+        nodes[index] = {};
+        nodes[index].parent = freeList;
+        freeList = index;
+    }
+
+    void InsertLeaf(uint32_t leaf){
+        if (root == Null){
+            root = leaf;
+            nodes[root].parent = Null;
+            return;
+        }
+
+        // descend to the sibling where adding the leaf costs the least, counting the growth of every ancestor
+        const auto leafBox = nodes[leaf].box;
+        auto index = root;
+        while (!nodes[index].IsLeaf()){
+            const auto& node = nodes[index];
+            const auto area = node.box.Perimeter();
+            const auto combinedArea = node.box.Union(leafBox).Perimeter();
+
+            // cost of making a new parent for this node and the leaf
+            const auto cost = 2 * combinedArea;
+            // cost of pushing the leaf further down the tree
+            const auto inheritanceCost = 2 * (combinedArea - area);
+
+            auto childCost = [&](uint32_t child){
+                const auto& childBox = nodes[child].box;
+                const auto newArea = childBox.Union(leafBox).Perimeter();
+                return nodes[child].IsLeaf() ? newArea + inheritanceCost : newArea - childBox.Perimeter() + inheritanceCost;
+            };
+            const auto cost1 = childCost(node.child1);
+            const auto cost2 = childCost(node.child2);
+
+            if (cost < cost1 && cost < cost2){
+                break;
+            }
+            index = cost1 < cost2 ? node.child1 : node.child2;
+        }
+        const auto sibling = index;
+
+        // make a new parent for the sibling and the leaf
+        const auto oldParent = nodes[sibling].parent;
+        const auto newParent = AllocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = leafBox.Union(nodes[sibling].box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if (oldParent != Null){
+            if (nodes[oldParent].child1 == sibling){
+                nodes[oldParent].child1 = newParent;
+            }
+            else{
+                nodes[oldParent].child2 = newParent;
+            }
+        }
+        else{
+            root = newParent;
+        }
+
+        FixUpwards(nodes[leaf].parent);
+    }
+
+    void RemoveLeaf(uint32_t leaf){
+        if (leaf == root){
+            root = Null;
+            return;
+        }
+
+        // the leaf's sibling takes the place of their parent
+        const auto parent = nodes[leaf].parent;
+        const auto grandParent = nodes[parent].parent;
+        const auto sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        if (grandParent != Null){
+            if (nodes[grandParent].child1 == parent){
+                nodes[grandParent].child1 = sibling;
+            }
+            else{
+                nodes[grandParent].child2 = sibling;
+            }
+            nodes[sibling].parent = grandParent;
+            FreeNode(parent);
+            FixUpwards(grandParent);
+        }
+        else{
+            root = sibling;
+            nodes[sibling].parent = Null;
+            FreeNode(parent);
+        }
+        nodes[leaf].parent = Null;
+    }
+
+    /**
+     Rebalance, and recompute the boxes and heights of, a node and all of its ancestors
+     */
+    void FixUpwards(uint32_t index){
+        while (index != Null){
+            index = Balance(index);
+            auto& node = nodes[index];
+            node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+            node.box = nodes[node.child1].box.Union(nodes[node.child2].box);
+            index = node.parent;
+        }
+    }
+
+    /**
+     If the children of a node differ in height by more than one, rotate the taller one up
+     @return the node now in the place of the given one
+     */
+    uint32_t Balance(uint32_t a){
+        auto& nodeA = nodes[a];
+        if (nodeA.IsLeaf() || nodeA.height < 2){
+            return a;
+        }
+        const auto b = nodeA.child1, c = nodeA.child2;
+        const auto balance = nodes[c].height - nodes[b].height;
+        if (balance > 1){
+            return Rotate(a, c, b);
+        }
+        if (balance < -1){
+            return Rotate(a, b, c);
+        }
+        return a;
+    }
+
+    /**
+     Make the taller child of a its parent, and a takes one of that child's children
+     @param a the unbalanced node
+     @param up the taller child of a, which replaces it
+     @param other the other child of a, which stays under it
+     */
+    uint32_t Rotate(uint32_t a, uint32_t up, uint32_t other){
+        const auto f = nodes[up].child1, g = nodes[up].child2;
+
+        // up takes a's place under a's parent
+        nodes[up].child1 = a;
+        nodes[up].parent = nodes[a].parent;
+        nodes[a].parent = up;
+        if (nodes[up].parent != Null){
+            auto& upParent = nodes[nodes[up].parent];
+            if (upParent.child1 == a){
+                upParent.child1 = up;
+            }
+            else{
+                upParent.child2 = up;
+            }
+        }
+        else{
+            root = up;
+        }
+
+        // a keeps the shorter of up's children, up keeps the taller
+        const bool keepF = nodes[f].height > nodes[g].height;
+        const auto taller = keepF ? f : g, shorter = keepF ? g : f;
+        nodes[up].child2 = taller;
+        if (nodes[a].child1 == up){
+            nodes[a].child1 = shorter;
+        }
+        else{
+            nodes[a].child2 = shorter;
+        }
+        nodes[shorter].parent = a;
+
+        nodes[a].box = nodes[other].box.Union(nodes[shorter].box);
+        nodes[a].height = 1 + std::max(nodes[other].height, nodes[shorter].height);
+        nodes[up].box = nodes[a].box.Union(nodes[taller].box);
+        nodes[up].height = 1 + std::max(nodes[a].height, nodes[taller].height);
+        return up;
+    }
+
+    Vector<Node> nodes;
+    Vector<uint32_t> dirtyLeaves;
+    uint32_t root = Null;
+    uint32_t freeList = Null;
+    uint32_t numLeaves = 0;
+    float margin = 0;
+};
+
+}
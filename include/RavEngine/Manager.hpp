@@ -4,24 +4,114 @@
 #include "SpinLock.hpp"
 #include "Map.hpp"
 #include "Vector.hpp"
+#include "Function.hpp"
 #include <tuple>
+#include <future>
+#include <atomic>
+#include <mutex>
 
 namespace RavEngine {
 
     struct CacheBase {
         using unique_key_t = uint32_t;
+    protected:
+        /**
+         Run a load on the App executor
+         */
+        static void Dispatch(Function<void()>&& load);
     };
 
 /**
  Defines a generic non-owning cache.
  If the key type is not a parameter in the construction of your object, set the final template parameter to false
+ Objects are constructed outside of the cache lock, so loads of different keys run at once. Requests for a key
+ that is already loading wait for that load instead of starting another.
  */
 template<typename key_t, typename T, bool keyIsConstructionParam = true>
 struct GenericWeakReadThroughCache : public CacheBase{
 
 protected:
-    static UnorderedMap<std::tuple<key_t, unique_key_t>,WeakRef<T>> items;
+    using cache_key_t = std::tuple<key_t, unique_key_t>;
+
+    struct Loading{
+        Function<Ref<T>()> construct;
+        std::promise<Ref<T>> promise;
+        std::shared_future<Ref<T>> future = promise.get_future().share();
+        std::atomic<bool> started = false;  // set by whichever thread runs construct
+    };
+
+    struct Entry{
+        WeakRef<T> value;
+        std::shared_ptr<Loading> loading;   // set while the object is being constructed
+    };
+
+    static UnorderedMap<cache_key_t, Entry> items;
     static SpinLock mtx;
+
+    /**
+     Find a cached or loading object, or register a new load for it
+     @param loaded set to the cached object, if there is one
+     @param isNew set to true if the returned load was registered by this call
+     @return the load to wait on, or nullptr if the object is cached
+     */
+    template<typename ... A>
+    static std::shared_ptr<Loading> Find(const key_t& str, unique_key_t unique_key, Ref<T>& loaded, bool& isNew, A ... extras){
+        std::lock_guard guard(mtx);
+        auto& entry = items[cache_key_t(str, unique_key)];
+        isNew = false;
+        if (entry.loading) {
+            return entry.loading;
+        }
+        if ((loaded = entry.value.lock())) {
+            return nullptr;
+        }
+        isNew = true;
+        entry.loading = std::make_shared<Loading>();
+        entry.loading->construct = [str, extras...]() -> Ref<T> {
+            if constexpr (keyIsConstructionParam) {
+                return std::make_shared<T>(str, extras...);
+            }
+            else {
+                return std::make_shared<T>(extras...);
+            }
+        };
+        return entry.loading;
+    }
+
+    /**
+     Record the result of a load. If the cache was cleared while it ran, the key may belong to a newer load, which is left alone.
+     */
+    static void Finish(const cache_key_t& key, const Loading& loading, const Ref<T>& value){
+        std::lock_guard guard(mtx);
+        auto it = items.find(key);
+        if (it == items.end() || it->second.loading.get() != &loading) {
+            return;
+        }
+        it->second.value = value;
+        it->second.loading.reset();
+    }
+
+    /**
+     Construct the object if no other thread has started to, otherwise wait for the thread that did
+     */
+    static Ref<T> Resolve(const cache_key_t& key, Loading& loading){
+        if (loading.started.exchange(true)) {
+            return loading.future.get();
+        }
+        Ref<T> value;
+        try {
+            value = loading.construct();
+        }
+        catch (...) {
+            Finish(key, loading, nullptr);
+            loading.promise.set_exception(std::current_exception());
+            throw;
+        }
+        Finish(key, loading, value);
+        loading.promise.set_value(value);
+        return value;
+    }
+
 public:
     /**
      Load object from cache. If the object is not cached in memory, it will be loaded from disk.
@@ -43,34 +133,67 @@ public:
      */
     template<typename ... A>
     static inline Ref<T> GetWithKey(const key_t& str, unique_key_t unique_key, A ... extras) {
-        auto key = std::tuple<key_t, unique_key_t>(str, unique_key);
-       
-        //TODO: optimize
-        std::lock_guard guard(mtx);
-        if (items.contains(key)) {
-            auto value = items.at(key).lock();
-            if (auto ptr = value) {
-                return ptr;
-            }
+        Ref<T> loaded;
+        bool isNew;
+        auto loading = Find(str, unique_key, loaded, isNew, extras...);
+        if (!loading) {
+            return loaded;
         }
-        Ref<T> m;
-        if constexpr (keyIsConstructionParam) {
-            m = std::make_shared<T>(str, extras...);
+        // a load that was queued but not started yet runs here, so that this thread does not wait on the executor
+        return Resolve(cache_key_t(str, unique_key), *loading);
+    }
+
+    /**
+     Load object from cache without blocking. If the object is not cached in memory, it is loaded on the App executor,
+     so its constructor must be safe to run off the main thread.
+     @param str the name of the mesh
+     @param extras additional arguments to pass to meshasset constructor
+     @return a future for the object, which rethrows the error if loading fails
+     */
+    template<typename ... A>
+    static inline std::shared_future<Ref<T>> GetAsync(const key_t& str, A ... extras){
+        return GetWithKeyAsync(str, 0, extras...);
+    }
+
+    /**
+     Load object from cache without blocking. If the object is not cached in memory, it is loaded on the App executor,
+     so its constructor must be safe to run off the main thread.
+     @param str the name of the mesh
+     @param unique_key a differentiator to force a new load and identify it later
+     @param extras additional arguments to pass to meshasset constructor
+     @return a future for the object, which rethrows the error if loading fails
+     */
+    template<typename ... A>
+    static std::shared_future<Ref<T>> GetWithKeyAsync(const key_t& str, unique_key_t unique_key, A ... extras) {
+        Ref<T> loaded;
+        bool isNew;
+        auto loading = Find(str, unique_key, loaded, isNew, extras...);
+        if (!loading) {
+            std::promise<Ref<T>> ready;
+            ready.set_value(loaded);
+            return ready.get_future().share();
         }
-        else {
-            m = std::make_shared<T>(extras...);
+        if (isNew) {
+            Dispatch([loading, key = cache_key_t(str, unique_key)] {
+                try {
+                    Resolve(key, *loading);
+                }
+                catch (...) {
+                    // delivered through the future
+                }
+            });
         }
-        items[key] = m;
-        return m;
+        return loading->future;
     }
 
     /**
      Reduce the size of the cache by removing expired pointers
      */
     static void Compact(){
-        RavEngine::Vector<std::tuple<std::string, unique_key_t>> toremove;
+        std::lock_guard guard(mtx);
+        RavEngine::Vector<cache_key_t> toremove;
         for(const auto& entry : items){
-            if (entry.second.expired()){
+            if (entry.second.value.expired() && !entry.second.loading){
                 toremove.push_back(entry.first);
             }
         }
@@ -78,9 +201,9 @@ public:
             items.erase(c);
         }
     }
-    
+
     /**
-     * Remove all items from the cache
+     * Remove all items from the cache. Loads in flight still complete for their callers, but are not cached.
      */
     static void Clear(){
         std::lock_guard guard(mtx);
@@ -92,5 +215,4 @@ template<typename key, typename T, bool keyIsConstructionParam>
 RavEngine::SpinLock RavEngine::GenericWeakReadThroughCache<key,T,keyIsConstructionParam>::mtx;
 
 template<typename key,typename T, bool keyIsConstructionParam>
-RavEngine::UnorderedMap<std::tuple<key, RavEngine::CacheBase::unique_key_t>, WeakRef<T>> RavEngine::GenericWeakReadThroughCache<key, T, keyIsConstructionParam>::items;
-
+RavEngine::UnorderedMap<std::tuple<key, RavEngine::CacheBase::unique_key_t>, typename RavEngine::GenericWeakReadThroughCache<key, T, keyIsConstructionParam>::Entry> RavEngine::GenericWeakReadThroughCache<key, T, keyIsConstructionParam>::items;
@@ -1,21 +1,136 @@
 #pragma once
 #include "Vector.hpp"
 #include <glm/mat4x4.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
 #include "Common3D.hpp"
+#include "Meshlet.hpp"
 #include <span>
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <functional>
 
 namespace RavEngine{
 
+typedef VertexNormalUV vertex_t;
+
+/**
+ Compute the bounding box and the radius from the origin of a list of vertices
+ */
+template<typename T>
+inline void CalculateBounds(const T& vertices, Bounds& bounds, float& radius){
+    for(const auto& vert : vertices){
+        bounds.max[0] = std::max<decimalType>(bounds.max[0],vert.position[0]);
+        bounds.max[1] = std::max<decimalType>(bounds.max[1],vert.position[1]);
+        bounds.max[2] = std::max<decimalType>(bounds.max[2],vert.position[2]);
+
+        bounds.min[0] = std::min<decimalType>(bounds.min[0],vert.position[0]);
+        bounds.min[1] = std::min<decimalType>(bounds.min[1],vert.position[1]);
+        bounds.min[2] = std::min<decimalType>(bounds.min[2],vert.position[2]);
+
+        radius = std::max(radius, glm::length(glm::vec3(vert.position[0],vert.position[1],vert.position[2])));
+    }
+}
+
+/**
+ Compact vertex used by compressed meshes. Normals, tangents and bitangents are 16-bit snorm, and UVs are half floats.
+ */
+struct QuantizedVertex{
+    float position[3];
+    int16_t normal[3];
+    int16_t tangent[3];
+    int16_t bitangent[3];
+    uint16_t uv[2];
+    uint16_t padding = 0;   // the vertex codec needs a multiple of 4 bytes
+
+    QuantizedVertex() : position{0,0,0}, normal{0,0,0}, tangent{0,0,0}, bitangent{0,0,0}, uv{0,0}{}
+
+    QuantizedVertex(const vertex_t& vert) : position{vert.position.x, vert.position.y, vert.position.z}{
+        for(int i = 0; i < 3; i++){
+            normal[i] = int16_t(glm::packSnorm1x16(vert.normal[i]));
+            tangent[i] = int16_t(glm::packSnorm1x16(vert.tangent[i]));
+            bitangent[i] = int16_t(glm::packSnorm1x16(vert.bitangent[i]));
+        }
+        uv[0] = glm::packHalf1x16(vert.uv.x);
+        uv[1] = glm::packHalf1x16(vert.uv.y);
+    }
+
+    vertex_t Dequantize() const{
+        vertex_t vert;
+        for(int i = 0; i < 3; i++){
+            vert.position[i] = position[i];
+            vert.normal[i] = glm::unpackSnorm1x16(uint16_t(normal[i]));
+            vert.tangent[i] = glm::unpackSnorm1x16(uint16_t(tangent[i]));
+            vert.bitangent[i] = glm::unpackSnorm1x16(uint16_t(bitangent[i]));
+        }
+        vert.uv = {glm::unpackHalf1x16(uv[0]), glm::unpackHalf1x16(uv[1])};
+        return vert;
+    }
+};
+static_assert(sizeof(QuantizedVertex) % 4 == 0, "Quantized vertices must be a multiple of 4 bytes");
+
+/**
+ Header for a mesh. It is followed by numVertices vertex_t, then numIndicies uint32_t, then for skinned meshes
+ numVertices VertexWeights. The header is a multiple of 16 bytes, so the vertex and index data can be used in place.
+ If CompressedBit is set, the vertices are instead QuantizedVertex compressed with meshoptimizer's vertex codec,
+ and the indices are compressed with its index codec. Each compressed block starts on a multiple of 4 bytes.
+ If MeshletsBit is set, a meshlet block of meshletBytes follows the indices, before any skin data.
+ */
 struct SerializedMeshDataHeader{
+    constexpr static uint32_t currentVersion = 3;
     const std::array<char, 4> header = {'r','v','e','m'};
+    uint32_t version = currentVersion;
     uint32_t numVertices = 0;
     uint32_t numIndicies = 0;
     uint8_t attributes = 0;     // info about the file
+    uint8_t padding[3]{0,0,0};
+    Bounds bounds;              // precomputed by rvemc
+    float radius = 0;
+    uint32_t encodedVertexBytes = 0;    // sizes of the compressed blocks, if CompressedBit is set
+    uint32_t encodedIndexBytes = 0;
+    uint32_t meshletBytes = 0;          // size of the meshlet block, if MeshletsBit is set
+    uint32_t reserved = 0;
 
     constexpr static uint8_t SkinnedMeshBit = 1 << 0;
-};
+    constexpr static uint8_t CompressedBit = 1 << 1;
+    constexpr static uint8_t MeshletsBit = 1 << 2;
 
-typedef VertexNormalUV vertex_t;
+    bool IsCompressed() const{
+        return attributes & CompressedBit;
+    }
+
+    bool HasMeshlets() const{
+        return attributes & MeshletsBit;
+    }
+
+    /**
+     @return the offset of the index data from the start of the header
+     */
+    size_t IndexDataOffset() const{
+        return IsCompressed() ? AlignBlock(sizeof(SerializedMeshDataHeader) + encodedVertexBytes) : sizeof(SerializedMeshDataHeader) + numVertices * sizeof(vertex_t);
+    }
+
+    /**
+     @return the offset of the meshlet block from the start of the header
+     */
+    size_t MeshletDataOffset() const{
+        return IsCompressed() ? AlignBlock(IndexDataOffset() + encodedIndexBytes) : IndexDataOffset() + numIndicies * sizeof(uint32_t);
+    }
+
+    /**
+     @return the size of the header, vertices, indices and meshlets, which is where skin data starts
+     */
+    size_t MeshDataSize() const{
+        return MeshletDataOffset() + (HasMeshlets() ? meshletBytes : 0);
+    }
+
+    static size_t AlignBlock(size_t offset){
+        return (offset + 3) / 4 * 4;
+    }
+};
+static_assert(sizeof(SerializedMeshDataHeader) % 16 == 0, "Mesh data must stay aligned after the header");
 
 template<template<typename...> class T>
 struct MeshPartBase{
@@ -38,5 +153,94 @@ struct MeshPartView : public MeshPartBase<basic_immutable_span>{
     }
 };
 
+/**
+ Write a mesh in the rvem format, with its bounds in the header. Skin data, if any, is written after it by the caller.
+ @param meshlets optional meshlets of the mesh
+ */
+inline void SerializeMesh(std::ostream& out, const MeshPart& mesh, uint8_t attributes = 0, const MeshletData* meshlets = nullptr){
+    SerializedMeshDataHeader header{
+       .numVertices = uint32_t(mesh.vertices.size()),
+       .numIndicies = uint32_t(mesh.indices.size()),
+       .attributes = uint8_t(attributes | (meshlets ? SerializedMeshDataHeader::MeshletsBit : 0))
+    };
+    if (meshlets){
+        header.meshletBytes = uint32_t(meshlets->SerializedSize());
+    }
+    // precompute bounds so that loading does not need to visit every vertex
+    CalculateBounds(mesh.vertices, header.bounds, header.radius);
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(mesh.vertices[0]));
+    out.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(mesh.indices[0]));
+    if (meshlets){
+        meshlets->Serialize(out);
+    }
+}
+
+/**
+ Header for a LOD chain, which rvemc writes as {name}.rvelod next to {name}.rvem. It is followed by numLods
+ SerializedMeshLodEntry ordered from most to least detailed, then an rvem mesh for each entry. The base mesh is not
+ part of the chain. Meshes start on a multiple of dataAlignment, so they can be read in place.
+ */
+struct SerializedMeshLodHeader{
+    constexpr static uint32_t currentVersion = 1;
+    constexpr static uint32_t dataAlignment = 16;
+    const std::array<char, 4> header = {'r','v','l','d'};
+    uint32_t version = currentVersion;
+    uint32_t numLods = 0;
+    uint32_t padding = 0;
+};
+
+struct SerializedMeshLodEntry{
+    uint64_t dataOffset = 0;    // from the start of the chain
+    uint64_t dataSize = 0;
+    float minDistance = 0;      // the distance from the camera at which this LOD replaces the previous one
+    float error = 0;            // world-space simplification error
+};
+
+/**
+ Collects simplified meshes and writes them as a LOD chain. Used by rvemc.
+ */
+struct MeshLodChainBuilder{
+    struct Lod{
+        MeshPart mesh;
+        float minDistance = 0;
+        float error = 0;
+    };
+    std::vector<Lod> lods;
+
+    /**
+     @param serialize writes one mesh of the chain, so that the chain can be compressed like the base mesh
+     */
+    void Write(std::ostream& out, const std::function<void(std::ostream&, const MeshPart&)>& serialize = [](std::ostream& out, const MeshPart& mesh){ SerializeMesh(out, mesh); }) const{
+        SerializedMeshLodHeader header;
+        header.numLods = uint32_t(lods.size());
+        std::vector<SerializedMeshLodEntry> entries(lods.size());
+        std::vector<std::string> meshes(lods.size());
+
+        auto align = [](uint64_t offset){
+            return (offset + SerializedMeshLodHeader::dataAlignment - 1) / SerializedMeshLodHeader::dataAlignment * SerializedMeshLodHeader::dataAlignment;
+        };
+        uint64_t offset = align(sizeof(header) + sizeof(SerializedMeshLodEntry) * entries.size());
+        for(size_t i = 0; i < lods.size(); i++){
+            std::ostringstream mesh;
+            serialize(mesh, lods[i].mesh);
+            meshes[i] = std::move(mesh).str();
+            entries[i] = {offset, meshes[i].size(), lods[i].minDistance, lods[i].error};
+            offset = align(offset + meshes[i].size());
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), sizeof(SerializedMeshLodEntry) * entries.size());
+        uint64_t written = sizeof(header) + sizeof(SerializedMeshLodEntry) * entries.size();
+        for(size_t i = 0; i < lods.size(); i++){
+            const std::string padding(entries[i].dataOffset - written, 0);
+            out.write(padding.data(), padding.size());
+            out.write(meshes[i].data(), meshes[i].size());
+            written = entries[i].dataOffset + meshes[i].size();
+        }
+    }
+};
+
 
 }
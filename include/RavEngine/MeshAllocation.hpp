@@ -1,10 +1,10 @@
 #pragma once
-#include "DataStructures.hpp"
+#include "OffsetAllocator.hpp"
 namespace RavEngine {
-	using allocation_freelist_t = LinkedList<Range>;
-	using allocation_allocatedlist_t = allocation_freelist_t;
-
+	/**
+	* Where a mesh lives in the shared vertex and index buffers. Offsets are in vertices and indices, not bytes.
+	*/
 	struct MeshRange {
-		allocation_allocatedlist_t::iterator vertRange, indexRange;
+		OffsetAllocator::Allocation vertRange, indexRange;
 	};
 }
\ No newline at end of file
@@ -53,12 +53,37 @@ protected:
 	 */
 	void InitializeFromRawMesh(const MeshPart& mp, const MeshAssetOptions& options = MeshAssetOptions());
     void InitializeFromRawMeshView(const MeshPartView& mp, const MeshAssetOptions& options = MeshAssetOptions());
+
+	/**
+	 Initialize from deserialized mesh data, using the bounds stored in its header
+	 @param mp the mesh to initialize from, which may point into a file view
+	 @param header the header of the serialized mesh
+	 */
+	void InitializeFromSerializedMesh(const MeshPartView& mp, const SerializedMeshDataHeader& header, const MeshAssetOptions& options);
+
+	/**
+	 Initialize from a complete serialized mesh, including its meshlets
+	 */
+	void InitializeFromSerialized(const std::span<const uint8_t> serialized, const MeshAssetOptions& options);
 	
 	// optionally stores a copy of the mesh in system memory
 	MeshPart systemRAMcopy;
 
-	MeshPart DeserializeMesh(const std::istream& stream);
-	std::pair<MeshPart,uint32_t> DeserializeMeshFromMemory(const std::span<uint8_t> mem);
+	// clusters for culling parts of the mesh, if rvemc generated them
+	MeshletData meshlets;
+
+	/**
+	 Read a serialized mesh from a stream, with one read each for the vertices and the indices
+	 @param header set to the header of the mesh
+	 */
+	static MeshPart DeserializeMesh(std::istream& stream, SerializedMeshDataHeader& header);
+
+	/**
+	 Read a serialized mesh. Uncompressed meshes are read in place, so the returned view is only valid while mem is.
+	 @param header set to the header of the mesh
+	 @param decoded holds the mesh if it is compressed, and the returned view points into it instead
+	 */
+	static MeshPartView DeserializeMeshFromMemory(const std::span<const uint8_t> mem, SerializedMeshDataHeader& header, MeshPart& decoded);
 
     friend class RenderEngine;
 	
@@ -85,6 +110,24 @@ public:
 	
 	MeshAsset(const Filesystem::Path& pathOnDisk, const MeshAssetOptions& options = MeshAssetOptions());
 
+	/**
+	 Create a MeshAsset from data in the rvem format
+	 @param serialized the mesh data, which is not referenced after construction
+	 */
+	MeshAsset(const std::span<const uint8_t> serialized, const MeshAssetOptions& options = MeshAssetOptions());
+
+	struct Lod {
+		Ref<MeshAsset> mesh;
+		float minDistance = 0;
+	};
+
+	/**
+	 Load a LOD chain generated by rvemc
+	 @param data the contents of a .rvelod file
+	 @return the LODs that follow the base mesh, from most to least detailed
+	 */
+	static RavEngine::Vector<Lod> DeserializeLods(const std::span<const uint8_t> data, const MeshAssetOptions& options = MeshAssetOptions());
+
 	/**
 	 Create a MeshAsset from multiple vertex and index lists
 	 @param rawMeshData the index and triangle data
@@ -123,6 +166,10 @@ public:
     constexpr inline decltype(systemRAMcopy)& GetSystemCopy(){
 		return systemRAMcopy;
 	}
+
+	const MeshletData& GetMeshlets() const{
+		return meshlets;
+	}
 	
     inline bool hasSystemRAMCopy() const{
         return systemRAMcopy.vertices.size() > 0;
@@ -27,7 +27,10 @@ namespace RavEngine {
 		MeshCollectionStatic(std::span<Entry> meshes);
 		MeshCollectionStatic(std::initializer_list<Entry> meshes);
 		MeshCollectionStatic(Ref<MeshAsset> mesh);
-		MeshCollectionStatic(const std::string& meshName, const MeshAssetOptions& opt = {}) : MeshCollectionStatic(MeshAsset::Manager::Get(meshName, opt)) {}
+		/**
+		 Load a mesh by name. If rvemc generated a LOD chain for it, the LODs are loaded too, with their distances.
+		 */
+		MeshCollectionStatic(const std::string& meshName, const MeshAssetOptions& opt = {});
 
 		void AddMesh(const Entry& m);
 
@@ -0,0 +1,83 @@
+#pragma once
+#include "Vector.hpp"
+#include "CullingVolume.hpp"
+#include <glm/mat4x4.hpp>
+#include <cstdint>
+#include <span>
+#include <ostream>
+
+namespace RavEngine{
+
+/**
+ A cluster of triangles in a mesh, with bounds for culling it on its own. Generated by rvemc.
+ */
+struct Meshlet{
+    uint32_t vertexOffset = 0;      // into MeshletData::vertices
+    uint32_t triangleOffset = 0;    // into MeshletData::triangles
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+
+    // bounding sphere, in the space of the mesh
+    float center[3]{0,0,0};
+    float radius = 0;
+
+    // normal cone. The meshlet faces away from any viewer inside the cone.
+    float coneApex[3]{0,0,0};
+    float coneAxis[3]{0,0,0};
+    float coneCutoff = 1;           // cos(angle / 2), or 1 if the cone is degenerate and the meshlet cannot be backface culled
+};
+
+/**
+ Header for the meshlet block of a mesh. It is followed by numMeshlets Meshlet, then numVertices uint32_t
+ indexing the mesh's vertices, then numTriangleBytes uint8_t, three per triangle, indexing each meshlet's vertices.
+ */
+struct SerializedMeshletHeader{
+    uint32_t numMeshlets = 0;
+    uint32_t numVertices = 0;
+    uint32_t numTriangleBytes = 0;
+    uint32_t padding = 0;
+};
+
+struct MeshletData{
+    Vector<Meshlet> meshlets;
+    Vector<uint32_t> vertices;
+    Vector<uint8_t> triangles;
+
+    /**
+     @return the size of the serialized block, which keeps data after it 4-byte aligned
+     */
+    size_t SerializedSize() const{
+        return sizeof(SerializedMeshletHeader) + meshlets.size() * sizeof(Meshlet) + vertices.size() * sizeof(uint32_t) + (triangles.size() + 3) / 4 * 4;
+    }
+
+    void Serialize(std::ostream& out) const{
+        SerializedMeshletHeader header{
+            .numMeshlets = uint32_t(meshlets.size()),
+            .numVertices = uint32_t(vertices.size()),
+            .numTriangleBytes = uint32_t(triangles.size()),
+        };
+        const char padding[4]{};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(meshlets.data()), meshlets.size() * sizeof(Meshlet));
+        out.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(triangles.data()), triangles.size());
+        out.write(padding, (4 - triangles.size() % 4) % 4);
+    }
+
+    /**
+     Read a block written by Serialize. Fatal if the block is truncated.
+     */
+    static MeshletData Deserialize(std::span<const uint8_t> block);
+};
+
+/**
+ Find the meshlets of a mesh that may be visible to a camera
+ @param meshlets the meshlets to test
+ @param model the transform of the mesh
+ @param frustum the camera frustum, in world space
+ @param cameraPosition the camera position, in world space
+ @param visible receives the indices of meshlets that pass both the frustum test and the backface cone test
+ */
+void CullMeshlets(std::span<const Meshlet> meshlets, const glm::mat4& model, const Frustum& frustum, const glm::vec3& cameraPosition, Vector<uint32_t>& visible);
+
+}
@@ -2,22 +2,36 @@
 #include "Queryable.hpp"
 #include "IDebugRenderable.hpp"
 #include "Vector.hpp"
+#include "Function.hpp"
+#include "Array.hpp"
+#include <memory>
+#include <atomic>
+#include <span>
+#include <string>
 
 class dtNavMesh;
 class dtNavMeshQuery;
 
 namespace RavEngine{
 
-    class NavMeshComponent : public IDebugRenderable, public Queryable<NavMeshComponent,IDebugRenderable>{
-    private:
-        dtNavMesh* navMesh = nullptr;
-        dtNavMeshQuery* navMeshQuery = nullptr;
-        unsigned char* navData = nullptr;
-        Bounds bounds;
-        mutable SpinLock mtx;
+    class MeshAsset;
 
+    /**
+     A navigation mesh split into square tiles, built with the Recast/Detour tile cache.
+     Tiles are rasterized in parallel on the App executor, and dynamic obstacles or geometry
+     changes only rebuild the tiles they touch. Rebuilds run in the background, and queries
+     keep using the previous navmesh until a rebuild is swapped in.
+     Path queries only take a shared lock and use one dtNavMeshQuery per worker thread, so
+     any number of them can run at once.
+     */
+    class NavMeshComponent : public IDebugRenderable, public Queryable<NavMeshComponent,IDebugRenderable>{
+        struct Data;
+        struct Shared;
+        friend class CrowdComponent;
     public:
 		using Queryable<NavMeshComponent,IDebugRenderable>::GetQueryTypes;
+        using ObstacleID = uint32_t;
+
         struct Options{
             float cellSize = 0.3f;
             float cellHeight = 0.2f;
@@ -26,32 +40,106 @@ namespace RavEngine{
             float maxVertsPerPoly = 6.f;
             float detailSampleDist = 6.f;
             float detailSampleMaxError = 1.f;
-            
+
             struct Agent{
                 float height = 2.0f;
                 float radius = 0.6f;
                 float maxClimb = 0.9f;
                 float maxSlope = 45.f;
             } agent;
-           
+
             float regionMinDimension = 8.f;
             float regionMergeDimension = 20.f;
-            
-            enum PartitionMethod{
-                Watershed,  // best but slowest
-                Monotone,   // worst but fastest
-                Layer       // compromise, good for tiled w/ small-medium tiles
-            } partitionMethod = Watershed;
-            
+
+            uint16_t tileSize = 48;         // width and depth of a tile, in cells
+            uint16_t maxLayersPerTile = 8;  // walkable surfaces stacked within one tile, such as floors of a building
+            uint16_t maxObstacles = 128;
         };
-        
+
         /**
-         Construct a mesh asset 
+         Build a navmesh for a mesh. Blocks until the navmesh is ready.
+         @param mesh the walkable geometry, created with keepInSystemRAM = true
+         @param opt build settings
          */
         NavMeshComponent(Ref<MeshAsset> mesh, Options opt);
-        
+
+        /**
+         Load a navmesh made with Bake. Its tiles are read as they were baked, without building anything from geometry.
+         @param name the name of the navmesh in the navmeshes folder of the VFS, without the .rvenm extension
+         */
+        NavMeshComponent(const std::string& name);
+
+        /**
+         Load a navmesh made with Bake
+         @param baked the data returned by Bake
+         */
+        NavMeshComponent(std::span<const uint8_t> baked);
+
+        /**
+         Serialize the navmesh that queries currently use, to be loaded later without building it from geometry.
+         Pending obstacle changes are applied first. Obstacles are not baked, so if any exist, only the tile cache layers
+         are baked and the navmesh tiles are built from them on load.
+         @return the baked navmesh, as described by SerializedNavMeshHeader
+         */
+        RavEngine::Vector<uint8_t> Bake();
+
+        /**
+         Rebuild the entire navmesh in the background. Queries use the previous navmesh until the rebuild finishes.
+         Obstacles are carried over to the new navmesh.
+         @param mesh the walkable geometry, created with keepInSystemRAM = true
+         @param opt build settings
+         */
         void UpdateNavMesh(Ref<MeshAsset> mesh, Options opt);
-        
+
+        /**
+         Rebuild only the tiles that overlap a changed region, in the background. If the geometry
+         no longer fits in the existing tile grid, this falls back to UpdateNavMesh.
+         @param mesh the complete new walkable geometry, created with keepInSystemRAM = true
+         @param changed the region that changed, in local coordinates to the owning entity
+         */
+        void UpdateGeometry(Ref<MeshAsset> mesh, const Bounds& changed);
+
+        /**
+         @return true if a background rebuild has not yet been swapped in
+         */
+        bool IsBuilding() const;
+
+        /**
+         Block until all background rebuilds have been swapped in. On an executor worker, this runs other tasks while it waits.
+         */
+        void WaitForBuild() const;
+
+        /**
+         Add an upright cylinder obstacle. Affected tiles are rebuilt by UpdateObstacles.
+         An obstacle only carves the first 8 tiles it overlaps, so keep obstacles smaller than a few tiles.
+         @param base the bottom center of the cylinder, in local coordinates
+         @return an ID to remove the obstacle with, which stays valid across rebuilds
+         */
+        ObstacleID AddCylinderObstacle(const vector3& base, float radius, float height);
+
+        /**
+         Add a box obstacle. Affected tiles are rebuilt by UpdateObstacles.
+         @param center the center of the box, in local coordinates
+         @param halfExtents half of the size of the box on each axis
+         @param yaw rotation of the box about the Y axis, in radians
+         @return an ID to remove the obstacle with, which stays valid across rebuilds
+         */
+        ObstacleID AddBoxObstacle(const vector3& center, const vector3& halfExtents, float yaw = 0);
+
+        void RemoveObstacle(ObstacleID id);
+
+        /**
+         Rebuild tiles touched by obstacle changes. Called by NavMeshSystem every tick.
+         @param maxTileRebuilds the most tiles to rebuild in this call
+         @return true if every obstacle change has been applied
+         */
+        bool UpdateObstacles(uint32_t maxTileRebuilds = std::numeric_limits<uint32_t>::max());
+
+        /**
+         @return the number of navmesh tiles that contain walkable polygons
+         */
+        uint32_t GetNumTiles() const;
+
         /**
          Calculate a route between two points
          @param start the start location of the path, in local coordinates to the owning entity
@@ -59,9 +147,118 @@ namespace RavEngine{
          @return list of coordinates composing the path
          */
         RavEngine::Vector<vector3> CalculatePath(const vector3& start, const vector3& end, uint16_t maxPoints = std::numeric_limits<uint16_t>::max());
-        
+
         void DebugDraw(class RavEngine::DebugDrawer& dbg, const struct RavEngine::Transform& tr) const override;
-                
-        virtual ~NavMeshComponent();
+
+        struct PathRequest{
+            vector3 start, end;                 // in local coordinates to the owning entity
+            vector3 searchExtents{2, 4, 2};     // how far from start and end to look for the navmesh, on each axis
+            uint16_t maxPoints = 256;
+        };
+
+        struct PathResult{
+            enum class Status : uint8_t{
+                Pending,
+                Complete,
+                Partial,    // end is unreachable, so the path leads to the closest reachable point
+                NoStart,    // no navmesh within searchExtents of start
+                NoEnd,      // no navmesh within searchExtents of end
+                Failed
+            } status = Status::Pending;
+            RavEngine::Vector<vector3> points;
+        };
+
+        /**
+         A set of paths resolved in parallel on the App executor
+         */
+        struct PathBatch{
+            RavEngine::Vector<PathRequest> requests;
+            RavEngine::Vector<PathResult> results;  // same order as requests, valid once IsDone
+
+            inline bool IsDone() const{
+                return done.load(std::memory_order_acquire);
+            }
+
+            /**
+             Block until every path is resolved. Do not call from an executor worker.
+             */
+            inline void Wait() const{
+                done.wait(false, std::memory_order_acquire);
+            }
+        private:
+            friend class NavMeshComponent;
+            std::atomic<bool> done = false;
+        };
+
+        /**
+         A path search that runs a limited number of iterations at a time, to spread long searches over several ticks
+         */
+        class SlicedPath{
+        public:
+            /**
+             Continue searching
+             @param maxIterations the most nodes to visit in this call
+             @return true once the search has finished
+             */
+            bool Update(uint32_t maxIterations);
+
+            inline bool IsDone() const{
+                return result.status != PathResult::Status::Pending;
+            }
+
+            inline const PathResult& GetResult() const{
+                return result;
+            }
+
+            ~SlicedPath();
+        private:
+            friend class NavMeshComponent;
+            SlicedPath(const std::shared_ptr<Shared>& shared, const PathRequest& request) : shared(shared), request(request){}
+            bool Finish(uint32_t status);
+
+            std::shared_ptr<Shared> shared;
+            std::shared_ptr<Data> data;  // the navmesh the search started on, restarted if a rebuild replaces it
+            dtNavMeshQuery* query = nullptr;
+            PathRequest request;
+            PathResult result;
+            float startPos[3], endPos[3];
+        };
+
+        /**
+         Resolve many paths in parallel on the App executor
+         @param requests the paths to find
+         @return a batch that holds the results once it is done
+         */
+        Ref<PathBatch> RequestPaths(RavEngine::Vector<PathRequest> requests);
+
+        /**
+         Start a path search that is advanced with SlicedPath::Update
+         */
+        Ref<SlicedPath> BeginSlicedPath(const PathRequest& request);
+
+    private:
+        /**
+         Invoke a function while holding shared access to the current navmesh, for crowds that steer agents over it
+         @param fn receives the navmesh, and a handle that keeps it alive after a rebuild replaces it
+         */
+        static void ReadNavMesh(Shared& shared, const Function<void(dtNavMesh*, const std::shared_ptr<void>&)>& fn);
+
+        // shared so that background builds can outlive a moved or destroyed component
+        std::shared_ptr<Shared> shared;
+    };
+
+    /**
+     Header for a baked navmesh. It is followed by numLayers Detour tile cache layers, then numTiles Detour navmesh tiles.
+     Each is a uint32_t size followed by that many bytes of tile data.
+     */
+    struct SerializedNavMeshHeader{
+        constexpr static uint32_t currentVersion = 1;
+        const Array<char, 4> header = { 'r','v','n','m' };
+        uint32_t version = currentVersion;
+        NavMeshComponent::Options options;
+        float bmin[3]{}, bmax[3]{};
+        uint32_t tilesX = 0, tilesZ = 0;
+        uint32_t numLayers = 0;
+        uint32_t numTiles = 0;
     };
 }
@@ -0,0 +1,14 @@
+#pragma once
+#include "NavMeshComponent.hpp"
+#include "CTTI.hpp"
+
+namespace RavEngine {
+	class NavMeshSystem : public AutoCTTI{
+	public:
+		uint32_t maxTileRebuildsPerTick = 4;	// spreads the cost of many obstacle changes over several ticks
+
+		inline void operator()(NavMeshComponent& navMesh) const{
+			navMesh.UpdateObstacles(maxTileRebuildsPerTick);
+		}
+	};
+}
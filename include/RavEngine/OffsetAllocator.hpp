@@ -0,0 +1,106 @@
+#pragma once
+#include "Vector.hpp"
+#include "Array.hpp"
+#include <cstdint>
+
+namespace RavEngine{
+
+/**
+ Manages ranges of an externally owned buffer, such as the shared vertex and index buffers. It only hands out offsets and
+ never touches the memory itself, so it can be used and tested without a GPU. Units are up to the caller.
+
+ Free ranges are sorted into 256 bins by size, using a small floating point representation (5 bits of exponent,
+ 3 of mantissa), and a two-level bitmask records which bins are non-empty. Allocate and Free are O(1): finding a bin is a
+ pair of bit scans, and freed ranges are merged with their neighbors through a linked list of ranges in offset order.
+ The cost of constant time placement is that a free range less than 1/8th larger than a request may be passed over.
+ */
+class OffsetAllocator{
+public:
+    constexpr static uint32_t NoSpace = 0xffffffff;
+
+    struct Allocation{
+        uint32_t offset = NoSpace;
+        uint32_t metadata = NoSpace;    // node index, used by Free
+
+        bool IsValid() const{
+            return offset != NoSpace;
+        }
+    };
+
+    struct StorageReport{
+        uint32_t totalFree = 0;
+        uint32_t largestFree = 0;
+    };
+
+    OffsetAllocator(uint32_t size);
+
+    /**
+     @param size number of units to allocate
+     @return the placement, or an invalid allocation if no free range is large enough
+     */
+    Allocation Allocate(uint32_t size);
+
+    /**
+     Return an allocation to the allocator. Adjacent free ranges are merged.
+     */
+    void Free(Allocation allocation);
+
+    /**
+     Extend the managed range, for after the underlying buffer has been resized. Existing allocations keep their offsets.
+     */
+    void Grow(uint32_t newSize);
+
+    /**
+     @return the size of a completed allocation
+     */
+    uint32_t AllocationSize(Allocation allocation) const;
+
+    StorageReport GetStorageReport() const;
+
+    /**
+     A defragmentation hint, from 0 when all free space is one range, to nearly 1 when it is scattered into many small
+     ranges. Allocations may fail while this is high even though enough space is free in total.
+     */
+    float GetFragmentation() const;
+
+    uint32_t GetSize() const{
+        return size;
+    }
+
+    /**
+     @return the smallest free range that Allocate(size) is guaranteed to find. Allocate rounds requests up to a bin
+     size, so growing by exactly the requested size may not be enough.
+     */
+    static uint32_t SizeRoundedUpToBin(uint32_t size);
+
+private:
+    constexpr static uint32_t NumTopBins = 32, BinsPerLeaf = 8, NumLeafBins = NumTopBins * BinsPerLeaf;
+    constexpr static uint32_t Unused = 0xffffffff;
+
+    struct Node{
+        uint32_t dataOffset = 0;
+        uint32_t dataSize = 0;
+        uint32_t binListPrev = Unused;
+        uint32_t binListNext = Unused;
+        uint32_t neighborPrev = Unused;
+        uint32_t neighborNext = Unused;
+        bool used = false;
+    };
+
+    uint32_t InsertNodeIntoBin(uint32_t size, uint32_t dataOffset);
+    void RemoveNodeFromBin(uint32_t nodeIndex);
+    uint32_t AllocateNode();
+
+    uint32_t size = 0;
+    uint32_t freeStorage = 0;
+    uint32_t tail = Unused;         // the node at the end of the buffer, which Grow extends
+
+    uint32_t usedBinsTop = 0;
+    Array<uint8_t, NumTopBins> usedBins{};
+    Array<uint32_t, NumLeafBins> binIndices;
+
+    Vector<Node> nodes;
+    Vector<uint32_t> freeNodes;
+};
+
+}
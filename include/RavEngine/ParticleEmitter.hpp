@@ -127,7 +127,8 @@ namespace RavEngine {
 
 		// this is icky and nasty, we need a better solution than this
 		struct RenderState {
-			uint32_t maxTotalParticlesOffset = 0;
+			RGLBufferPtr engineDataBuffer;	// transient, written each frame
+			uint32_t engineDataOffset = 0;
 		} renderState;
 
 		bool emittingThisFrame : 1 = false;
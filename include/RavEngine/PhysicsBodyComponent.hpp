@@ -260,6 +260,11 @@ public Queryable<PhysicsBodyComponent
 		*/
 		bool IsSleeping() const;
 		
+		/**
+		@return true if the body is kinematic, and is moved with SetKinematicTarget instead of by the simulation
+		*/
+		bool IsKinematic() const;
+		
 		enum AxisLock{
 			Linear_X = (1 << 0),
 			Linear_Y = (1 << 1),
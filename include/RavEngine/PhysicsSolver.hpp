@@ -15,6 +15,7 @@
 #include <PxPhysicsAPI.h>
 #include <PxFiltering.h>
 #include <cstdint>
+#include <span>
 #include "Types.hpp"
 #include "Entity.hpp"
 
@@ -101,6 +102,20 @@ namespace RavEngine {
         */
         bool Raycast(const vector3& origin, const vector3& direction, decimalType maxDistance, RaycastHit& out_hit);
 
+        struct RaycastQuery {
+            vector3 origin{};
+            vector3 direction{};
+            decimalType maxDistance{};
+            const physx::PxRigidActor* ignoredActor = nullptr;    // hits on this actor are skipped, such as the caster's own collider
+        };
+
+        /**
+        Perform many raycasts at once, taking the scene lock once for the whole batch
+        @param queries the rays to cast
+        @param out_hits the results, one per query
+        */
+        void Raycast(std::span<const RaycastQuery> queries, std::span<RaycastHit> out_hits);
+
 
         struct OverlapHit {
             OverlapHit() {}
@@ -19,6 +19,7 @@
 #include <span>
 #include "SpinLock.hpp"
 #include "MeshAllocation.hpp"
+#include "TransientRingAllocator.hpp"
 #include "RenderTargetCollection.hpp"
 #include "PostProcess.hpp"
 #include <unordered_set>
@@ -282,24 +283,33 @@ namespace RavEngine {
 		matrix4 make_gui_matrix(Rml::Vector2f translation);
 
 		constexpr static uint32_t transientSizeBytes = 65536;
-		RGLBufferPtr transientBuffer, transientStagingBuffer;
-		uint32_t transientOffset = 0;
+		struct TransientPage {
+			RGLBufferPtr buffer, stagingBuffer;
+		};
+		Vector<TransientPage> transientPages;	// indexed by TransientRingAllocator page, so the ring comes first
+		TransientRingAllocator transientAllocator{ transientSizeBytes, 16 };	// Metal and Vulkan require that buffer offsets be multiples of 16
+		uint64_t lastTransientFrame = 0;
+
+		struct TransientAllocation {
+			RGLBufferPtr buffer;
+			uint32_t offset = 0;
+		};
 		
 		/**
 		* Add data to the transient buffer.
-		* The transient buffer is reset every frame. 
-		* @return the offset in bytes to the transient buffer
+		* The data stays valid until the frame it was written in has finished on the GPU.
+		* @return the buffer holding the data, which is an overflow page if the ring is full, and the offset in bytes to the data
 		*/
-		uint32_t WriteTransient(RGL::untyped_span data);
+		TransientAllocation WriteTransient(RGL::untyped_span data);
+		TransientPage CreateTransientPage(uint32_t size);
 
-		allocation_freelist_t vertexFreeList{ 1, Range{.start = 0, .count = initialVerts}};
-		allocation_freelist_t indexFreeList{ 1, Range{.start = 0, .count = initialIndices}};
-		allocation_allocatedlist_t vertexAllocatedList, indexAllocatedList;
-		uint32_t currentVertexSize = initialVerts, currentIndexSize = initialIndices;
+		// placement in the shared buffers, in vertices and indices
+		OffsetAllocator vertexAllocator{ initialVerts }, indexAllocator{ initialIndices };
+		uint32_t currentVertexSize = 0, currentIndexSize = 0;
 		
 		void ReallocateVertexAllocationToSize(uint32_t newSize);
 		void ReallocateIndexAllocationToSize(uint32_t newSize);
-		void ReallocateGeneric(RGLBufferPtr& reallocBuffer, uint32_t& reallocBufferSize, uint32_t newSize, allocation_allocatedlist_t& allocatedList, allocation_freelist_t& freelist, uint32_t stride, RGL::BufferConfig::Type bufferType, const char* debugName = nullptr);
+		void ReallocateGeneric(RGLBufferPtr& reallocBuffer, uint32_t& reallocBufferSize, uint32_t newSize, OffsetAllocator& allocator, uint32_t stride, RGL::BufferConfig::Type bufferType, const char* debugName = nullptr);
 
 		SpinLock allocationLock;
 
@@ -1,6 +1,8 @@
 #pragma once
 #include <ozz/animation/runtime/skeleton.h>
 #include <ozz/animation/offline/skeleton_builder.h>
+#include <ozz/base/maths/simd_math.h>
+#include <ozz/base/containers/vector.h>
 #include <string>
 #include "Vector.hpp"
 #include "mathtypes.hpp"
@@ -17,8 +19,15 @@ class SkeletonAsset{
 #endif
 
     RavEngine::Vector<glm::mat4> bindposes;
+	ozz::vector<ozz::math::Float4x4> inverseBindposesSIMD;
 public:
 	SkeletonAsset(const std::string& path);
+	
+	/**
+	 Create a skeleton from an in-memory hierarchy, for rigs built at runtime
+	 @param raw_skeleton the joint hierarchy and rest poses
+	 */
+	SkeletonAsset(const ozz::animation::offline::RawSkeleton& raw_skeleton);
 	~SkeletonAsset();
 	
 	
@@ -40,10 +49,17 @@ public:
 	/**
 	 @return bindposes for use in software
 	 */
-    inline const auto GetBindposes() const{
+    inline const auto& GetBindposes() const{
 		return bindposes;
 	}
 	
+	/**
+	 @return inverse bindposes in ozz's SIMD layout, for CPU skinning matrix generation
+	 */
+	inline const auto& GetInverseBindposesSIMD() const{
+		return inverseBindposesSIMD;
+	}
+	
 #if !RVE_SERVER
 	/**
 	 @return the bone hierarchy information. This is a linear buffer where each bone is represented by one entry in the buffer.
@@ -59,5 +75,11 @@ public:
 	 @return True if the skeleton has a bone by the name, false if not
 	 */
 	bool HasBone(const std::string& boneName) const;
+	
+	/**
+	 @param boneName name of the bone to find
+	 @return the joint index of the bone, or -1 if the skeleton has no bone by the name
+	 */
+	int FindBone(const std::string& boneName) const;
 };
 }
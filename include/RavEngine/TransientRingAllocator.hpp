@@ -0,0 +1,97 @@
+#pragma once
+#include "Vector.hpp"
+#include "Queue.hpp"
+#include <cstdint>
+
+namespace RavEngine{
+
+/**
+ Places per-frame data, such as uniforms and light lists, in a ring buffer that several frames in flight share.
+ Like OffsetAllocator it only hands out offsets, so it can be tested without a GPU.
+
+ Each frame's allocations follow the previous frame's. Space is reclaimed when the caller reports that a frame has
+ finished on the GPU. If the ring is full of frames still in flight, allocations spill into overflow pages instead of
+ failing. Overflow pages are kept and reused once the frames that wrote to them have finished.
+ */
+class TransientRingAllocator{
+public:
+    constexpr static uint32_t RingPage = 0;
+
+    struct Allocation{
+        uint32_t page = RingPage;   // RingPage, or an overflow page
+        uint32_t offset = 0;        // in bytes, from the start of the page
+    };
+
+    /**
+     @param capacity size of the ring in bytes, a multiple of alignment
+     @param alignment every allocation starts on a multiple of this
+     @param overflowPageSize the minimum size of an overflow page
+     */
+    TransientRingAllocator(uint32_t capacity, uint32_t alignment = 16, uint32_t overflowPageSize = 0);
+
+    Allocation Allocate(uint32_t size);
+
+    /**
+     Close the current frame. Allocations made since the previous call belong to the returned frame.
+     */
+    uint64_t EndFrame();
+
+    /**
+     Reclaim the space of a frame, and every frame before it, once the GPU is done with them
+     */
+    void CompleteFrame(uint64_t frame);
+
+    /**
+     @return the number of pages, including the ring. Pages are never removed, so new ones are always at the end.
+     */
+    uint32_t GetNumPages() const{
+        return uint32_t(overflowPages.size()) + 1;
+    }
+
+    uint32_t GetPageSize(uint32_t page) const{
+        return page == RingPage ? capacity : overflowPages[page - 1].size;
+    }
+
+    /**
+     @return the number of ring bytes held by frames that have not completed, including the current frame
+     */
+    uint32_t GetRingBytesInUse() const{
+        return uint32_t(head - tail);
+    }
+
+    /**
+     @return the number of bytes that spilled into overflow pages in the current frame. If this is regularly
+     nonzero, the ring is too small for the workload.
+     */
+    uint32_t GetOverflowBytes() const{
+        return overflowBytes;
+    }
+
+private:
+    struct OverflowPage{
+        uint32_t size = 0;
+        uint32_t used = 0;
+        uint64_t lastFrame = 0;     // the last frame that wrote to this page
+        bool inFlight = false;
+    };
+
+    struct FrameRecord{
+        uint64_t frame;
+        uint64_t end;               // ring position after the frame's last allocation
+    };
+
+    Allocation AllocateOverflow(uint32_t size);
+
+    uint32_t capacity, alignment, overflowPageSize;
+
+    // positions increase forever, and wrap into the ring by modulo, so the ring is never ambiguously full or empty
+    uint64_t head = 0, tail = 0;
+    uint64_t currentFrame = 1;
+    Queue<FrameRecord> framesInFlight;
+
+    Vector<OverflowPage> overflowPages;
+    uint32_t currentOverflowPage = 0;   // 0 if this frame has not overflowed yet
+    uint32_t overflowBytes = 0;
+};
+
+}
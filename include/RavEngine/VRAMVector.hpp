@@ -115,6 +115,10 @@ namespace RavEngine {
 			return static_cast<T*>(buffer->GetMappedDataPtr());
 		}
 
+		auto data() const {
+			return static_cast<const T*>(buffer->GetMappedDataPtr());
+		}
+
 		auto size() const {
 			return nValues;
 		}
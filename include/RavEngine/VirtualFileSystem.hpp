@@ -6,10 +6,46 @@
 #include "Utilities.hpp"
 #include "Debug.hpp"
 #include <span>
+#include <memory>
+#include <cstring>
 
 struct PHYSFS_File;
 
 namespace RavEngine{
+class AssetPack;
+
+/**
+ Data for one file. It is either a view into a memory-mapped asset pack, or a copy read out of the archive.
+ */
+class FileView{
+    RavEngine::Vector<uint8_t> owned;
+    std::span<const uint8_t> view;
+    friend class VirtualFilesystem;
+public:
+    FileView() = default;
+    FileView(const FileView&) = delete;
+    FileView(FileView&&) = default;
+    const uint8_t* data() const{
+        return view.data();
+    }
+    size_t size() const{
+        return view.size();
+    }
+    std::span<const uint8_t> span() const{
+        return view;
+    }
+    /**
+     @return true if the data is read in place from a memory-mapped pack, and stays valid for the lifetime of the VFS
+     */
+    bool IsMapped() const{
+        return owned.empty() && view.data() != nullptr;
+    }
+};
+
+/**
+ Reads the app's resources. If a memory-mapped asset pack (.rvepack) is next to the executable it is used,
+ otherwise resources come from the PhysFS archive (.rvedata).
+ */
 class VirtualFilesystem {
 private:
     struct ptrsize{
@@ -22,8 +58,16 @@ private:
     void close(PHYSFS_File* file);
     
     size_t ReadInto(PHYSFS_File*, void* data, size_t size);
+
+    /**
+     @return the file in the mapped pack. Fatal if it does not exist.
+     */
+    std::span<const uint8_t> MappedFileAt(const char* fullpath) const;
+
+    std::unique_ptr<AssetPack> pack;    // null when resources come from the archive
 public:
 	VirtualFilesystem();
+	~VirtualFilesystem();
 
 	/**
 	 Get the file data as a string
@@ -49,6 +93,16 @@ public:
     void FileContentsAt(const char* path, vec& datavec, bool nullTerminate = true){
         auto fullpath = Format("{}/{}",rootname,path);
         
+        if (pack){
+            auto mapped = MappedFileAt(fullpath.c_str());
+            datavec.resize(mapped.size() + (nullTerminate ? 1 : 0));
+            std::memcpy(datavec.data(), mapped.data(), mapped.size());
+            if (nullTerminate){
+                datavec.data()[mapped.size()] = '\0';
+            }
+            return;
+        }
+
         if(!Exists(path)){
             Debug::Fatal("cannot open {}",fullpath);
         }
@@ -66,6 +120,13 @@ public:
         close(ptrsize.ptr);
     }
 
+	/**
+	 Get the file data without copying it when possible. Prefer this over FileContentsAt for data that is only parsed.
+	 @param path the resources path to the asset
+	 @return a view into the memory-mapped pack, or a copy of the file if resources come from the archive. Not null terminated.
+	 */
+	FileView FileViewAt(const char* path);
+
 	/**
 	 @return true if the VFS has the file at the path
 	 */
@@ -19,6 +19,7 @@
     #include "VRAMSparseSet.hpp"
     #include "BuiltinMaterials.hpp"
     #include "Light.hpp"
+    #include "DynamicBVH.hpp"
 #else
     #include "Ref.hpp"
 #endif
@@ -28,6 +29,7 @@
 #include "Format.hpp"
 #include "Queue.hpp"
 #include "Layer.hpp"
+#include "mathtypes.hpp"
 
 namespace RavEngine {
 	struct Entity;
@@ -49,6 +51,8 @@ namespace RavEngine {
     struct AudioMeshComponent;
     struct MeshCollectionStatic;
     struct MeshCollectionSkinned;
+    class AnimatorSystem;
+    class AnimationPoseCache;
 
     template <typename T, typename... Ts>
     struct Index;
@@ -96,6 +100,7 @@ namespace RavEngine {
 		friend class AudioPlayer;
 		friend class App;
         friend class PhysicsBodyComponent;
+        friend class AnimatorSystem;
         Queue<entity_t> available;
         entity_t numEntities = 0;
         ConcurrentQueue<entity_t> destroyedAudioSources, destroyedMeshSources;
@@ -283,7 +288,13 @@ namespace RavEngine {
                     entities.Emplace(index, first_value);
                 }
             };
+            using key_t = const MeshCollectionStatic*;
             unordered_vector<command> commands;
+            UnorderedMap<key_t, uint32_t> commandSlots;     // the index in commands of each mesh's command
+
+            static key_t KeyOf(const command& cmd) {
+                return cmd.mesh.lock().get();
+            }
         };
 
         struct MDIICommandSkinned : public MDICommandBase {
@@ -296,7 +307,49 @@ namespace RavEngine {
                     entities.Emplace(index, first_value);
                 }
             };
+            using key_t = std::pair<const MeshCollectionSkinned*, const SkeletonAsset*>;
             unordered_vector<command> commands;
+            UnorderedMap<key_t, uint32_t> commandSlots;     // the index in commands of each mesh and skeleton's command
+
+            static key_t KeyOf(const command& cmd) {
+                return { cmd.mesh.lock().get(), cmd.skeleton.lock().get() };
+            }
+        };
+
+        /**
+         A DynamicBVH with at most one leaf per entity
+         */
+        template<typename T>
+        struct EntityBounds {
+            DynamicBVH<T> tree;
+            Vector<uint32_t> proxies;   // uses world-local ID
+
+            // enlarges leaves, so that objects moving a little each frame rarely change the tree
+            constexpr static float margin = 0.1f;
+
+            EntityBounds() : tree(margin) {}
+
+            bool Contains(entity_t localId) const {
+                return localId < proxies.size() && proxies[localId] != DynamicBVH<T>::Null;
+            }
+
+            void Insert(entity_t localId, const AABB& box, const T& userData) {
+                if (proxies.size() <= localId) {
+                    proxies.resize(closest_power_of(localId + 1, 2), DynamicBVH<T>::Null);
+                }
+                proxies[localId] = tree.Insert(box, userData);
+            }
+
+            void Remove(entity_t localId) {
+                if (Contains(localId)) {
+                    tree.Remove(proxies[localId]);
+                    proxies[localId] = DynamicBVH<T>::Null;
+                }
+            }
+
+            void Update(entity_t localId, const AABB& box) {
+                tree.Update(proxies[localId], box);
+            }
         };
     
         struct DirLightUploadData {
@@ -364,10 +417,43 @@ namespace RavEngine {
 
             locked_node_hashmap<Ref<MaterialInstance>, MDIICommand, phmap::NullMutex> staticMeshRenderData;
             locked_node_hashmap<Ref<MaterialInstance>, MDIICommandSkinned, phmap::NullMutex> skinnedMeshRenderData;
+
+            // CPU-side bounds, for rejecting draw commands and shadow maps before any GPU culling is recorded
+            EntityBounds<const MaterialInstance*> staticMeshBounds, skinnedMeshBounds;
+            EntityBounds<entity_t> pointLightBounds, spotLightBounds;
         };
 
         RenderData renderData;
 
+        /**
+         The material buckets that may draw something in each of up to 32 views, from the CPU-side bounds.
+         A bucket missing from the map has nothing in any of the views, so its culling and drawing can be skipped.
+         */
+        struct MaterialVisibility {
+            // bit i is set if the bucket may be visible in view i
+            UnorderedMap<const MaterialInstance*, uint32_t> staticMeshes, skinnedMeshes;
+
+            bool IsVisible(const Ref<MaterialInstance>& material, bool skinned, uint32_t view) const {
+                auto& map = skinned ? skinnedMeshes : staticMeshes;
+                auto it = map.find(material.get());
+                return it != map.end() && (it->second & (1u << view));
+            }
+        };
+
+        void QueryMaterialVisibility(std::span<const BoundedFrustum> views, MaterialVisibility& visibility) const;
+
+        /**
+         Add the point and spot lights whose influence reaches at least one of the views to the sets
+         */
+        void QueryVisibleLights(std::span<const BoundedFrustum> views, UnorderedSet<entity_t>& pointLights, UnorderedSet<entity_t>& spotLights) const;
+
+        AABB CalculateMeshBounds(entity_t localId, const matrix4& transform, float radius) const;
+
+        /**
+         The distance past which a light contributes nothing, matching getPointLightRadius in the light clustering shaders
+         */
+        static float LightInfluenceRadius(float intensity);
+
         void updateStaticMeshMaterial(entity_t localId, Ref<MaterialInstance> oldMat, Ref<MaterialInstance> newMat, Ref<MeshCollectionStatic> mesh);
         void updateSkinnedMeshMaterial(entity_t localId, Ref<MaterialInstance> oldMat, Ref<MaterialInstance> newMat, Ref<MeshCollectionSkinned> mesh, Ref<SkeletonAsset> skeleton);
         void StaticMeshChangedVisibility(const StaticMesh*);
@@ -606,9 +692,11 @@ namespace RavEngine {
             }
             else if constexpr (std::is_same_v<T, PointLight>){
                 renderData.pointLightData.Emplace(local_id);
+                renderData.pointLightBounds.Insert(local_id, {}, local_id);    // placed when the render data is next updated
             }
             else if constexpr (std::is_same_v<T, SpotLight>){
                 renderData.spotLightData.Emplace(local_id);
+                renderData.spotLightBounds.Insert(local_id, {}, local_id);
             }
 #endif
             //detect if T constructor's first argument is an Entity, if it is, then we need to pass that before args (pass local_id again)
@@ -667,9 +755,11 @@ namespace RavEngine {
             }
             else if constexpr (std::is_same_v<T, PointLight>){
                 renderData.pointLightData.EraseAtSparseIndex(local_id);
+                renderData.pointLightBounds.Remove(local_id);
             }
             else if constexpr (std::is_same_v<T, SpotLight>){
                 renderData.spotLightData.EraseAtSparseIndex(local_id);
+                renderData.spotLightBounds.Remove(local_id);
             }
             else if constexpr (std::is_same_v<T, AudioSourceComponent>) {
                 destroyedAudioSources.enqueue(local_id);
@@ -1027,7 +1117,9 @@ namespace RavEngine {
         template<typename T>
         inline void RemoveSystem() {
             auto& tpair = typeToSystem.at(CTTI<T>());
-            ECSTasks.erase(tpair.first);
+            if (tpair.first != tpair.second) {
+                ECSTasks.erase(tpair.first);
+            }
             ECSTasks.erase(tpair.second);
             typeToSystem.erase(CTTI<T>());
         }
@@ -1086,6 +1178,7 @@ namespace RavEngine {
 		
 		std::chrono::time_point<e_clock_t> time_now = e_clock_t::now();
 		float currentFPSScale = 0.01f;
+		vector3 animationLODOrigin{0,0,0};
 		
 		//Entity list
         struct dispatched_func{
@@ -1106,6 +1199,8 @@ namespace RavEngine {
 		//physics system
 		std::unique_ptr<PhysicsSolver> Solver;
 		
+		std::unique_ptr<AnimatorSystem> animatorSystem;
+		
 		//fire-and-forget audio
 #if !RVE_SERVER
        
@@ -1148,6 +1243,23 @@ namespace RavEngine {
 			return currentFPSScale;
 		}
         
+        /**
+         Set the point that distance-based animation LOD is measured from. This is usually the active camera or the local player.
+         @param origin the world-space position
+         */
+        inline void SetAnimationLODOrigin(const vector3& origin){
+            animationLODOrigin = origin;
+        }
+        
+        inline const vector3& GetAnimationLODOrigin() const{
+            return animationLODOrigin;
+        }
+        
+        /**
+         @return the cache that AnimatorComponents with pose sharing enabled use to share evaluated poses
+         */
+        AnimationPoseCache& GetAnimationPoseCache();
+        
         inline void ExportTaskGraph(std::ostream& out){
             masterTasks.dump(out);
         }
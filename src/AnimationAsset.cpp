@@ -4,10 +4,11 @@
 #include <ozz/base/io/archive.h>
 #include <ozz/base/maths/simd_math.h>
 #include <ozz/animation/runtime/blending_job.h>
-#include <ozz/animation/offline/raw_animation.h>
-#include <ozz/animation/offline/animation_builder.h>
+#include <ozz/base/io/stream.h>
 #include <ozz/base/maths/soa_transform.h>
 #include <ozz/animation/runtime/animation.h>
+#include <ozz/animation/runtime/track.h>
+#include <ozz/animation/runtime/track_sampling_job.h>
 #include "DataStructures.hpp"
 #include <ozz/base/span.h>
 #include "Filesystem.hpp"
@@ -18,16 +19,19 @@
 using namespace RavEngine;
 using namespace std;
 
+float AnimationAssetSegment::SegmentPlayhead(float globaltime, float last_global_starttime, float speed) const{
+	float seg_len_sec = (end_ticks - start_ticks)/anim_asset->tps;
+	return (globaltime - last_global_starttime)/(seg_len_sec/speed);
+}
+
 bool AnimationAssetSegment::Sample(float globaltime, float last_global_starttime, float speed, bool looping, ozz::vector<ozz::math::SoaTransform> & transforms, ozz::animation::SamplingJob::Context &cache, const ozz::animation::Skeleton *skeleton) const{
 	
 	float asset_duration_ticks = (anim_asset->duration_seconds * anim_asset->tps);
-		
-	float seg_len_sec = (end_ticks - start_ticks)/anim_asset->tps;
 	
 	float start_unitized = start_ticks / asset_duration_ticks;
 	float end_unitized = end_ticks / asset_duration_ticks;
 	
-	float region = (globaltime - last_global_starttime)/(seg_len_sec/speed);
+	float region = SegmentPlayhead(globaltime, last_global_starttime, speed);
 	
 	if (looping){
 		region = std::fmod(region,1.f);
@@ -44,99 +48,107 @@ bool AnimationAssetSegment::Sample(float globaltime, float last_global_starttime
 	return retval;
 }
 
-template<typename T>
-T ReadBytesFromMem(uint8_t*& fp) {
-	T val = *reinterpret_cast<T*>(fp);
-	fp += sizeof(T);
-	return val;
-}
-
-template<typename T>
-void ReadNFromMem(uint8_t*& fp, T* dest, uint32_t count) {
-	auto nbytes = count * sizeof(T);
-	std::memcpy(dest, fp, nbytes);
-	fp += nbytes;
+bool AnimationAssetSegment::SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const{
+	if (!anim_asset->HasRootMotion()){
+		delta = {};
+		return false;
+	}
+	float asset_duration_ticks = (anim_asset->duration_seconds * anim_asset->tps);
+	delta = anim_asset->ExtractRootMotion(SegmentPlayhead(from, start, speed), SegmentPlayhead(to, start, speed), looping, start_ticks / asset_duration_ticks, end_ticks / asset_duration_ticks);
+	return true;
 }
 
-JointAnimation DeserializeJointAnimation(const std::span<uint8_t> data) {
-	uint8_t* fp = data.data();
-	auto header = ReadBytesFromMem<SerializedJointAnimationHeader>(fp);
+namespace {
+	/**
+	 Read-only ozz stream over a block of memory, so archives can be read without copying them
+	 */
+	class SpanStream : public ozz::io::Stream {
+		std::span<const uint8_t> data;
+		size_t position = 0;
+	public:
+		SpanStream(std::span<const uint8_t> data) : data(data) {}
 
-	// check header
-	if (strncmp(header.header.data(), "rvea", sizeof("rvea") - 1) != 0) {
-		Debug::Fatal("Header does not match, data is not a mesh!");
-	}
+		bool opened() const final {
+			return data.data() != nullptr;
+		}
 
-	JointAnimation anim{
-		.duration = header.duration,
-        .ticksPerSecond = header.ticksPerSecond
-	};
-	anim.tracks.reserve(header.numTracks);
-	anim.name.resize(header.nameLength);
+		size_t Read(void* buffer, size_t size) final {
+			size = std::min(size, data.size() - position);
+			std::memcpy(buffer, data.data() + position, size);
+			position += size;
+			return size;
+		}
 
-	// read the track name
-	memcpy(anim.name.data(), fp, anim.name.size());
-	fp += anim.name.size();
+		size_t Write(const void* buffer, size_t size) final {
+			return 0;
+		}
 
-	for (int i = 0; i < header.numTracks; i++) {
-		auto header = ReadBytesFromMem<SerializedJointAnimationTrackHeader>(fp);
-		auto& track = anim.tracks.emplace_back();
-		track.translations.resize(header.numTranslations);
-		track.rotations.resize(header.numRotations);
-		track.scales.resize(header.numScales);
+		int Seek(int offset, Origin origin) final {
+			int64_t base = 0;
+			switch (origin) {
+			case kCurrent: base = position; break;
+			case kEnd: base = data.size(); break;
+			case kSet: base = 0; break;
+			}
+			const auto target = base + offset;
+			if (target < 0 || target > int64_t(data.size())) {
+				return -1;
+			}
+			position = target;
+			return 0;
+		}
 
-		ReadNFromMem(fp, track.translations.data(), header.numTranslations);
-		ReadNFromMem(fp, track.rotations.data(), header.numRotations);
-		ReadNFromMem(fp, track.scales.data(), header.numScales);
-	}
+		int Tell() const final {
+			return int(position);
+		}
 
-	return anim;
+		size_t Size() const final {
+			return data.size();
+		}
+	};
 }
 
 AnimationAsset::AnimationAsset(const std::string& name){
 	auto path = Format("animations/{}.rvea", name);
 	if(GetApp()->GetResources().Exists(path.c_str())){
 		
-		auto data = GetApp()->GetResources().FileContentsAt(path.c_str());
-		auto anim = DeserializeJointAnimation(data);
-
-		// convert to ozz
-		ozz::animation::offline::RawAnimation raw_animation;
-		raw_animation.duration = anim.duration;
-		raw_animation.name = anim.name;
-		raw_animation.tracks.reserve(anim.tracks.size());
-
-        tps = anim.ticksPerSecond;;
-		duration_seconds = anim.duration / tps;
-
-		for (const auto& src_track : anim.tracks) {
-			auto& track = raw_animation.tracks.emplace_back();
-			{
-				track.translations.reserve(src_track.translations.size());
-				for (const auto& key : src_track.translations) {
-					track.translations.push_back({ key.time, {key.value.x, key.value.y, key.value.z} });
-				}
-			}
+		auto data = GetApp()->GetResources().FileViewAt(path.c_str());
 
-			{
-				track.rotations.reserve(src_track.rotations.size());
-				for (const auto& key : src_track.rotations) {
-					track.rotations.push_back({ key.time, {key.value.x, key.value.y, key.value.z, key.value.w} });
-				}
-			}
+		SerializedCompiledAnimationHeader header;
+		Debug::Assert(data.size() >= sizeof(header), "Animation {} is truncated", name);
+		std::memcpy(&header, data.data(), sizeof(header));
 
-			{
-				track.scales.reserve(src_track.scales.size());
-				for (const auto& key : src_track.scales) {
-					track.scales.push_back({ key.time, {key.value.x, key.value.y, key.value.z} });
-				}
-			}
+		// check header
+		if (strncmp(header.header.data(), "rvea", sizeof("rvea") - 1) != 0) {
+			Debug::Fatal("Header does not match, {} is not an animation!", path);
+		}
+		if (header.version != SerializedCompiledAnimationHeader::currentVersion) {
+			Debug::Fatal("Animation {} was compiled with an incompatible version of rveac, recompile it", path);
 		}
-		Debug::Assert(raw_animation.Validate(),"Animation {} failed validation",name);
+		Debug::Assert(data.size() >= sizeof(header) + header.archiveSize, "Animation {} is truncated", name);
 
-		ozz::animation::offline::AnimationBuilder builder;
-		this->anim = std::move(builder(raw_animation));
-		
+		// the archive was built and optimized by rveac, so it only needs to be read
+		SpanStream stream({ reinterpret_cast<const uint8_t*>(data.data()) + sizeof(header), header.archiveSize });
+		ozz::io::IArchive archive(&stream);
+		if (!archive.TestTag<ozz::animation::Animation>()) {
+			Debug::Fatal("Animation {} does not contain a compiled animation", path);
+		}
+		anim = ozz::make_unique<ozz::animation::Animation>();
+		archive >> *anim;
+
+		if (header.rootMotionArchiveSize > 0) {
+			Debug::Assert(data.size() >= sizeof(header) + header.archiveSize + header.rootMotionArchiveSize, "Animation {} is truncated", name);
+			SpanStream rootMotionStream({ reinterpret_cast<const uint8_t*>(data.data()) + sizeof(header) + header.archiveSize, header.rootMotionArchiveSize });
+			ozz::io::IArchive rootMotionArchive(&rootMotionStream);
+			auto translation = ozz::make_unique<ozz::animation::Float3Track>();
+			auto rotation = ozz::make_unique<ozz::animation::QuaternionTrack>();
+			rootMotionArchive >> *translation;
+			rootMotionArchive >> *rotation;
+			SetRootMotion(std::move(translation), std::move(rotation));
+		}
+
+        tps = header.ticksPerSecond;
+		duration_seconds = anim->duration() / tps;
 	}
 	else{
 		Debug::Fatal("No file at {}",path);
@@ -154,6 +166,79 @@ void IAnimGraphable::SampleDirect(float t, const ozz::animation::Animation *anim
 	Debug::Assert(sampling_job.Run(), "Sampling job failed");
 }
 
+AnimationAsset::AnimationAsset(ozz::unique_ptr<ozz::animation::Animation>&& animation, float tps) : anim(std::move(animation)), tps(tps){
+	duration_seconds = anim->duration() / tps;
+}
+
+AnimationAsset::~AnimationAsset() = default;
+
+void AnimationAsset::SetRootMotion(ozz::unique_ptr<ozz::animation::Float3Track>&& translation, ozz::unique_ptr<ozz::animation::QuaternionTrack>&& rotation){
+	Debug::Assert(translation != nullptr && rotation != nullptr, "Root motion requires both tracks");
+	rootMotionTranslation = std::move(translation);
+	rootMotionRotation = std::move(rotation);
+}
+
+RootMotionDelta AnimationAsset::ExtractRootMotion(float from, float to, bool looping, float begin, float end) const{
+	if (!HasRootMotion()){
+		return {};
+	}
+	// time before the state started does not move the root
+	from = std::max(from, 0.f);
+	to = std::max(to, from);
+	
+	auto sample = [&](float playhead){
+		const float ratio = begin + playhead * (end - begin);
+		ozz::math::Float3 translation;
+		ozz::animation::Float3TrackSamplingJob translationJob;
+		translationJob.track = rootMotionTranslation.get();
+		translationJob.ratio = ratio;
+		translationJob.result = &translation;
+		
+		ozz::math::Quaternion rotation;
+		ozz::animation::QuaternionTrackSamplingJob rotationJob;
+		rotationJob.track = rootMotionRotation.get();
+		rotationJob.ratio = ratio;
+		rotationJob.result = &rotation;
+		
+		Debug::Assert(translationJob.Run() && rotationJob.Run(), "Root motion sampling failed");
+		return RootMotionDelta{vector3(translation.x, translation.y, translation.z), quaternion(rotation.w, rotation.x, rotation.y, rotation.z)};
+	};
+	// the tracks store motion relative to the first frame, convert to motion relative to the earlier playhead
+	auto between = [&](float a, float b){
+		const auto pa = sample(a), pb = sample(b);
+		const auto inv = glm::inverse(pa.rotation);
+		return RootMotionDelta{inv * (pb.translation - pa.translation), glm::normalize(inv * pb.rotation)};
+	};
+	
+	if (!looping){
+		return between(std::min(from, 1.f), std::min(to, 1.f));
+	}
+	
+	const auto fromLoop = std::floor(from), toLoop = std::floor(to);
+	if (fromLoop == toLoop){
+		return between(from - fromLoop, to - toLoop);
+	}
+	// finish the current loop, play any whole loops, then start the last one
+	auto delta = between(from - fromLoop, 1);
+	const auto wholeLoops = static_cast<int>(toLoop - fromLoop) - 1;
+	if (wholeLoops > 0){
+		const auto loop = between(0, 1);
+		for(int i = 0; i < wholeLoops; i++){
+			delta = delta.Then(loop);
+		}
+	}
+	return delta.Then(between(0, to - toLoop));
+}
+
+bool AnimationAsset::SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const{
+	if (!HasRootMotion()){
+		delta = {};
+		return false;
+	}
+	delta = ExtractRootMotion((from - start) / duration_seconds * speed, (to - start) / duration_seconds * speed, looping);
+	return true;
+}
+
 bool AnimationAsset::Sample(float time, float start, float speed, bool looping, ozz::vector<ozz::math::SoaTransform>& locals, ozz::animation::SamplingJob::Context& cache, const ozz::animation::Skeleton* skeleton) const{
 	float t = (time - start) / (duration_seconds) * speed;
 	bool ret = false;
@@ -171,28 +256,25 @@ bool AnimationAsset::Sample(float time, float start, float speed, bool looping,
 bool AnimationClip::Sample(float t, float start, float speed, bool looping, ozz::vector<ozz::math::SoaTransform>& transforms, ozz::animation::SamplingJob::Context& cache, const ozz::animation::Skeleton* skeleton) const{
 	//calculate the subtracks
 	stackarray(layers, ozz::animation::BlendingJob::Layer, influence.size());
+	// the clip may be shared by animators on different threads, so the sub-poses live in per-thread scratch
+	auto locals = AnimationScratch::ForCurrentThread().Acquire(influence.size(), skeleton->num_soa_joints());
 	int index = 0;
 	bool allDone = true;
 	for(auto& row : influence){
-		Sampler& sampler = const_cast<Sampler&>(row.second);	//TODO: avoid const_cast
-		bool done = row.first->Sample(t,start,speed, looping, sampler.locals,cache,skeleton);
+		bool done = row.first->Sample(t,start,speed, looping, locals[index],cache,skeleton);
 		if (!done) {
 			allDone = false;
 		}
 		
-		//make sure the buffers are the correct size
-		if (sampler.locals.size() != skeleton->num_soa_joints()){
-			sampler.locals.resize(skeleton->num_soa_joints());
-		}
-		
-		//populate layers
-		layers[index].transform = ozz::make_span(sampler.locals);
-		layers[index].weight = sampler.influence;
+		//populate layers, stackarray may not construct them
+		layers[index] = {};
+		layers[index].transform = ozz::make_span(locals[index]);
+		layers[index].weight = row.second.influence;
 		index++;
 	}
 	
 	ozz::animation::BlendingJob blend_job;
-	blend_job.threshold = 0;			//TODO: make threshold configurable
+	blend_job.threshold = std::numeric_limits<float>::epsilon();	// ozz requires a positive threshold
 	blend_job.layers = ozz::span(layers,influence.size());
 	blend_job.rest_pose = skeleton->joint_rest_poses();
 	
@@ -202,3 +284,57 @@ bool AnimationClip::Sample(float t, float start, float speed, bool looping, ozz:
 	}
 	return allDone;
 }
+
+bool AnimationClip::SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const{
+	// clips without root motion count as standing still, as their poses count towards the blend
+	RootMotionDelta::Accumulator accumulator;
+	bool any = false;
+	for(auto& row : influence){
+		RootMotionDelta sub;
+		any |= row.first->SampleRootMotion(from, to, start, speed, looping, sub);
+		accumulator.Add(sub, row.second.influence);
+	}
+	delta = accumulator.Result();
+	return any;
+}
+
+RootMotionDelta RootMotionDelta::Then(const RootMotionDelta& next) const{
+	return {translation + rotation * next.translation, glm::normalize(rotation * next.rotation)};
+}
+
+void RootMotionDelta::Accumulator::Add(const RootMotionDelta& delta, float weight){
+	if (weight <= 0){
+		return;
+	}
+	// q and -q are the same rotation, keep everything in one hemisphere so they do not cancel out
+	const auto sign = glm::dot(rotation, delta.rotation) < 0 ? -1 : 1;
+	translation += delta.translation * decimalType(weight);
+	rotation += delta.rotation * decimalType(weight * sign);
+	totalWeight += weight;
+}
+
+RootMotionDelta RootMotionDelta::Accumulator::Result() const{
+	if (totalWeight <= 0){
+		return {};
+	}
+	const auto length = glm::length(rotation);
+	return {translation / decimalType(totalWeight), length > 1e-6 ? rotation / length : quaternion(1, 0, 0, 0)};
+}
+
+AnimationScratch::Lease AnimationScratch::Acquire(size_t count, size_t num_soa_joints){
+	const auto begin = top;
+	top += count;
+	while (buffers.size() < top){
+		buffers.emplace_back();
+	}
+	for(size_t i = begin; i < top; i++){
+		// shrinking keeps the capacity, so alternating skeletons does not reallocate
+		buffers[i].resize(num_soa_joints);
+	}
+	return Lease(*this, begin, count);
+}
+
+AnimationScratch& AnimationScratch::ForCurrentThread(){
+	thread_local AnimationScratch scratch;
+	return scratch;
+}
@@ -0,0 +1,51 @@
+#include "AnimationMath.hpp"
+#include "Debug.hpp"
+
+using namespace RavEngine;
+
+void RavEngine::ComputeSkinningMatrices(std::span<const ozz::math::Float4x4> models, std::span<const ozz::math::Float4x4> inverseBindposes, std::span<glm::mat4> out){
+	Debug::Assert(models.size() <= inverseBindposes.size() && models.size() <= out.size(), "Skinning matrix buffers are too small");
+	for(size_t i = 0; i < models.size(); i++){
+		SkinningMatrix(models[i], inverseBindposes[i], out[i]);
+	}
+}
+
+void RavEngine::ConvertPose(std::span<const ozz::math::Float4x4> models, std::span<matrix4> out){
+	Debug::Assert(models.size() <= out.size(), "Pose buffer is too small");
+	for(size_t i = 0; i < models.size(); i++){
+#if DOUBLE_PRECISION
+		glm::mat4 mat;
+		StoreMatrix(models[i], mat);
+		out[i] = mat;
+#else
+		StoreMatrix(models[i], out[i]);
+#endif
+	}
+}
+
+void RavEngine::ConvertPose(std::span<const ozz::math::Float4x4> models, const matrix4& world, std::span<matrix4> out){
+	Debug::Assert(models.size() <= out.size(), "Pose buffer is too small");
+#if DOUBLE_PRECISION
+	// keep the world multiply in double precision
+	for(size_t i = 0; i < models.size(); i++){
+		glm::mat4 mat;
+		StoreMatrix(models[i], mat);
+		out[i] = world * matrix4(mat);
+	}
+#else
+	const auto simdWorld = LoadMatrix(world);
+	for(size_t i = 0; i < models.size(); i++){
+		StoreMatrix(simdWorld * models[i], out[i]);
+	}
+#endif
+}
+
+void RavEngine::MultiplyJointRotation(std::span<ozz::math::SoaTransform> pose, int joint, const ozz::math::SimdQuaternion& rotation){
+	Debug::Assert(joint / 4 < pose.size(), "Joint {} is out of range for this pose", joint);
+	// transpose the SoA quaternions of the joint's group of 4 to AoS, rotate the one lane, and transpose back
+	auto& soa = pose[joint / 4];
+	ozz::math::SimdQuaternion aos[4];
+	ozz::math::Transpose4x4(&soa.rotation.x, &aos->xyzw);
+	aos[joint & 3] = aos[joint & 3] * rotation;
+	ozz::math::Transpose4x4(&aos->xyzw, &soa.rotation.x);
+}
@@ -0,0 +1,31 @@
+#include "AnimationPoseCache.hpp"
+#include <cmath>
+
+using namespace RavEngine;
+
+AnimationPoseCache::Entry& AnimationPoseCache::Claim(const Key& key, AnimatorComponent* claimant){
+	std::lock_guard lock(mtx);
+	auto [it, inserted] = entries.try_emplace(key);
+	if (inserted){
+		it->second.producer = claimant;
+		uniquePoses++;
+	}
+	else{
+		sharedPoses++;
+	}
+	return it->second;
+}
+
+void AnimationPoseCache::Reset(){
+	std::lock_guard lock(mtx);
+	entries.clear();
+	uniquePoses = 0;
+	sharedPoses = 0;
+}
+
+float AnimationPoseCache::QuantizeTime(double elapsed) const{
+	if (timeQuantization <= 0){
+		return static_cast<float>(elapsed);
+	}
+	return static_cast<float>(std::round(elapsed / timeQuantization) * timeQuantization);
+}
@@ -6,6 +6,12 @@
 #include "Debug.hpp"
 #include "Transform.hpp"
 #include "SkeletonAsset.hpp"
+#include "World.hpp"
+#include "AnimationMath.hpp"
+#include "Animation.hpp"
+#include "PhysicsBodyComponent.hpp"
+#include <ozz/animation/runtime/ik_two_bone_job.h>
+#include <ozz/animation/runtime/ik_aim_job.h>
 
 using namespace RavEngine;
 using namespace std;
@@ -29,6 +35,9 @@ Create an AnimatorComponent with a SkeletonAsset
 */
 
 RavEngine::AnimatorComponent::AnimatorComponent(Ref<SkeletonAsset> sk) : isPlaying(false), isBlending(false) {
+	// spread LOD update ticks across animators
+	static std::atomic<uint16_t> nextLODPhase = 0;
+	lodPhase = nextLODPhase++;
 	UpdateSkeletonData(sk);
 }
 
@@ -81,6 +90,8 @@ void RavEngine::AnimatorComponent::Play(float resetPlayhead) {
 			lastPlayTime = GetApp()->GetCurrentTime() - lastPlayTime;
 		}
 		isPlaying = true;
+		// paused time is not motion
+		rootMotionTime = -1;
 	}
 }
 
@@ -92,31 +103,213 @@ void RavEngine::AnimatorComponent::Pause() {
 	isPlaying = false;
 }
 
-void AnimatorComponent::Tick(const Transform& t){
-	//skip calculation 
-	if(!isPlaying){
-		return;
-	}
-	
-    auto timeScale = GetApp()->GetCurrentFPSScale();
-    
+void AnimatorComponent::SampleGraph(float timeScale, AnimationPoseCache* poseCache){
 	auto currentTime = GetApp()->GetCurrentTime();
-	//if isBlending, need to calculate both states, and blend between them
+	
+	//if isBlending, need to calculate both states, and blend them in the blend stage
+	std::array<State*, 2> sampled{nullptr, nullptr};
 	if (isBlending){
-		
-		auto& fromState = states[stateBlend.from];
-		auto& toState = states[stateBlend.to];
-			
 		//advance playheads
 		if (isPlaying){
 			//update the tween
 			currentBlendingValue = stateBlend.currentTween.step((float)timeScale / stateBlend.currentTween.duration());
 		}
+		sampled = {&states[stateBlend.from], &states[stateBlend.to]};
+		tickState.stateBlend = true;
 		
-        auto& cref = *cache;
-		fromState.clip->Sample(currentTime, std::max(lastPlayTime,fromState.lastPlayTime), fromState.speed, fromState.isLooping, transforms, cref, skeleton->GetSkeleton().get());
-		bool toDone = toState.clip->Sample(currentTime, std::max(lastPlayTime,toState.lastPlayTime), toState.speed, toState.isLooping, transformsSecondaryBlending, cref, skeleton->GetSkeleton().get());
-		
+		//when the tween is finished, isBlending = false
+		if (stateBlend.currentTween.progress() >= 1.0){
+			isBlending = false;
+			tickState.endIndex = 1;
+			tickState.endState = stateBlend.to;
+			tickState.endNext = stateBlend.from;
+		}
+	}
+	else if (states.contains(currentState)){
+		sampled[0] = &states[currentState];
+		tickState.endIndex = 0;
+		tickState.endState = currentState;
+		tickState.endNext = currentState;
+	}
+	
+	std::array<double, 2> starts{0, 0};
+	for(int i = 0; i < sampled.size(); i++){
+		if (sampled[i] != nullptr){
+			starts[i] = std::max(lastPlayTime, sampled[i]->lastPlayTime);
+		}
+	}
+	
+	// root motion depends on this animator's own history, so it is sampled even when the pose is shared
+	if (rootMotionMode != RootMotionMode::Ignore){
+		if (rootMotionTime >= 0){
+			std::array<RootMotionDelta, 2> deltas;
+			for(int i = 0; i < sampled.size(); i++){
+				if (sampled[i] != nullptr){
+					sampled[i]->clip->SampleRootMotion(rootMotionTime, currentTime, starts[i], sampled[i]->speed, sampled[i]->isLooping, deltas[i]);
+				}
+			}
+			if (tickState.stateBlend){
+				RootMotionDelta::Accumulator accumulator;
+				accumulator.Add(deltas[0], 1 - currentBlendingValue);
+				accumulator.Add(deltas[1], currentBlendingValue);
+				rootMotion = accumulator.Result();
+			}
+			else{
+				rootMotion = deltas[0];
+			}
+			rootMotionSeconds = static_cast<float>(currentTime - rootMotionTime);
+		}
+		rootMotionTime = currentTime;
+	}
+	
+	AnimationPoseCache::Entry* shared = nullptr;
+	if (poseCache != nullptr){
+		AnimationPoseCache::Key key;
+		key.skeleton = skeleton.get();
+		key.blend = tickState.stateBlend ? currentBlendingValue : 0;
+		key.maxJointDepth = tickState.maxJointDepth;
+		for(int i = 0; i < sampled.size(); i++){
+			if (sampled[i] == nullptr){
+				continue;
+			}
+			const auto speed = sampled[i]->speed;
+			key.clips[i] = sampled[i]->clip.get();
+			key.looping[i] = sampled[i]->isLooping;
+			key.elapsed[i] = poseCache->QuantizeTime((currentTime - starts[i]) * speed);
+			if (speed != 0){
+				// sample at the quantized playhead, so every animator sharing the key sees the same pose
+				starts[i] = currentTime - key.elapsed[i] / speed;
+			}
+		}
+		shared = &poseCache->Claim(key, this);
+		if (shared->producer != this){
+			// the producer's results are read in later stages, once it has finished sampling
+			tickState.sharedPose = shared;
+			return;
+		}
+	}
+	
+	if (sampled[0] != nullptr){
+		std::array<ozz::vector<ozz::math::SoaTransform>*, 2> outputs{&transforms, &transformsSecondaryBlending};
+		auto& cref = *cache;
+		for(int i = 0; i < sampled.size(); i++){
+			if (sampled[i] != nullptr){
+				tickState.done[i] = sampled[i]->clip->Sample(currentTime, starts[i], sampled[i]->speed, sampled[i]->isLooping, *outputs[i], cref, skeleton->GetSkeleton().get());
+			}
+		}
+	}
+	else{
+		//set all to skeleton bind pose
+		for(int i = 0; i < transforms.size(); i++){
+			transforms[i] = skeleton->GetSkeleton()->joint_rest_poses()[i];
+		}
+	}
+	
+	if (shared != nullptr){
+		shared->done = tickState.done;
+	}
+}
+
+void AnimatorComponent::SetLODLevels(const Vector<LODLevel>& levels){
+	lodLevels = levels;
+	std::sort(lodLevels.begin(), lodLevels.end(), [](const LODLevel& a, const LODLevel& b){
+		return a.minDistance < b.minDistance;
+	});
+	for(auto& level : lodLevels){
+		level.updateInterval = std::max<uint16_t>(level.updateInterval, 1);
+	}
+	currentLOD = 0;
+	hasPreviousLODPose = false;
+}
+
+uint8_t AnimatorComponent::SelectLOD(const Transform& t) const{
+	if (lodLevels.empty()){
+		return 0;
+	}
+	const auto maxLOD = static_cast<uint8_t>(std::min<size_t>(lodLevels.size() - 1, std::numeric_limits<uint8_t>::max()));
+	if (lodSelector){
+		return std::min(lodSelector(t), maxLOD);
+	}
+	
+	// levels are sorted by distance, so pick the farthest one that applies
+	auto origin = t.GetOwner().GetWorld()->GetAnimationLODOrigin();
+	auto dist = glm::distance(t.GetWorldPosition(), origin);
+	uint8_t lod = 0;
+	for(uint8_t i = 0; i <= maxLOD; i++){
+		if (dist >= lodLevels[i].minDistance){
+			lod = i;
+		}
+		else{
+			break;
+		}
+	}
+	return lod;
+}
+
+void AnimatorComponent::Tick(const Transform& t){
+	SampleStage(t);
+	BlendStage();
+	LocalToModelStage();
+	IKProbeStage(t);
+	IKStage(t);
+	SkinningStage(t);
+}
+
+void AnimatorComponent::SampleStage(const Transform& t, AnimationPoseCache* poseCache){
+	tickState = {};
+	rootMotion = {};
+	rootMotionSeconds = 0;
+	//skip calculation 
+	if(!isPlaying){
+		return;
+	}
+	tickState.active = true;
+	
+	// ticks skipped by LOD still need to advance transition tweens
+	lodPendingTimeScale += GetApp()->GetCurrentFPSScale();
+	
+	currentLOD = SelectLOD(t);
+	const LODLevel fullDetail;
+	const auto& level = lodLevels.empty() ? fullDetail : lodLevels[currentLOD];
+	tickState.lodInterval = level.updateInterval;
+	tickState.maxJointDepth = level.maxJointDepth;
+	
+	// stagger updates across animators so that a crowd does not evaluate on the same tick
+	tickState.lodStep = (lodTickCounter + lodPhase) % level.updateInterval;
+	lodTickCounter++;
+	
+	if (tickState.lodStep == 0){
+		const bool interpolating = level.updateInterval > 1 && lodInterpolate;
+		if (interpolating){
+			std::swap(transforms, transformsPreviousLOD);
+		}
+		// interpolated poses depend on this animator's own history and IK on its own targets, so they cannot be shared
+		SampleGraph(lodPendingTimeScale, sharePoses && !interpolating && !HasIK() ? poseCache : nullptr);
+		lodPendingTimeScale = 0;
+		tickState.evaluated = true;
+	}
+}
+
+void AnimatorComponent::BlendStage(){
+	if (!tickState.active){
+		return;
+	}
+	
+	// end states here rather than while sampling, so that shared poses report the producer's results
+	if (tickState.endIndex >= 0){
+		const auto& done = tickState.sharedPose != nullptr ? tickState.sharedPose->done : tickState.done;
+		if (done[tickState.endIndex]){
+			EndState(states[tickState.endState], tickState.endNext);
+		}
+	}
+	
+	if (tickState.sharedPose != nullptr){
+		// the local pose was not sampled, so there is nothing to interpolate from next time
+		hasPreviousLODPose = false;
+		return;
+	}
+	
+	if (tickState.stateBlend){
 		//blend into output
 		ozz::animation::BlendingJob::Layer layers[2];
 		
@@ -126,14 +319,6 @@ void AnimatorComponent::Tick(const Transform& t){
 		layers[1].transform = ozz::make_span(transformsSecondaryBlending);
 		layers[1].weight = currentBlendingValue;
 		
-		//when the tween is finished, isBlending = false
-		if (stateBlend.currentTween.progress() >= 1.0){
-			isBlending = false;
-			if (toDone) {
-				EndState(toState,stateBlend.from);
-			}
-		}
-		
 		ozz::animation::BlendingJob blend_job;
 		blend_job.threshold = 0.1f;			//TODO: make threshold configurable
 		blend_job.layers = layers;
@@ -144,57 +329,312 @@ void AnimatorComponent::Tick(const Transform& t){
 			Debug::Fatal("Blend job failed");
 		}
 	}
-	else{
-        if (states.contains(currentState)){
-            auto& state = states[currentState];
-            auto& cref = *cache;
-			if (state.clip->Sample(currentTime, std::max(lastPlayTime, state.lastPlayTime), state.speed, state.isLooping, transforms, cref, skeleton->GetSkeleton().get())) {
-				EndState(state,currentState);
-			}
-        }
-        else{
-            //set all to skeleton bind pose
-			for(int i = 0; i < transforms.size(); i++){
-				transforms[i] = skeleton->GetSkeleton()->joint_rest_poses()[i];
+	
+	const bool interpolating = tickState.lodInterval > 1 && lodInterpolate;
+	if (tickState.evaluated){
+		tickState.ltmSource = &transforms;
+		if (interpolating){
+			if (!hasPreviousLODPose){
+				std::copy(transforms.begin(), transforms.end(), transformsPreviousLOD.begin());
+				hasPreviousLODPose = true;
 			}
-        }
+			// show the older pose, the following ticks move towards the newly sampled one
+			tickState.ltmSource = &transformsPreviousLOD;
+		}
+		else{
+			hasPreviousLODPose = false;
+		}
+	}
+	else if (interpolating && hasPreviousLODPose){
+		const float alpha = float(tickState.lodStep) / tickState.lodInterval;
+		ozz::animation::BlendingJob::Layer layers[2];
+		layers[0].transform = ozz::make_span(transformsPreviousLOD);
+		layers[0].weight = 1 - alpha;
+		layers[1].transform = ozz::make_span(transforms);
+		layers[1].weight = alpha;
+		
+		ozz::animation::BlendingJob blend_job;
+		blend_job.threshold = std::numeric_limits<float>::epsilon();	// the two weights always sum to 1, ozz only requires it to be positive
+		blend_job.layers = layers;
+		blend_job.rest_pose = skeleton->GetSkeleton()->joint_rest_poses();
+		blend_job.output = ozz::make_span(transformsInterpolatedLOD);
+		if (!blend_job.Run()) {
+			Debug::Fatal("LOD interpolation blend job failed");
+		}
+		tickState.ltmSource = &transformsInterpolatedLOD;
+	}
+	// otherwise hold the last evaluated pose
+}
+
+void AnimatorComponent::LocalToModelStage(){
+	if (tickState.ltmSource == nullptr){
+		return;
 	}
 	
 	//convert from local space to model space
 	ozz::animation::LocalToModelJob job;
 	job.skeleton = skeleton->GetSkeleton().get();
-	job.input = ozz::make_span(transforms);
+	job.input = ozz::make_span(*tickState.ltmSource);
 	job.output = ozz::make_span(models);
 	
 	if (!job.Run()){
 		Debug::Fatal("local to model job failed");
 	}
 	
-	// create pose-bindpose skinning matrices
-	auto& pose = GetLocalPose();
-	auto& bindpose = skeleton->GetBindposes();
-	for(int i = 0; i < skinningmats.size(); i++){
-		skinningmats[i] = pose[i] * matrix4(bindpose[i]);
+	if (HasIK()){
+		// the IK stage changes the pose, so it computes the skinning matrices afterwards
+		tickState.solveIK = true;
+		return;
 	}
+	UpdateSkinningMatrices();
+}
 
-	// update world poses
-	GetPose(t);
+void AnimatorComponent::UpdateSkinningMatrices(){
+	// create pose-bindpose skinning matrices, directly in the layout the GPU reads
+	const auto& inverseBindposes = skeleton->GetInverseBindposesSIMD();
+	if (tickState.maxJointDepth == std::numeric_limits<uint8_t>::max()){
+		ComputeSkinningMatrices(models, inverseBindposes, skinningmats);
+	}
+	else{
+		const auto parents = skeleton->GetSkeleton()->joint_parents();
+		for(int i = 0; i < skinningmats.size(); i++){
+			if (jointDepths[i] > tickState.maxJointDepth){
+				// reduced joint set: rigidly follow the ancestor at the depth limit, as in the bind pose.
+				// parents always precede their children, so the parent's matrix is already final.
+				skinningmats[i] = skinningmats[parents[i]];
+			}
+			else{
+				SkinningMatrix(models[i], inverseBindposes[i], skinningmats[i]);
+			}
+		}
+	}
 }
 
-void AnimatorComponent::UpdateSocket(const std::string& name, Transform& t) const{
-	for (int i = 0; i < skeleton->GetSkeleton()->num_joints(); i++) {
-		auto name = skeleton->GetSkeleton()->joint_names()[i];
-		//TODO: set matrix directly instead of with decompose?
-        auto& mat = glm_pose[i];
+void AnimatorComponent::IKProbeStage(const Transform& t){
+	ikProbes.clear();
+	if (!tickState.solveIK){
+		return;
+	}
+	const auto world = t.GetWorldMatrix();
+	for(uint16_t i = 0; i < twoBoneChains.size(); i++){
+		const auto& chain = twoBoneChains[i];
+		if (!chain.groundProbe.enabled || chain.weight <= 0){
+			continue;
+		}
+		// cast down from above the animated end joint, so that feet can be raised onto steps as well as lowered
+		float end[4];
+		ozz::math::StorePtrU(models[chain.endJoint].cols[3], end);
+		const auto worldEnd = vector3(world * vector4(end[0], end[1], end[2], 1));
+		ikProbes.push_back({
+			.origin = worldEnd + vector3(0, chain.groundProbe.castHeight, 0),
+			.distance = chain.groundProbe.castHeight + chain.groundProbe.castDistance,
+			.chain = i
+		});
+	}
+}
 
-        auto translate = mat[3];
-        auto rotation = glm::quat_cast(mat);
+void AnimatorComponent::IKStage(const Transform& t){
+	if (!tickState.solveIK){
+		return;
+	}
+	
+	// solve on a copy, since the source may be kept for LOD interpolation
+	std::copy(tickState.ltmSource->begin(), tickState.ltmSource->end(), transformsIK.begin());
+	
+	// ozz solves in model space
+	const auto toModel = glm::inverse(t.GetWorldMatrix());
+	auto modelPoint = [&](const vector3& world){
+		const auto p = toModel * vector4(world, 1);
+		return ozz::math::simd_float4::Load(p.x, p.y, p.z, 1);
+	};
+	auto direction = [](const vector3& v){
+		return ozz::math::simd_float4::Load(v.x, v.y, v.z, 0);
+	};
+	// corrections only affect the chain's joints and their descendants
+	auto updateModelsFrom = [&](uint16_t joint){
+		ozz::animation::LocalToModelJob job;
+		job.skeleton = skeleton->GetSkeleton().get();
+		job.input = ozz::make_span(transformsIK);
+		job.output = ozz::make_span(models);
+		job.from = joint;
+		if (!job.Run()){
+			Debug::Fatal("local to model job failed");
+		}
+	};
+	
+	for(const auto& chain : aimChains){
+		if (chain.weight <= 0){
+			continue;
+		}
+		ozz::math::SimdQuaternion correction;
+		ozz::animation::IKAimJob job;
+		job.target = modelPoint(chain.target);
+		job.forward = direction(chain.forward);
+		job.up = direction(chain.up);
+		job.offset = ozz::math::simd_float4::Load(chain.offset.x, chain.offset.y, chain.offset.z, 1);
+		job.pole_vector = direction(chain.poleVector);
+		job.twist_angle = chain.twistAngle;
+		job.weight = chain.weight;
+		job.joint = &models[chain.joint];
+		job.joint_correction = &correction;
+		if (!job.Run()){
+			Debug::Fatal("Aim IK job failed");
+		}
+		MultiplyJointRotation(transformsIK, chain.joint, correction);
+		updateModelsFrom(chain.joint);
+	}
+	
+	// probes are in chain order
+	auto probe = ikProbes.begin();
+	for(uint16_t i = 0; i < twoBoneChains.size(); i++){
+		auto& chain = twoBoneChains[i];
+		if (chain.weight <= 0){
+			continue;
+		}
+		if (chain.groundProbe.enabled){
+			if (probe == ikProbes.end() || probe->chain != i){
+				continue;
+			}
+			const auto hit = *probe++;
+			if (!hit.hit){
+				continue;
+			}
+			chain.target = hit.hitPosition + vector3(0, chain.groundProbe.footHeight, 0);
+		}
 		
-		t.SetWorldPosition(translate);
-		t.SetWorldRotation(rotation);
+		ozz::math::SimdQuaternion startCorrection, midCorrection;
+		ozz::animation::IKTwoBoneJob job;
+		job.target = modelPoint(chain.target);
+		job.pole_vector = direction(chain.poleVector);
+		job.mid_axis = direction(chain.midAxis);
+		job.weight = chain.weight;
+		job.soften = chain.soften;
+		job.twist_angle = chain.twistAngle;
+		job.start_joint = &models[chain.startJoint];
+		job.mid_joint = &models[chain.midJoint];
+		job.end_joint = &models[chain.endJoint];
+		job.start_joint_correction = &startCorrection;
+		job.mid_joint_correction = &midCorrection;
+		if (!job.Run()){
+			Debug::Fatal("Two-bone IK job failed");
+		}
+		MultiplyJointRotation(transformsIK, chain.startJoint, startCorrection);
+		MultiplyJointRotation(transformsIK, chain.midJoint, midCorrection);
+		updateModelsFrom(chain.startJoint);
+	}
+	
+	UpdateSkinningMatrices();
+}
+
+uint16_t AnimatorComponent::AddTwoBoneIK(const TwoBoneIK& chain){
+	Debug::Assert(std::max({chain.startJoint, chain.midJoint, chain.endJoint}) < models.size(), "IK chain joints are out of range for this skeleton");
+	twoBoneChains.push_back(chain);
+	return static_cast<uint16_t>(twoBoneChains.size() - 1);
+}
+
+uint16_t AnimatorComponent::AddAimIK(const AimIK& chain){
+	Debug::Assert(chain.joint < models.size(), "IK chain joint is out of range for this skeleton");
+	aimChains.push_back(chain);
+	return static_cast<uint16_t>(aimChains.size() - 1);
+}
+
+void AnimatorComponent::ClearIK(){
+	twoBoneChains.clear();
+	aimChains.clear();
+	ikProbes.clear();
+}
+
+void AnimatorComponent::SkinningStage(const Transform& t){
+	if (!tickState.active){
+		return;
+	}
+	
+	if (tickState.sharedPose != nullptr){
+		// the producer finished its skinning matrices in the previous stage
+		const auto producer = tickState.sharedPose->producer;
+		std::copy(producer->models.begin(), producer->models.end(), models.begin());
+		std::copy(producer->skinningmats.begin(), producer->skinningmats.end(), skinningmats.begin());
+	}
+
+	// update socket world poses, the transform may have moved even if the pose did not change.
+	// other joints are only converted when GetPose is called.
+	if (!sockets->joints.empty()){
+		const auto world = t.GetWorldMatrix();
+		for(const auto joint : sockets->joints){
+			ConvertPose(std::span(&models[joint], 1), world, std::span(&sockets->poses[joint], 1));
+		}
+	}
+}
+
+void AnimatorComponent::ApplyRootMotion(Transform& t) const{
+	if (!tickState.evaluated || rootMotionSeconds <= 0){
+		return;
+	}
+	switch(rootMotionMode){
+	case RootMotionMode::Transform:
+		// the motion is in model space, so scale and rotate it into the parent's space
+		t.LocalTranslateDelta(t.GetLocalRotation() * (rootMotion.translation * t.GetLocalScale()));
+		t.LocalRotateDelta(rootMotion.rotation);
+		break;
+	case RootMotionMode::PhysicsBody:{
+		auto owner = t.GetOwner();
+		if (!owner.HasComponent<RigidBodyDynamicComponent>()){
+			break;
+		}
+		auto& body = owner.GetComponent<RigidBodyDynamicComponent>();
+		const auto worldRotation = t.GetWorldRotation();
+		const auto worldDelta = vector3(t.GetWorldMatrix() * vector4(rootMotion.translation, 0));
+		if (body.IsKinematic()){
+			body.SetKinematicTarget(t.GetWorldPosition() + worldDelta, worldRotation * rootMotion.rotation);
+		}
+		else{
+			// velocities let the solver resolve collisions along the way
+			auto velocity = worldDelta / decimalType(rootMotionSeconds);
+			if (rootMotion.translation.y == 0){
+				// animations without vertical motion leave falling and jumping to the simulation
+				velocity.y = body.GetLinearVelocity().y;
+			}
+			body.SetLinearVelocity(velocity, true);
+			body.SetAngularVelocity(worldRotation * (glm::axis(rootMotion.rotation) * glm::angle(rootMotion.rotation)) / decimalType(rootMotionSeconds), true);
+		}
+	}
+		break;
+	default:
+		break;
 	}
 }
 
+void AnimatorSocketPoses::Add(uint16_t joint){
+	Debug::Assert(joint < poses.size(), "Joint {} is out of range for this skeleton", joint);
+	joints.push_back(joint);
+}
+
+void AnimatorSocketPoses::Remove(uint16_t joint){
+	auto it = std::find(joints.begin(), joints.end(), joint);
+	if (it != joints.end()){
+		joints.erase(it);
+	}
+}
+
+void AnimatorSocketPoses::UpdateTransform(uint16_t joint, Transform& t) const{
+	//TODO: set matrix directly instead of with decompose?
+	auto& mat = poses[joint];
+
+	auto translate = mat[3];
+	auto rotation = glm::quat_cast(mat);
+	
+	t.SetWorldPosition(translate);
+	t.SetWorldRotation(rotation);
+}
+
+size_t AnimatorComponent::GetMemoryUsage() const{
+	auto bytes = [](const auto& vec){
+		return vec.capacity() * sizeof(vec[0]);
+	};
+	return bytes(transforms) + bytes(transformsSecondaryBlending) + bytes(transformsPreviousLOD) + bytes(transformsInterpolatedLOD) + bytes(transformsIK)
+		+ bytes(models) + bytes(glm_pose) + bytes(local_pose) + bytes(skinningmats) + bytes(jointDepths) + bytes(sockets->poses);
+}
+
 /**
 Update buffer sizes for current skeleton
 */
@@ -210,7 +650,22 @@ inline void RavEngine::AnimatorComponent::UpdateSkeletonData(Ref<SkeletonAsset>
 	cache->Resize(n_joints);
 	glm_pose.resize(n_joints);
 	local_pose.resize(n_joints);
+	sockets->skeleton = skeleton.get();
+	sockets->poses.resize(n_joints);
 	skinningmats.resize(n_joints);
+	
+	transformsPreviousLOD.resize(n_joints_soa);
+	transformsInterpolatedLOD.resize(n_joints_soa);
+	transformsIK.resize(n_joints_soa);
+	hasPreviousLODPose = false;
+	
+	// hierarchy depth of each joint, for reduced LOD joint sets
+	const auto parents = skeleton->GetSkeleton()->joint_parents();
+	jointDepths.resize(n_joints);
+	for(int i = 0; i < n_joints; i++){
+		const auto parent = parents[i];
+		jointDepths[i] = parent == ozz::animation::Skeleton::kNoParent ? 0 : static_cast<uint8_t>(std::min(jointDepths[parent] + 1, int(std::numeric_limits<uint8_t>::max())));
+	}
 }
 
 
@@ -220,41 +675,12 @@ Get the current pose of the animation in world space
 */
 
 const decltype(RavEngine::AnimatorComponent::glm_pose)& RavEngine::AnimatorComponent::GetPose(const Transform& t) const {
-	decimalType matrix[16]{ 0 };
-	auto worldMat = t.GetWorldMatrix();
-	for (int i = 0; i < models.size(); i++) {
-		auto& t = models[i];
-		for (int r = 0; r < 4; r++) {
-			float result[4];
-			std::memcpy(result, t.cols + r, sizeof(t.cols[r]));
-			decimalType dresult[4];
-			for (int j = 0; j < 4; j++) {
-				dresult[j] = result[j];
-			}
-			//_mm_store_ps(result,p.cols[r]);
-			std::memcpy(matrix + r * 4, dresult, sizeof(dresult));
-		}
-		glm_pose[i] = worldMat * glm::make_mat4(matrix);
-	}
+	ConvertPose(models, t.GetWorldMatrix(), glm_pose);
 	return glm_pose;
 }
 
 const decltype(RavEngine::AnimatorComponent::local_pose)& RavEngine::AnimatorComponent::GetLocalPose() {
-	decimalType matrix[16];
-	for (int i = 0; i < models.size(); i++) {
-		auto& t = models[i];
-		for (int r = 0; r < 4; r++) {
-			float result[4];
-			std::memcpy(result, t.cols + r, sizeof(t.cols[r]));
-			decimalType dresult[4];
-			for (int j = 0; j < 4; j++) {
-				dresult[j] = result[j];
-			}
-			//_mm_store_ps(result,p.cols[r]);
-			std::memcpy(matrix + r * 4, dresult, sizeof(dresult));
-		}
-		local_pose[i] = glm::make_mat4(matrix);
-	}
+	ConvertPose(models, local_pose);
 	return local_pose;
 }
 
@@ -262,33 +688,122 @@ bool AnimBlendTree::Node::Sample(float t, float start, float speed, bool looping
 	return state->Sample(t, start, speed, looping, output, cache, skeleton);
 }
 
-bool AnimBlendTree::Sample(float t, float start, float speed, bool looping, ozz::vector<ozz::math::SoaTransform> &output, ozz::animation::SamplingJob::Context &cache, const ozz::animation::Skeleton* skeleton) const{
-	//iterate though the nodes, sample all, and blend
-	//calculate the subtracks
-	ozz::animation::BlendingJob::Layer layers[kmax_nodes];
-	Debug::Assert(states.size() <= kmax_nodes, "An AnimBlendTree can have a maximum of {} nodes",kmax_nodes);
-	//stackarray(layers, ozz::animation::BlendingJob::Layer, states.size());
-	int index = 0;
-	for(auto& row : states){
-		Sampler& sampler = const_cast<Sampler&>(row.second);	//TODO: avoid const_cast
-		
-		//make sure the buffers are the correct size
-		if (sampler.locals.size() != skeleton->num_soa_joints()){
-			sampler.locals.resize(skeleton->num_soa_joints());
+bool AnimBlendTree::Node::SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const{
+	return state->SampleRootMotion(from, to, start, speed, looping, delta);
+}
+
+float AnimBlendTree::Node::GetWeight(const clamped_vec2& blend_pos) const{
+	if (layer == Layer::Additive){
+		return max_influence;
+	}
+	//the influence is calculated as 1 - (distance from control point)
+	return 1.0 - distance(blend_pos, graph_pos) * max_influence;
+}
+
+void AnimBlendTree::Compile() const{
+	program.clear();
+	programMasks.clear();
+	
+	for(const auto layer : {Node::Layer::Blend, Node::Layer::Additive}){
+		if (layer == Node::Layer::Additive){
+			numBlendInstructions = static_cast<uint16_t>(program.size());
+		}
+		for(auto& row : states){
+			const auto& node = row.second.node;
+			if (node.layer != layer || !node.state){
+				continue;
+			}
+			Instruction instruction{.node = &node};
+			if (!node.joint_mask.empty()){
+				// pack the mask into SoA form. Joints past the end of the mask get weight 0, so this node does not affect them.
+				// Trees can be shared between skeletons, so pad to the largest skeleton ozz supports.
+				instruction.maskBegin = static_cast<uint32_t>(programMasks.size());
+				instruction.maskSize = ozz::animation::Skeleton::kMaxSoAJoints;
+				for(uint32_t i = 0; i < instruction.maskSize; i++){
+					float soa[4];
+					for(int j = 0; j < 4; j++){
+						const auto joint = i * 4 + j;
+						soa[j] = joint < node.joint_mask.size() ? node.joint_mask[joint] : 0;
+					}
+					programMasks.push_back({ozz::math::simd_float4::LoadPtrU(soa)});
+				}
+			}
+			program.push_back(instruction);
+		}
+	}
+	dirty = false;
+}
+
+void AnimBlendTree::CompileIfDirty() const{
+	if (dirty){
+		std::lock_guard lock(compileLock);
+		if (dirty){
+			Compile();
 		}
+	}
+}
+
+bool AnimBlendTree::SampleRootMotion(float from, float to, float start, float speed, bool looping, RootMotionDelta& delta) const{
+	CompileIfDirty();
+	
+	// only blend layers move the root, additive layers are offsets on top of the blended pose
+	RootMotionDelta::Accumulator accumulator;
+	bool any = false;
+	for(uint16_t i = 0; i < numBlendInstructions; i++){
+		const auto weight = program[i].node->GetWeight(blend_pos);
+		if (weight <= 0){
+			continue;
+		}
+		RootMotionDelta sub;
+		any |= program[i].node->SampleRootMotion(from, to, start, speed, looping, sub);
+		accumulator.Add(sub, weight);
+	}
+	delta = accumulator.Result();
+	return any;
+}
 
-		row.second.node.Sample(t, start, speed, looping, sampler.locals,cache,skeleton);
+bool AnimBlendTree::Sample(float t, float start, float speed, bool looping, ozz::vector<ozz::math::SoaTransform> &output, ozz::animation::SamplingJob::Context &cache, const ozz::animation::Skeleton* skeleton) const{
+	CompileIfDirty();
+	
+	// weigh every node first, so that nodes which would not contribute are never sampled
+	stackarray(weights, float, program.size() + 1);
+	uint32_t numActive = 0;
+	for(size_t i = 0; i < program.size(); i++){
+		weights[i] = program[i].node->GetWeight(blend_pos);
+		if (weights[i] > 0){
+			numActive++;
+		}
+	}
+	
+	// trees can be shared between animators on different threads, so the node poses live in per-thread scratch
+	auto locals = AnimationScratch::ForCurrentThread().Acquire(numActive, skeleton->num_soa_joints());
+	stackarray(layers, ozz::animation::BlendingJob::Layer, numActive + 1);
+	uint32_t index = 0, numBlendLayers = 0;
+	for(size_t i = 0; i < program.size(); i++){
+		if (weights[i] <= 0){
+			continue;
+		}
+		const auto& instruction = program[i];
+		instruction.node->Sample(t, start, speed, looping, locals[index], cache, skeleton);
 		
 		//populate layers
-		layers[index].transform = ozz::make_span(sampler.locals);
-		//the influence is calculated as 1 - (distance from control point)
-		layers[index].weight = 1.0 - distance(blend_pos, sampler.node.graph_pos) * sampler.node.max_influence;
+		layers[index] = {};
+		layers[index].transform = ozz::make_span(locals[index]);
+		layers[index].weight = weights[i];
+		if (instruction.maskSize > 0){
+			static_assert(sizeof(MaskWeights) == sizeof(ozz::math::SimdFloat4));
+			layers[index].joint_weights = {&programMasks[instruction.maskBegin].weights, instruction.maskSize};
+		}
+		if (i < numBlendInstructions){
+			numBlendLayers++;
+		}
 		index++;
 	}
 	
 	ozz::animation::BlendingJob blend_job;
-	blend_job.threshold = 0.1;			//TODO: make threshold configurable
-	blend_job.layers = ozz::span(layers,states.size());
+	blend_job.threshold = blend_threshold;
+	blend_job.layers = ozz::span<const ozz::animation::BlendingJob::Layer>(layers, numBlendLayers);
+	blend_job.additive_layers = ozz::span<const ozz::animation::BlendingJob::Layer>(layers + numBlendLayers, numActive - numBlendLayers);
 	blend_job.rest_pose = skeleton->joint_rest_poses();
 	blend_job.output = make_span(output);
 	
@@ -299,6 +814,78 @@ bool AnimBlendTree::Sample(float t, float start, float speed, bool looping, ozz:
 	// TODO: proper end detection for trees
 	return false;
 }
+
+AnimBlendTree::AnimBlendTree(std::span<const uint8_t> data, const Function<Ref<IAnimGraphable>(uint8_t)>& resolve){
+	SerializedBlendTreeHeader header;
+	if (data.size() < sizeof(header)) {
+		Debug::Fatal("Blend tree data is truncated");
+	}
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (strncmp(header.header.data(), "rvbt", sizeof("rvbt") - 1) != 0) {
+		Debug::Fatal("Header does not match, data is not a blend tree");
+	}
+	if (header.version != SerializedBlendTreeHeader::currentVersion) {
+		Debug::Fatal("Blend tree was serialized with an incompatible version");
+	}
+	SetBlendThreshold(header.threshold);
+	
+	size_t offset = sizeof(header);
+	for(uint32_t i = 0; i < header.numNodes; i++){
+		SerializedBlendTreeNode record;
+		if (data.size() < offset + sizeof(record)) {
+			Debug::Fatal("Blend tree data is truncated");
+		}
+		std::memcpy(&record, data.data() + offset, sizeof(record));
+		offset += sizeof(record);
+		if (record.layer > static_cast<uint8_t>(Node::Layer::Additive)) {
+			Debug::Fatal("Blend tree node {} has an invalid layer {}", int(record.id), int(record.layer));
+		}
+		
+		Node node;
+		node.state = resolve(record.id);
+		node.graph_pos = clamped_vec2(record.x, record.y);
+		node.max_influence = record.maxInfluence;
+		node.layer = static_cast<Node::Layer>(record.layer);
+		
+		const auto maskBytes = record.numMaskWeights * sizeof(float);
+		if (data.size() < offset + maskBytes) {
+			Debug::Fatal("Blend tree data is truncated");
+		}
+		node.joint_mask.resize(record.numMaskWeights);
+		std::memcpy(node.joint_mask.data(), data.data() + offset, maskBytes);
+		offset += maskBytes;
+		
+		InsertNode(record.id, node);
+	}
+	Compile();
+}
+
+Vector<uint8_t> AnimBlendTree::Serialize() const{
+	Vector<uint8_t> data;
+	auto append = [&data](const void* ptr, size_t size){
+		auto bytes = static_cast<const uint8_t*>(ptr);
+		data.insert(data.end(), bytes, bytes + size);
+	};
+	
+	SerializedBlendTreeHeader header;
+	header.threshold = blend_threshold;
+	header.numNodes = static_cast<uint32_t>(states.size());
+	append(&header, sizeof(header));
+	
+	for(auto& row : states){
+		const auto& node = row.second.node;
+		SerializedBlendTreeNode record;
+		record.id = row.first;
+		record.layer = static_cast<uint8_t>(node.layer);
+		record.x = node.graph_pos.get_x();
+		record.y = node.graph_pos.get_y();
+		record.maxInfluence = node.max_influence;
+		record.numMaskWeights = static_cast<uint32_t>(node.joint_mask.size());
+		append(&record, sizeof(record));
+		append(node.joint_mask.data(), node.joint_mask.size() * sizeof(float));
+	}
+	return data;
+}
 #if !RVE_SERVER
 
 void AnimatorComponent::DebugDraw(RavEngine::DebugDrawer &dbg, const Transform& t) const{
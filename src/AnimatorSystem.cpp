@@ -0,0 +1,166 @@
+#include "AnimatorSystem.hpp"
+#include "World.hpp"
+#include "Transform.hpp"
+#include "PhysicsSolver.hpp"
+#include "PhysicsBodyComponent.hpp"
+#include <taskflow/taskflow.hpp>
+
+using namespace RavEngine;
+using namespace std;
+
+void AnimatorSystem::UpdateBatches(World& world, uint32_t numWorkers){
+	entries.clear();
+	batches.clear();
+	poseCache.Reset();
+	solver = world.Solver.get();
+	
+	auto animators = world.GetAllComponentsOfType<AnimatorComponent>();
+	auto transforms = world.GetAllComponentsOfType<Transform>();
+	if (animators == nullptr || transforms == nullptr){
+		return;
+	}
+	
+	// the set only exists once a physics body has been added to the world
+	auto bodies = world.polymorphicQueryMap.find(CTTI<PhysicsBodyComponent>());
+	
+	uint64_t totalJoints = 0;
+	entries.reserve(animators->DenseSize());
+	for(pos_t i = 0; i < animators->DenseSize(); i++){
+		auto owner = animators->GetOwner(i);
+		if (!EntityIsValid(owner) || !transforms->HasComponent(owner)){
+			continue;
+		}
+		auto& animator = animators->Get(i);
+		const physx::PxRigidActor* body = nullptr;
+		if (bodies != world.polymorphicQueryMap.end() && bodies->second.HasForEntity(owner)){
+			body = world.GetAllComponentsPolymorphic<PhysicsBodyComponent>(owner)[0].rigidActor;
+		}
+		entries.push_back({&animator, &transforms->GetComponent(owner), body});
+		totalJoints += animator.GetNumJoints();
+	}
+	
+	// aim for a few batches per worker so that uneven rigs can be load balanced
+	const auto jointsPerBatch = std::max<uint64_t>(totalJoints / (std::max(numWorkers, 1u) * 4), minJointsPerBatch);
+	
+	Batch current;
+	uint64_t currentJoints = 0;
+	for(pos_t i = 0; i < entries.size(); i++){
+		currentJoints += entries[i].animator->GetNumJoints();
+		current.end = i + 1;
+		if (currentJoints >= jointsPerBatch){
+			batches.push_back(current);
+			current.begin = current.end;
+			currentJoints = 0;
+		}
+	}
+	if (current.end > current.begin){
+		batches.push_back(current);
+	}
+}
+
+void AnimatorSystem::Schedule(tf::Subflow& subflow){
+	if (batches.empty()){
+		return;
+	}
+	
+	auto makeStage = [this,&subflow](auto&& fn, const char* name){
+		return subflow.for_each_index(size_t(0), batches.size(), size_t(1), [this,fn](size_t b){
+			const auto batch = batches[b];
+			for(auto i = batch.begin; i < batch.end; i++){
+				fn(*entries[i].animator, *entries[i].transform);
+			}
+		}).name(name);
+	};
+	
+	auto sample = makeStage([this](AnimatorComponent& anim, const Transform& t){
+		anim.SampleStage(t, &poseCache);
+	}, "Animation Sample");
+	auto blend = makeStage([](AnimatorComponent& anim, const Transform& t){
+		anim.BlendStage();
+	}, "Animation Blend");
+	auto ltm = makeStage([](AnimatorComponent& anim, const Transform& t){
+		anim.LocalToModelStage();
+	}, "Animation Local To Model");
+	auto probe = subflow.for_each_index(size_t(0), batches.size(), size_t(1), [this](size_t b){
+		const auto batch = batches[b];
+		for(auto i = batch.begin; i < batch.end; i++){
+			entries[i].animator->IKProbeStage(*entries[i].transform);
+		}
+		RaycastProbes(batch);
+	}).name("Animation IK Probes");
+	auto ik = makeStage([](AnimatorComponent& anim, const Transform& t){
+		anim.IKStage(t);
+	}, "Animation IK");
+	auto skinning = makeStage([](AnimatorComponent& anim, const Transform& t){
+		anim.SkinningStage(t);
+	}, "Animation Skinning");
+	// only touches transforms and physics bodies, so it overlaps the pose stages.
+	// It runs on one thread because animated entities in the same hierarchy share their parents' dirty state.
+	auto rootMotion = subflow.emplace([this]{
+		for(auto& entry : entries){
+			entry.animator->ApplyRootMotion(*entry.transform);
+		}
+	}).name("Animation Root Motion");
+	
+	sample.precede(blend, rootMotion);
+	blend.precede(ltm);
+	ltm.precede(probe);
+	probe.precede(ik);
+	ik.precede(skinning);
+	// probes start from the moved entities
+	rootMotion.precede(probe);
+}
+
+void AnimatorSystem::RunSerial(){
+	for(auto& entry : entries){
+		entry.animator->SampleStage(*entry.transform, &poseCache);
+	}
+	for(auto& entry : entries){
+		entry.animator->ApplyRootMotion(*entry.transform);
+	}
+	for(auto& entry : entries){
+		entry.animator->BlendStage();
+	}
+	for(auto& entry : entries){
+		entry.animator->LocalToModelStage();
+	}
+	for(auto& entry : entries){
+		entry.animator->IKProbeStage(*entry.transform);
+	}
+	RaycastProbes({0, static_cast<pos_t>(entries.size())});
+	for(auto& entry : entries){
+		entry.animator->IKStage(*entry.transform);
+	}
+	for(auto& entry : entries){
+		entry.animator->SkinningStage(*entry.transform);
+	}
+}
+
+void AnimatorSystem::RaycastProbes(const Batch& batch){
+	if (solver == nullptr){
+		return;
+	}
+	thread_local Vector<PhysicsSolver::RaycastQuery> queries;
+	thread_local Vector<PhysicsSolver::RaycastHit> hits;
+	queries.clear();
+	for(auto i = batch.begin; i < batch.end; i++){
+		for(const auto& probe : entries[i].animator->GetIKProbes()){
+			queries.push_back({probe.origin, vector3(0, -1, 0), probe.distance, entries[i].body});
+		}
+	}
+	if (queries.empty()){
+		return;
+	}
+	
+	hits.resize(queries.size());
+	solver->Raycast(queries, hits);
+	
+	size_t next = 0;
+	for(auto i = batch.begin; i < batch.end; i++){
+		for(auto& probe : entries[i].animator->GetIKProbes()){
+			const auto& hit = hits[next++];
+			probe.hit = hit.hasBlocking;
+			probe.hitPosition = hit.hitPosition;
+		}
+	}
+}
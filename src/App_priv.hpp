@@ -143,6 +143,7 @@ int App::run(int argc, char** argv) {
 				{"metal", decltype(apis)::value_type::second_type::Metal},
 				{ "d3d12", decltype(apis)::value_type::second_type::Direct3D12 },
 				{ "vulkan", decltype(apis)::value_type::second_type::Vulkan },
+				{ "noop", decltype(apis)::value_type::second_type::Noop },
 			};
 
 			auto it = apis.find(backend);
@@ -442,7 +443,9 @@ void App::Tick(){
         RVE_PROFILE_SECTION_END(getSwapchain);
         mainWindowView.collection.finalFramebuffer = nextTexture.texture;
         allViews.push_back(mainWindowView);
+        auto drawBegin = clocktype::now();
         auto mainCommandBuffer = Renderer->Draw(renderWorld, allViews, scale);
+        lastDrawTime = clocktype::now() - drawBegin;
 
 
         // show the results to the user
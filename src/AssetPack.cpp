@@ -0,0 +1,162 @@
+#include "AssetPack.hpp"
+#include "Debug.hpp"
+#include <cstring>
+
+#if _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <Windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace RavEngine;
+using namespace std;
+
+namespace {
+    /**
+     Strip leading, trailing and repeated slashes, so that VFS paths match names in the pack
+     */
+    std::string Normalize(std::string_view path){
+        std::string result;
+        result.reserve(path.size());
+        for(auto c : path){
+            if (c == '/' && (result.empty() || result.back() == '/')){
+                continue;
+            }
+            result += c;
+        }
+        if (!result.empty() && result.back() == '/'){
+            result.pop_back();
+        }
+        return result;
+    }
+}
+
+AssetPack::AssetPack(const std::filesystem::path& path){
+#if _WIN32
+    file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE){
+        file = nullptr;
+        Debug::Fatal("Cannot open asset pack {}", path.string());
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    size = fileSize.QuadPart;
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping){
+        Debug::Fatal("Cannot map asset pack {}", path.string());
+    }
+    base = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        Debug::Fatal("Cannot open asset pack {}", path.string());
+    }
+    struct stat info;
+    fstat(fd, &info);
+    size = info.st_size;
+    auto mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    base = mapped == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(mapped);
+#endif
+    if (!base){
+        Debug::Fatal("Cannot map asset pack {}", path.string());
+    }
+
+    SerializedAssetPackHeader header;
+    Debug::Assert(size >= sizeof(header), "Asset pack {} is truncated", path.string());
+    std::memcpy(&header, base, sizeof(header));
+    if (strncmp(header.header.data(), "rvep", sizeof("rvep") - 1) != 0){
+        Debug::Fatal("Header does not match, {} is not an asset pack!", path.string());
+    }
+    if (header.version != SerializedAssetPackHeader::currentVersion){
+        Debug::Fatal("Asset pack {} was made with an incompatible version of rvepack, repack it", path.string());
+    }
+    numEntries = header.numEntries;
+    entries = reinterpret_cast<const SerializedAssetPackEntry*>(base + sizeof(header));
+    names = reinterpret_cast<const char*>(entries + numEntries);
+    Debug::Assert(sizeof(header) + sizeof(SerializedAssetPackEntry) * numEntries + header.namesSize <= size, "Asset pack {} is truncated", path.string());
+    if (numEntries > 0){
+        const auto& last = entries[numEntries - 1];
+        Debug::Assert(last.dataOffset + last.dataSize <= size, "Asset pack {} is truncated", path.string());
+    }
+}
+
+AssetPack::~AssetPack(){
+#if _WIN32
+    if (base){
+        UnmapViewOfFile(base);
+    }
+    if (mapping){
+        CloseHandle(mapping);
+    }
+    if (file){
+        CloseHandle(file);
+    }
+#else
+    if (base){
+        munmap(const_cast<uint8_t*>(base), size);
+    }
+    if (fd >= 0){
+        close(fd);
+    }
+#endif
+}
+
+uint32_t AssetPack::LowerBound(std::string_view path) const{
+    uint32_t first = 0, count = numEntries;
+    while (count > 0){
+        const auto step = count / 2;
+        if (NameAt(first + step) < path){
+            first += step + 1;
+            count -= step + 1;
+        }
+        else{
+            count = step;
+        }
+    }
+    return first;
+}
+
+std::span<const uint8_t> AssetPack::Find(std::string_view path) const{
+    const auto name = Normalize(path);
+    const auto i = LowerBound(name);
+    if (i < numEntries && NameAt(i) == name){
+        return {base + entries[i].dataOffset, entries[i].dataSize};
+    }
+    return {};
+}
+
+bool AssetPack::Exists(std::string_view path) const{
+    const auto name = Normalize(path);
+    if (Find(name).data()){
+        return true;
+    }
+    // a directory exists if an entry is inside it
+    const auto prefix = name.empty() ? name : name + '/';
+    const auto i = LowerBound(prefix);
+    return i < numEntries && NameAt(i).starts_with(prefix);
+}
+
+void AssetPack::IterateDirectory(std::string_view path, const std::function<void(std::string_view)>& callback) const{
+    auto prefix = Normalize(path);
+    if (!prefix.empty()){
+        prefix += '/';
+    }
+    // entries in a directory are contiguous in sorted order, and so are the entries of each subdirectory
+    std::string_view previous;
+    for(auto i = LowerBound(prefix); i < numEntries; i++){
+        const auto name = NameAt(i);
+        if (!name.starts_with(prefix)){
+            break;
+        }
+        auto child = name.substr(prefix.size());
+        child = child.substr(0, child.find('/'));
+        if (child != previous){
+            callback(child);
+            previous = child;
+        }
+    }
+}
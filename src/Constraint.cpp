@@ -31,13 +31,24 @@ void Constraint::Destroy(){
 
 
 SocketConstraint::SocketConstraint(Entity id, decltype(target) t, const decltype(boneTarget)& tgt) : Constraint(id,t) , boneTarget(tgt){
-	//TODO: check if target entity has the bone
-	Debug::Assert(target.GetOwner().GetComponent<AnimatorComponent>().GetSkeleton()->HasBone(tgt), "Cannot add socket constraint to nonexistent bone {}", tgt);
+	auto& animator = target.GetOwner().GetComponent<AnimatorComponent>();
+	sockets = animator.GetSocketPoses();
+	skeleton = sockets->skeleton;
+	const auto joint = animator.GetSkeleton()->FindBone(tgt);
+	Debug::Assert(joint >= 0, "Cannot add socket constraint to nonexistent bone {}", tgt);
+	jointIndex = static_cast<uint16_t>(joint);
+	sockets->Add(jointIndex);
+}
+
+void SocketConstraint::Destroy(){
+	// the poses outlive the animator, so this does not need to check for it
+	sockets->Remove(jointIndex);
+	Constraint::Destroy();
 }
 
 void SocketSystem::operator()(const SocketConstraint& constraint, Transform& trns){
 	if (constraint){
-		auto& animator = constraint.GetTarget()->GetOwner().GetComponent<AnimatorComponent>();
-		animator.UpdateSocket(constraint.boneTarget,trns);
+		Debug::Assert(constraint.sockets->skeleton == constraint.skeleton, "The animator of socket {} changed skeletons, recreate the constraint", constraint.boneTarget);
+		constraint.sockets->UpdateTransform(constraint.jointIndex, trns);
 	}
 }
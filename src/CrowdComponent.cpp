@@ -0,0 +1,308 @@
+#include "CrowdComponent.hpp"
+#include "NavMeshComponent.hpp"
+#include "Transform.hpp"
+#include "SpinLock.hpp"
+#include "Debug.hpp"
+#include <DetourCrowd.h>
+#include <DetourNavMeshQuery.h>
+#include <DetourCommon.h>
+#include <deque>
+
+using namespace std;
+using namespace RavEngine;
+
+struct CrowdComponent::Slot{
+    enum class Request : uint8_t{
+        None,
+        Target,
+        Velocity,
+        Stop
+    } request = Request::None;
+
+    CrowdAgentComponent::Params params;
+    float target[3]{};      // a position or a velocity, depending on request
+    float position[3]{};
+    float velocity[3]{};
+    int index = -1;         // agent index in the dtCrowd, or -1 if not yet added
+    bool paramsDirty = false;
+    bool requestDirty = false;
+    bool faceVelocity = false;  // copied from params by the crowd, so that writing transforms does not race SetParams
+    bool removed = false;
+    bool inUse = true;
+};
+
+struct CrowdComponent::State{
+    std::shared_ptr<NavMeshComponent::Shared> navMesh;
+    std::shared_ptr<void> navMeshHandle;    // the navmesh the crowd was initialized on
+    dtCrowd* crowd = nullptr;
+
+    SpinLock mtx;
+    std::deque<Slot> slots;                 // deque so that agents can hold on to their slot
+    Vector<Slot*> freeSlots;
+    matrix4 worldMatrix{1};
+    uint16_t maxAgents;
+    float maxAgentRadius;
+    uint32_t numAgents = 0;
+    bool warnedFull = false;
+
+    State(const std::shared_ptr<NavMeshComponent::Shared>& navMesh, uint16_t maxAgents, float maxAgentRadius) : navMesh(navMesh), crowd(dtAllocCrowd()), maxAgents(maxAgents), maxAgentRadius(maxAgentRadius){}
+
+    State(const State&) = delete;
+
+    ~State(){
+        dtFreeCrowd(crowd);
+    }
+
+    static dtCrowdAgentParams ToDetour(const CrowdAgentComponent::Params& params){
+        dtCrowdAgentParams ap{};
+        ap.radius = params.radius;
+        ap.height = params.height;
+        ap.maxAcceleration = params.maxAcceleration;
+        ap.maxSpeed = params.maxSpeed;
+        ap.collisionQueryRange = params.radius * 12;
+        ap.pathOptimizationRange = params.radius * 30;
+        ap.separationWeight = params.separationWeight;
+        ap.updateFlags = (params.anticipateTurns ? DT_CROWD_ANTICIPATE_TURNS : 0)
+            | (params.avoidObstacles ? DT_CROWD_OBSTACLE_AVOIDANCE : 0)
+            | (params.separate ? DT_CROWD_SEPARATION : 0)
+            | (params.optimizePath ? DT_CROWD_OPTIMIZE_VIS | DT_CROWD_OPTIMIZE_TOPO : 0);
+        ap.obstacleAvoidanceType = std::min<uint8_t>(params.avoidanceQuality, 3);
+        ap.queryFilterType = 0;
+        return ap;
+    }
+
+    /**
+     Point the crowd at a new navmesh. Agents are added again at their last positions, with their last requests.
+     */
+    void Reset(dtNavMesh* newNavMesh, const std::shared_ptr<void>& handle){
+        if (!crowd->init(maxAgents, maxAgentRadius, newNavMesh)){
+            Debug::Fatal("Could not initialize crowd");
+        }
+        navMeshHandle = handle;
+
+        // avoidance presets by quality, from low to high
+        constexpr static uint8_t presets[][3]{
+            {5, 2, 1},
+            {5, 2, 2},
+            {7, 2, 3},
+            {7, 3, 3},
+        };
+        for(int i = 0; i < 4; i++){
+            dtObstacleAvoidanceParams params = *crowd->getObstacleAvoidanceParams(i);
+            params.velBias = 0.5f;
+            params.adaptiveDivs = presets[i][0];
+            params.adaptiveRings = presets[i][1];
+            params.adaptiveDepth = presets[i][2];
+            crowd->setObstacleAvoidanceParams(i, &params);
+        }
+
+        for(auto& slot : slots){
+            slot.index = -1;
+            slot.paramsDirty = false;
+            slot.requestDirty = slot.request != Slot::Request::None;
+        }
+    }
+
+    Slot* Allocate(const vector3& position, const CrowdAgentComponent::Params& params){
+        Slot* slot;
+        if (freeSlots.empty()){
+            slot = &slots.emplace_back();
+        }
+        else{
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            *slot = {};
+        }
+        slot->params = params;
+        slot->position[0] = position.x;
+        slot->position[1] = position.y;
+        slot->position[2] = position.z;
+        return slot;
+    }
+
+    /**
+     Apply every agent's changes since the last update to the dtCrowd
+     */
+    void ApplyChanges(){
+        for(auto& slot : slots){
+            if (!slot.inUse){
+                continue;
+            }
+            if (slot.removed){
+                if (slot.index >= 0){
+                    crowd->removeAgent(slot.index);
+                    slot.index = -1;
+                }
+                slot.inUse = false;
+                freeSlots.push_back(&slot);
+                continue;
+            }
+
+            if (slot.index < 0){
+                const auto ap = ToDetour(slot.params);
+                slot.index = crowd->addAgent(slot.position, &ap);
+                if (slot.index < 0){
+                    if (!warnedFull){
+                        Debug::Warning("Crowd is full with {} agents, agents are waiting to be added", maxAgents);
+                        warnedFull = true;
+                    }
+                    continue;
+                }
+                slot.paramsDirty = false;
+            }
+            else if (slot.paramsDirty){
+                const auto ap = ToDetour(slot.params);
+                crowd->updateAgentParameters(slot.index, &ap);
+                slot.paramsDirty = false;
+            }
+
+            if (slot.requestDirty){
+                ApplyRequest(slot);
+                slot.requestDirty = false;
+            }
+        }
+    }
+
+    void ApplyRequest(Slot& slot){
+        switch(slot.request){
+            case Slot::Request::Target:{
+                dtPolyRef ref = 0;
+                float nearest[3];
+                auto query = crowd->getNavMeshQuery();
+                if (dtStatusFailed(query->findNearestPoly(slot.target, crowd->getQueryHalfExtents(), crowd->getFilter(0), &ref, nearest)) || ref == 0){
+                    Debug::Warning("Crowd agent target ({}, {}, {}) is not on the navmesh", slot.target[0], slot.target[1], slot.target[2]);
+                    slot.request = Slot::Request::None;
+                    break;
+                }
+                crowd->requestMoveTarget(slot.index, ref, nearest);
+            }
+                break;
+            case Slot::Request::Velocity:
+                crowd->requestMoveVelocity(slot.index, slot.target);
+                break;
+            case Slot::Request::Stop:
+                crowd->resetMoveTarget(slot.index);
+                // the agent stays stopped if it is added again, so there is nothing to remember
+                slot.request = Slot::Request::None;
+                break;
+            case Slot::Request::None:
+                break;
+        }
+    }
+
+    void ReadBack(){
+        numAgents = 0;
+        for(auto& slot : slots){
+            if (slot.index < 0){
+                continue;
+            }
+            auto agent = crowd->getAgent(slot.index);
+            dtVcopy(slot.position, agent->npos);
+            dtVcopy(slot.velocity, agent->vel);
+            slot.faceVelocity = slot.params.faceVelocity;
+            numAgents++;
+        }
+    }
+};
+
+CrowdComponent::CrowdComponent(const NavMeshComponent& navMesh, uint16_t maxAgents, float maxAgentRadius) : state(std::make_shared<State>(navMesh.shared, maxAgents, maxAgentRadius)){}
+
+void CrowdComponent::Update(float deltaSeconds, const matrix4& worldMatrix){
+    NavMeshComponent::ReadNavMesh(*state->navMesh, [&](dtNavMesh* navMesh, const std::shared_ptr<void>& handle){
+        {
+            RAIILock lock(state->mtx);
+            state->worldMatrix = worldMatrix;
+            if (handle != state->navMeshHandle){
+                state->Reset(navMesh, handle);
+            }
+            state->ApplyChanges();
+        }
+
+        // agents only touch their slots, so they can keep making requests while the crowd updates
+        state->crowd->update(deltaSeconds, nullptr);
+
+        RAIILock lock(state->mtx);
+        state->ReadBack();
+    });
+}
+
+uint32_t CrowdComponent::GetNumAgents() const{
+    RAIILock lock(state->mtx);
+    return state->numAgents;
+}
+
+CrowdAgentComponent::CrowdAgentComponent(const CrowdComponent& crowd, const vector3& position, const Params& params) : crowd(crowd.state){
+    Debug::Assert(params.radius <= this->crowd->maxAgentRadius, "Agent radius {} exceeds the crowd's maximum of {}", params.radius, this->crowd->maxAgentRadius);
+    RAIILock lock(this->crowd->mtx);
+    slot = this->crowd->Allocate(position, params);
+}
+
+void CrowdAgentComponent::MoveTo(const vector3& target){
+    RAIILock lock(crowd->mtx);
+    slot->request = CrowdComponent::Slot::Request::Target;
+    slot->target[0] = target.x;
+    slot->target[1] = target.y;
+    slot->target[2] = target.z;
+    slot->requestDirty = true;
+}
+
+void CrowdAgentComponent::SetVelocity(const vector3& velocity){
+    RAIILock lock(crowd->mtx);
+    slot->request = CrowdComponent::Slot::Request::Velocity;
+    slot->target[0] = velocity.x;
+    slot->target[1] = velocity.y;
+    slot->target[2] = velocity.z;
+    slot->requestDirty = true;
+}
+
+void CrowdAgentComponent::Stop(){
+    RAIILock lock(crowd->mtx);
+    slot->request = CrowdComponent::Slot::Request::Stop;
+    slot->requestDirty = true;
+}
+
+void CrowdAgentComponent::SetParams(const Params& params){
+    Debug::Assert(params.radius <= crowd->maxAgentRadius, "Agent radius {} exceeds the crowd's maximum of {}", params.radius, crowd->maxAgentRadius);
+    RAIILock lock(crowd->mtx);
+    slot->params = params;
+    slot->paramsDirty = true;
+}
+
+CrowdAgentComponent::Params CrowdAgentComponent::GetParams() const{
+    RAIILock lock(crowd->mtx);
+    return slot->params;
+}
+
+vector3 CrowdAgentComponent::GetPosition() const{
+    RAIILock lock(crowd->mtx);
+    return vector3(slot->position[0], slot->position[1], slot->position[2]);
+}
+
+vector3 CrowdAgentComponent::GetVelocity() const{
+    RAIILock lock(crowd->mtx);
+    return vector3(slot->velocity[0], slot->velocity[1], slot->velocity[2]);
+}
+
+void CrowdAgentComponent::WriteTransform(Transform& transform) const{
+    // the crowd only writes slots while it updates, which finishes before this runs, so there is no need to lock
+    if (slot->index < 0){
+        return;
+    }
+    const auto& world = crowd->worldMatrix;
+    transform.SetWorldPosition(vector3(world * vector4(slot->position[0], slot->position[1], slot->position[2], 1)));
+
+    if (slot->faceVelocity){
+        const auto dir = matrix3(world) * vector3(slot->velocity[0], slot->velocity[1], slot->velocity[2]);
+        if (dir.x * dir.x + dir.z * dir.z > 1e-6){
+            // turn about the Y axis, so that forward (-Z) points along the horizontal velocity
+            transform.SetWorldRotation(glm::angleAxis(decimalType(std::atan2(-dir.x, -dir.z)), vector3(0, 1, 0)));
+        }
+    }
+}
+
+void CrowdAgentComponent::Destroy(){
+    if (crowd){
+        RAIILock lock(crowd->mtx);
+        slot->removed = true;
+    }
+}
@@ -0,0 +1,101 @@
+#include "CullingVolume.hpp"
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+#include <glm/vector_relational.hpp>
+#include <cmath>
+#include <algorithm>
+
+using namespace RavEngine;
+
+bool AABB::Contains(const AABB& other) const{
+    return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+}
+
+bool AABB::Overlaps(const AABB& other) const{
+    return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+}
+
+AABB AABB::Union(const AABB& other) const{
+    return {glm::min(min, other.min), glm::max(max, other.max)};
+}
+
+float AABB::Perimeter() const{
+    const auto extent = max - min;
+    return 2 * (extent.x + extent.y + extent.z);
+}
+
+namespace{
+    /**
+     @return false if the box is entirely on the negative side of the plane
+     */
+    bool OnPositiveSide(const AABB& box, const glm::vec3& normal, float distance){
+        // the corner furthest along the normal is the last to leave
+        const glm::vec3 corner(
+            normal.x >= 0 ? box.max.x : box.min.x,
+            normal.y >= 0 ? box.max.y : box.min.y,
+            normal.z >= 0 ? box.max.z : box.min.z
+        );
+        return glm::dot(corner, normal) + distance >= 0;
+    }
+}
+
+Frustum::Frustum(const glm::mat4& viewProj){
+    for (int i = 0; i < 4; i++) {
+        planes[0][i] = viewProj[i][3] + viewProj[i][0];
+        planes[1][i] = viewProj[i][3] - viewProj[i][0];
+        planes[2][i] = viewProj[i][3] + viewProj[i][1];
+        planes[3][i] = viewProj[i][3] - viewProj[i][1];
+        planes[4][i] = viewProj[i][3] + viewProj[i][2];
+        planes[5][i] = viewProj[i][3] - viewProj[i][2];
+    }
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const{
+    for (const auto& plane : planes) {
+        if (glm::dot(glm::vec4(center, 1), plane) < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::Intersects(const AABB& box) const{
+    for (const auto& plane : planes) {
+        if (!OnPositiveSide(box, glm::vec3(plane), plane.w)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BoundingSphere::Intersects(const AABB& box) const{
+    const auto closest = glm::clamp(center, box.min, box.max);
+    const auto toClosest = closest - center;
+    return glm::dot(toClosest, toClosest) <= radius * radius;
+}
+
+bool BoundingCone::Intersects(const AABB& box) const{
+    // behind the apex, or beyond the cap
+    if (!OnPositiveSide(box, axis, -glm::dot(axis, apex)) || !OnPositiveSide(box, -axis, glm::dot(axis, apex) + range)) {
+        return false;
+    }
+
+    // the sides are approximated by planes tangent to the cone, which together enclose it
+    const auto helper = std::abs(axis.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+    const auto u = glm::normalize(glm::cross(axis, helper));
+    const auto v = glm::cross(axis, u);
+    const auto cosAngle = std::cos(halfAngle), sinAngle = std::sin(halfAngle);
+    constexpr int numSides = 8;
+    for (int i = 0; i < numSides; i++) {
+        const float around = 2 * 3.14159265358979f * i / numSides;
+        const auto outwards = std::cos(around) * u + std::sin(around) * v;
+        const auto normal = sinAngle * axis - cosAngle * outwards;    // points into the cone
+        if (!OnPositiveSide(box, normal, -glm::dot(normal, apex))) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,8 @@
+#include "Manager.hpp"
+#include "App.hpp"
+
+using namespace RavEngine;
+
+void CacheBase::Dispatch(Function<void()>&& load){
+	GetApp()->executor.silent_async(std::move(load));
+}
@@ -4,6 +4,7 @@
 #include <filesystem>
 #include "Debug.hpp"
 #include "VirtualFileSystem.hpp"
+#include <meshoptimizer.h>
 #if !RVE_SERVER
     #include "RenderEngine.hpp"
     #include <RGL/Buffer.hpp>
@@ -15,58 +16,142 @@ using namespace RavEngine;
 // Vertex data structure
 using namespace std;
 
-MeshPart RavEngine::MeshAsset::DeserializeMesh(const istream& stream)
-{
-	return {};
+namespace {
+	void CheckHeader(const SerializedMeshDataHeader& header) {
+		if (strncmp(header.header.data(), "rvem", sizeof("rvem") - 1) != 0) {
+			Debug::Fatal("Header does not match, data is not a mesh!");
+		}
+		if (header.version != SerializedMeshDataHeader::currentVersion) {
+			Debug::Fatal("Mesh was compiled with an incompatible version of rvemc, recompile it");
+		}
+	}
 }
 
-std::pair<MeshPart, uint32_t> RavEngine::MeshAsset::DeserializeMeshFromMemory(const std::span<uint8_t> mem)
+MeshPart RavEngine::MeshAsset::DeserializeMesh(istream& stream, SerializedMeshDataHeader& header)
 {
-	uint8_t* fp = mem.data();
-	SerializedMeshDataHeader header = *reinterpret_cast<SerializedMeshDataHeader*>(fp);
-	fp += sizeof(SerializedMeshDataHeader);
-
-	// check header
-	if (strncmp(header.header.data(), "rvem", sizeof("rvem") - 1) != 0) {
-		Debug::Fatal("Header does not match, data is not a mesh!");
+	if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		Debug::Fatal("Mesh data is truncated");
 	}
+	CheckHeader(header);
 
 	MeshPart mesh;
-	mesh.indices.reserve(header.numIndicies);
-	mesh.vertices.reserve(header.numVertices);
+	if (header.IsCompressed()) {
+		Vector<uint8_t> data(header.MeshletDataOffset());
+		std::memcpy(data.data(), &header, sizeof(header));
+		if (!stream.read(reinterpret_cast<char*>(data.data() + sizeof(header)), data.size() - sizeof(header))) {
+			Debug::Fatal("Mesh data is truncated");
+		}
+		DeserializeMeshFromMemory(data, header, mesh);
+		return mesh;
+	}
 
-	// load vertices
-	for (int i = 0; i < header.numVertices; i++) {
-		VertexNormalUV vert = *reinterpret_cast<decltype(vert)*>(fp);
-		mesh.vertices.push_back(vert);
+	mesh.vertices.resize(header.numVertices);
+	mesh.indices.resize(header.numIndicies);
+	stream.read(reinterpret_cast<char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(vertex_t));
+	stream.read(reinterpret_cast<char*>(mesh.indices.data()), mesh.indices.size() * sizeof(uint32_t));
+	if (!stream) {
+		Debug::Fatal("Mesh data is truncated");
+	}
+	return mesh;
+}
 
-		fp += sizeof(vert);
+MeshPartView RavEngine::MeshAsset::DeserializeMeshFromMemory(const std::span<const uint8_t> mem, SerializedMeshDataHeader& header, MeshPart& decoded)
+{
+	Debug::Assert(mem.size() >= sizeof(header), "Mesh data is truncated");
+	std::memcpy(&header, mem.data(), sizeof(header));
+	CheckHeader(header);
+	Debug::Assert(mem.size() >= header.MeshletDataOffset(), "Mesh data is truncated");
+
+	if (header.IsCompressed()) {
+		Vector<QuantizedVertex> quantized(header.numVertices);
+		if (meshopt_decodeVertexBuffer(quantized.data(), quantized.size(), sizeof(QuantizedVertex), mem.data() + sizeof(header), header.encodedVertexBytes) != 0) {
+			Debug::Fatal("Mesh vertex data is corrupt");
+		}
+		decoded.vertices.resize(header.numVertices);
+		for (uint32_t i = 0; i < header.numVertices; i++) {
+			decoded.vertices[i] = quantized[i].Dequantize();
+		}
+		decoded.indices.resize(header.numIndicies);
+		if (meshopt_decodeIndexBuffer(decoded.indices.data(), decoded.indices.size(), mem.data() + header.IndexDataOffset(), header.encodedIndexBytes) != 0) {
+			Debug::Fatal("Mesh index data is corrupt");
+		}
+		return decoded;
 	}
 
-	for (int i = 0; i < header.numIndicies; i++) {
-		uint32_t ind = *reinterpret_cast<decltype(ind)*>(fp);
-		mesh.indices.push_back(ind);
+	// file views and asset pack entries are aligned, and the header keeps the data after it aligned
+	Debug::Assert(reinterpret_cast<uintptr_t>(mem.data()) % alignof(vertex_t) == 0, "Mesh data is not aligned");
 
-		fp += sizeof(ind);
-	}
+	auto vertices = reinterpret_cast<const vertex_t*>(mem.data() + sizeof(header));
+	auto indices = reinterpret_cast<const uint32_t*>(mem.data() + header.IndexDataOffset());
 
-	return { mesh, fp - mem.data()};
+	MeshPartView mesh;
+	mesh.vertices = { vertices, header.numVertices };
+	mesh.indices = { indices, header.numIndicies };
+	return mesh;
 }
 
 MeshAsset::MeshAsset(const string& name, const MeshAssetOptions& options){
 	string dir = Format("meshes/{}.rvem", name);
-	auto str = GetApp()->GetResources().FileContentsAt(dir.c_str());
+	auto data = GetApp()->GetResources().FileViewAt(dir.c_str());
 
-	auto mesh = DeserializeMeshFromMemory(str);
-	InitializeFromRawMesh(mesh.first, options);
+	InitializeFromSerialized(data.span(), options);
 }
 
 MeshAsset::MeshAsset(const Filesystem::Path& path, const MeshAssetOptions& opt){
-	
-	auto mesh = DeserializeMesh(ifstream(path, std::ios::binary));
-	InitializeFromRawMesh(mesh, opt);
+	ifstream stream(path, std::ios::binary);
+	if (!stream) {
+		Debug::Fatal("Cannot open {}", path.string());
+	}
+	SerializedMeshDataHeader header;
+	auto mesh = DeserializeMesh(stream, header);
+	InitializeFromSerializedMesh(mesh, header, opt);
+	if (header.HasMeshlets()) {
+		// the stream is at the end of the indices, where the meshlet block starts
+		Vector<uint8_t> block(header.meshletBytes);
+		if (!stream.read(reinterpret_cast<char*>(block.data()), block.size())) {
+			Debug::Fatal("Mesh data is truncated");
+		}
+		meshlets = MeshletData::Deserialize(block);
+	}
 }
 
+MeshAsset::MeshAsset(const std::span<const uint8_t> serialized, const MeshAssetOptions& options){
+	InitializeFromSerialized(serialized, options);
+}
+
+void MeshAsset::InitializeFromSerialized(const std::span<const uint8_t> serialized, const MeshAssetOptions& options){
+	SerializedMeshDataHeader header;
+	MeshPart decoded;
+	auto mesh = DeserializeMeshFromMemory(serialized, header, decoded);
+	InitializeFromSerializedMesh(mesh, header, options);
+	if (header.HasMeshlets()) {
+		Debug::Assert(serialized.size() >= header.MeshDataSize(), "Mesh data is truncated");
+		meshlets = MeshletData::Deserialize(serialized.subspan(header.MeshletDataOffset(), header.meshletBytes));
+	}
+}
+
+RavEngine::Vector<MeshAsset::Lod> MeshAsset::DeserializeLods(const std::span<const uint8_t> data, const MeshAssetOptions& options){
+	SerializedMeshLodHeader header;
+	Debug::Assert(data.size() >= sizeof(header), "LOD chain is truncated");
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (strncmp(header.header.data(), "rvld", sizeof("rvld") - 1) != 0) {
+		Debug::Fatal("Header does not match, data is not a LOD chain!");
+	}
+	if (header.version != SerializedMeshLodHeader::currentVersion) {
+		Debug::Fatal("LOD chain was generated with an incompatible version of rvemc, recompile it");
+	}
+	Debug::Assert(data.size() >= sizeof(header) + header.numLods * sizeof(SerializedMeshLodEntry), "LOD chain is truncated");
+
+	RavEngine::Vector<Lod> lods;
+	lods.reserve(header.numLods);
+	for (uint32_t i = 0; i < header.numLods; i++) {
+		SerializedMeshLodEntry entry;
+		std::memcpy(&entry, data.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+		Debug::Assert(entry.dataOffset + entry.dataSize <= data.size(), "LOD chain is truncated");
+		lods.push_back({ std::make_shared<MeshAsset>(data.subspan(entry.dataOffset, entry.dataSize), options), entry.minDistance });
+	}
+	return lods;
+}
 
 RavEngine::MeshAsset::~MeshAsset()
 {
@@ -114,17 +199,7 @@ void MeshAsset::InitializeFromRawMesh(const MeshPart& allMeshes, const MeshAsset
 void MeshAsset::InitializeFromRawMeshView(const MeshPartView& allMeshes, const MeshAssetOptions& options){
     
     // calculate bounding box
-    for(const auto& vert : allMeshes.vertices){
-        bounds.max[0] = std::max<decimalType>(bounds.max[0],vert.position[0]);
-        bounds.max[1] = std::max<decimalType>(bounds.max[1],vert.position[1]);
-        bounds.max[2] = std::max<decimalType>(bounds.max[2],vert.position[2]);
-        
-        bounds.min[0] = std::min<decimalType>(bounds.min[0],vert.position[0]);
-        bounds.min[1] = std::min<decimalType>(bounds.min[1],vert.position[1]);
-        bounds.min[2] = std::min<decimalType>(bounds.min[2],vert.position[2]);
-        
-        radius = std::max(radius, glm::distance(glm::vec3(vert.position[0],vert.position[1],vert.position[2]), glm::vec3(0,0,0)));
-    }
+    CalculateBounds(allMeshes.vertices, bounds, radius);
     
     if (options.uploadToGPU){
 	
@@ -138,3 +213,20 @@ void MeshAsset::InitializeFromRawMeshView(const MeshPartView& allMeshes, const M
 #endif
     }
 }
+
+void MeshAsset::InitializeFromSerializedMesh(const MeshPartView& mesh, const SerializedMeshDataHeader& header, const MeshAssetOptions& options){
+    if (options.keepInSystemRAM){
+        systemRAMcopy.vertices.assign(mesh.vertices.begin(), mesh.vertices.end());
+        systemRAMcopy.indices.assign(mesh.indices.begin(), mesh.indices.end());
+    }
+    bounds = header.bounds;
+    radius = header.radius;
+    
+    if (options.uploadToGPU){
+        totalVerts = mesh.vertices.size();
+        totalIndices = mesh.indices.size();
+#if !RVE_SERVER
+		meshAllocation = GetApp()->GetRenderEngine().AllocateMesh(mesh.vertices, mesh.indices);
+#endif
+    }
+}
@@ -31,32 +31,26 @@ MeshAssetSkinned::MeshAssetSkinned(const std::string& path) // we intentionally
 		Debug::Fatal("No asset at {}",fullpath);
 	}
 	
-	auto str = GetApp()->GetResources().FileContentsAt(fullpath.c_str());
+	auto str = GetApp()->GetResources().FileViewAt(fullpath.c_str());
 
 
-	auto mesh = DeserializeMeshFromMemory(str);
-	InitializeFromRawMesh(mesh.first, MeshAssetOptions{ false,true });	// this intializes the staticmesh part
+	SerializedMeshDataHeader header;
+	MeshPart decoded;
+	auto mesh = DeserializeMeshFromMemory(str.span(), header, decoded);
+	InitializeFromSerializedMesh(mesh, header, MeshAssetOptions{ false,true });	// this intializes the staticmesh part
 	
 	
 #if !RVE_SERVER
-	// mesh.second has the file offset
-
-	// check if there is weight data
-	if (str.size() - mesh.second < 4) {
+	// skin data follows the indices
+	if (!(header.attributes & SerializedMeshDataHeader::SkinnedMeshBit)) {
 		Debug::Fatal("Mesh is probably not a skinned mesh");
 	}
 
-	uint8* fp = str.data() + mesh.second;
+	const uint8_t* fp = str.data() + header.MeshDataSize();
 	auto size = ((str.data() + str.size()) - fp) / sizeof(VertexWeights);
 	Debug::Assert(size == GetNumVerts(),"Skin does not have vertex weights for every vertex, input file is corrupt");
 
-	//make gpu version
-    std::vector<VertexWeights> weightsgpu;
-	weightsgpu.reserve(size);
-	for (int i = 0; i < size; i++) {
-		VertexWeights weights = *(reinterpret_cast<VertexWeights*>(fp)+i);
-		weightsgpu.push_back(weights);
-	}
+	std::span<const VertexWeights> weightsgpu{ reinterpret_cast<const VertexWeights*>(fp), size };
 
 	//map to GPU
 	weightsBuffer = GetApp()->GetDevice()->CreateBuffer({
@@ -66,7 +60,7 @@ MeshAssetSkinned::MeshAssetSkinned(const std::string& path) // we intentionally
 		RGL::BufferAccess::Private,
 		{.Writable = false}
 	});
-	weightsBuffer->SetBufferData({ weightsgpu.data(),weightsgpu.size() * sizeof(decltype(weightsgpu)::value_type)});
+	weightsBuffer->SetBufferData({ weightsgpu.data(),weightsgpu.size_bytes()});
 #endif
 }
 
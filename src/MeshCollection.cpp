@@ -3,6 +3,8 @@
 #include "MeshAsset.hpp"
 #include "MeshAssetSkinned.hpp"
 #include "MeshAllocation.hpp"
+#include "App.hpp"
+#include "VirtualFileSystem.hpp"
 
 namespace RavEngine {
 	MeshCollectionStatic::MeshCollectionStatic(std::span<Entry> meshes)
@@ -24,6 +26,24 @@ namespace RavEngine {
 		AddMesh({mesh, std::numeric_limits<float>::infinity()});
 	}
 
+	MeshCollectionStatic::MeshCollectionStatic(const std::string& meshName, const MeshAssetOptions& opt)
+	{
+		auto base = MeshAsset::Manager::Get(meshName, opt);
+		auto lodPath = Format("meshes/{}.rvelod", meshName);
+		auto& resources = GetApp()->GetResources();
+		if (!resources.Exists(lodPath.c_str())) {
+			AddMesh({ base, std::numeric_limits<float>::infinity() });
+			return;
+		}
+
+		auto lods = MeshAsset::DeserializeLods(resources.FileViewAt(lodPath.c_str()).span(), opt);
+		Reserve(lods.size() + 1);
+		AddMesh({ base, 0 });
+		for (const auto& lod : lods) {
+			AddMesh({ lod.mesh, lod.minDistance });
+		}
+	}
+
 	void MeshCollectionStatic::AddMesh(const Entry& m)
 	{
 		meshes.push_back(m.mesh);
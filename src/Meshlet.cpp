@@ -0,0 +1,54 @@
+#include "Meshlet.hpp"
+#include "Debug.hpp"
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <cstring>
+#include <algorithm>
+
+using namespace RavEngine;
+
+MeshletData MeshletData::Deserialize(std::span<const uint8_t> block){
+    SerializedMeshletHeader header;
+    Debug::Assert(block.size() >= sizeof(header), "Meshlet data is truncated");
+    std::memcpy(&header, block.data(), sizeof(header));
+    const auto meshletBytes = header.numMeshlets * sizeof(Meshlet);
+    const auto vertexBytes = header.numVertices * sizeof(uint32_t);
+    Debug::Assert(block.size() >= sizeof(header) + meshletBytes + vertexBytes + header.numTriangleBytes, "Meshlet data is truncated");
+
+    MeshletData data;
+    data.meshlets.resize(header.numMeshlets);
+    data.vertices.resize(header.numVertices);
+    data.triangles.resize(header.numTriangleBytes);
+    auto fp = block.data() + sizeof(header);
+    std::memcpy(data.meshlets.data(), fp, meshletBytes);
+    fp += meshletBytes;
+    std::memcpy(data.vertices.data(), fp, vertexBytes);
+    fp += vertexBytes;
+    std::memcpy(data.triangles.data(), fp, header.numTriangleBytes);
+    return data;
+}
+
+void RavEngine::CullMeshlets(std::span<const Meshlet> meshlets, const glm::mat4& model, const Frustum& frustum, const glm::vec3& cameraPosition, Vector<uint32_t>& visible){
+    // spheres are tested in world space, scaled by the largest axis scale like the GPU culling shader
+    const float scale = std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))});
+
+    // cones are tested in the mesh's space, where they were computed. Which side of a triangle faces
+    // the camera does not change under an affine transform, so this is exact even with non-uniform scale.
+    const auto localCamera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1));
+
+    for (uint32_t i = 0; i < meshlets.size(); i++) {
+        const auto& meshlet = meshlets[i];
+        const glm::vec3 apex(meshlet.coneApex[0], meshlet.coneApex[1], meshlet.coneApex[2]);
+        const glm::vec3 axis(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]);
+        const auto toApex = apex - localCamera;
+        const auto distance = glm::length(toApex);
+        if (meshlet.coneCutoff < 1 && distance > 0 && glm::dot(toApex, axis) >= meshlet.coneCutoff * distance) {
+            continue;   // every triangle faces away from the camera
+        }
+
+        const auto center = glm::vec3(model * glm::vec4(meshlet.center[0], meshlet.center[1], meshlet.center[2], 1));
+        if (frustum.IntersectsSphere(center, meshlet.radius * scale)) {
+            visible.push_back(i);
+        }
+    }
+}
@@ -4,324 +4,1016 @@
 #include <DetourNavMesh.h>
 #include <DetourNavMeshBuilder.h>
 #include <DetourCommon.h>
-#include <DetourCrowd.h>
 #include <DetourNavMeshQuery.h>
+#include <DetourTileCache.h>
+#include <DetourTileCacheBuilder.h>
 #include <DetourDebugDraw.h>
 #include "App.hpp"
 #include "MeshAsset.hpp"
+#include "VirtualFileSystem.hpp"
+#include "Map.hpp"
 #include "RenderEngine.hpp"
+#include <taskflow/taskflow.hpp>
+#include <atomic>
+#include <shared_mutex>
 
 using namespace std;
 using namespace RavEngine;
 
-NavMeshComponent::NavMeshComponent(Ref<MeshAsset> mesh, Options opt){
-    UpdateNavMesh(mesh, opt);
+namespace {
+    /**
+     Layers are kept uncompressed. They are only decompressed when an obstacle rebuilds a tile,
+     so this trades some memory for not needing a compression library.
+     */
+    struct UncompressedLayers : public dtTileCacheCompressor{
+        int maxCompressedSize(const int bufferSize) final{
+            return bufferSize;
+        }
+        dtStatus compress(const unsigned char* buffer, const int bufferSize, unsigned char* compressed, const int maxCompressedSize, int* compressedSize) final{
+            if (bufferSize > maxCompressedSize){
+                return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+            }
+            std::memcpy(compressed, buffer, bufferSize);
+            *compressedSize = bufferSize;
+            return DT_SUCCESS;
+        }
+        dtStatus decompress(const unsigned char* compressed, const int compressedSize, unsigned char* buffer, const int maxBufferSize, int* bufferSize) final{
+            if (compressedSize > maxBufferSize){
+                return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+            }
+            std::memcpy(buffer, compressed, compressedSize);
+            *bufferSize = compressedSize;
+            return DT_SUCCESS;
+        }
+    };
+
+    struct WalkablePolys : public dtTileCacheMeshProcess{
+        void process(dtNavMeshCreateParams* params, unsigned char* polyAreas, unsigned short* polyFlags) final{
+            // set all poly flags to 1 so that the default query filter includes them
+            for(int i = 0; i < params->polyCount; i++){
+                polyFlags[i] = 1;
+            }
+        }
+    };
+
+    // stateless, so every tile cache shares them
+    dtTileCacheAlloc tileAllocator;
+    UncompressedLayers tileCompressor;
+    WalkablePolys tileMeshProcess;
+
+    // sliced queries keep a pointer to their filter, so it must outlive them
+    const dtQueryFilter defaultFilter;
+    constexpr int maxQueryNodes = 2048;
+
+    /**
+     Find the polygons nearest to the ends of a path
+     @return Pending if both were found, otherwise the reason the path cannot be found
+     */
+    NavMeshComponent::PathResult::Status LocateEnds(const dtNavMeshQuery& query, const NavMeshComponent::PathRequest& request, dtPolyRef& startPoly, dtPolyRef& endPoly, float* startPos, float* endPos){
+        using Status = NavMeshComponent::PathResult::Status;
+        const float startf[3]{static_cast<float>(request.start.x),static_cast<float>(request.start.y),static_cast<float>(request.start.z)};
+        const float endf[3]{static_cast<float>(request.end.x),static_cast<float>(request.end.y),static_cast<float>(request.end.z)};
+        const float extents[3]{static_cast<float>(request.searchExtents.x),static_cast<float>(request.searchExtents.y),static_cast<float>(request.searchExtents.z)};
+        startPoly = endPoly = 0;
+        if (dtStatusFailed(query.findNearestPoly(startf, extents, &defaultFilter, &startPoly, startPos)) || startPoly == 0){
+            return Status::NoStart;
+        }
+        if (dtStatusFailed(query.findNearestPoly(endf, extents, &defaultFilter, &endPoly, endPos)) || endPoly == 0){
+            return Status::NoEnd;
+        }
+        return Status::Pending;
+    }
+
+    /**
+     Turn a polygon corridor into points
+     @param status the result of the corridor search
+     */
+    void StraightenPath(const dtNavMeshQuery& query, const float* startPos, const float* endPos, const dtPolyRef* polys, int npolys, dtStatus status, uint16_t maxPoints, NavMeshComponent::PathResult& result){
+        using Status = NavMeshComponent::PathResult::Status;
+        if (dtStatusFailed(status) || npolys == 0){
+            result.status = Status::Failed;
+            return;
+        }
+        const bool partial = dtStatusDetail(status, DT_PARTIAL_RESULT);
+        float target[3];
+        dtVcopy(target, endPos);
+        if (partial){
+            // the end is unreachable, so stop at the closest point of the last reachable polygon
+            query.closestPointOnPoly(polys[npolys - 1], endPos, target, nullptr);
+        }
+        Vector<float> straightPath(maxPoints * 3);
+        int npoints = 0;
+        if (dtStatusFailed(query.findStraightPath(startPos, target, polys, npolys, straightPath.data(), nullptr, nullptr, &npoints, maxPoints))){
+            result.status = Status::Failed;
+            return;
+        }
+        result.points.resize(npoints);
+        for(int i = 0; i < npoints; i++){
+            result.points[i] = vector3(straightPath[i * 3], straightPath[i * 3 + 1], straightPath[i * 3 + 2]);
+        }
+        result.status = partial ? Status::Partial : Status::Complete;
+    }
+
+    struct Geometry{
+        Vector<float> verts;
+        Vector<int> tris;
+        Bounds bounds;
+        Vector<Vector<int>> tileTriangles;  // triangles overlapping each tile, including its border
+    };
+
+    // compressed layers produced for one tile
+    using TileLayers = Vector<std::pair<unsigned char*, int>>;
+
+    Geometry ExtractGeometry(MeshAsset& mesh){
+        Debug::Assert(mesh.hasSystemRAMCopy(),"MeshAsset must be created with keepInSystemRAM = true");
+        auto& rawData = mesh.GetSystemCopy();
+        Geometry geometry;
+        geometry.bounds = mesh.GetBounds();
+        geometry.verts.resize(rawData.vertices.size() * 3);
+        for(uint32_t i = 0; i < rawData.vertices.size(); i++){
+            geometry.verts[i*3] = rawData.vertices[i].position[0];
+            geometry.verts[i*3+1] = rawData.vertices[i].position[1];
+            geometry.verts[i*3+2] = rawData.vertices[i].position[2];
+        }
+        geometry.tris.resize(rawData.indices.size());
+        std::memcpy(geometry.tris.data(), rawData.indices.data(), rawData.indices.size() * sizeof(rawData.indices[0]));
+        return geometry;
+    }
+
+    rcConfig MakeConfig(const NavMeshComponent::Options& opt, const Bounds& bounds){
+        rcConfig cfg;
+        memset(&cfg,0,sizeof(cfg));
+        cfg.cs = opt.cellSize;
+        cfg.ch = opt.cellHeight;
+        cfg.walkableSlopeAngle = opt.agent.maxSlope;
+        cfg.walkableHeight = ceilf(opt.agent.height / cfg.ch);
+        cfg.walkableClimb = floorf(opt.agent.maxClimb / cfg.ch);
+        cfg.walkableRadius = ceilf(opt.agent.radius / cfg.cs);
+        cfg.maxEdgeLen = opt.maxEdgeLen / opt.cellSize;
+        cfg.maxSimplificationError = opt.maxSimplificationError;
+        cfg.minRegionArea = rcSqr(opt.regionMinDimension);
+        cfg.mergeRegionArea = rcSqr(opt.regionMergeDimension);
+        cfg.maxVertsPerPoly = opt.maxVertsPerPoly;
+        cfg.detailSampleDist = opt.detailSampleDist < 0.9? 0 : opt.cellSize * opt.detailSampleDist;
+        cfg.detailSampleMaxError = opt.cellHeight * opt.detailSampleMaxError;
+
+        // each tile is rasterized with a border so that neighboring tiles agree on their shared edges
+        cfg.tileSize = opt.tileSize;
+        cfg.borderSize = cfg.walkableRadius + 3;
+        cfg.width = cfg.tileSize + cfg.borderSize * 2;
+        cfg.height = cfg.tileSize + cfg.borderSize * 2;
+
+        rcVcopy(cfg.bmin, bounds.min);
+        rcVcopy(cfg.bmax, bounds.max);
+        return cfg;
+    }
 }
 
-void NavMeshComponent::UpdateNavMesh(Ref<MeshAsset> mesh, Options opt){
-    Debug::Assert(mesh->hasSystemRAMCopy(),"MeshAsset must be created with keepInSystemRAM = true");
-    mtx.lock();
-    // delete old values
-    dtFree(navMesh);
-    dtFree(navMeshQuery);
-    dtFree(navData);
-    
-    auto& rawData = mesh->GetSystemCopy();
-    bounds = mesh->GetBounds();
-    
-    const float* bmin = bounds.min;
-    const float* bmax = bounds.max;
-    
-    const auto nverts = rawData.vertices.size();
-    vector<float> vertsOnly(rawData.vertices.size() * 3);
-    for(uint32_t i = 0; i < rawData.vertices.size(); i++){
-        vertsOnly[i*3] = rawData.vertices[i].position[0];
-        vertsOnly[i*3+1] = rawData.vertices[i].position[1];
-        vertsOnly[i*3+2] = rawData.vertices[i].position[2];
-    }
-    
-    // step 1: setup configuration
+struct NavMeshComponent::Data{
+    Options options;
     rcConfig cfg;
-    memset(&cfg,0,sizeof(cfg));
-    cfg.cs = opt.cellSize;
-    cfg.ch = opt.cellHeight;
-    cfg.walkableSlopeAngle = opt.agent.maxSlope;
-    cfg.walkableHeight = ceilf(opt.agent.height / cfg.ch);
-    cfg.walkableClimb = ceilf(opt.agent.maxClimb / cfg.ch);
-    cfg.walkableRadius = ceilf(opt.agent.radius / cfg.cs);
-    cfg.maxEdgeLen = opt.maxEdgeLen / opt.cellSize;
-    cfg.maxSimplificationError = opt.maxSimplificationError;
-    cfg.minRegionArea = rcSqr(opt.regionMinDimension);
-    cfg.mergeRegionArea = rcSqr(opt.regionMergeDimension);
-    cfg.maxVertsPerPoly = opt.maxVertsPerPoly;
-    cfg.detailSampleDist = opt.detailSampleDist < 0.9? 0 : opt.cellSize * opt.detailSampleDist;
-    cfg.detailSampleMaxError = opt.cellHeight * opt.detailSampleMaxError;
-    
-    // setup bounds
-    rcVcopy(cfg.bmin, bmin);
-    rcVcopy(cfg.bmax, bmax);
-    rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &cfg.width, &cfg.height);
-    
-    rcContext ctx(0);
-    
-    // step 2: rasterize input polygon
-    auto solid = rcAllocHeightfield();
-    if (!solid){
-        Debug::Fatal("Build nagivation failed: out of memory");
-    }
-    if (!rcCreateHeightfield(&ctx, *solid, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch)){
-        Debug::Fatal("Height field generation failed");
-    }
-    
-    const int ntris = Debug::AssertSize<decltype(ntris)>(rawData.indices.size()/3);
-    // allocate array to hold triangle area types ( = number of triangles)
-    unsigned char* triareas = new unsigned char[ntris];
-    std::memset(triareas, 0, ntris * sizeof(triareas[0]));
-
-    const int* idxptr = nullptr;
-    std::vector<int> convertedIndices;
-    if (true/* rawData.indices.mode == MeshAsset::BitWidth::uint32*/) {
-        idxptr = reinterpret_cast<const int*>(rawData.indices.data());
-    }
-    else {
-        convertedIndices.reserve(rawData.indices.size());
-        for (int i = 0; i < rawData.indices.size(); i++) {
-            convertedIndices.push_back(rawData.indices[i]);
-        }
-        idxptr = reinterpret_cast<const int*>(convertedIndices.data());
-    }
-    
-    rcMarkWalkableTriangles(&ctx, cfg.walkableSlopeAngle, vertsOnly.data(), Debug::AssertSize<int>(nverts), idxptr, ntris, triareas);
-    if(!rcRasterizeTriangles(&ctx, vertsOnly.data(), Debug::AssertSize<int>(vertsOnly.size()), idxptr, triareas, ntris, *solid)){
-        Debug::Fatal("Could not rasterize triangles for navigation");
-    }
-    
-    delete[] triareas;  // don't need this anymore
-    
-    // step 3: filter walkable areas
-    rcFilterLowHangingWalkableObstacles(&ctx, cfg.walkableClimb, *solid);
-    rcFilterLedgeSpans(&ctx, cfg.walkableHeight, cfg.walkableClimb, *solid);
-    rcFilterWalkableLowHeightSpans(&ctx,cfg.walkableHeight, *solid);
-    
-    // step 4: partition walkable surfaces to simple regions
-    auto chf = rcAllocCompactHeightfield();
-    if (!chf){
-        Debug::Fatal("Failed to allocate compact height field");
-    }
-    if (!rcBuildCompactHeightfield(&ctx, cfg.walkableHeight, cfg.walkableClimb, *solid, *chf)){
-        Debug::Fatal("Compact height field generation failed");
-    }
-    rcFreeHeightField(solid);   // don't need this anymore
-    solid = nullptr;
-    
-    // Erode walkable area by agent radius
-    if (!rcErodeWalkableArea(&ctx, cfg.walkableRadius, *chf)){
-        Debug::Fatal("Walkable radius erode failed");
-    }
-    
-    switch(opt.partitionMethod){
-        case Options::Watershed:{
-            if (!rcBuildDistanceField(&ctx, *chf)){
-                Debug::Fatal("Distance field generation failed");
+    int tilesX = 0, tilesZ = 0;
+    Vector<uint32_t> tileStamps;    // the latest geometry update applied to each tile
+    uint32_t generation = 0;
+    dtNavMesh* navMesh = nullptr;
+    dtTileCache* tileCache = nullptr;
+
+    // dtNavMeshQuery holds search state, so each thread searching at once needs its own
+    Vector<dtNavMeshQuery*> workerQueries;  // one per executor worker, created on first use
+    SpinLock poolMtx;
+    Vector<dtNavMeshQuery*> pooledQueries;  // for threads outside the executor, and sliced searches
+
+    /**
+     Borrow a query for the calling thread for the duration of one search
+     */
+    struct QueryHandle{
+        Data& data;
+        dtNavMeshQuery* query;
+        bool pooled = false;
+
+        QueryHandle(Data& data) : data(data){
+            const auto worker = GetApp()->executor.this_worker_id();
+            if (worker >= 0 && worker < int(data.workerQueries.size())){
+                auto& workerQuery = data.workerQueries[worker];
+                if (!workerQuery){
+                    workerQuery = data.AllocQuery();
+                }
+                query = workerQuery;
             }
-            if (!rcBuildRegions(&ctx,*chf,0,cfg.minRegionArea,cfg.mergeRegionArea)){
-                Debug::Fatal("Region generation failed");
+            else{
+                query = data.AcquireQuery();
+                pooled = true;
             }
         }
-        break;
-        case Options::Monotone:{
-            if (!rcBuildRegionsMonotone(&ctx,*chf,0,cfg.minRegionArea,cfg.mergeRegionArea)){
-                Debug::Fatal("Monotone region generation failed");
+        ~QueryHandle(){
+            if (pooled){
+                data.ReleaseQuery(query);
             }
         }
-        break;
-        case Options::Layer:{
-            if (!rcBuildLayerRegions(&ctx,*chf,0,cfg.minRegionArea)){
-                Debug::Fatal("Layer region generation failed");
-            }
+        dtNavMeshQuery& operator*(){
+            return *query;
         }
-        break;
-    }
-    
-    // step 5: trace and simplify region contours
-    auto cset = rcAllocContourSet();
-    if (!cset){
-        Debug::Fatal("Could not allocate contour set");
-    }
-    if (!rcBuildContours(&ctx, *chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *cset)){
-        Debug::Fatal("Contour generation failed");
-    }
-    
-    // step 6: build polygon mesh from contours
-    auto pmesh = rcAllocPolyMesh();
-    if (!pmesh){
-        Debug::Fatal("PolyMesh allocation failed");
-    }
-    if(!rcBuildPolyMesh(&ctx, *cset, cfg.maxVertsPerPoly, *pmesh)){
-        Debug::Fatal("Contour triangulation failed");
-    }
-    // TODO: fix - for now, set all poly flags to 1 so that the filter includes them
-    for(int i = 0; i < pmesh->npolys; i++){
-        pmesh->flags[i] = 1;
-    }
-    
-    // step 7: create detail mesh to approximate height on each polygon
-    auto dmesh = rcAllocPolyMeshDetail();
-    if (!dmesh){
-        Debug::Fatal("Detail mesh allocation failed");
-    }
-    if (!rcBuildPolyMeshDetail(&ctx, *pmesh, *chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *dmesh)){
-        Debug::Fatal("Detail mesh generation failed");
-    }
-    
-    // no longer need these
-    rcFreeCompactHeightfield(chf);
-    rcFreeContourSet(cset);
-    chf = nullptr;
-    cset = nullptr;
-    
-    // step 8: create detour data
-    if (cfg.maxVertsPerPoly <= DT_VERTS_PER_POLYGON){
-        int navDataSize = 0;
-        
-        dtNavMeshCreateParams params;
-        memset(&params, 0, sizeof(params));
-        params.verts = pmesh->verts;
-        params.vertCount = pmesh->nverts;
-        params.polys = pmesh->polys;
-        params.polyAreas = pmesh->areas;
-        params.polyFlags = pmesh->flags;
-        params.polyCount = pmesh->npolys;
-        params.nvp = pmesh->nvp;
-        params.detailMeshes = dmesh->meshes;
-        params.detailVerts = dmesh->verts;
-        params.detailVertsCount = dmesh->nverts;
-        params.detailTris = dmesh->tris;
-        params.detailTriCount = dmesh->ntris;
-        params.offMeshConVerts = nullptr; // m_geom->getOffMeshConnectionVerts();
-        params.offMeshConRad = nullptr; //m_geom->getOffMeshConnectionRads();
-        params.offMeshConDir = nullptr; // m_geom->getOffMeshConnectionDirs();
-        params.offMeshConAreas = nullptr; // m_geom->getOffMeshConnectionAreas();
-        params.offMeshConFlags = nullptr; // m_geom->getOffMeshConnectionFlags();
-        params.offMeshConUserID = nullptr; // m_geom->getOffMeshConnectionId();
-        params.offMeshConCount = 0; // m_geom->getOffMeshConnectionCount();
-        params.walkableHeight = opt.agent.height;
-        params.walkableRadius = opt.agent.radius;
-        params.walkableClimb = opt.agent.maxClimb;
-        rcVcopy(params.bmin, pmesh->bmin);
-        rcVcopy(params.bmax, pmesh->bmax);
-        params.cs = cfg.cs;
-        params.ch = cfg.ch;
-        params.buildBvTree = true;
-        
-        if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
-        {
-            Debug::Fatal("Detour mesh data creation failed");
+    };
+
+    Data(const Options& opt, const Bounds& bounds, uint32_t generation) : options(opt), cfg(MakeConfig(opt, bounds)), generation(generation){
+        Debug::Assert(opt.maxVertsPerPoly <= DT_VERTS_PER_POLYGON, "Cannot generate Detour data for NavMesh - too many vertices per polygon");
+        Debug::Assert(opt.tileSize > 0 && opt.maxLayersPerTile > 0, "NavMesh tiles must have a nonzero size and layer count");
+
+        int gridWidth = 0, gridHeight = 0;
+        rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &gridWidth, &gridHeight);
+        tilesX = std::max((gridWidth + cfg.tileSize - 1) / cfg.tileSize, 1);
+        tilesZ = std::max((gridHeight + cfg.tileSize - 1) / cfg.tileSize, 1);
+        tileStamps.resize(tilesX * tilesZ, 0);
+
+        dtTileCacheParams tcparams;
+        memset(&tcparams, 0, sizeof(tcparams));
+        rcVcopy(tcparams.orig, cfg.bmin);
+        tcparams.cs = cfg.cs;
+        tcparams.ch = cfg.ch;
+        tcparams.width = cfg.tileSize;
+        tcparams.height = cfg.tileSize;
+        tcparams.walkableHeight = opt.agent.height;
+        tcparams.walkableRadius = opt.agent.radius;
+        tcparams.walkableClimb = opt.agent.maxClimb;
+        tcparams.maxSimplificationError = opt.maxSimplificationError;
+        tcparams.maxTiles = tilesX * tilesZ * opt.maxLayersPerTile;
+        tcparams.maxObstacles = opt.maxObstacles;
+
+        tileCache = dtAllocTileCache();
+        if (!tileCache || dtStatusFailed(tileCache->init(&tcparams, &tileAllocator, &tileCompressor, &tileMeshProcess))){
+            Debug::Fatal("Could not init Detour tile cache");
         }
-        
+
+        // Detour tile refs are 32 bits, split between tile and polygon indices
+        const int tileBits = std::min<int>(dtIlog2(dtNextPow2(tcparams.maxTiles)), 14);
+        dtNavMeshParams params;
+        memset(&params, 0, sizeof(params));
+        rcVcopy(params.orig, cfg.bmin);
+        params.tileWidth = cfg.tileSize * cfg.cs;
+        params.tileHeight = cfg.tileSize * cfg.cs;
+        params.maxTiles = 1 << tileBits;
+        params.maxPolys = 1 << (22 - tileBits);
+
         navMesh = dtAllocNavMesh();
-        if (!navMesh)
-        {
-            dtFree(navData);
-            Debug::Fatal("Detour mesh allocaton failed");
-        }
-        
-        dtStatus status;
-        
-        status = navMesh->init(navData, navDataSize, DT_TILE_FREE_DATA);
-        if (dtStatusFailed(status))
-        {
-            dtFree(navData);
+        if (!navMesh || dtStatusFailed(navMesh->init(&params))){
             Debug::Fatal("Could not init Detour navmesh");
         }
-        navMeshQuery = dtAllocNavMeshQuery();
-        if (!navMeshQuery){
-            Debug::Fatal("Could not allocate navmesh query");
+        workerQueries.resize(GetApp()->executor.num_workers(), nullptr);
+    }
+
+    Data(const Data&) = delete;
+
+    ~Data(){
+        for(auto query : workerQueries){
+            dtFreeNavMeshQuery(query);
         }
-        
-        status = navMeshQuery->init(navMesh, 2048);
-        if (dtStatusFailed(status))
-        {
+        for(auto query : pooledQueries){
+            dtFreeNavMeshQuery(query);
+        }
+        dtFreeTileCache(tileCache);
+        dtFreeNavMesh(navMesh);
+    }
+
+    dtNavMeshQuery* AllocQuery() const{
+        auto query = dtAllocNavMeshQuery();
+        if (!query || dtStatusFailed(query->init(navMesh, maxQueryNodes))){
             Debug::Fatal("Could not init Detour navmesh query");
         }
+        return query;
+    }
+
+    dtNavMeshQuery* AcquireQuery(){
+        {
+            RAIILock lock(poolMtx);
+            if (!pooledQueries.empty()){
+                auto query = pooledQueries.back();
+                pooledQueries.pop_back();
+                return query;
+            }
+        }
+        return AllocQuery();
+    }
+
+    void ReleaseQuery(dtNavMeshQuery* query){
+        RAIILock lock(poolMtx);
+        pooledQueries.push_back(query);
+    }
+
+    /**
+     Find a path. The caller must hold a shared lock.
+     */
+    void FindPath(dtNavMeshQuery& query, const PathRequest& request, PathResult& result) const{
+        dtPolyRef startPoly, endPoly;
+        float startPos[3], endPos[3];
+        result.status = LocateEnds(query, request, startPoly, endPoly, startPos, endPos);
+        if (result.status != PathResult::Status::Pending){
+            return;
+        }
+        Vector<dtPolyRef> polys(request.maxPoints);
+        int npolys = 0;
+        const auto status = query.findPath(startPoly, endPoly, startPos, endPos, &defaultFilter, polys.data(), &npolys, request.maxPoints);
+        StraightenPath(query, startPos, endPos, polys.data(), npolys, status, request.maxPoints, result);
+    }
+
+    /**
+     @return true if the geometry fits inside the tile grid, so that it can be updated incrementally
+     */
+    bool Contains(const Bounds& bounds) const{
+        for(int i = 0; i < 3; i++){
+            if (bounds.min[i] < cfg.bmin[i] || bounds.max[i] > cfg.bmax[i]){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     Sort triangles into the tiles they overlap
+     */
+    void BinTriangles(Geometry& geometry) const{
+        geometry.tileTriangles.clear();
+        geometry.tileTriangles.resize(tilesX * tilesZ);
+        const float tileWorldSize = cfg.tileSize * cfg.cs;
+        const float border = cfg.borderSize * cfg.cs;
+        auto tileCoord = [&](float pos, float origin, int numTiles){
+            return std::clamp(static_cast<int>(std::floor((pos - origin) / tileWorldSize)), 0, numTiles - 1);
+        };
+        const auto& verts = geometry.verts;
+        for(int tri = 0; tri < int(geometry.tris.size() / 3); tri++){
+            float minx = std::numeric_limits<float>::max(), minz = minx, maxx = std::numeric_limits<float>::lowest(), maxz = maxx;
+            for(int v = 0; v < 3; v++){
+                const float* pos = &verts[geometry.tris[tri * 3 + v] * 3];
+                minx = std::min(minx, pos[0]);
+                maxx = std::max(maxx, pos[0]);
+                minz = std::min(minz, pos[2]);
+                maxz = std::max(maxz, pos[2]);
+            }
+            const int x0 = tileCoord(minx - border, cfg.bmin[0], tilesX), x1 = tileCoord(maxx + border, cfg.bmin[0], tilesX);
+            const int z0 = tileCoord(minz - border, cfg.bmin[2], tilesZ), z1 = tileCoord(maxz + border, cfg.bmin[2], tilesZ);
+            for(int z = z0; z <= z1; z++){
+                for(int x = x0; x <= x1; x++){
+                    geometry.tileTriangles[x + z * tilesX].push_back(tri);
+                }
+            }
+        }
+    }
+
+    /**
+     Rasterize one tile into tile cache layers. Only reads shared state, so tiles can be rasterized in parallel.
+     */
+    TileLayers RasterizeTile(const Geometry& geometry, int tx, int tz) const{
+        TileLayers result;
+        const auto& triangles = geometry.tileTriangles[tx + tz * tilesX];
+        if (triangles.empty()){
+            return result;
+        }
+
+        rcContext ctx(false);
+        rcConfig tcfg = cfg;
+        const float tileWorldSize = cfg.tileSize * cfg.cs;
+        const float border = cfg.borderSize * cfg.cs;
+        tcfg.bmin[0] = cfg.bmin[0] + tx * tileWorldSize - border;
+        tcfg.bmin[2] = cfg.bmin[2] + tz * tileWorldSize - border;
+        tcfg.bmax[0] = cfg.bmin[0] + (tx + 1) * tileWorldSize + border;
+        tcfg.bmax[2] = cfg.bmin[2] + (tz + 1) * tileWorldSize + border;
+
+        Vector<int> tris;
+        tris.reserve(triangles.size() * 3);
+        for(auto tri : triangles){
+            tris.insert(tris.end(), geometry.tris.begin() + tri * 3, geometry.tris.begin() + tri * 3 + 3);
+        }
+        const int ntris = Debug::AssertSize<int>(triangles.size());
+        const int nverts = Debug::AssertSize<int>(geometry.verts.size() / 3);
+        Vector<unsigned char> triareas(ntris, 0);
+
+        std::unique_ptr<rcHeightfield, decltype(&rcFreeHeightField)> solid(rcAllocHeightfield(), &rcFreeHeightField);
+        if (!solid || !rcCreateHeightfield(&ctx, *solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch)){
+            Debug::Fatal("Height field generation failed");
+        }
+        rcMarkWalkableTriangles(&ctx, tcfg.walkableSlopeAngle, geometry.verts.data(), nverts, tris.data(), ntris, triareas.data());
+        if (!rcRasterizeTriangles(&ctx, geometry.verts.data(), nverts, tris.data(), triareas.data(), ntris, *solid, tcfg.walkableClimb)){
+            Debug::Fatal("Could not rasterize triangles for navigation");
+        }
+
+        rcFilterLowHangingWalkableObstacles(&ctx, tcfg.walkableClimb, *solid);
+        rcFilterLedgeSpans(&ctx, tcfg.walkableHeight, tcfg.walkableClimb, *solid);
+        rcFilterWalkableLowHeightSpans(&ctx, tcfg.walkableHeight, *solid);
+
+        std::unique_ptr<rcCompactHeightfield, decltype(&rcFreeCompactHeightfield)> chf(rcAllocCompactHeightfield(), &rcFreeCompactHeightfield);
+        if (!chf || !rcBuildCompactHeightfield(&ctx, tcfg.walkableHeight, tcfg.walkableClimb, *solid, *chf)){
+            Debug::Fatal("Compact height field generation failed");
+        }
+        solid.reset();
+        if (!rcErodeWalkableArea(&ctx, tcfg.walkableRadius, *chf)){
+            Debug::Fatal("Walkable radius erode failed");
+        }
+
+        std::unique_ptr<rcHeightfieldLayerSet, decltype(&rcFreeHeightfieldLayerSet)> lset(rcAllocHeightfieldLayerSet(), &rcFreeHeightfieldLayerSet);
+        if (!lset || !rcBuildHeightfieldLayers(&ctx, *chf, tcfg.borderSize, tcfg.walkableHeight, *lset)){
+            Debug::Fatal("Heightfield layer generation failed");
+        }
+
+        const int nlayers = std::min<int>(lset->nlayers, options.maxLayersPerTile);
+        for(int i = 0; i < nlayers; i++){
+            const auto& layer = lset->layers[i];
+            dtTileCacheLayerHeader header;
+            header.magic = DT_TILECACHE_MAGIC;
+            header.version = DT_TILECACHE_VERSION;
+            header.tx = tx;
+            header.ty = tz;
+            header.tlayer = i;
+            dtVcopy(header.bmin, layer.bmin);
+            dtVcopy(header.bmax, layer.bmax);
+            header.width = static_cast<unsigned char>(layer.width);
+            header.height = static_cast<unsigned char>(layer.height);
+            header.minx = static_cast<unsigned char>(layer.minx);
+            header.maxx = static_cast<unsigned char>(layer.maxx);
+            header.miny = static_cast<unsigned char>(layer.miny);
+            header.maxy = static_cast<unsigned char>(layer.maxy);
+            header.hmin = static_cast<unsigned short>(layer.hmin);
+            header.hmax = static_cast<unsigned short>(layer.hmax);
+
+            unsigned char* data = nullptr;
+            int dataSize = 0;
+            if (dtStatusFailed(dtBuildTileCacheLayer(&tileCompressor, &header, layer.heights, layer.areas, layer.cons, &data, &dataSize))){
+                Debug::Fatal("Could not build tile cache layer");
+            }
+            result.emplace_back(data, dataSize);
+        }
+        return result;
+    }
+
+    /**
+     Hand rasterized layers to the tile cache and build their navmesh tiles. Not thread safe.
+     */
+    void AddTile(int tx, int tz, TileLayers& layers){
+        for(auto& [data, size] : layers){
+            if (dtStatusFailed(tileCache->addTile(data, size, DT_COMPRESSEDTILE_FREE_DATA, nullptr))){
+                dtFree(data);
+                Debug::Warning("NavMesh tile {},{} has too many layers, increase Options::maxLayersPerTile", tx, tz);
+            }
+        }
+        layers.clear();
+        if (dtStatusFailed(tileCache->buildNavMeshTilesAt(tx, tz, navMesh))){
+            Debug::Warning("Could not build NavMesh tile {},{}", tx, tz);
+        }
+    }
+
+    /**
+     Remove the cached layers and navmesh tiles at a tile coordinate. Not thread safe.
+     */
+    void RemoveTile(int tx, int tz){
+        Vector<dtCompressedTileRef> cached(options.maxLayersPerTile);
+        const int ncached = tileCache->getTilesAt(tx, tz, cached.data(), int(cached.size()));
+        for(int i = 0; i < ncached; i++){
+            tileCache->removeTile(cached[i], nullptr, nullptr);
+        }
+        Vector<const dtMeshTile*> tiles(options.maxLayersPerTile);
+        const int ntiles = static_cast<const dtNavMesh*>(navMesh)->getTilesAt(tx, tz, tiles.data(), int(tiles.size()));
+        for(int i = 0; i < ntiles; i++){
+            navMesh->removeTile(navMesh->getTileRef(tiles[i]), nullptr, nullptr);
+        }
+    }
+};
+
+struct NavMeshComponent::Shared{
+    struct Obstacle{
+        enum class Type : uint8_t{ Cylinder, Box } type;
+        float position[3];      // cylinder base or box center
+        float halfExtents[3];   // radius and height for cylinders
+        float yaw = 0;
+        dtObstacleRef ref = 0;
+    };
+
+    // path queries share it, while anything that changes current or the Detour objects it owns holds it exclusively
+    std::shared_mutex mtx;
+    std::shared_ptr<Data> current;
+    UnorderedMap<ObstacleID, Obstacle> obstacles;
+    ObstacleID nextObstacle = 1;
+    uint32_t generation = 0;        // the latest full rebuild requested
+    uint32_t geometryStamp = 0;     // the latest incremental update requested
+    Options latestOptions;
+    std::atomic<uint32_t> pendingBuilds = 0;
+
+    /**
+     Queue an obstacle in a tile cache. Must hold the lock.
+     */
+    void AddToCache(Data& data, Obstacle& obstacle){
+        auto add = [&]{
+            switch(obstacle.type){
+                case Obstacle::Type::Cylinder:
+                    return data.tileCache->addObstacle(obstacle.position, obstacle.halfExtents[0], obstacle.halfExtents[1], &obstacle.ref);
+                case Obstacle::Type::Box:
+                    if (obstacle.yaw == 0){
+                        // rotated boxes are bounded by a square around their longest side, which touches far more tiles
+                        float bmin[3], bmax[3];
+                        dtVsub(bmin, obstacle.position, obstacle.halfExtents);
+                        dtVadd(bmax, obstacle.position, obstacle.halfExtents);
+                        return data.tileCache->addBoxObstacle(bmin, bmax, &obstacle.ref);
+                    }
+                    return data.tileCache->addBoxObstacle(obstacle.position, obstacle.halfExtents, obstacle.yaw, &obstacle.ref);
+            }
+            return dtStatus(DT_FAILURE);
+        };
+        auto status = add();
+        if (dtStatusDetail(status, DT_BUFFER_TOO_SMALL)){
+            // the request queue is full, so apply the queued requests and try again
+            bool upToDate = false;
+            data.tileCache->update(0, data.navMesh, &upToDate);
+            status = add();
+        }
+        if (dtStatusFailed(status)){
+            obstacle.ref = 0;
+            Debug::Warning("Could not add NavMesh obstacle, increase Options::maxObstacles");
+        }
+    }
+
+    /**
+     Remove and re-add the obstacles that overlap a region, so that they also apply to tiles that replaced the ones they touched
+     */
+    void RefreshObstacles(Data& data, const float* bmin, const float* bmax){
+        for(auto& [id, obstacle] : obstacles){
+            if (obstacle.ref == 0){
+                continue;
+            }
+            auto ob = data.tileCache->getObstacleByRef(obstacle.ref);
+            if (!ob){
+                continue;
+            }
+            float obmin[3], obmax[3];
+            data.tileCache->getObstacleBounds(ob, obmin, obmax);
+            if (dtOverlapBounds(bmin, bmax, obmin, obmax)){
+                data.tileCache->removeObstacle(obstacle.ref);
+                AddToCache(data, obstacle);
+            }
+        }
+    }
+
+    /**
+     Run a build, rasterizing tiles in parallel on the App executor
+     @param numTiles the number of tiles to rasterize
+     @param rasterize invoked once per tile index, possibly concurrently
+     @param finish invoked after every tile is rasterized
+     @param async if false, block until finish returns
+     */
+    template<typename Rasterize, typename Finish>
+    static void Dispatch(int numTiles, Rasterize&& rasterize, Finish&& finish, bool async){
+        auto& executor = GetApp()->executor;
+        if (!async && executor.this_worker_id() >= 0){
+            // waiting on the executor from one of its own workers could deadlock, so build inline
+            for(int i = 0; i < numTiles; i++){
+                rasterize(i);
+            }
+            finish();
+            return;
+        }
+        tf::Taskflow flow;
+        auto tiles = flow.for_each_index(0, numTiles, 1, std::forward<Rasterize>(rasterize));
+        auto done = flow.emplace(std::forward<Finish>(finish));
+        tiles.precede(done);
+        auto future = executor.run(std::move(flow));
+        if (!async){
+            future.wait();
+        }
+    }
+
+    /**
+     Build an entire navmesh and swap it in, unless a newer full rebuild was requested in the meantime
+     */
+    static void Build(const std::shared_ptr<Shared>& shared, Geometry&& input, const Options& opt, uint32_t generation, bool async){
+        auto data = std::make_shared<Data>(opt, input.bounds, generation);
+        auto geometry = std::make_shared<Geometry>(std::move(input));
+        data->BinTriangles(*geometry);
+        auto layers = std::make_shared<Vector<TileLayers>>(data->tilesX * data->tilesZ);
+
+        shared->pendingBuilds++;
+        Dispatch(data->tilesX * data->tilesZ, [data, geometry, layers](int i){
+            (*layers)[i] = data->RasterizeTile(*geometry, i % data->tilesX, i / data->tilesX);
+        }, [shared, data, layers, generation]{
+            for(int i = 0; i < int(layers->size()); i++){
+                data->AddTile(i % data->tilesX, i / data->tilesX, (*layers)[i]);
+            }
+            std::shared_ptr<Data> previous;
+            {
+                std::unique_lock lock(shared->mtx);
+                if (generation == shared->generation){
+                    for(auto& [id, obstacle] : shared->obstacles){
+                        shared->AddToCache(*data, obstacle);
+                    }
+                    previous = std::move(shared->current);
+                    shared->current = data;
+                }
+            }
+            shared->pendingBuilds--;
+            shared->pendingBuilds.notify_all();
+            // previous is freed here, outside of the lock
+        }, async);
+    }
+};
+
+NavMeshComponent::NavMeshComponent(Ref<MeshAsset> mesh, Options opt) : shared(std::make_shared<Shared>()){
+    shared->latestOptions = opt;
+    Shared::Build(shared, ExtractGeometry(*mesh), opt, shared->generation, false);
+}
+
+NavMeshComponent::NavMeshComponent(const std::string& name) : NavMeshComponent(std::span<const uint8_t>(GetApp()->GetResources().FileContentsAt(Format("navmeshes/{}.rvenm", name).c_str(), false))){}
+
+NavMeshComponent::NavMeshComponent(std::span<const uint8_t> baked) : shared(std::make_shared<Shared>()){
+    SerializedNavMeshHeader header;
+    if (baked.size() < sizeof(header)){
+        Debug::Fatal("Baked navmesh is truncated");
+    }
+    std::memcpy(&header, baked.data(), sizeof(header));
+    if (strncmp(header.header.data(), "rvnm", sizeof("rvnm") - 1) != 0){
+        Debug::Fatal("Header does not match, data is not a baked navmesh!");
+    }
+    if (header.version != SerializedNavMeshHeader::currentVersion){
+        Debug::Fatal("Navmesh was baked with an incompatible version, bake it again");
+    }
+
+    Bounds bounds;
+    dtVcopy(bounds.min, header.bmin);
+    dtVcopy(bounds.max, header.bmax);
+    auto data = std::make_shared<Data>(header.options, bounds, 0);
+    if (data->tilesX != int(header.tilesX) || data->tilesZ != int(header.tilesZ)){
+        Debug::Fatal("Baked navmesh tile grid does not match its options");
+    }
+
+    size_t offset = sizeof(header);
+    auto readTile = [&]{
+        uint32_t size;
+        if (baked.size() - offset < sizeof(size)){
+            Debug::Fatal("Baked navmesh is truncated");
+        }
+        std::memcpy(&size, baked.data() + offset, sizeof(size));
+        offset += sizeof(size);
+        if (baked.size() - offset < size){
+            Debug::Fatal("Baked navmesh is truncated");
+        }
+        // Detour frees tile data with dtFree, and expects it to be aligned for its headers
+        auto tile = static_cast<unsigned char*>(dtAlloc(size, DT_ALLOC_PERM));
+        std::memcpy(tile, baked.data() + offset, size);
+        offset += size;
+        return std::make_pair(tile, int(size));
+    };
+    for(uint32_t i = 0; i < header.numLayers; i++){
+        auto [tile, size] = readTile();
+        if (dtStatusFailed(data->tileCache->addTile(tile, size, DT_COMPRESSEDTILE_FREE_DATA, nullptr))){
+            dtFree(tile);
+            Debug::Fatal("Could not load baked tile cache layer");
+        }
+    }
+    if (header.numTiles > 0){
+        for(uint32_t i = 0; i < header.numTiles; i++){
+            auto [tile, size] = readTile();
+            if (dtStatusFailed(data->navMesh->addTile(tile, size, DT_TILE_FREE_DATA, 0, nullptr))){
+                dtFree(tile);
+                Debug::Fatal("Could not load baked navmesh tile");
+            }
+        }
     }
     else{
-        Debug::Warning("Cannot generate Detour data for NavMesh - too many vertices");
+        for(int tz = 0; tz < data->tilesZ; tz++){
+            for(int tx = 0; tx < data->tilesX; tx++){
+                data->tileCache->buildNavMeshTilesAt(tx, tz, data->navMesh);
+            }
+        }
+    }
+    shared->latestOptions = header.options;
+    shared->current = std::move(data);
+}
+
+RavEngine::Vector<uint8_t> NavMeshComponent::Bake(){
+    std::unique_lock lock(shared->mtx);
+    auto& data = *shared->current;
+    bool upToDate = false;
+    while(!upToDate){
+        data.tileCache->update(0, data.navMesh, &upToDate);
+    }
+
+    SerializedNavMeshHeader header;
+    header.options = data.options;
+    dtVcopy(header.bmin, data.cfg.bmin);
+    dtVcopy(header.bmax, data.cfg.bmax);
+    header.tilesX = data.tilesX;
+    header.tilesZ = data.tilesZ;
+
+    Vector<uint8_t> baked(sizeof(header));
+    auto writeTile = [&](const unsigned char* tile, int size){
+        const uint32_t size32 = size;
+        const auto offset = baked.size();
+        baked.resize(offset + sizeof(size32) + size32);
+        std::memcpy(baked.data() + offset, &size32, sizeof(size32));
+        std::memcpy(baked.data() + offset + sizeof(size32), tile, size32);
+    };
+    const dtTileCache* tileCache = data.tileCache;
+    for(int i = 0; i < tileCache->getTileCount(); i++){
+        auto tile = tileCache->getTile(i);
+        if (tile->header && tile->data){
+            writeTile(tile->data, tile->dataSize);
+            header.numLayers++;
+        }
+    }
+    // obstacles have carved the navmesh tiles, so those are rebuilt from the layers on load instead
+    if (shared->obstacles.empty()){
+        const dtNavMesh* navMesh = data.navMesh;
+        for(int i = 0; i < navMesh->getMaxTiles(); i++){
+            auto tile = navMesh->getTile(i);
+            if (tile->header && tile->data){
+                writeTile(tile->data, tile->dataSize);
+                header.numTiles++;
+            }
+        }
     }
-    mtx.unlock();
+    std::memcpy(baked.data(), &header, sizeof(header));
+    return baked;
 }
 
-NavMeshComponent::~NavMeshComponent(){
-    dtFree(navMesh);
-    dtFree(navMeshQuery);
-    dtFree(navData);
+void NavMeshComponent::UpdateNavMesh(Ref<MeshAsset> mesh, Options opt){
+    uint32_t generation;
+    {
+        std::unique_lock lock(shared->mtx);
+        generation = ++shared->generation;
+        shared->latestOptions = opt;
+    }
+    Shared::Build(shared, ExtractGeometry(*mesh), opt, generation, true);
 }
 
-RavEngine::Vector<vector3> NavMeshComponent::CalculatePath(const vector3 &start, const vector3 &end, uint16_t maxPoints){
-    mtx.lock();
-    float startf[3]{static_cast<float>(start.x),static_cast<float>(start.y),static_cast<float>(start.z)};
-    float endf[3]{static_cast<float>(end.x),static_cast<float>(end.y),static_cast<float>(end.z)};
-    
-    dtPolyRef ref;
-    
-    auto midpoint = [](auto f1, auto f2){
-        return (f1+f2)/2;
+void NavMeshComponent::UpdateGeometry(Ref<MeshAsset> mesh, const Bounds& changed){
+    auto geometry = std::make_shared<Geometry>(ExtractGeometry(*mesh));
+    std::shared_ptr<Data> base;
+    uint32_t stamp;
+    Options options;
+    {
+        std::unique_lock lock(shared->mtx);
+        base = shared->current;
+        stamp = ++shared->geometryStamp;
+        options = shared->latestOptions;
+        if (base->generation != shared->generation || !base->Contains(geometry->bounds)){
+            // a full rebuild is in flight and would overwrite this one, or the tile grid has to grow
+            base.reset();
+        }
+    }
+    if (!base){
+        UpdateNavMesh(mesh, options);
+        return;
+    }
+
+    base->BinTriangles(*geometry);
+    const float tileWorldSize = base->cfg.tileSize * base->cfg.cs;
+    auto tileRange = [&](int axis, int numTiles){
+        auto coord = [&](float pos){
+            return std::clamp(static_cast<int>(std::floor((pos - base->cfg.bmin[axis]) / tileWorldSize)), 0, numTiles - 1);
+        };
+        return std::make_pair(coord(changed.min[axis]), coord(changed.max[axis]));
+    };
+    const auto [x0, x1] = tileRange(0, base->tilesX);
+    const auto [z0, z1] = tileRange(2, base->tilesZ);
+    auto tiles = std::make_shared<Vector<std::pair<int,int>>>();
+    for(int z = z0; z <= z1; z++){
+        for(int x = x0; x <= x1; x++){
+            tiles->emplace_back(x, z);
+        }
+    }
+    auto layers = std::make_shared<Vector<TileLayers>>(tiles->size());
+
+    auto sharedState = shared;
+    shared->pendingBuilds++;
+    Shared::Dispatch(int(tiles->size()), [base, geometry, tiles, layers](int i){
+        const auto [x, z] = (*tiles)[i];
+        (*layers)[i] = base->RasterizeTile(*geometry, x, z);
+    }, [sharedState, base, tiles, layers, stamp, tileWorldSize]{
+        {
+            std::unique_lock lock(sharedState->mtx);
+            if (sharedState->current == base){
+                float bmin[3]{std::numeric_limits<float>::max(), base->cfg.bmin[1], std::numeric_limits<float>::max()};
+                float bmax[3]{std::numeric_limits<float>::lowest(), base->cfg.bmax[1], std::numeric_limits<float>::lowest()};
+                for(int i = 0; i < int(tiles->size()); i++){
+                    const auto [x, z] = (*tiles)[i];
+                    auto& tileStamp = base->tileStamps[x + z * base->tilesX];
+                    if (tileStamp > stamp){
+                        // a newer update already replaced this tile
+                        continue;
+                    }
+                    tileStamp = stamp;
+                    base->RemoveTile(x, z);
+                    base->AddTile(x, z, (*layers)[i]);
+                    bmin[0] = std::min(bmin[0], base->cfg.bmin[0] + x * tileWorldSize);
+                    bmin[2] = std::min(bmin[2], base->cfg.bmin[2] + z * tileWorldSize);
+                    bmax[0] = std::max(bmax[0], base->cfg.bmin[0] + (x + 1) * tileWorldSize);
+                    bmax[2] = std::max(bmax[2], base->cfg.bmin[2] + (z + 1) * tileWorldSize);
+                }
+                sharedState->RefreshObstacles(*base, bmin, bmax);
+            }
+        }
+        // free layers that were not used
+        for(auto& tileLayers : *layers){
+            for(auto& [data, size] : tileLayers){
+                dtFree(data);
+            }
+        }
+        sharedState->pendingBuilds--;
+        sharedState->pendingBuilds.notify_all();
+    }, true);
+}
+
+bool NavMeshComponent::IsBuilding() const{
+    return shared->pendingBuilds > 0;
+}
+
+void NavMeshComponent::WaitForBuild() const{
+    auto& executor = GetApp()->executor;
+    if (executor.this_worker_id() >= 0){
+        // blocking a worker could starve the rebuild, so run other tasks (possibly the rebuild itself) until it is done
+        executor.loop_until([this]{
+            return !IsBuilding();
+        });
+        return;
+    }
+    for(auto pending = shared->pendingBuilds.load(); pending > 0; pending = shared->pendingBuilds.load()){
+        shared->pendingBuilds.wait(pending);
+    }
+}
+
+NavMeshComponent::ObstacleID NavMeshComponent::AddCylinderObstacle(const vector3& base, float radius, float height){
+    Shared::Obstacle obstacle{
+        .type = Shared::Obstacle::Type::Cylinder,
+        .position = {float(base.x), float(base.y), float(base.z)},
+        .halfExtents = {radius, height, 0},
     };
-    
-    float center[3] = {midpoint(bounds.min[0],bounds.max[0]),midpoint(bounds.min[1],bounds.max[1]),midpoint(bounds.min[2],bounds.max[2])};
-    float halfexts[3] = {std::abs(center[0]-bounds.min[0]),std::abs(center[1]-bounds.min[1]),std::abs(center[2]-bounds.min[2])};
-    
-    // get polyref
-    float nearestpt[3];
-    float endpt[3];
-    
-    dtQueryFilter filter;
-    //filter.setIncludeFlags(0xFFF);
-    //filter.setExcludeFlags(0);
-    //filter.setAreaCost(0, 1.0f);  // TODO: replace 0 with named region enum
-    
-    dtStatus status;
-    dtPolyRef startPoly;
-    dtPolyRef endPoly;
-    
-    status = navMeshQuery->findNearestPoly(startf, halfexts, &filter, &startPoly, nearestpt);
-    if (dtStatusFailed(status) || startPoly == 0){
-        Debug::Fatal("Could not locate start poly");
-    }
-    status = navMeshQuery->findNearestPoly(endf, halfexts, &filter, &endPoly, endpt);
-    if (dtStatusFailed(status) || endPoly == 0){
-        Debug::Fatal("Could not locate end poly");
-    }
-    
-    std::vector<dtPolyRef> polyPath(maxPoints);
-    int nPathCount = 0;
-    
-    status = navMeshQuery->findPath(startPoly, endPoly, nearestpt, endpt, &filter, polyPath.data(), &nPathCount, maxPoints);
-    if (dtStatusFailed(status)){
-        Debug::Fatal("Unable to create poly path");
-    }
-    std::vector<float> straightPath(maxPoints);
-    int nVertCount = 0;
-    status = navMeshQuery->findStraightPath(nearestpt, endpt, polyPath.data(), nPathCount, straightPath.data(), NULL, NULL, &nVertCount, maxPoints*3);
-    if (dtStatusFailed(status)){
-        Debug::Fatal("Unable to create path");
-    }
-    
-    // convert path to engine format
-    RavEngine::Vector<vector3> path(nVertCount);
-    for (size_t i = 0; i < path.size(); i++) {
-        path[i] = vector3(straightPath[i * 3],straightPath[i * 3 +1],straightPath[i * 3 +2]);
-    }
-    mtx.unlock();
-
-
-    return path;
+    std::unique_lock lock(shared->mtx);
+    shared->AddToCache(*shared->current, obstacle);
+    auto id = shared->nextObstacle++;
+    shared->obstacles.emplace(id, obstacle);
+    return id;
+}
+
+NavMeshComponent::ObstacleID NavMeshComponent::AddBoxObstacle(const vector3& center, const vector3& halfExtents, float yaw){
+    Shared::Obstacle obstacle{
+        .type = Shared::Obstacle::Type::Box,
+        .position = {float(center.x), float(center.y), float(center.z)},
+        .halfExtents = {float(halfExtents.x), float(halfExtents.y), float(halfExtents.z)},
+        .yaw = yaw,
+    };
+    std::unique_lock lock(shared->mtx);
+    shared->AddToCache(*shared->current, obstacle);
+    auto id = shared->nextObstacle++;
+    shared->obstacles.emplace(id, obstacle);
+    return id;
+}
+
+void NavMeshComponent::RemoveObstacle(ObstacleID id){
+    std::unique_lock lock(shared->mtx);
+    auto it = shared->obstacles.find(id);
+    if (it == shared->obstacles.end()){
+        return;
+    }
+    if (it->second.ref != 0){
+        shared->current->tileCache->removeObstacle(it->second.ref);
+    }
+    shared->obstacles.erase(it);
+}
+
+bool NavMeshComponent::UpdateObstacles(uint32_t maxTileRebuilds){
+    std::unique_lock lock(shared->mtx);
+    auto& data = *shared->current;
+    // each update applies queued obstacle changes, then rebuilds at most one tile
+    bool upToDate = false;
+    for(uint32_t i = 0; i < maxTileRebuilds && !upToDate; i++){
+        data.tileCache->update(0, data.navMesh, &upToDate);
+    }
+    return upToDate;
+}
+
+uint32_t NavMeshComponent::GetNumTiles() const{
+    std::shared_lock lock(shared->mtx);
+    const dtNavMesh* navMesh = shared->current->navMesh;
+    uint32_t count = 0;
+    for(int i = 0; i < navMesh->getMaxTiles(); i++){
+        auto tile = navMesh->getTile(i);
+        if (tile->header && tile->header->polyCount > 0){
+            count++;
+        }
+    }
+    return count;
+}
+
+RavEngine::Vector<vector3> NavMeshComponent::CalculatePath(const vector3 &start, const vector3 &end, uint16_t maxPoints){
+    PathResult result;
+    {
+        std::shared_lock lock(shared->mtx);
+        auto& data = *shared->current;
+
+        // search the entire navmesh for the ends. Flat geometry has no height, so search at least an agent's height above and below
+        const auto& bmin = data.cfg.bmin;
+        const auto& bmax = data.cfg.bmax;
+        const PathRequest request{
+            .start = start,
+            .end = end,
+            .searchExtents = vector3(bmax[0] - bmin[0], std::max(bmax[1] - bmin[1], data.options.agent.height), bmax[2] - bmin[2]),
+            .maxPoints = maxPoints,
+        };
+        Data::QueryHandle query(data);
+        data.FindPath(*query, request, result);
+    }
+    switch(result.status){
+        case PathResult::Status::NoStart:
+            Debug::Fatal("Could not locate start poly");
+        case PathResult::Status::NoEnd:
+            Debug::Fatal("Could not locate end poly");
+        case PathResult::Status::Failed:
+            Debug::Fatal("Unable to create path");
+        default:
+            break;
+    }
+    return std::move(result.points);
+}
+
+Ref<NavMeshComponent::PathBatch> NavMeshComponent::RequestPaths(RavEngine::Vector<PathRequest> requests){
+    auto batch = std::make_shared<PathBatch>();
+    batch->requests = std::move(requests);
+    batch->results.resize(batch->requests.size());
+
+    tf::Taskflow flow;
+    auto paths = flow.for_each_index(0, int(batch->requests.size()), 1, [batch, shared = shared](int i){
+        // lock per path, so that obstacle updates are not held up until the entire batch finishes
+        std::shared_lock lock(shared->mtx);
+        auto& data = *shared->current;
+        Data::QueryHandle query(data);
+        data.FindPath(*query, batch->requests[i], batch->results[i]);
+    });
+    auto done = flow.emplace([batch]{
+        batch->done.store(true, std::memory_order_release);
+        batch->done.notify_all();
+    });
+    paths.precede(done);
+    GetApp()->executor.run(std::move(flow));
+    return batch;
+}
+
+Ref<NavMeshComponent::SlicedPath> NavMeshComponent::BeginSlicedPath(const PathRequest& request){
+    return Ref<SlicedPath>(new SlicedPath(shared, request));
+}
+
+bool NavMeshComponent::SlicedPath::Update(uint32_t maxIterations){
+    if (IsDone()){
+        return true;
+    }
+    std::shared_lock lock(shared->mtx);
+    if (data != shared->current){
+        // first update, or a rebuild replaced the navmesh, so start the search over
+        if (query){
+            data->ReleaseQuery(query);
+        }
+        data = shared->current;
+        query = data->AcquireQuery();
+        dtPolyRef startPoly, endPoly;
+        const auto located = LocateEnds(*query, request, startPoly, endPoly, startPos, endPos);
+        if (located != PathResult::Status::Pending){
+            result.status = located;
+            return Finish(DT_FAILURE);
+        }
+        if (dtStatusFailed(query->initSlicedFindPath(startPoly, endPoly, startPos, endPos, &defaultFilter))){
+            return Finish(DT_FAILURE);
+        }
+    }
+    int iterations = 0;
+    const auto status = query->updateSlicedFindPath(static_cast<int>(std::min<uint32_t>(maxIterations, std::numeric_limits<int>::max())), &iterations);
+    if (dtStatusInProgress(status)){
+        return false;
+    }
+    return Finish(status);
+}
+
+bool NavMeshComponent::SlicedPath::Finish(uint32_t status){
+    if (dtStatusSucceed(status)){
+        Vector<dtPolyRef> polys(request.maxPoints);
+        int npolys = 0;
+        status = query->finalizeSlicedFindPath(polys.data(), &npolys, request.maxPoints);
+        StraightenPath(*query, startPos, endPos, polys.data(), npolys, status, request.maxPoints, result);
+    }
+    else if (result.status == PathResult::Status::Pending){
+        result.status = PathResult::Status::Failed;
+    }
+    data->ReleaseQuery(query);
+    query = nullptr;
+    return true;
+}
+
+NavMeshComponent::SlicedPath::~SlicedPath(){
+    if (query){
+        data->ReleaseQuery(query);
+    }
+}
+
+void NavMeshComponent::ReadNavMesh(Shared& shared, const Function<void(dtNavMesh*, const std::shared_ptr<void>&)>& fn){
+    std::shared_lock lock(shared.mtx);
+    fn(shared.current->navMesh, shared.current);
 }
 
 void RavEngine::NavMeshComponent::DebugDraw(RavEngine::DebugDrawer& dbg, const RavEngine::Transform& tr) const {
 #if !RVE_SERVER
-    mtx.lock();
-    duDebugDrawNavMesh(&GetApp()->GetRenderEngine(), *navMesh, 0);
-    mtx.unlock();
+    std::shared_lock lock(shared->mtx);
+    duDebugDrawNavMesh(&GetApp()->GetRenderEngine(), *shared->current->navMesh, 0);
 #endif
 }
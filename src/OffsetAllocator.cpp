@@ -0,0 +1,310 @@
+#include "OffsetAllocator.hpp"
+#include "Debug.hpp"
+#include <bit>
+#include <algorithm>
+
+using namespace RavEngine;
+
+namespace {
+    constexpr uint32_t MantissaBits = 3, MantissaValue = 1 << MantissaBits, MantissaMask = MantissaValue - 1;
+
+    /**
+     Convert a size to a bin index, rounding up, so that every range in the bin is at least this large
+     */
+    uint32_t SizeToBinRoundUp(uint32_t size){
+        if (size < MantissaValue){
+            return size;    // denormal
+        }
+        const uint32_t highestSetBit = 31 - std::countl_zero(size);
+        const uint32_t mantissaStartBit = highestSetBit - MantissaBits;
+        const uint32_t exponent = mantissaStartBit + 1;
+        uint32_t mantissa = (size >> mantissaStartBit) & MantissaMask;
+        if (size & ((1u << mantissaStartBit) - 1)){
+            mantissa++;     // carries into the exponent if needed
+        }
+        return (exponent << MantissaBits) + mantissa;
+    }
+
+    /**
+     Convert a size to a bin index, rounding down, which is the bin a free range of this size is stored in
+     */
+    uint32_t SizeToBinRoundDown(uint32_t size){
+        if (size < MantissaValue){
+            return size;
+        }
+        const uint32_t highestSetBit = 31 - std::countl_zero(size);
+        const uint32_t mantissaStartBit = highestSetBit - MantissaBits;
+        const uint32_t exponent = mantissaStartBit + 1;
+        const uint32_t mantissa = (size >> mantissaStartBit) & MantissaMask;
+        return (exponent << MantissaBits) | mantissa;
+    }
+
+    /**
+     Convert a bin index back to the smallest size stored in the bin
+     */
+    uint32_t BinToSize(uint32_t binIndex){
+        const uint32_t exponent = binIndex >> MantissaBits;
+        const uint32_t mantissa = binIndex & MantissaMask;
+        if (exponent == 0){
+            return mantissa;    // denormal
+        }
+        return (mantissa | MantissaValue) << (exponent - 1);
+    }
+
+    /**
+     @return the lowest set bit in the mask at or after startBit, or NoSpace if there is none
+     */
+    uint32_t FindLowestSetBitAfter(uint32_t mask, uint32_t startBit){
+        if (startBit >= 32){
+            return OffsetAllocator::NoSpace;
+        }
+        const uint32_t bits = mask & ~((1u << startBit) - 1);
+        return bits == 0 ? OffsetAllocator::NoSpace : std::countr_zero(bits);
+    }
+}
+
+OffsetAllocator::OffsetAllocator(uint32_t size){
+    binIndices.fill(Unused);
+    if (size > 0){
+        tail = InsertNodeIntoBin(size, 0);
+    }
+    this->size = size;
+}
+
+uint32_t OffsetAllocator::AllocateNode(){
+    if (freeNodes.empty()){
+        nodes.emplace_back();
+        return uint32_t(nodes.size() - 1);
+    }
+    const auto index = freeNodes.back();
+    freeNodes.pop_back();
+    nodes[index] = {};
+    return index;
+}
+
+OffsetAllocator::Allocation OffsetAllocator::Allocate(uint32_t size){
+    if (size == 0){
+        size = 1;   // a zero-sized allocation still needs a node to free
+    }
+    const auto minBinIndex = SizeToBinRoundUp(size);
+    const auto minTopBinIndex = minBinIndex >> MantissaBits;
+    const auto minLeafBinIndex = minBinIndex & MantissaMask;
+
+    // search the smallest top bin that can fit this size first, then any larger top bin
+    auto topBinIndex = minTopBinIndex;
+    uint32_t leafBinIndex = NoSpace;
+    if (topBinIndex < NumTopBins && (usedBinsTop & (1u << topBinIndex))){
+        leafBinIndex = FindLowestSetBitAfter(usedBins[topBinIndex], minLeafBinIndex);
+    }
+    if (leafBinIndex == NoSpace){
+        topBinIndex = FindLowestSetBitAfter(usedBinsTop, minTopBinIndex + 1);
+        if (topBinIndex == NoSpace){
+            return {};
+        }
+        leafBinIndex = std::countr_zero(uint32_t(usedBins[topBinIndex]));
+    }
+
+    // pop the head of the bin
+    const auto binIndex = (topBinIndex << MantissaBits) | leafBinIndex;
+    const auto nodeIndex = binIndices[binIndex];
+    auto& node = nodes[nodeIndex];
+    const auto nodeTotalSize = node.dataSize;
+    node.dataSize = size;
+    node.used = true;
+    binIndices[binIndex] = node.binListNext;
+    if (node.binListNext != Unused){
+        nodes[node.binListNext].binListPrev = Unused;
+    }
+    freeStorage -= nodeTotalSize;
+
+    if (binIndices[binIndex] == Unused){
+        usedBins[topBinIndex] &= ~(1u << leafBinIndex);
+        if (usedBins[topBinIndex] == 0){
+            usedBinsTop &= ~(1u << topBinIndex);
+        }
+    }
+
+    // return the rest of the range to the bins
+    const auto dataOffset = node.dataOffset;
+    const auto remainder = nodeTotalSize - size;
+    if (remainder > 0){
+        const auto newNodeIndex = InsertNodeIntoBin(remainder, dataOffset + size);   // may reallocate nodes
+
+        const auto neighborNext = nodes[nodeIndex].neighborNext;
+        if (neighborNext != Unused){
+            nodes[neighborNext].neighborPrev = newNodeIndex;
+        }
+        else{
+            tail = newNodeIndex;
+        }
+        nodes[newNodeIndex].neighborPrev = nodeIndex;
+        nodes[newNodeIndex].neighborNext = neighborNext;
+        nodes[nodeIndex].neighborNext = newNodeIndex;
+    }
+
+    return {dataOffset, nodeIndex};
+}
+
+void OffsetAllocator::Free(Allocation allocation){
+    Debug::Assert(allocation.metadata < nodes.size() && nodes[allocation.metadata].used, "Invalid allocation freed");
+    const auto nodeIndex = allocation.metadata;
+    const auto node = nodes[nodeIndex];
+
+    auto offset = node.dataOffset;
+    auto size = node.dataSize;
+    auto neighborPrev = node.neighborPrev;
+    auto neighborNext = node.neighborNext;
+
+    // merge with free neighbors
+    if (neighborPrev != Unused && !nodes[neighborPrev].used){
+        const auto prev = nodes[neighborPrev];
+        offset = prev.dataOffset;
+        size += prev.dataSize;
+        RemoveNodeFromBin(neighborPrev);
+        neighborPrev = prev.neighborPrev;
+    }
+    if (neighborNext != Unused && !nodes[neighborNext].used){
+        const auto next = nodes[neighborNext];
+        size += next.dataSize;
+        RemoveNodeFromBin(neighborNext);
+        neighborNext = next.neighborNext;
+    }
+
+    nodes[nodeIndex].used = false;
+    freeNodes.push_back(nodeIndex);
+
+    const auto combinedNodeIndex = InsertNodeIntoBin(size, offset);
+    auto& combined = nodes[combinedNodeIndex];
+    combined.neighborPrev = neighborPrev;
+    combined.neighborNext = neighborNext;
+    if (neighborPrev != Unused){
+        nodes[neighborPrev].neighborNext = combinedNodeIndex;
+    }
+    if (neighborNext != Unused){
+        nodes[neighborNext].neighborPrev = combinedNodeIndex;
+    }
+    else{
+        tail = combinedNodeIndex;
+    }
+}
+
+void OffsetAllocator::Grow(uint32_t newSize){
+    Debug::Assert(newSize >= size, "OffsetAllocator cannot shrink");
+    if (newSize == size){
+        return;
+    }
+    const auto extra = newSize - size;
+
+    if (tail != Unused && !nodes[tail].used){
+        // extend the free range at the end, which may move it to a larger bin
+        const auto last = nodes[tail];
+        RemoveNodeFromBin(tail);
+        const auto newTail = InsertNodeIntoBin(last.dataSize + extra, last.dataOffset);
+        nodes[newTail].neighborPrev = last.neighborPrev;
+        if (last.neighborPrev != Unused){
+            nodes[last.neighborPrev].neighborNext = newTail;
+        }
+        tail = newTail;
+    }
+    else{
+        // the buffer ends in an allocation (or is empty), so the new space is a range of its own
+        const auto newTail = InsertNodeIntoBin(extra, size);
+        nodes[newTail].neighborPrev = tail;
+        if (tail != Unused){
+            nodes[tail].neighborNext = newTail;
+        }
+        tail = newTail;
+    }
+    size = newSize;
+}
+
+uint32_t OffsetAllocator::SizeRoundedUpToBin(uint32_t size){
+    return BinToSize(SizeToBinRoundUp(std::max(size, 1u)));
+}
+
+uint32_t OffsetAllocator::AllocationSize(Allocation allocation) const{
+    if (!allocation.IsValid()){
+        return 0;
+    }
+    return nodes[allocation.metadata].dataSize;
+}
+
+uint32_t OffsetAllocator::InsertNodeIntoBin(uint32_t size, uint32_t dataOffset){
+    const auto binIndex = SizeToBinRoundDown(size);
+    const auto topBinIndex = binIndex >> MantissaBits;
+    const auto leafBinIndex = binIndex & MantissaMask;
+
+    if (binIndices[binIndex] == Unused){
+        usedBins[topBinIndex] |= 1u << leafBinIndex;
+        usedBinsTop |= 1u << topBinIndex;
+    }
+
+    // push onto the head of the bin's list
+    const auto topNodeIndex = binIndices[binIndex];
+    const auto nodeIndex = AllocateNode();
+    auto& node = nodes[nodeIndex];
+    node.dataOffset = dataOffset;
+    node.dataSize = size;
+    node.binListNext = topNodeIndex;
+    if (topNodeIndex != Unused){
+        nodes[topNodeIndex].binListPrev = nodeIndex;
+    }
+    binIndices[binIndex] = nodeIndex;
+
+    freeStorage += size;
+    return nodeIndex;
+}
+
+void OffsetAllocator::RemoveNodeFromBin(uint32_t nodeIndex){
+    const auto& node = nodes[nodeIndex];
+
+    if (node.binListPrev != Unused){
+        // in the middle of a list, so the bin does not change
+        nodes[node.binListPrev].binListNext = node.binListNext;
+        if (node.binListNext != Unused){
+            nodes[node.binListNext].binListPrev = node.binListPrev;
+        }
+    }
+    else{
+        // the head of a list
+        const auto binIndex = SizeToBinRoundDown(node.dataSize);
+        const auto topBinIndex = binIndex >> MantissaBits;
+        const auto leafBinIndex = binIndex & MantissaMask;
+
+        binIndices[binIndex] = node.binListNext;
+        if (node.binListNext != Unused){
+            nodes[node.binListNext].binListPrev = Unused;
+        }
+
+        if (binIndices[binIndex] == Unused){
+            usedBins[topBinIndex] &= ~(1u << leafBinIndex);
+            if (usedBins[topBinIndex] == 0){
+                usedBinsTop &= ~(1u << topBinIndex);
+            }
+        }
+    }
+
+    freeStorage -= node.dataSize;
+    freeNodes.push_back(nodeIndex);
+}
+
+OffsetAllocator::StorageReport OffsetAllocator::GetStorageReport() const{
+    uint32_t largestFree = 0;
+    if (usedBinsTop){
+        // the largest range is somewhere in the highest non-empty bin
+        const uint32_t topBinIndex = 31 - std::countl_zero(usedBinsTop);
+        const uint32_t leafBinIndex = 31 - std::countl_zero(uint32_t(usedBins[topBinIndex]));
+        for (auto i = binIndices[(topBinIndex << MantissaBits) | leafBinIndex]; i != Unused; i = nodes[i].binListNext){
+            largestFree = std::max(largestFree, nodes[i].dataSize);
+        }
+    }
+    return {freeStorage, largestFree};
+}
+
+float OffsetAllocator::GetFragmentation() const{
+    const auto report = GetStorageReport();
+    if (report.totalFree == 0){
+        return 0;
+    }
+    return 1 - float(report.largestFree) / report.totalFree;
+}
@@ -231,6 +231,15 @@ bool RavEngine::RigidBodyDynamicComponent::IsSleeping() const
 	return static_cast<PxRigidDynamic*>(rigidActor)->isSleeping();
 }
 
+bool RavEngine::RigidBodyDynamicComponent::IsKinematic() const
+{
+	bool kinematic = false;
+	LockRead([&]{
+		kinematic = static_cast<PxRigidDynamic*>(rigidActor)->getRigidBodyFlags().isSet(PxRigidBodyFlag::eKINEMATIC);
+	});
+	return kinematic;
+}
+
 void PhysicsBodyComponent::OnColliderEnter(PhysicsBodyComponent& other, const ContactPairPoint* contactPoints, size_t numContactPoints)
 {
 	for (auto& receiver : receivers) {
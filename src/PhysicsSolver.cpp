@@ -157,6 +157,45 @@ bool RavEngine::PhysicsSolver::Raycast(const vector3& origin, const vector3& dir
     return result;
 }
 
+namespace {
+    /**
+     Skips the shapes of one actor, so that rays cast from inside an object do not report that object
+     */
+    struct IgnoreActorFilter : public PxQueryFilterCallback {
+        const PxRigidActor* ignored = nullptr;
+
+        PxQueryHitType::Enum preFilter(const PxFilterData& filterData, const PxShape* shape, const PxRigidActor* actor, PxHitFlags& queryFlags) final {
+            return actor == ignored ? PxQueryHitType::eNONE : PxQueryHitType::eBLOCK;
+        }
+
+        PxQueryHitType::Enum postFilter(const PxFilterData& filterData, const PxQueryHit& hit, const PxShape* shape, const PxRigidActor* actor) final {
+            return PxQueryHitType::eBLOCK;
+        }
+    };
+}
+
+void RavEngine::PhysicsSolver::Raycast(std::span<const RaycastQuery> queries, std::span<RaycastHit> out_hits)
+{
+    Debug::Assert(out_hits.size() >= queries.size(), "Raycast result buffer is too small");
+    IgnoreActorFilter filter;
+    const PxQueryFilterData filterData(PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC | PxQueryFlag::ePREFILTER);
+    scene->lockRead();
+    for (size_t i = 0; i < queries.size(); i++) {
+        const auto& query = queries[i];
+        PxRaycastBuffer hit;
+        const PxVec3 origin(query.origin.x, query.origin.y, query.origin.z), direction(query.direction.x, query.direction.y, query.direction.z);
+        if (query.ignoredActor != nullptr) {
+            filter.ignored = query.ignoredActor;
+            scene->raycast(origin, direction, query.maxDistance, hit, PxHitFlag::eDEFAULT, filterData, &filter);
+        }
+        else {
+            scene->raycast(origin, direction, query.maxDistance, hit);
+        }
+        out_hits[i] = RaycastHit(hit, owner);
+    }
+    scene->unlockRead();
+}
+
 bool RavEngine::PhysicsSolver::BoxOverlap(const vector3& origin, const quaternion& r, const vector3& half_ext, OverlapHit& out_hit)
 {
     return generic_overlap(PhysicsTransform(origin,r),PxBoxGeometry(half_ext.x, half_ext.y, half_ext.z),out_hit);
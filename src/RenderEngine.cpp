@@ -785,22 +785,7 @@ RenderEngine::RenderEngine(const AppConfig& config, RGLDevicePtr device) : devic
 			.pipelineLayout = guiPipelineLayout,
 		});
 
-	//TODO: on unified memory systems, don't make a staging buffer, and mark the transientBuffer as shared
-	transientBuffer = device->CreateBuffer({
-		65535,
-		{.StorageBuffer = true},
-		sizeof(char),
-		RGL::BufferAccess::Private,
-		{.TransferDestination = true, .PixelShaderResource = true, .debugName = "Transient Buffer" }
-	});
-	transientStagingBuffer = device->CreateBuffer({
-		65535,
-		{.StorageBuffer = true},
-		sizeof(char),
-		RGL::BufferAccess::Shared,
-		{.Transfersource = true, .debugName = "Transient Staging Buffer" }
-	});
-	transientStagingBuffer->MapMemory();
+	transientPages.push_back(CreateTransientPage(transientSizeBytes));
 
 	// lighting meshes
 	constexpr static Vertex2D vertices[] = {
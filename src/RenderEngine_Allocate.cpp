@@ -12,86 +12,33 @@ namespace RavEngine {
 	MeshRange RenderEngine::AllocateMesh(const std::span<const VertexNormalUV> vertices, const std::span<const uint32_t> indices)
 	{
         std::lock_guard mtx{allocationLock};
-		auto const vertexBytes = std::as_bytes(vertices);
-		auto const indexBytes = std::as_bytes( indices );
-
-	
-		using alloc_iterator_t = allocation_allocatedlist_t::iterator;
-		using freelist_iterator_t = allocation_freelist_t::iterator;
 
 		/**
-		Find a Range that can fit the current allocation. If one does not exist, returns -1 (aka uint max)
-		@return an interator into the freelist.
+		* Place a range in a shared buffer, growing the buffer if nothing fits.
+		* Growth is geometric, so that streaming in many meshes does not reallocate the buffer for each one.
 		*/
-		auto findPlacement = [](uint32_t requestedSize, allocation_freelist_t& freeList) {
-			auto bestRangeIndex = freeList.begin();
-			for (auto it = freeList.begin(); it != freeList.end(); it++) {
-				auto& nextRange = *it;
-				if (requestedSize <= (*bestRangeIndex).count) {
-					return it;
-				}
+		auto allocate = [](uint32_t count, OffsetAllocator& allocator, const uint32_t& currentSize, auto realloc_fn) {
+			auto allocation = allocator.Allocate(count);
+			if (!allocation.IsValid()) {
+				// the new space must hold the request after Allocate rounds it up to a bin size
+				realloc_fn(std::max(currentSize * 2, currentSize + OffsetAllocator::SizeRoundedUpToBin(count)));
+				allocation = allocator.Allocate(count);
+				Debug::Assert(allocation.IsValid(), "Shared buffer growth did not make space for {} elements", count);
 			}
-			return freeList.end();
-		};
-
-		/**
-		* Given a byte size, find a possible block, resizing the underlying memory if necessary.
-		* @returns an iterator into the freelist
-		*/
-		auto getAllocationLocation = [&findPlacement](uint32_t size, const uint32_t& currentSize, allocation_freelist_t& freeList, auto realloc_fn) {
-			auto allocation = freeList.end();
-			do {
-				allocation = findPlacement(size, freeList);
-				if (allocation == freeList.end()) {
-					// resize to fit
-					realloc_fn(currentSize + size);
-				}
-
-			} while (allocation == freeList.end());
 			return allocation;
 		};
 
-		// figure out where to put the new data, resizing the buffer as needed
-		auto vertexAllocation = getAllocationLocation(vertexBytes.size_bytes(), currentVertexSize, vertexFreeList,[this](uint32_t newSize) {ReallocateVertexAllocationToSize(newSize); });
-		auto indexAllocation = getAllocationLocation(indexBytes.size_bytes(), currentIndexSize, indexFreeList,  [this](uint32_t newSize) {ReallocateIndexAllocationToSize(newSize); });
-
-		// now we have the location to place the vertex and index data in the buffer
-		// these numbers are stable because, if the buffer resized, then the only place it could be stored is at the end.
-		// if the new data fits, then the buffer was not resized, so the indices are stable.
-
-		auto consumeRange = [](alloc_iterator_t allocation, uint32_t allocatedSize, allocation_freelist_t& freeList, allocation_allocatedlist_t& allocatedList) {
-			// construct a range to match the current allocation
-			auto range = *allocation;
-			range.count = allocatedSize;
-			// mark as allocated (copy into)
-			allocatedList.push_back(range);
-
-			// update the freelist
-			auto& rangeToUpdate = *allocation;
-			// if it fits exactly, delete it
-			if (rangeToUpdate.count == allocatedSize) {
-				freeList.erase(allocation);
-			}
-			else {
-				// otherwise, modify it to represent the new shrunken size
-				// we allocate aligned with the start of the range
-				rangeToUpdate.start += allocatedSize;
-				rangeToUpdate.count -= allocatedSize;
-			}
-			
-			return --allocatedList.end();
-		};
-
-		// mark the ranges as consumed
-		auto vertexPlacement = consumeRange(vertexAllocation, vertexBytes.size_bytes(), vertexFreeList, vertexAllocatedList);
-		auto indexPlacement = consumeRange(indexAllocation, indexBytes.size_bytes(), indexFreeList, indexAllocatedList);
+		auto vertexPlacement = allocate(vertices.size(), vertexAllocator, currentVertexSize, [this](uint32_t newSize) {ReallocateVertexAllocationToSize(newSize); });
+		auto indexPlacement = allocate(indices.size(), indexAllocator, currentIndexSize, [this](uint32_t newSize) {ReallocateIndexAllocationToSize(newSize); });
 
 		// upload buffer data
+		auto const vertexBytes = std::as_bytes(vertices);
+		auto const indexBytes = std::as_bytes(indices);
 		sharedVertexBuffer->SetBufferData(
-			{ vertexBytes.data(), vertexBytes.size_bytes() }, vertexPlacement->start
+			{ vertexBytes.data(), vertexBytes.size_bytes() }, vertexPlacement.offset * sizeof(VertexNormalUV)
 		);
 		sharedIndexBuffer->SetBufferData(
-			{ indexBytes.data(), indexBytes.size_bytes() }, indexPlacement->start
+			{ indexBytes.data(), indexBytes.size_bytes() }, indexPlacement.offset * sizeof(uint32_t)
 		);
 		
 		return {
@@ -101,90 +48,76 @@ namespace RavEngine {
 	void RenderEngine::DeallocateMesh(const MeshRange& range)
 	{
         std::lock_guard mtx{allocationLock};
-		
-		auto deallocateData = [](Range range, allocation_allocatedlist_t& allocatedList, allocation_freelist_t& freeList) {
-
-			Range foundRange;
-			for (auto it = allocatedList.begin(); it != allocatedList.end(); it++) {
-				const auto& nextRange = *it;
-				if (nextRange.start >= range.start && nextRange.count >= range.count) {
-					foundRange = nextRange;
-					allocatedList.erase(it);
-					break;
-				}
-			}
-
-			// xxxxx------xxxxx --> ----------xxxxx --> ----------------
-
-			//does this range border any other ranges? If so, don't push a new range onto the freelist, isntead merge the existing ranges
-			bool overlapFound = false;
-			for (auto& range : freeList) {
-				// the found range overlaps with a range to the left of it
-				if (range.start + range.count == foundRange.start) {
-					range.count += foundRange.count;
-					overlapFound = true;
-				}
-				// the found range overlaps with a range to the right of it
-				if (foundRange.start + foundRange.count == range.start) {
-					range.start -= foundRange.count;
-					range.count += foundRange.count;
-					overlapFound = true;
-				}
-			}
-			if (!overlapFound) {
-				freeList.push_back(range);
-			}
-
-		};
-		if (range.vertRange.getNodePointer() != nullptr) {
-			deallocateData(*range.vertRange, vertexAllocatedList, vertexFreeList);
+		if (range.vertRange.IsValid()) {
+			vertexAllocator.Free(range.vertRange);
 		}
-		if (range.indexRange.getNodePointer() != nullptr) {
-			deallocateData(*range.indexRange, indexAllocatedList, indexFreeList);
+		if (range.indexRange.IsValid()) {
+			indexAllocator.Free(range.indexRange);
 		}
 	}
 
-	uint32_t RenderEngine::WriteTransient(RGL::untyped_span data)
+	RenderEngine::TransientAllocation RenderEngine::WriteTransient(RGL::untyped_span data)
 	{
-		auto start = transientOffset;
+		auto allocation = transientAllocator.Allocate(data.size());
 
-		if (start + data.size() > transientSizeBytes) {
-			Debug::Fatal("Not enough space left in transient buffer");
+		// overflow pages are only backed by buffers once something spills into them
+		while (transientPages.size() < transientAllocator.GetNumPages()) {
+			transientPages.push_back(CreateTransientPage(transientAllocator.GetPageSize(transientPages.size())));
 		}
+		const auto& page = transientPages[allocation.page];
 
 		// TODO: on unified memory systems, don't make a staging buffer
-		std::memcpy((char*)(transientStagingBuffer->GetMappedDataPtr()) + start,data.data(),data.size());
+		std::memcpy((char*)(page.stagingBuffer->GetMappedDataPtr()) + allocation.offset, data.data(), data.size());
 		mainCommandBuffer->CopyBufferToBuffer(
 			{
-				.buffer = transientStagingBuffer,
-				.offset = start
+				.buffer = page.stagingBuffer,
+				.offset = allocation.offset
 			},
 			{
-				.buffer = transientBuffer,
-				.offset = start
+				.buffer = page.buffer,
+				.offset = allocation.offset
 			},
 			data.size()
 		);
 
-		transientOffset += data.size();
-
-        // Metal and Vulkan require that buffer offsets be multiples of 16
-        transientOffset = closest_multiple_of<decltype(transientOffset)>(transientOffset, 16);
+		return { page.buffer, allocation.offset };
+	}
 
-		return start;
+	RenderEngine::TransientPage RenderEngine::CreateTransientPage(uint32_t size)
+	{
+		//TODO: on unified memory systems, don't make a staging buffer, and mark the transient buffer as shared
+		TransientPage page{
+			.buffer = device->CreateBuffer({
+				size,
+				{.StorageBuffer = true},
+				sizeof(char),
+				RGL::BufferAccess::Private,
+				{.TransferDestination = true, .PixelShaderResource = true, .debugName = "Transient Buffer" }
+			}),
+			.stagingBuffer = device->CreateBuffer({
+				size,
+				{.StorageBuffer = true},
+				sizeof(char),
+				RGL::BufferAccess::Shared,
+				{.Transfersource = true, .debugName = "Transient Staging Buffer" }
+			}),
+		};
+		page.stagingBuffer->MapMemory();
+		return page;
 	}
 
 	void RavEngine::RenderEngine::ReallocateVertexAllocationToSize(uint32_t newSize)
 	{
-		ReallocateGeneric(sharedVertexBuffer, currentVertexSize, newSize, vertexAllocatedList, vertexFreeList, sizeof(VertexNormalUV), { .StorageBuffer = true, .VertexBuffer = true }, "Shared Vertex Buffer");
+		ReallocateGeneric(sharedVertexBuffer, currentVertexSize, newSize, vertexAllocator, sizeof(VertexNormalUV), { .StorageBuffer = true, .VertexBuffer = true }, "Shared Vertex Buffer");
 	}
 	void RenderEngine::ReallocateIndexAllocationToSize(uint32_t newSize)
 	{
-		ReallocateGeneric(sharedIndexBuffer, currentIndexSize, newSize, indexAllocatedList, indexFreeList, sizeof(uint32_t), {.IndexBuffer = true}, "Shared Index Buffer");
+		ReallocateGeneric(sharedIndexBuffer, currentIndexSize, newSize, indexAllocator, sizeof(uint32_t), {.IndexBuffer = true}, "Shared Index Buffer");
 	}
-	void RenderEngine::ReallocateGeneric(RGLBufferPtr& reallocBuffer, uint32_t& targetBufferCurrentSize, uint32_t newSize, allocation_allocatedlist_t& allocatedList, allocation_freelist_t& freelist, uint32_t stride, RGL::BufferConfig::Type bufferType, const char* debugName)
+	void RenderEngine::ReallocateGeneric(RGLBufferPtr& reallocBuffer, uint32_t& targetBufferCurrentSize, uint32_t newSize, OffsetAllocator& allocator, uint32_t stride, RGL::BufferConfig::Type bufferType, const char* debugName)
 	{
 		auto oldBuffer = reallocBuffer;
+		auto oldSize = targetBufferCurrentSize;
 		// trash old buffer
 		reallocBuffer = device->CreateBuffer({
 			newSize,
@@ -194,64 +127,34 @@ namespace RavEngine {
 			{.TransferDestination = true, .Transfersource = true, .debugName = debugName}
 			});
 
-		auto extendLastRange = [&freelist,newSize,targetBufferCurrentSize]() {
-			if (freelist.size() == 0) {
-				// add a new range representing the space that has been made available
-                freelist.push_back(Range{targetBufferCurrentSize, newSize - targetBufferCurrentSize});
-				return;
-			}
-			// otherwise find the last range and extend its length
-			auto lastIt = freelist.begin();
-			for (auto it = freelist.begin(); it != freelist.end(); it++) {
-				if (it->start > lastIt->start) {
-					lastIt = it;
-				}
-			}
-			lastIt->count = newSize - lastIt->start;
-		};
 		targetBufferCurrentSize = newSize;
-
+		allocator.Grow(newSize);
 
 		// no copying needed if the buffer began empty
 		if (oldBuffer == nullptr) {
-			extendLastRange();
 			return;
 		}
 
 		gcBuffers.enqueue(oldBuffer);
 
-
-		// begin compaction
-
+		// allocations keep their offsets when the buffer grows, so the old contents are copied over in one piece
 		auto commandbuffer = mainCommandQueue->CreateCommandBuffer();
 		auto fence = device->CreateFence({});
 		commandbuffer->Begin();
-
-		// fill holes and copy data
-		{
-			uint32_t offset = 0;
-			for (auto& ptr : allocatedList) {
-				auto oldstart = ptr.start;
-				// copy buffers from:oldBuffer, offset:oldstart, to:sharedVertexBuffer offset:offset, size: ptr->count
-				commandbuffer->CopyBufferToBuffer(
-					{
-						.buffer = oldBuffer,
-						.offset = oldstart,
-					},
+		commandbuffer->CopyBufferToBuffer(
+			{
+				.buffer = oldBuffer,
+				.offset = 0,
+			},
 			{
 				.buffer = reallocBuffer,
-				.offset = offset,
+				.offset = 0,
 			},
-			ptr.count
-			);
-				ptr.start = offset;
-				offset += ptr.count;
-			}
-		}
+			oldSize * stride
+		);
 		// submit and wait
 		commandbuffer->End();
 		commandbuffer->Commit({ fence });
-		extendLastRange();
 		fence->Wait();
 	}
 }
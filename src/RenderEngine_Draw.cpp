@@ -95,7 +95,10 @@ struct LightingType{
  Render one frame using the current state of every object in the world
  */
 RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const std::span<RenderViewCollection> screenTargets, float guiScaleFactor) {
-    transientOffset = 0;
+    // App waits on the swapchain fence before drawing, so the previous frame is done with its transient data
+    if (lastTransientFrame > 0) {
+        transientAllocator.CompleteFrame(lastTransientFrame);
+    }
     
     RVE_PROFILE_FN_N("RenderEngine::Draw");
     DestroyUnusedResources();
@@ -257,7 +260,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 
 					ubo.nVerticesInThisMesh = vertexCount;
 					ubo.nTotalObjects = objectCount;
-					ubo.indexBufferOffset = mesh->GetAllocation().indexRange->start / sizeof(uint32_t);
+					ubo.indexBufferOffset = mesh->GetAllocation().indexRange.offset;
 					ubo.nIndicesInThisMesh = mesh->GetNumIndices();
 
 					mainCommandBuffer->SetComputeBytes(ubo, 0);
@@ -293,7 +296,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 					subo.numObjects = command.entities.DenseSize();
 					subo.numVertices = mesh->GetNumVerts();
 					subo.numBones = skeleton->GetSkeleton()->num_joints();
-					subo.vertexReadOffset = mesh->GetAllocation().vertRange->start / sizeof(VertexNormalUV);
+					subo.vertexReadOffset = mesh->GetAllocation().vertRange.offset;
 
 					// write joint transform matrices into buffer and update uniform offset
 					{
@@ -372,8 +375,8 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 							*(ptr + i) = {
 								.indexCount = uint32_t(mesh->GetNumIndices()),
 								.instanceCount = 0,
-								.indexStart = uint32_t(allocation.indexRange->start / sizeof(uint32_t)),
-								.baseVertex = uint32_t(allocation.vertRange->start / sizeof(VertexNormalUV)),
+								.indexStart = allocation.indexRange.offset,
+								.baseVertex = allocation.vertRange.offset,
 								.baseInstance = i
 							};
 						}
@@ -552,8 +555,9 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 						.maxTotalParticles = emitter.GetMaxParticles()
 					};
 
-					auto transientOffset = WriteTransient(engineData);
-					emitter.renderState.maxTotalParticlesOffset = transientOffset;
+					auto engineDataAllocation = WriteTransient(engineData);
+					emitter.renderState.engineDataBuffer = engineDataAllocation.buffer;
+					emitter.renderState.engineDataOffset = engineDataAllocation.offset;
 
 					// setup rendering
 					auto selMat = meshSelFn->material;
@@ -562,7 +566,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 
 					mainCommandBuffer->BindComputeBuffer(emitter.meshAliveParticleIndexBuffer, 10);
 					mainCommandBuffer->BindComputeBuffer(emitter.indirectDrawBuffer, 11);
-					mainCommandBuffer->BindComputeBuffer(transientBuffer, 12, transientOffset);
+					mainCommandBuffer->BindComputeBuffer(engineDataAllocation.buffer, 12, engineDataAllocation.offset);
 					mainCommandBuffer->BindComputeBuffer(emitter.emitterStateBuffer, 13);
 					mainCommandBuffer->BindComputeBuffer(emitter.activeParticleIndexBuffer, 14);
 					mainCommandBuffer->BindComputeBuffer(emitter.particleDataBuffer, 15);
@@ -592,9 +596,9 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 			prepareSkeletalCullingBuffer();
 		}
 
-        auto renderFromPerspective = [this, &worldTransformBuffer, &worldOwning, &skeletalPrepareResult]<bool includeLighting = true, bool transparentMode = false>(const matrix4& viewproj, const matrix4& viewonly, const matrix4& projOnly, vector3 camPos, glm::vec2 zNearFar, RGLRenderPassPtr renderPass, auto&& pipelineSelectorFunction, RGL::Rect viewportScissor, LightingType lightingFilter, const DepthPyramid& pyramid, const renderlayer_t layers, const RenderTargetCollection* target){
+        auto renderFromPerspective = [this, &worldTransformBuffer, &worldOwning, &skeletalPrepareResult]<bool includeLighting = true, bool transparentMode = false>(const matrix4& viewproj, const matrix4& viewonly, const matrix4& projOnly, vector3 camPos, glm::vec2 zNearFar, RGLRenderPassPtr renderPass, auto&& pipelineSelectorFunction, RGL::Rect viewportScissor, LightingType lightingFilter, const DepthPyramid& pyramid, const renderlayer_t layers, const RenderTargetCollection* target, const World::MaterialVisibility& visibility, uint32_t view){
 			RVE_PROFILE_FN_N("RenderFromPerspective");
-            uint32_t particleBillboardMatrices = 0;
+            TransientAllocation particleBillboardMatrices;
 
             struct QuadParticleData {
                 glm::mat4 viewProj;
@@ -685,7 +689,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 			};
 
 #pragma pack(pop)
-			const auto lightDataOffset = WriteTransient(lightData);
+			const auto lightDataAllocation = WriteTransient(lightData);
 
 			auto reallocBuffer = [this](RGLBufferPtr& buffer, uint32_t size_count, uint32_t stride, RGL::BufferAccess access, RGL::BufferConfig::Type type, RGL::BufferFlags flags) {
 				if (buffer == nullptr || buffer->getBufferSize() < size_count * stride) {
@@ -709,7 +713,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 
 			
 
-            auto cullSkeletalMeshes = [this, &worldTransformBuffer, &worldOwning, &reallocBuffer, layers, lightingFilter](matrix4 viewproj, const DepthPyramid pyramid) {
+            auto cullSkeletalMeshes = [this, &worldTransformBuffer, &worldOwning, &reallocBuffer, layers, lightingFilter, &visibility, view](matrix4 viewproj, const DepthPyramid pyramid) {
 				RVE_PROFILE_FN_N("Cull Skeletal Meshes");
 			// first reset the indirect buffers
 				uint32_t skeletalVertexOffset = 0;
@@ -735,7 +739,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 								initData = {
 									.indexCount = uint32_t(mesh->GetNumIndices()),
 									.instanceCount = 0,
-									.indexStart = uint32_t((indexRange->start) / sizeof(uint32_t)),
+									.indexStart = indexRange.offset,
 									.baseVertex = skeletalVertexOffset,
 									.baseInstance = i
 								};
@@ -768,6 +772,9 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
             mainCommandBuffer->BindComputeBuffer(worldOwning->renderData.renderLayers.buffer, 5);
 			mainCommandBuffer->BindComputeBuffer(worldOwning->renderData.perObjectAttributes.buffer, 6);
 			for (auto& [materialInstance, drawcommand] : worldOwning->renderData.skinnedMeshRenderData) {
+				if (!visibility.IsVisible(materialInstance, true, view)) {
+					continue;	// skipped when drawing too, so its stale indirect buffer is never read
+				}
 				CullingUBO cubo{
 					.viewProj = viewproj,
 					.indirectBufferOffset = 0,
@@ -840,7 +847,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 			};
 
 
-            auto cullTheRenderData = [this, &viewproj, &worldTransformBuffer, &camPos, &pyramid, &lightingFilter, &reallocBuffer, layers, &worldOwning](auto&& renderData) {
+            auto cullTheRenderData = [this, &viewproj, &worldTransformBuffer, &camPos, &pyramid, &lightingFilter, &reallocBuffer, layers, &worldOwning, &visibility, view](auto&& renderData) {
 				for (auto& [materialInstance, drawcommand] : renderData) {
 					RVE_PROFILE_FN_N("Cull RenderData");
 					bool shouldKeep = filterRenderData(lightingFilter, materialInstance);
@@ -851,6 +858,11 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 						continue;
 					}
 
+					// nothing in this bucket can be in view, so it records no culling or drawing
+					if (!visibility.IsVisible(materialInstance, false, view)) {
+						continue;
+					}
+
 					//prepass: get number of LODs and entities
 					uint32_t numLODs = 0, numEntities = 0;
 					for (const auto& command : drawcommand.commands) {
@@ -880,8 +892,8 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 									initData = {
 										.indexCount = uint32_t(meshInst->totalIndices),
 										.instanceCount = 0,
-										.indexStart = uint32_t(meshInst->meshAllocation.indexRange->start / sizeof(uint32_t)),
-										.baseVertex = uint32_t(meshInst->meshAllocation.vertRange->start / sizeof(VertexNormalUV)),
+										.indexStart = meshInst->meshAllocation.indexRange.offset,
+										.baseVertex = meshInst->meshAllocation.vertRange.offset,
 										.baseInstance = baseInstance,	// sets the offset into the material-global culling buffer (and other per-instance data buffers). we allocate based on worst-case here, so the offset is known.
 									};
 									baseInstance += nEntitiesInThisCommand;
@@ -945,7 +957,8 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 					mainCommandBuffer->EndCompute();
 				}
 				};
-			auto renderTheRenderData = [this, &viewproj, &viewonly,&projOnly, &worldTransformBuffer, &pipelineSelectorFunction, &viewportScissor, &worldOwning, particleBillboardMatrices, &lightDataOffset,&layers, &target](auto&& renderData, RGLBufferPtr vertexBuffer, LightingType currentLightingType) {
+			auto renderTheRenderData = [this, &viewproj, &viewonly,&projOnly, &worldTransformBuffer, &pipelineSelectorFunction, &viewportScissor, &worldOwning, particleBillboardMatrices, &lightDataAllocation,&layers, &target, &visibility, view](auto&& renderData, RGLBufferPtr vertexBuffer, LightingType currentLightingType) {
+				constexpr bool skinned = std::is_same_v<std::remove_cvref_t<decltype(renderData)>, decltype(worldOwning->renderData.skinnedMeshRenderData)>;
 				// do static meshes
 				RVE_PROFILE_FN_N("RenderTheRenderData");
 				mainCommandBuffer->SetViewport({
@@ -962,7 +975,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 					bool shouldKeep = filterRenderData(currentLightingType, materialInstance);
 
 					// is this the correct material type? if not, skip
-					if (!shouldKeep) {
+					if (!shouldKeep || !visibility.IsVisible(materialInstance, skinned, view)) {
 						continue;
 					}
 
@@ -971,7 +984,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 					mainCommandBuffer->BindRenderPipeline(pipeline);
 
 					// this is always needed
-					mainCommandBuffer->BindBuffer(transientBuffer, 11, lightDataOffset);
+					mainCommandBuffer->BindBuffer(lightDataAllocation.buffer, 11, lightDataAllocation.offset);
 
 					if constexpr (includeLighting) {
 						// make textures resident and put them in the right format
@@ -1055,7 +1068,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 				}
 
 				// render particles
-                worldOwning->Filter([this, &viewproj, &particleBillboardMatrices, &currentLightingType, &pipelineSelectorFunction, &lightDataOffset, &worldOwning, &layers, &target](const ParticleEmitter& emitter, const Transform& t) {
+                worldOwning->Filter([this, &viewproj, &particleBillboardMatrices, &currentLightingType, &pipelineSelectorFunction, &lightDataAllocation, &worldOwning, &layers, &target](const ParticleEmitter& emitter, const Transform& t) {
                     // check if the render layers match
                     auto renderLayers = worldOwning->renderData.renderLayers[emitter.GetOwner().GetID()];
                     if ((renderLayers & layers) == 0){
@@ -1073,7 +1086,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 						return;
 					}
 
-					auto sharedParticleImpl = [this, &particleBillboardMatrices, &pipelineSelectorFunction, &worldOwning, &lightDataOffset, &target](const ParticleEmitter& emitter, auto&& materialInstance, Ref<ParticleRenderMaterial> material, RGLBufferPtr activeParticleIndexBuffer, bool isLit) {
+					auto sharedParticleImpl = [this, &particleBillboardMatrices, &pipelineSelectorFunction, &worldOwning, &lightDataAllocation, &target](const ParticleEmitter& emitter, auto&& materialInstance, Ref<ParticleRenderMaterial> material, RGLBufferPtr activeParticleIndexBuffer, bool isLit) {
 						auto pipeline = pipelineSelectorFunction(material);
 
 
@@ -1081,9 +1094,9 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 						mainCommandBuffer->BindBuffer(emitter.particleDataBuffer, material->particleDataBufferBinding);
 						mainCommandBuffer->BindBuffer(activeParticleIndexBuffer, material->particleAliveIndexBufferBinding);
                         mainCommandBuffer->BindBuffer(emitter.emitterStateBuffer, material->particleEmitterStateBufferBinding);
-						mainCommandBuffer->BindBuffer(transientBuffer, material->particleMatrixBufferBinding, particleBillboardMatrices);
+						mainCommandBuffer->BindBuffer(particleBillboardMatrices.buffer, material->particleMatrixBufferBinding, particleBillboardMatrices.offset);
 
-						mainCommandBuffer->BindBuffer(transientBuffer, 11, lightDataOffset);
+						mainCommandBuffer->BindBuffer(lightDataAllocation.buffer, 11, lightDataAllocation.offset);
 						if (isLit) {
 							mainCommandBuffer->BindBuffer(worldOwning->renderData.ambientLightData.GetDense().get_underlying().buffer, 12);
 							mainCommandBuffer->BindBuffer(worldOwning->renderData.directionalLightData.GetDense().get_underlying().buffer, 13);
@@ -1155,7 +1168,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 									});
 
 							},
-							[this,&emitter,&sharedParticleImpl, &currentLightingType,&lightDataOffset](const Ref <MeshParticleRenderMaterialInstance>& meshMat) {
+							[this,&emitter,&sharedParticleImpl, &currentLightingType,&lightDataAllocation](const Ref <MeshParticleRenderMaterialInstance>& meshMat) {
 							RGLBufferPtr activeIndexBuffer;
 
 								auto result = particleRenderFilter<MeshParticleRenderMaterial>(currentLightingType, meshMat);
@@ -1177,7 +1190,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 
 								mainCommandBuffer->SetVertexBuffer(sharedVertexBuffer);
 								mainCommandBuffer->SetIndexBuffer(sharedIndexBuffer);
-								mainCommandBuffer->BindBuffer(transientBuffer, MeshParticleRenderMaterialInstance::kEngineDataBinding, emitter.renderState.maxTotalParticlesOffset);
+								mainCommandBuffer->BindBuffer(emitter.renderState.engineDataBuffer, MeshParticleRenderMaterialInstance::kEngineDataBinding, emitter.renderState.engineDataOffset);
 
 								mainCommandBuffer->ExecuteIndirectIndexed(
 									{
@@ -1218,6 +1231,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 		struct lightViewProjResult {
 			glm::mat4 lightProj, lightView;
 			glm::vec3 camPos = glm::vec3{ 0,0,0 };
+			BoundingSphere influence = BoundingSphere::Unbounded();	// nothing outside this can cast a shadow that the light lights
 			DepthPyramid depthPyramid;
 			RGLTexturePtr shadowmapTexture;
 			glm::mat4 spillData;
@@ -1228,7 +1242,8 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 
 		// the generic shadowmap rendering function
 		RVE_PROFILE_SECTION(encode_shadowmaps, "Render Encode Shadowmaps");
-        auto renderLightShadowmap = [this, &renderFromPerspective, &worldOwning](auto&& lightStore, uint32_t numShadowmaps, auto&& genLightViewProjAtIndex, auto&& postshadowmapFunction, auto&& shouldRendershadowmap) {
+		World::MaterialVisibility shadowVisibility, viewVisibility;
+        auto renderLightShadowmap = [this, &renderFromPerspective, &worldOwning, &shadowVisibility](auto&& lightStore, uint32_t numShadowmaps, auto&& genLightViewProjAtIndex, auto&& postshadowmapFunction, auto&& shouldRendershadowmap) {
 			if (lightStore.DenseSize() <= 0) {
 				return;
 			}
@@ -1243,11 +1258,26 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 
 				using lightadt_t = std::remove_reference_t<decltype(lightStore)>;
 
+				// find the casters of all of this light's shadowmaps in one pass over the bounds
+				constexpr static uint32_t maxShadowmaps = std::max<uint32_t>(6, MAX_CASCADES);
+				Array<lightViewProjResult, maxShadowmaps> shadowViews;
+				Array<BoundedFrustum, maxShadowmaps> shadowVolumes;
+				uint32_t numViews = 0;
 				for (uint8_t i = 0; i < numShadowmaps; i++) {
                     if (!shouldRendershadowmap(i, owner)){
                         continue;
                     }
-					lightViewProjResult lightMats = genLightViewProjAtIndex(i, light, owner);
+					shadowViews[numViews] = genLightViewProjAtIndex(i, light, owner);
+					shadowVolumes[numViews] = { Frustum(shadowViews[numViews].lightProj * shadowViews[numViews].lightView), shadowViews[numViews].influence };
+					numViews++;
+				}
+				if (numViews == 0) {
+					continue;
+				}
+				worldOwning->QueryMaterialVisibility({ shadowVolumes.data(), numViews }, shadowVisibility);
+
+				for (uint32_t view = 0; view < numViews; view++) {
+					const auto& lightMats = shadowViews[view];
 
 					auto lightSpaceMatrix = lightMats.lightProj * lightMats.lightView;
 
@@ -1257,7 +1287,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 					auto shadowMapSize = shadowTexture->GetSize().width;
 					renderFromPerspective.template operator()<false,false>(lightSpaceMatrix, lightMats.lightView, lightMats.lightProj, lightMats.camPos, {}, shadowRenderPass, [](auto&& mat) {
 						return mat->GetShadowRenderPipeline();
-                    }, { 0, 0, shadowMapSize,shadowMapSize }, { .Lit = true, .Unlit = true, .FilterLightBlockers = true, .Opaque = true }, lightMats.depthPyramid, light.shadowLayers, nullptr);
+                    }, { 0, 0, shadowMapSize,shadowMapSize }, { .Lit = true, .Unlit = true, .FilterLightBlockers = true, .Opaque = true }, lightMats.depthPyramid, light.shadowLayers, nullptr, shadowVisibility, view);
 
 				}
 				postshadowmapFunction(owner);
@@ -1265,6 +1295,22 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 			mainCommandBuffer->EndRenderDebugMarker();
 		};
 
+		// a point or spot light whose influence reaches no camera lights nothing on screen, so its shadowmaps are not needed
+		UnorderedSet<entity_t> visiblePointLights, visibleSpotLights;
+		{
+			// reverse-Z projections have no far plane, so camera views are not bounded in depth
+			Vector<BoundedFrustum> cameraFrusta;
+			for (const auto& view : screenTargets) {
+				for (const auto& camdata : view.camDatas) {
+					cameraFrusta.push_back({ Frustum(camdata.viewProj) });
+				}
+			}
+			for (uint32_t i = 0; i < cameraFrusta.size(); i += DynamicBVH<entity_t>::MaxBatchSize) {
+				const auto count = std::min<uint32_t>(cameraFrusta.size() - i, DynamicBVH<entity_t>::MaxBatchSize);
+				worldOwning->QueryVisibleLights({ cameraFrusta.data() + i, count }, visiblePointLights, visibleSpotLights);
+			}
+		}
+
 		RVE_PROFILE_SECTION(encode_spot_shadows,"Render Encode Spot Shadows");
 		const auto spotlightShadowMapFunction = [](uint8_t index, RavEngine::World::SpotLightDataUpload& light, Entity owner) {
 
@@ -1286,6 +1332,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 				.lightProj = lightProj,
 				.lightView = viewMat,
 				.camPos = camPos,
+				.influence = { glm::vec3(camPos), World::LightInfluenceRadius(light.intensity) },
 				.depthPyramid = origLight.shadowData.pyramid,
 				.shadowmapTexture = origLight.shadowData.shadowMap,
 				.spillData = light.lightViewProj
@@ -1295,7 +1342,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 		renderLightShadowmap(worldOwning->renderData.spotLightData, 1,
 			spotlightShadowMapFunction,
 			[](Entity unused) {},
-            [](uint32_t i, auto&& entity){ return true;}
+            [&visibleSpotLights](uint32_t i, auto&& entity){ return visibleSpotLights.contains(entity.GetID()); }
 		);
 		RVE_PROFILE_SECTION_END(encode_spot_shadows);
 
@@ -1341,6 +1388,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 				.lightProj = lightProj,
 				.lightView = viewMat,
 				.camPos = camPos,
+				.influence = { camPos, World::LightInfluenceRadius(light.intensity) },
 				.depthPyramid = origLight.shadowData.cubePyramids[index],
 				.shadowmapTexture = origLight.shadowData.cubeShadowmaps[index],
 				.spillData = lightProj
@@ -1366,7 +1414,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 					);
 				}
             },
-        [](uint32_t i, auto&& entity){ return true;}
+        [&visiblePointLights](uint32_t i, auto&& entity){ return visiblePointLights.contains(entity.GetID()); }
         );
 		RVE_PROFILE_SECTION_END(encode_point_shadows);
 		RVE_PROFILE_SECTION_END(encode_shadowmaps);
@@ -1377,7 +1425,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 			auto nextImgSize = view.pixelDimensions;
 			auto& target = view.collection;
 
-			auto renderLitPass_Impl = [this,&target, &renderFromPerspective,&renderLightShadowmap,&worldOwning]<bool transparentMode = false>(auto&& camData, auto&& fullSizeViewport, auto&& fullSizeScissor, auto&& renderArea) {
+			auto renderLitPass_Impl = [this,&target, &renderFromPerspective,&renderLightShadowmap,&worldOwning,&viewVisibility]<bool transparentMode = false>(auto&& camData, auto&& fullSizeViewport, auto&& fullSizeScissor, auto&& renderArea) {
 				// directional light shadowmaps
                 
 
@@ -1520,10 +1568,11 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 				}
 
 				// render all the static meshes
-
+				const BoundedFrustum cameraFrustum{ Frustum(camData.viewProj) };
+				worldOwning->QueryMaterialVisibility({ &cameraFrustum, 1 }, viewVisibility);
 				renderFromPerspective.template operator()<true, transparentMode>(camData.viewProj, camData.viewOnly, camData.projOnly, camData.camPos, camData.zNearFar, transparentMode ? litTransparentPass : litRenderPass, [](auto&& mat) {
 					return mat->GetMainRenderPipeline();
-                }, renderArea, {.Lit = true, .Transparent = transparentMode, .Opaque = !transparentMode, }, target.depthPyramid, camData.layers, &target);
+                }, renderArea, {.Lit = true, .Transparent = transparentMode, .Opaque = !transparentMode, }, target.depthPyramid, camData.layers, &target, viewVisibility, 0);
 
 				
 			};
@@ -1536,15 +1585,17 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 				renderLitPass_Impl.template operator()<true>(camData, fullSizeViewport, fullSizeScissor, renderArea);
 			};
 
-            auto renderFinalPass = [this, &target, &worldOwning, &view, &guiScaleFactor, &nextImgSize, &renderFromPerspective](auto&& camData, auto&& fullSizeViewport, auto&& fullSizeScissor, auto&& renderArea) {
+            auto renderFinalPass = [this, &target, &worldOwning, &view, &guiScaleFactor, &nextImgSize, &renderFromPerspective, &viewVisibility](auto&& camData, auto&& fullSizeViewport, auto&& fullSizeScissor, auto&& renderArea) {
                 
                 //render unlits
 				RVE_PROFILE_SECTION(unlit, "Encode Unlit Opaques");
+				const BoundedFrustum cameraFrustum{ Frustum(camData.viewProj) };
+				worldOwning->QueryMaterialVisibility({ &cameraFrustum, 1 }, viewVisibility);
                 unlitRenderPass->SetAttachmentTexture(0, target.lightingTexture->GetDefaultView());
                 unlitRenderPass->SetDepthAttachmentTexture(target.depthStencil->GetDefaultView());
 				renderFromPerspective.template operator() < false > (camData.viewProj, camData.viewOnly, camData.projOnly, camData.camPos, {}, unlitRenderPass, [](auto&& mat) {
                     return mat->GetMainRenderPipeline();
-                }, renderArea, {.Unlit = true, .Opaque = true }, target.depthPyramid, camData.layers, &target);
+                }, renderArea, {.Unlit = true, .Opaque = true }, target.depthPyramid, camData.layers, &target, viewVisibility, 0);
 				RVE_PROFILE_SECTION_END(unlit);
 
 				// render unlits with transparency
@@ -1552,7 +1603,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 				unlitTransparentPass->SetDepthAttachmentTexture(target.depthStencil->GetDefaultView());
 				renderFromPerspective.template operator() < false, true > (camData.viewProj, camData.viewOnly, camData.projOnly, camData.camPos, {}, unlitTransparentPass, [](auto&& mat) {
 					return mat->GetMainRenderPipeline();
-				}, renderArea, { .Unlit = true, .Transparent = true }, target.depthPyramid, camData.layers,&target);
+				}, renderArea, { .Unlit = true, .Transparent = true }, target.depthPyramid, camData.layers,&target, viewVisibility, 0);
 				RVE_PROFILE_SECTION_END(unlittrans);
                 
                 // then do the skybox, if one is defined.
@@ -1569,14 +1620,14 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
                         float(fullSizeViewport.width) / float(fullSizeViewport.height)
                     };
                     
-                    auto transientOffset = WriteTransient(data);
+                    auto skyboxData = WriteTransient(data);
                     
                     mainCommandBuffer->BeginRendering(unlitRenderPass);
                     mainCommandBuffer->BeginRenderDebugMarker("Skybox");
                     mainCommandBuffer->SetViewport(fullSizeViewport);
                     mainCommandBuffer->SetScissor(fullSizeScissor);
                     mainCommandBuffer->BindRenderPipeline(worldOwning->skybox->skyMat->GetMat()->renderPipeline);
-                    mainCommandBuffer->BindBuffer(transientBuffer, 1, transientOffset);
+                    mainCommandBuffer->BindBuffer(skyboxData.buffer, 1, skyboxData.offset);
                     mainCommandBuffer->SetVertexBuffer(screenTriVerts);
                     mainCommandBuffer->Draw(3);
                     mainCommandBuffer->EndRenderDebugMarker();
@@ -1951,7 +2002,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
             
             if (VideoSettings.ssao){
 
-				stackarray(offsets, uint32_t, view.camDatas.size());
+				Vector<TransientAllocation> offsets(view.camDatas.size());
 				uint32_t offset_index = 0;
 
 				auto renderSSAOPass = [this, &target, &nextImgSize, &worldOwning, &offsets, &offset_index](auto&& camData, auto&& fullsizeViewport, auto&& fullSizeScissor, auto&& renderArea) {
@@ -1967,7 +2018,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 
 					mainCommandBuffer->SetVertexBuffer(screenTriVerts);
 					mainCommandBuffer->SetFragmentBytes(pushConstants,0);
-					mainCommandBuffer->BindBuffer(transientBuffer, 7, offsets[offset_index]);
+					mainCommandBuffer->BindBuffer(offsets[offset_index].buffer, 7, offsets[offset_index].offset);
 					mainCommandBuffer->Draw(3);
 				};
 
@@ -2031,6 +2082,7 @@ RGLCommandBufferPtr RenderEngine::Draw(Ref<RavEngine::World> worldOwning, const
 		}
 		RVE_PROFILE_SECTION_END(allViews);
 		mainCommandBuffer->End();
+		lastTransientFrame = transientAllocator.EndFrame();
 
 		return mainCommandBuffer;
 	}
@@ -168,8 +168,8 @@ Rml::CompiledGeometryHandle RenderEngine::CompileGeometry(Rml::Vertex* vertices,
 
 		mainCommandBuffer->CopyBufferToBuffer(
 			{
-				.buffer = transientBuffer,
-				.offset = vbufStaging
+				.buffer = vbufStaging.buffer,
+				.offset = vbufStaging.offset
 			},
 		{
 			.buffer = vbuf,
@@ -178,8 +178,8 @@ Rml::CompiledGeometryHandle RenderEngine::CompileGeometry(Rml::Vertex* vertices,
 
 		mainCommandBuffer->CopyBufferToBuffer(
 			{
-				.buffer = transientBuffer,
-				.offset = ibufStaging
+				.buffer = ibufStaging.buffer,
+				.offset = ibufStaging.offset
 			},
 		{
 			.buffer = ibuf,
@@ -10,9 +10,11 @@
 #include <ozz/base/span.h>
 #include <ozz/base/maths/soa_transform.h>
 #include <ozz/animation/runtime/local_to_model_job.h>
+#include <ozz/animation/runtime/skeleton_utils.h>
 #include "VirtualFileSystem.hpp"
 #include <glm/gtc/type_ptr.hpp>
 #include "Skeleton.hpp"
+#include "AnimationMath.hpp"
 #if !RVE_SERVER
     #include "RenderEngine.hpp"
 #endif
@@ -20,10 +22,10 @@
 using namespace RavEngine;
 using namespace std;
 
-SkeletonData DeserializeSkeleton(std::span<uint8_t> binaryData) {
-	uint8_t* fp = binaryData.data();
+SkeletonData DeserializeSkeleton(std::span<const uint8_t> binaryData) {
+	const uint8_t* fp = binaryData.data();
 
-	SerializedSkeletonDataHeader header = *reinterpret_cast<decltype(header)*>(fp);
+	SerializedSkeletonDataHeader header = *reinterpret_cast<const decltype(header)*>(fp);
 	fp += sizeof(header);
 
 	// check header
@@ -37,13 +39,13 @@ SkeletonData DeserializeSkeleton(std::span<uint8_t> binaryData) {
 
 	// Get bone transforms
 	for (uint32_t i = 0; i < header.numBones; i++) {
-		BoneTransform transform = *reinterpret_cast<decltype(transform)*>(fp);
+		BoneTransform transform = *reinterpret_cast<const decltype(transform)*>(fp);
 		fp += sizeof(transform);
         deserialized.allBones.push_back({transform});
 	}
 	// get bone names
 	for (uint32_t i = 0; i < header.numBones; i++) {
-		uint16_t length = *reinterpret_cast<decltype(length)*>(fp);
+		uint16_t length = *reinterpret_cast<const decltype(length)*>(fp);
 		fp += sizeof(length);
 		auto& name = deserialized.allBones[i].name;
 		name.reserve(length);
@@ -54,13 +56,13 @@ SkeletonData DeserializeSkeleton(std::span<uint8_t> binaryData) {
 	}
 	// get bone children
 	for (uint32_t i = 0; i < header.numBones; i++) {
-		uint16_t numchildren = *reinterpret_cast<decltype(numchildren)*>(fp);
+		uint16_t numchildren = *reinterpret_cast<const decltype(numchildren)*>(fp);
 		fp += sizeof(numchildren);
 
 		auto& vec = deserialized.childrenMap.emplace_back();
 		vec.reserve(numchildren);
 		for (int i = 0; i < numchildren; i++) {
-			uint16_t childIdx = *reinterpret_cast<decltype(childIdx)*>(fp);
+			uint16_t childIdx = *reinterpret_cast<const decltype(childIdx)*>(fp);
 			fp += sizeof(childIdx);
 			vec.push_back(childIdx);
 		}
@@ -87,17 +89,17 @@ SkeletonData DeserializeSkeleton(std::span<uint8_t> binaryData) {
 	return data;
 }
 
-SkeletonAsset::SkeletonAsset(const std::string& str){
+static ozz::animation::offline::RawSkeleton LoadRawSkeleton(const std::string& str){
+	ozz::animation::offline::RawSkeleton raw_skeleton;
 	auto path = Format("skeletons/{}.rves",str);
 	
 	if(GetApp()->GetResources().Exists(path.c_str())){
 		
-		auto data = GetApp()->GetResources().FileContentsAt(path.c_str());
+		auto data = GetApp()->GetResources().FileViewAt(path.c_str());
 
-		auto skeletonData = DeserializeSkeleton(data);
+		auto skeletonData = DeserializeSkeleton(data.span());
 
 		//recurse the root node and get all of the bones
-		ozz::animation::offline::RawSkeleton raw_skeleton;
 		raw_skeleton.roots.resize(1);
 		auto& root = raw_skeleton.roots[0];
 
@@ -114,17 +116,21 @@ SkeletonAsset::SkeletonAsset(const std::string& str){
 			}
 		};
 		convertBone(root, skeletonData.root, convertBone);
-
-		//convert into a runtime-optimized skeleton
-		Debug::Assert(raw_skeleton.Validate(), "Skeleton validation failed");
-
-		ozz::animation::offline::SkeletonBuilder skbuilder;
-		ozz::unique_ptr<ozz::animation::Skeleton> sk = skbuilder(raw_skeleton);
-		skeleton = std::move(sk);
 	}
 	else{
 		Debug::Fatal("No skeleton at {}",path);
 	}
+	return raw_skeleton;
+}
+
+SkeletonAsset::SkeletonAsset(const std::string& str) : SkeletonAsset(LoadRawSkeleton(str)){}
+
+SkeletonAsset::SkeletonAsset(const ozz::animation::offline::RawSkeleton& raw_skeleton){
+	//convert into a runtime-optimized skeleton
+	Debug::Assert(raw_skeleton.Validate(), "Skeleton validation failed");
+
+	ozz::animation::offline::SkeletonBuilder skbuilder;
+	skeleton = skbuilder(raw_skeleton);
 
 	bindposes.resize(skeleton->joint_names().size());
 	stackarray(bindpose_ozz, ozz::math::Float4x4, skeleton->joint_names().size());
@@ -133,22 +139,16 @@ SkeletonAsset::SkeletonAsset(const std::string& str){
 	ozz::animation::LocalToModelJob job;
 	job.skeleton = skeleton.get();
 	job.input = ozz::span(skeleton->joint_rest_poses());
-	job.output = ozz::span(bindpose_ozz, skeleton->joint_names().size_bytes());
+	job.output = ozz::span(bindpose_ozz, skeleton->num_joints());
 	
 	Debug::Assert(job.Run(), "Bindpose extraction failed");
 	
 	//convert to format understandble by GPU
-	float matrix[16];
+	inverseBindposesSIMD.resize(skeleton->joint_names().size());
 	for(int i = 0; i < skeleton->joint_names().size(); i++){
-		auto& t = bindpose_ozz[i];
-		for(int r = 0; r < 4; r++){
-			float result[4];
-			std::memcpy(result,t.cols + r,sizeof(t.cols[r]));
-			//_mm_store_ps(result,p.cols[r]);
-			std::memcpy(matrix + r*4,result,sizeof(result));
-		}
 		//inverse here because shader needs the inverse bindpose
-		bindposes[i] = glm::inverse(glm::make_mat4(matrix));
+		inverseBindposesSIMD[i] = ozz::math::Invert(bindpose_ozz[i]);
+		StoreMatrix(inverseBindposesSIMD[i], bindposes[i]);
 	}
 	
 	assert(bindposes.size() * sizeof(bindposes[0]) < numeric_limits<uint32_t>::max());
@@ -186,10 +186,9 @@ RavEngine::SkeletonAsset::~SkeletonAsset()
 
 
 bool SkeletonAsset::HasBone(const std::string& boneName) const{
-	for (int i = 0; i < skeleton->num_joints(); i++) {
-		if (strcmp(skeleton->joint_names()[i], boneName.data()) == 0) {
-			return true;
-		}
-	}
-	return false;
+	return FindBone(boneName) >= 0;
+}
+
+int SkeletonAsset::FindBone(const std::string& boneName) const{
+	return ozz::animation::FindJoint(*skeleton, boneName.c_str());
 }
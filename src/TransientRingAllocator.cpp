@@ -0,0 +1,80 @@
+#include "TransientRingAllocator.hpp"
+#include "Debug.hpp"
+#include <algorithm>
+
+using namespace RavEngine;
+
+TransientRingAllocator::TransientRingAllocator(uint32_t capacity, uint32_t alignment, uint32_t overflowPageSize) : capacity(capacity), alignment(alignment), overflowPageSize(overflowPageSize == 0 ? capacity : overflowPageSize){
+    Debug::Assert(alignment > 0 && capacity % alignment == 0, "Transient ring capacity {} is not a multiple of its alignment {}", capacity, alignment);
+}
+
+TransientRingAllocator::Allocation TransientRingAllocator::Allocate(uint32_t size){
+    const auto alignedSize = (size + alignment - 1) / alignment * alignment;
+
+    if (alignedSize <= capacity){
+        // allocations do not straddle the end of the ring, so skip to the start if this one would
+        auto position = head;
+        const auto offsetInRing = position % capacity;
+        if (offsetInRing + alignedSize > capacity){
+            position += capacity - offsetInRing;
+        }
+        if (position + alignedSize - tail <= capacity){
+            head = position + alignedSize;
+            return {RingPage, uint32_t(position % capacity)};
+        }
+    }
+
+    return AllocateOverflow(alignedSize);
+}
+
+TransientRingAllocator::Allocation TransientRingAllocator::AllocateOverflow(uint32_t size){
+    overflowBytes += size;
+
+    if (currentOverflowPage != 0){
+        auto& page = overflowPages[currentOverflowPage - 1];
+        if (page.used + size <= page.size){
+            const auto offset = page.used;
+            page.used += size;
+            return {currentOverflowPage, offset};
+        }
+    }
+
+    // reuse a page that no frame in flight is reading, or make a new one
+    auto it = std::find_if(overflowPages.begin(), overflowPages.end(), [size](const OverflowPage& page){
+        return !page.inFlight && page.size >= size;
+    });
+    if (it == overflowPages.end()){
+        overflowPages.push_back({.size = std::max(overflowPageSize, size)});
+        it = overflowPages.end() - 1;
+    }
+    it->inFlight = true;
+    it->lastFrame = currentFrame;
+    it->used = size;
+    currentOverflowPage = uint32_t(it - overflowPages.begin()) + 1;
+    return {currentOverflowPage, 0};
+}
+
+uint64_t TransientRingAllocator::EndFrame(){
+    framesInFlight.push({currentFrame, head});
+    currentOverflowPage = 0;
+    overflowBytes = 0;
+    return currentFrame++;
+}
+
+void TransientRingAllocator::CompleteFrame(uint64_t frame){
+    Debug::Assert(frame < currentFrame, "Frame {} cannot complete before it has ended", frame);
+    while (!framesInFlight.empty() && framesInFlight.front().frame <= frame){
+        tail = framesInFlight.front().end;
+        framesInFlight.pop();
+    }
+    if (framesInFlight.empty() && tail == head){
+        // nothing is in use, so start again at the beginning of the ring, where the whole ring fits without wrapping
+        head = tail = (head + capacity - 1) / capacity * capacity;
+    }
+    for (auto& page : overflowPages){
+        if (page.inFlight && page.lastFrame <= frame){
+            page.inFlight = false;
+            page.used = 0;
+        }
+    }
+}
@@ -43,6 +43,11 @@ RGLShaderLibraryPtr RavEngine::LoadShaderByFilename(const std::string& name, RGL
 {
     auto shaderRelativePath = name;// GetShader(name);
 
+    // nothing is drawn, so there is no bytecode to load
+    if (RGL::CurrentAPI() == RGL::API::Noop) {
+        return device->CreateShaderLibraryFromBytes({});
+    }
+
     auto& resources = GetApp()->GetResources();
 #if __APPLE__
     auto name_copy = name;
@@ -1,6 +1,7 @@
 #include "VirtualFileSystem.hpp"
 #include <physfs.h>
 #include "Filesystem.hpp"
+#include "AssetPack.hpp"
 #include <span>
 
 #ifdef __APPLE__
@@ -164,6 +165,13 @@ VirtualFilesystem::VirtualFilesystem() {
 
     streamingAssetsPath = streamingAssetsPath / Format("{}_Streaming",path);
 
+    // an asset pack next to the archive is mapped instead of mounting the archive
+    auto packpath = Filesystem::Path(cstr).replace_extension(".rvepack");
+    if (std::filesystem::exists(packpath)){
+        pack = std::make_unique<AssetPack>(packpath);
+        return;
+    }
+
 #if __ANDROID__
     // we need to do some additional setup here. Android `assets` are not accessible to C functions
     // out of the box. we must copy them to a readable location using the Android api
@@ -196,6 +204,8 @@ VirtualFilesystem::VirtualFilesystem() {
 	PHYSFS_freeList(root);
 }
 
+VirtualFilesystem::~VirtualFilesystem() = default;
+
 const VirtualFilesystem::ptrsize VirtualFilesystem::GetSizeAndPtr(const char *path){
     auto ptr = PHYSFS_openRead(path);
     size_t size = PHYSFS_fileLength(ptr);
@@ -210,14 +220,44 @@ size_t VirtualFilesystem::ReadInto(PHYSFS_File* file, void* output, size_t size)
     return PHYSFS_readBytes(file,output,size);
 }
 
+std::span<const uint8_t> VirtualFilesystem::MappedFileAt(const char* fullpath) const{
+    auto mapped = pack->Find(fullpath);
+    if (!mapped.data()){
+        Debug::Fatal("cannot open {}", fullpath);
+    }
+    return mapped;
+}
+
+FileView VirtualFilesystem::FileViewAt(const char* path){
+    FileView file;
+    if (pack){
+        file.view = MappedFileAt(Format("{}/{}", rootname, path).c_str());
+    }
+    else{
+        FileContentsAt(path, file.owned, false);
+        file.view = file.owned;
+    }
+    return file;
+}
+
 bool RavEngine::VirtualFilesystem::Exists(const char* path)
 {
+	if (pack){
+		return pack->Exists(Format("{}/{}", rootname, path));
+	}
 	return PHYSFS_exists(Format("{}/{}",rootname,path).c_str());
 }
 
 void RavEngine::VirtualFilesystem::IterateDirectory(const char* path, Function<void(const std::string&)> callback)
 {
 	string fullpath = Format("{}/{}", rootname, path);
+	if (pack){
+		Debug::Assert(pack->Exists(fullpath), "{} not found", path);
+		pack->IterateDirectory(fullpath, [&](std::string_view name){
+			callback(Format("{}/{}", path, name));
+		});
+		return;
+	}
 	auto all = PHYSFS_enumerateFiles(fullpath.c_str());
 	Debug::Assert(all != nullptr, "{} not found", path);
 	for (int i = 0; *(all+i) != nullptr; i++) {
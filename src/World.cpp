@@ -22,6 +22,8 @@
 #include "SkinnedMeshComponent.hpp"
 #include "NetworkManager.hpp"
 #include "Constraint.hpp"
+#include "NavMeshSystem.hpp"
+#include "CrowdSystem.hpp"
 #include <physfs.h>
 #include "ScriptSystem.hpp"
 #include "RenderEngine.hpp"
@@ -62,16 +64,34 @@ void RavEngine::World::Tick(float scale) {
 }
 
 
-RavEngine::World::World() : Solver(std::make_unique<PhysicsSolver>(this)){
+RavEngine::World::World() : Solver(std::make_unique<PhysicsSolver>(this)), animatorSystem(std::make_unique<AnimatorSystem>()){
     SetupTaskGraph();
     EmplacePolymorphicSystem<ScriptSystem>();
-    EmplaceSystem<AnimatorSystem>();
+    {
+        // animators run as batched stages rather than as a per-component system.
+        // The batches are gathered inside the same task so that they obey the same dependencies as the stages.
+        auto stages = ECSTasks.emplace([this](tf::Subflow& subflow){
+            animatorSystem->UpdateBatches(*this, static_cast<uint32_t>(GetApp()->executor.num_workers()));
+            animatorSystem->Schedule(subflow);
+        }).name("AnimatorSystem");
+        typeToSystem[CTTI<AnimatorSystem>()] = std::make_pair(stages, stages);
+    }
 	EmplaceSystem<SocketSystem>();
     CreateDependency<AnimatorSystem,ScriptSystem>();			// run scripts before animations
     CreateDependency<AnimatorSystem,PhysicsLinkSystemRead>();	// run physics reads before animator
     CreateDependency<PhysicsLinkSystemWrite,ScriptSystem>();	// run physics write before scripts
 	CreateDependency<SocketSystem, AnimatorSystem>();			// run animator before socket system
 
+	EmplaceSystem<NavMeshSystem>();
+	CreateDependency<NavMeshSystem, ScriptSystem>();			// run scripts before rebuilding tiles touched by their obstacles
+
+	EmplaceSystem<CrowdSystem>();
+	EmplaceSystem<CrowdAgentSystem>();
+	CreateDependency<CrowdSystem, ScriptSystem>();				// apply agent requests made by scripts this tick
+	CreateDependency<CrowdSystem, NavMeshSystem>();				// steer around obstacles added this tick
+	CreateDependency<CrowdAgentSystem, CrowdSystem>();			// write transforms once every crowd has moved
+	CreateDependency<AnimatorSystem, CrowdAgentSystem>();		// animate agents where the crowd put them, root motion also writes transforms
+
     EmplaceSystem<RPCSystem>();
 #if !RVE_SERVER
 
@@ -327,39 +347,35 @@ void World::setupRenderTasks(){
         nCreatedThisTick = 0;
     });
     
-    auto updateRenderDataGeneric = [this]<typename SM_T, typename ... Aux_T>(const SM_T* sm_t_holder, auto& renderDataSource, auto&& captureLambda, auto&& iteratorComparator, const Aux_T* ... axillaryParams){
-        Filter([this,&renderDataSource,&captureLambda,&iteratorComparator](const SM_T& sm, const Aux_T& ..., Transform& trns) {
+    auto updateRenderDataGeneric = [this]<typename SM_T, typename ... Aux_T>(const SM_T* sm_t_holder, auto& renderDataSource, auto& bounds, auto&& captureLambda, const Aux_T* ... axillaryParams){
+        Filter([this,&renderDataSource,&bounds,&captureLambda](const SM_T& sm, const Aux_T& ..., Transform& trns) {
             if (trns.isTickDirty && sm.GetEnabled()) {
                 // update
                 assert(renderDataSource.contains(sm.GetMaterial()));
-                auto valuesToCompare = captureLambda(sm);
-                renderDataSource.if_contains(sm.GetMaterial(), [&trns,this, &iteratorComparator, &valuesToCompare](auto& row) {
-                    auto it = iteratorComparator(row, valuesToCompare);
-                    if (it == row.commands.end()){
+                auto key = captureLambda(sm);
+                renderDataSource.if_contains(sm.GetMaterial(), [&trns,this, &sm, &bounds, &key](auto& row) {
+                    if (!row.commandSlots.contains(key)){
                         return;
                     }
-                    assert(it != row.commands.end());
-                    auto& vec = *it;
                     // write new matrix
                     auto owner = trns.GetOwner();
                     auto ownerIDInWorld = owner.GetID();
-                    renderData.worldTransforms[ownerIDInWorld] = trns.GetWorldMatrix();
+                    auto worldMatrix = trns.GetWorldMatrix();
+                    renderData.worldTransforms[ownerIDInWorld] = worldMatrix;
                     renderData.worldTransformsToSync[ownerIDInWorld] = true;    // signal that this was modified
+                    bounds.Update(ownerIDInWorld, CalculateMeshBounds(ownerIDInWorld, worldMatrix, sm.GetMesh()->GetRadius()));
                 });
 
                 trns.ClearTickDirty();
             }
         });
+        bounds.tree.Refit();
     };
 
     auto updateRenderDataStaticMesh = renderTasks.emplace([this,updateRenderDataGeneric] {
         constexpr static StaticMesh* ptrForTemplate = nullptr;
-        updateRenderDataGeneric(ptrForTemplate,renderData.staticMeshRenderData, [](auto& sm){
-            return sm.GetMesh();
-        }, [](auto& row, auto& meshToUpdate){
-            return std::find_if(row.commands.begin(), row.commands.end(), [&](const auto& value) {
-                return value.mesh.lock() == meshToUpdate;
-            });
+        updateRenderDataGeneric(ptrForTemplate,renderData.staticMeshRenderData, renderData.staticMeshBounds, [](auto& sm){
+            return MDIICommand::key_t(sm.GetMesh().get());
         });
        
     }).name("Update invalidated static mesh transforms");
@@ -367,12 +383,8 @@ void World::setupRenderTasks(){
     auto updateRenderDataSkinnedMesh = renderTasks.emplace([this,updateRenderDataGeneric] {
         constexpr static SkinnedMeshComponent* ptrForTemplate = nullptr;
         constexpr static AnimatorComponent* ptrForTemplate2 = nullptr;
-        updateRenderDataGeneric(ptrForTemplate,renderData.skinnedMeshRenderData, [](auto& sm){
-            return std::make_pair(sm.GetMesh(), sm.GetSkeleton());
-        }, [](auto& row, auto& valuesToCompare){
-            return std::find_if(row.commands.begin(), row.commands.end(), [&](const auto& value) {
-                return value.mesh.lock() == valuesToCompare.first && value.skeleton.lock() == valuesToCompare.second;
-            });
+        updateRenderDataGeneric(ptrForTemplate,renderData.skinnedMeshRenderData, renderData.skinnedMeshBounds, [](auto& sm){
+            return MDIICommandSkinned::key_t(sm.GetMesh().get(), sm.GetSkeleton().get());
         }, ptrForTemplate2);
     }).name("Upate invalidated skinned mesh transforms");
 
@@ -429,6 +441,7 @@ void World::setupRenderTasks(){
             for(int i = 0; i < ptr->DenseSize(); i++){
                 auto owner = Entity(ptr->GetOwner(i),this);
                 auto& transform = owner.GetTransform();
+                const bool boundsChanged = transform.isTickDirty || ptr->Get(i).isInvalidated();
                 if (transform.isTickDirty){
                     // update transform data if it has changed
                     renderData.spotLightData.GetForSparseIndex(ptr->GetOwner(i)).worldTransform = transform.GetWorldMatrix();
@@ -448,8 +461,14 @@ void World::setupRenderTasks(){
                     denseData.illuminationLayers = lightData.GetIlluminationLayers();
                     lightData.clearInvalidate();
                 }
+                if (boundsChanged){
+                    // bounded like the light clustering shader, by a sphere around the cone
+                    auto& denseData = renderData.spotLightData.GetForSparseIndex(ptr->GetOwner(i));
+                    renderData.spotLightBounds.Update(ptr->GetOwner(i), AABB::FromSphere(glm::vec3(denseData.worldTransform[3]), LightInfluenceRadius(denseData.intensity)));
+                }
                 // don't reset transform tickInvalidated here because the meshUpdater needs it after this
             }
+            renderData.spotLightBounds.tree.Refit();
         }
     }).name("Update Invalidated SpotLights").precede(updateRenderDataStaticMesh, updateRenderDataSkinnedMesh);
     
@@ -458,6 +477,7 @@ void World::setupRenderTasks(){
             for(int i = 0; i < ptr->DenseSize(); i++){
                 auto owner = Entity(ptr->GetOwner(i),this);
                 auto& transform = owner.GetTransform();
+                const bool boundsChanged = transform.isTickDirty || ptr->Get(i).isInvalidated();
                 if (transform.isTickDirty){
                     // update transform data if it has changed
                     renderData.pointLightData.GetForSparseIndex(ptr->GetOwner(i)).position = transform.GetWorldPosition();
@@ -475,8 +495,13 @@ void World::setupRenderTasks(){
                     denseData.illuminationLayers = lightData.GetIlluminationLayers();
                     ptr->Get(i).clearInvalidate();
                 }
+                if (boundsChanged){
+                    auto& denseData = renderData.pointLightData.GetForSparseIndex(ptr->GetOwner(i));
+                    renderData.pointLightBounds.Update(ptr->GetOwner(i), AABB::FromSphere(denseData.position, LightInfluenceRadius(denseData.intensity)));
+                }
                 // don't reset transform tickInvalidated here because the meshUpdater needs it after this
             }
+            renderData.pointLightBounds.tree.Refit();
         }
     }).name("Update Invalidated PointLights").precede(updateRenderDataStaticMesh, updateRenderDataSkinnedMesh);
     
@@ -523,7 +548,23 @@ void World::SetEntityRenderlayer(entity_t localid, renderlayer_t layers){
 
 void World::SetEntityAttributes(entity_t localid, perobject_t attributes)
 {
+    const bool cullingChanged = (renderData.perObjectAttributes[localid] ^ attributes) & FrustumCullingBit;
     renderData.perObjectAttributes[localid] = attributes;
+
+    if (cullingChanged){
+        // meshes that opt out of frustum culling have unbounded boxes, so rebuild this entity's leaves
+        auto reinsert = [this, localid](auto& bounds, float radius){
+            auto material = bounds.tree.GetUserData(bounds.proxies[localid]);
+            bounds.Remove(localid);
+            bounds.Insert(localid, CalculateMeshBounds(localid, GetComponent<Transform>(localid).GetWorldMatrix(), radius), material);
+        };
+        if (renderData.staticMeshBounds.Contains(localid)){
+            reinsert(renderData.staticMeshBounds, GetComponent<StaticMesh>(localid).GetMesh()->GetRadius());
+        }
+        if (renderData.skinnedMeshBounds.Contains(localid)){
+            reinsert(renderData.skinnedMeshBounds, GetComponent<SkinnedMeshComponent>(localid).GetMesh()->GetRadius());
+        }
+    }
 }
 
 perobject_t World::GetEntityAttributes(entity_t localid)
@@ -531,20 +572,57 @@ perobject_t World::GetEntityAttributes(entity_t localid)
     return renderData.perObjectAttributes[localid];
 }
 
-void DestroyMeshRenderDataGeneric(const auto& mesh, auto material, auto&& renderData, entity_t local_id, auto&& iteratorComparator){
+AABB World::CalculateMeshBounds(entity_t localId, const matrix4& transform, float radius) const{
+    if (!(renderData.perObjectAttributes[localId] & FrustumCullingBit)){
+        return AABB::Unbounded();
+    }
+    // the same sphere as the GPU culling shader, scaled by the largest axis scale
+    const float scale = std::max({glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))});
+    return AABB::FromSphere(glm::vec3(transform[3]), radius * scale);
+}
+
+float World::LightInfluenceRadius(float intensity){
+    return std::sqrt(intensity / LIGHT_MIN_INFLUENCE);
+}
+
+void World::QueryMaterialVisibility(std::span<const BoundedFrustum> views, MaterialVisibility& visibility) const{
+    visibility.staticMeshes.clear();
+    visibility.skinnedMeshes.clear();
+    renderData.staticMeshBounds.tree.QueryBatch(views, [&visibility](const MaterialInstance* material, uint32_t mask){
+        visibility.staticMeshes[material] |= mask;
+    });
+    renderData.skinnedMeshBounds.tree.QueryBatch(views, [&visibility](const MaterialInstance* material, uint32_t mask){
+        visibility.skinnedMeshes[material] |= mask;
+    });
+}
+
+void World::QueryVisibleLights(std::span<const BoundedFrustum> views, UnorderedSet<entity_t>& pointLights, UnorderedSet<entity_t>& spotLights) const{
+    renderData.pointLightBounds.tree.QueryBatch(views, [&pointLights](entity_t light, uint32_t){
+        pointLights.insert(light);
+    });
+    renderData.spotLightBounds.tree.QueryBatch(views, [&spotLights](entity_t light, uint32_t){
+        spotLights.insert(light);
+    });
+}
+
+void DestroyMeshRenderDataGeneric(const auto& key, auto material, auto&& renderData, entity_t local_id){
     
     bool removeContains = false;
     auto data_it = renderData.find(material);
     if (data_it != renderData.end()){
         auto& data = (*data_it).second;
-        auto it = std::find_if(data.commands.begin(), data.commands.end(), [&](auto& other) {
-            return iteratorComparator(other);
-        });
-        if (it != data.commands.end() && (*it).entities.HasForSparseIndex(local_id)) {
-            (*it).entities.EraseAtSparseIndex(local_id);
+        auto slot_it = data.commandSlots.find(key);
+        if (slot_it != data.commandSlots.end() && data.commands[slot_it->second].entities.HasForSparseIndex(local_id)) {
+            const auto slot = slot_it->second;
+            data.commands[slot].entities.EraseAtSparseIndex(local_id);
             // if empty, remove from the larger container
-            if ((*it).entities.DenseSize() == 0) {
-                data.commands.erase(it);
+            if (data.commands[slot].entities.DenseSize() == 0) {
+                data.commandSlots.erase(slot_it);
+                data.commands.erase(data.commands.begin() + slot);
+                // the last command was moved into the freed slot
+                if (slot < data.commands.size()) {
+                    data.commandSlots[data.KeyOf(data.commands[slot])] = slot;
+                }
             }
             if (data.commands.size() == 0){
                 removeContains = true;
@@ -557,7 +635,7 @@ void DestroyMeshRenderDataGeneric(const auto& mesh, auto material, auto&& render
     
 }
 
-void updateMeshMaterialGeneric(auto&& renderData, entity_t localID, auto oldMat, auto newMat, auto mesh, auto&& deletionComparator, auto&& comparator, auto&& newConstructionFunction){
+void updateMeshMaterialGeneric(auto&& renderData, auto&& bounds, entity_t localID, auto oldMat, auto newMat, const auto& key, auto&& calculateBounds, auto&& newConstructionFunction){
     
     // detect the case of the material set to itself
     if (oldMat == newMat) {
@@ -565,22 +643,26 @@ void updateMeshMaterialGeneric(auto&& renderData, entity_t localID, auto oldMat,
     }
 
     // remove render data for the old mesh
-    DestroyMeshRenderDataGeneric(mesh, oldMat, renderData, localID, deletionComparator);
+    DestroyMeshRenderDataGeneric(key, oldMat, renderData, localID);
         
     // add the new mesh & its transform to the hashmap
     auto& set = ( * (renderData.try_emplace(newMat, typename std::remove_reference_t<decltype(renderData)>::mapped_type()).first)).second;
-    bool found = false;
-    for (auto& command : set.commands) {
-        found = comparator(command);
-        if (found) {
-            command.entities.Emplace(localID,localID);
-            break;
-        }
+    if (auto slot_it = set.commandSlots.find(key); slot_it != set.commandSlots.end()) {
+        set.commands[slot_it->second].entities.Emplace(localID,localID);
     }
     // otherwise create a new entry
-    if (!found) {
+    else {
+        set.commandSlots.emplace(key, uint32_t(set.commands.size()));
         newConstructionFunction(set.commands);
     }
+
+    // the entity's leaf now belongs to the new material's bucket
+    if (bounds.Contains(localID)) {
+        bounds.tree.GetUserData(bounds.proxies[localID]) = newMat.get();
+    }
+    else {
+        bounds.Insert(localID, calculateBounds(), newMat.get());
+    }
     
 }
 
@@ -588,13 +670,9 @@ void RavEngine::World::updateStaticMeshMaterial(entity_t localId, Ref<MaterialIn
 {
 
     assert(HasComponent<Transform>(localId) && "Cannot change material on an entity that does not have a transform!");
-    updateMeshMaterialGeneric(renderData.staticMeshRenderData, localId, oldMat, newMat, mesh,
-        [mesh](auto&& other){
-            return other.mesh.lock() == mesh;
-        },
-        [mesh](auto&& command){
-            auto cmpMesh = command.mesh.lock();
-            return cmpMesh == mesh;
+    updateMeshMaterialGeneric(renderData.staticMeshRenderData, renderData.staticMeshBounds, localId, oldMat, newMat, MDIICommand::key_t(mesh.get()),
+        [this, localId, &mesh]{
+            return CalculateMeshBounds(localId, GetComponent<Transform>(localId).GetWorldMatrix(), mesh->GetRadius());
         },
         [mesh, localId](auto&& commands){
             commands.emplace(mesh, localId, localId);
@@ -606,13 +684,9 @@ void RavEngine::World::updateSkinnedMeshMaterial(entity_t localId, Ref<MaterialI
 {
     
     assert(HasComponent<Transform>(localId) && "Cannot change material on an entity that does not have a transform!");
-    updateMeshMaterialGeneric(renderData.skinnedMeshRenderData, localId, oldMat, newMat, mesh,
-        [mesh, &skeleton](auto&& other){
-            return other.mesh.lock() == mesh && other.skeleton.lock() == skeleton;
-        },
-        [mesh, &skeleton](auto&& command){
-            auto cmpMesh = command.mesh.lock();
-            return cmpMesh == mesh && command.skeleton.lock() == skeleton;
+    updateMeshMaterialGeneric(renderData.skinnedMeshRenderData, renderData.skinnedMeshBounds, localId, oldMat, newMat, MDIICommandSkinned::key_t(mesh.get(), skeleton.get()),
+        [this, localId, &mesh]{
+            return CalculateMeshBounds(localId, GetComponent<Transform>(localId).GetWorldMatrix(), mesh->GetRadius());
         },
         [mesh, &skeleton, localId](auto&& commands){
             commands.emplace(mesh, skeleton, localId, localId);
@@ -623,19 +697,14 @@ void RavEngine::World::updateSkinnedMeshMaterial(entity_t localId, Ref<MaterialI
 void RavEngine::World::DestroyStaticMeshRenderData(const StaticMesh& mesh, entity_t local_id)
 {
     
-    auto meshData = mesh.GetMesh();
-    DestroyMeshRenderDataGeneric(mesh.GetMesh(), mesh.GetMaterial(), renderData.staticMeshRenderData, local_id, [meshData](auto&& other){
-        return other.mesh.lock() == meshData;
-    });
+    DestroyMeshRenderDataGeneric(MDIICommand::key_t(mesh.GetMesh().get()), mesh.GetMaterial(), renderData.staticMeshRenderData, local_id);
+    renderData.staticMeshBounds.Remove(local_id);
 }
 
 void World::DestroySkinnedMeshRenderData(const SkinnedMeshComponent& mesh, entity_t local_id) {
     
-    auto skeleton = mesh.GetSkeleton();
-    auto meshData = mesh.GetMesh();
-    DestroyMeshRenderDataGeneric(mesh.GetMesh(), mesh.GetMaterial(), renderData.skinnedMeshRenderData, local_id, [&meshData, &skeleton](auto&& other){
-        return other.mesh.lock() == meshData && other.skeleton.lock() == skeleton;
-    });
+    DestroyMeshRenderDataGeneric(MDIICommandSkinned::key_t(mesh.GetMesh().get(), mesh.GetSkeleton().get()), mesh.GetMaterial(), renderData.skinnedMeshRenderData, local_id);
+    renderData.skinnedMeshBounds.Remove(local_id);
 }
 
 void World::StaticMeshChangedVisibility(const StaticMesh* mesh){
@@ -673,6 +742,10 @@ entity_t World::CreateEntity(){
     return id;
 }
 
+AnimationPoseCache& RavEngine::World::GetAnimationPoseCache(){
+    return animatorSystem->GetPoseCache();
+}
+
 World::~World() {
 #if ENABLE_RINGBUFFERS
     // dump out any live rooms
@@ -0,0 +1,202 @@
+#include <RavEngine/OffsetAllocator.hpp>
+#include <RavEngine/DataStructures.hpp>
+#include <RavEngine/Debug.hpp>
+#include <RavEngine/Common3D.hpp>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <span>
+#include <string_view>
+
+using namespace RavEngine;
+using namespace std;
+
+// needed for linker
+const std::string_view RVE_VFS_get_name(){
+    return "";
+}
+const std::span<const char> cmrc_get_file_data(const std::string_view& path) {
+    return {};
+}
+
+using clocktype = std::chrono::high_resolution_clock;
+
+struct Settings{
+	uint32_t meshes = 100'000;		// total number of meshes streamed in
+	uint32_t resident = 500;		// meshes loaded at once, a random one is unloaded to make room
+	uint32_t maxSize = 16384;		// largest mesh, in vertices
+};
+
+/**
+ What a shared buffer did over the run. A reallocation creates a new GPU buffer and copies the old contents into it.
+ */
+struct Stats{
+	clocktype::duration placement{0};
+	uint32_t reallocations = 0;
+	uint64_t elementsCopied = 0;
+	uint32_t finalSize = 0;
+};
+
+/**
+ The first-fit freelist that RenderEngine used before OffsetAllocator. Growth is to exactly the size needed,
+ and the buffer is compacted on every reallocation.
+ */
+struct FirstFitAllocator{
+	LinkedList<Range> freeList, allocatedList;
+	uint32_t size;
+	Stats& stats;
+
+	FirstFitAllocator(uint32_t size, Stats& stats) : size(size), stats(stats){
+		freeList.push_back({0, size});
+	}
+
+	LinkedList<Range>::iterator Allocate(uint32_t count){
+		while(true){
+			for(auto it = freeList.begin(); it != freeList.end(); it++){
+				if (it->count >= count){
+					allocatedList.push_back({it->start, count});
+					it->start += count;
+					it->count -= count;
+					if (it->count == 0){
+						freeList.erase(it);
+					}
+					return --allocatedList.end();
+				}
+			}
+			Reallocate(size + count);
+		}
+	}
+
+	void Free(LinkedList<Range>::iterator allocation){
+		const auto range = *allocation;
+		allocatedList.erase(allocation);
+		auto left = freeList.end(), right = freeList.end();
+		for(auto it = freeList.begin(); it != freeList.end(); it++){
+			if (it->start + it->count == range.start){
+				left = it;
+			}
+			if (range.start + range.count == it->start){
+				right = it;
+			}
+		}
+		if (left != freeList.end() && right != freeList.end()){
+			left->count += range.count + right->count;
+			freeList.erase(right);
+		}
+		else if (left != freeList.end()){
+			left->count += range.count;
+		}
+		else if (right != freeList.end()){
+			right->start = range.start;
+			right->count += range.count;
+		}
+		else{
+			freeList.push_back(range);
+		}
+	}
+
+	void Reallocate(uint32_t newSize){
+		stats.reallocations++;
+		uint32_t offset = 0;
+		for(auto& range : allocatedList){
+			range.start = offset;
+			offset += range.count;
+			stats.elementsCopied += range.count;
+		}
+		freeList.clear();
+		freeList.push_back({offset, newSize - offset});
+		size = newSize;
+	}
+};
+
+/**
+ The placement policy in RenderEngine_Allocate: OffsetAllocator, with geometric growth and no compaction
+ */
+struct BinnedAllocator{
+	OffsetAllocator allocator;
+	Stats& stats;
+
+	BinnedAllocator(uint32_t size, Stats& stats) : allocator(size), stats(stats){}
+
+	OffsetAllocator::Allocation Allocate(uint32_t count){
+		auto allocation = allocator.Allocate(count);
+		if (!allocation.IsValid()){
+			stats.reallocations++;
+			stats.elementsCopied += allocator.GetSize();
+			allocator.Grow(std::max(allocator.GetSize() * 2, allocator.GetSize() + count));
+			allocation = allocator.Allocate(count);
+		}
+		return allocation;
+	}
+
+	void Free(OffsetAllocator::Allocation allocation){
+		allocator.Free(allocation);
+	}
+};
+
+template<typename T>
+static Stats Stream(const Settings& settings, const char* name){
+	Stats stats;
+	T allocator(1024, stats);
+	std::deque<decltype(allocator.Allocate(1))> loaded;
+	uint32_t seed = 1;
+
+	auto begin = clocktype::now();
+	for(uint32_t i = 0; i < settings.meshes; i++){
+		if (loaded.size() >= settings.resident){
+			// unload a random resident mesh, so that holes open up all over the buffer
+			seed = seed * 1664525 + 1013904223;
+			const auto index = (seed >> 8) % loaded.size();
+			allocator.Free(loaded[index]);
+			loaded[index] = loaded.back();
+			loaded.pop_back();
+		}
+		seed = seed * 1664525 + 1013904223;
+		loaded.push_back(allocator.Allocate(64 + (seed >> 8) % settings.maxSize));
+	}
+	stats.placement = clocktype::now() - begin;
+
+	const auto us = std::chrono::duration_cast<std::chrono::microseconds>(stats.placement).count();
+	if constexpr (std::is_same_v<T, BinnedAllocator>){
+		stats.finalSize = allocator.allocator.GetSize();
+	}
+	else{
+		stats.finalSize = allocator.size;
+	}
+	cout << Format("{:>10}: {:>10} µs placing, {:>6} reallocations, {:>12} elements copied, final size {}\n", name, us, stats.reallocations, stats.elementsCopied, stats.finalSize);
+
+	if constexpr (std::is_same_v<T, BinnedAllocator>){
+		const auto report = allocator.allocator.GetStorageReport();
+		cout << Format("{:>10}  {} free, largest free range {}, fragmentation {:.2f}\n", "", report.totalFree, report.largestFree, allocator.allocator.GetFragmentation());
+	}
+	return stats;
+}
+
+int main(int argc, char** argv){
+	Settings settings;
+	for(int i = 1; i < argc; i++){
+		const std::string_view arg = argv[i];
+		auto value = [&]{
+			Debug::Assert(i + 1 < argc, "Missing value for {}", arg);
+			return static_cast<uint32_t>(std::stoul(argv[++i]));
+		};
+		if (arg == "--meshes"){
+			settings.meshes = value();
+		}
+		else if (arg == "--resident"){
+			settings.resident = value();
+		}
+		else if (arg == "--max-size"){
+			settings.maxSize = value();
+		}
+		else{
+			cerr << "Usage: " << argv[0] << " [--meshes N] [--resident N] [--max-size N]\n";
+			return -1;
+		}
+	}
+
+	cout << Format("Streaming {} meshes, {} resident, up to {} elements each\n", settings.meshes, settings.resident, settings.maxSize);
+	Stream<FirstFitAllocator>(settings, "First fit");
+	Stream<BinnedAllocator>(settings, "Offset");
+	return 0;
+}
@@ -0,0 +1,257 @@
+#include <RavEngine/App.hpp>
+#include <RavEngine/World.hpp>
+#include <RavEngine/GameObject.hpp>
+#include <RavEngine/AnimatorComponent.hpp>
+#include <RavEngine/AnimationAsset.hpp>
+#include <RavEngine/SkeletonAsset.hpp>
+#include <RavEngine/Debug.hpp>
+#include <ozz/animation/offline/raw_skeleton.h>
+#include <ozz/animation/offline/raw_animation.h>
+#include <ozz/animation/offline/animation_builder.h>
+#include <ozz/animation/runtime/animation.h>
+#include <ozz/animation/runtime/skeleton.h>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <span>
+#include <string_view>
+
+using namespace RavEngine;
+using namespace std;
+
+// needed for linker
+const std::string_view RVE_VFS_get_name(){
+    return "";
+}
+const std::span<const char> cmrc_get_file_data(const std::string_view& path) {
+    return {};
+}
+
+struct AnimPerfApp : public App{
+	// the benchmark drives time itself instead of running the main loop
+	void AdvanceTime(double seconds){
+		time += seconds;
+	}
+};
+
+struct Settings{
+	uint32_t animators = 1000;
+	uint32_t joints = 64;
+	uint32_t keys = 30;
+	uint32_t ticks = 600;
+	bool sharePoses = false;
+};
+
+/**
+ Build a breadth-first joint tree with up to 3 children per joint
+ */
+static ozz::animation::offline::RawSkeleton MakeSkeleton(uint32_t numJoints){
+	using Joint = ozz::animation::offline::RawSkeleton::Joint;
+	ozz::animation::offline::RawSkeleton raw;
+	raw.roots.resize(1);
+	raw.roots[0].name = "joint_0";
+	raw.roots[0].transform = ozz::math::Transform::identity();
+
+	std::deque<Joint*> open{&raw.roots[0]};
+	uint32_t created = 1;
+	while(!open.empty() && created < numJoints){
+		auto joint = open.front();
+		open.pop_front();
+		// reserve up front so that pointers to children stay valid
+		joint->children.reserve(3);
+		for(int i = 0; i < 3 && created < numJoints; i++){
+			auto& child = joint->children.emplace_back();
+			child.name = Format("joint_{}", created++);
+			child.transform = ozz::math::Transform::identity();
+			child.transform.translation = {0.1f * (i - 1), 0.2f, 0};
+			open.push_back(&child);
+		}
+	}
+	return raw;
+}
+
+/**
+ Build a looping clip that swings every joint with a per-clip frequency
+ */
+static Ref<AnimationAsset> MakeAnimation(const ozz::animation::Skeleton& skeleton, uint32_t numKeys, float frequency){
+	ozz::animation::offline::RawAnimation raw;
+	constexpr float duration = 1;	// ticks, with 1 tick per second
+	raw.duration = duration;
+	raw.tracks.resize(skeleton.num_joints());
+
+	const auto restPoses = skeleton.joint_rest_poses();
+	for(int joint = 0; joint < skeleton.num_joints(); joint++){
+		auto& track = raw.tracks[joint];
+		// rest translations and scales, extracted from the SoA rest pose
+		const auto& soa = restPoses[joint / 4];
+		float tx[4], ty[4], tz[4];
+		ozz::math::StorePtrU(soa.translation.x, tx);
+		ozz::math::StorePtrU(soa.translation.y, ty);
+		ozz::math::StorePtrU(soa.translation.z, tz);
+		track.translations.push_back({0, {tx[joint % 4], ty[joint % 4], tz[joint % 4]}});
+		track.scales.push_back({0, ozz::math::Float3::one()});
+
+		for(uint32_t k = 0; k < numKeys; k++){
+			const float time = duration * k / std::max(numKeys - 1, 1u);
+			const float angle = 0.5f * std::sin(2 * 3.14159265f * frequency * time + joint);
+			track.rotations.push_back({time, ozz::math::Quaternion::FromAxisAngle(ozz::math::Float3::z_axis(), angle)});
+		}
+	}
+	Debug::Assert(raw.Validate(), "Synthetic animation is invalid");
+
+	ozz::animation::offline::AnimationBuilder builder;
+	return std::make_shared<AnimationAsset>(builder(raw), 1.0f);
+}
+
+int main(int argc, char** argv){
+	Settings settings;
+	for(int i = 1; i < argc; i++){
+		const std::string_view arg = argv[i];
+		auto value = [&]{
+			Debug::Assert(i + 1 < argc, "Missing value for {}", arg);
+			return static_cast<uint32_t>(std::stoul(argv[++i]));
+		};
+		if (arg == "--animators"){
+			settings.animators = value();
+		}
+		else if (arg == "--joints"){
+			settings.joints = value();
+		}
+		else if (arg == "--keys"){
+			settings.keys = value();
+		}
+		else if (arg == "--ticks"){
+			settings.ticks = value();
+		}
+		else if (arg == "--share"){
+			settings.sharePoses = true;
+		}
+		else{
+			cerr << "Usage: " << argv[0] << " [--animators N] [--joints N] [--keys N] [--ticks N] [--share]\n";
+			return -1;
+		}
+	}
+
+	AnimPerfApp app;
+	World world;
+
+	auto skeleton = std::make_shared<SkeletonAsset>(MakeSkeleton(settings.joints));
+	const auto& ozzSkeleton = *skeleton->GetSkeleton();
+	auto idle = MakeAnimation(ozzSkeleton, settings.keys, 1);
+	auto walk = MakeAnimation(ozzSkeleton, settings.keys, 2);
+	auto run = MakeAnimation(ozzSkeleton, settings.keys, 3);
+	auto lean = MakeAnimation(ozzSkeleton, settings.keys, 0.5);
+
+	// state 0: locomotion blend tree, with a node that only affects the first half of the joints
+	auto tree = std::make_shared<AnimBlendTree>();
+	tree->InsertNode(0, AnimBlendTree::Node(idle, {0, 0}));
+	tree->InsertNode(1, AnimBlendTree::Node(walk, {0, 0.5}));
+	tree->InsertNode(2, AnimBlendTree::Node(run, {0, 1}));
+	AnimBlendTree::Node leanNode(lean, {0.5, 0});
+	leanNode.joint_mask.resize(ozzSkeleton.num_joints());
+	for(size_t i = 0; i < leanNode.joint_mask.size(); i++){
+		leanNode.joint_mask[i] = i < leanNode.joint_mask.size() / 2 ? 1 : 0;
+	}
+	tree->InsertNode(3, leanNode);
+	tree->SetBlendPos({0.2, 0.6});
+	tree->Compile();
+
+	// state 1: a layered clip
+	auto clip = std::make_shared<AnimationClip>();
+	clip->SetAnimationInfluence(run, 1);
+	clip->SetAnimationInfluence(lean, 0.5);
+
+	Vector<GameObject> objects;
+	objects.reserve(settings.animators);
+	for(uint32_t i = 0; i < settings.animators; i++){
+		auto object = world.Instantiate<GameObject>();
+		object.GetTransform().SetWorldPosition({float(i % 100), 0, float(i / 100)});
+		auto& animator = object.EmplaceComponent<AnimatorComponent>(skeleton);
+
+		AnimatorComponent::State locomotion{0, tree}, layered{1, clip};
+		locomotion.SetTransition(1, TweenCurves::LinearCurve, 0.02);
+		layered.SetTransition(0, TweenCurves::LinearCurve, 0.02);
+		animator.InsertState(locomotion);
+		animator.InsertState(layered);
+		animator.SetPoseSharing(settings.sharePoses);
+		animator.Goto(0, true);
+		animator.Play();
+		objects.push_back(object);
+	}
+
+	// components are stored contiguously, so only take addresses once every animator exists
+	Vector<std::pair<AnimatorComponent*, Transform*>> animators;
+	animators.reserve(objects.size());
+	for(auto& object : objects){
+		animators.push_back({&object.GetComponent<AnimatorComponent>(), &object.GetTransform()});
+	}
+
+	cout << Format("{} animators, {} joints, {} keys per track, {} ticks{}\n", settings.animators, ozzSkeleton.num_joints(), settings.keys, settings.ticks, settings.sharePoses ? ", pose sharing" : "");
+
+	clocktype::duration sample{0}, blend{0}, ltm{0}, ik{0}, skinning{0};
+	auto timeStage = [&](clocktype::duration& total, auto&& fn){
+		auto begin = clocktype::now();
+		for(auto& [animator, transform] : animators){
+			fn(*animator, *transform);
+		}
+		total += clocktype::now() - begin;
+	};
+
+	constexpr uint32_t transitionInterval = 240;
+	for(uint32_t tick = 0; tick < settings.ticks; tick++){
+		app.AdvanceTime(1.0 / 60);
+		world.GetAnimationPoseCache().Reset();
+
+		// swap states on a staggered schedule, so some animators are always transitioning
+		for(uint32_t i = 0; i < animators.size(); i++){
+			if ((tick + i) % transitionInterval == 0){
+				auto& animator = *animators[i].first;
+				animator.Goto(animator.GetCurrentState() == 0 ? 1 : 0);
+			}
+		}
+
+		timeStage(sample, [&world](AnimatorComponent& animator, const Transform& t){
+			animator.SampleStage(t, &world.GetAnimationPoseCache());
+		});
+		timeStage(blend, [](AnimatorComponent& animator, const Transform&){
+			animator.BlendStage();
+		});
+		timeStage(ltm, [](AnimatorComponent& animator, const Transform&){
+			animator.LocalToModelStage();
+		});
+		timeStage(ik, [](AnimatorComponent& animator, const Transform& t){
+			animator.IKProbeStage(t);
+			animator.IKStage(t);
+		});
+		timeStage(skinning, [](AnimatorComponent& animator, const Transform& t){
+			animator.SkinningStage(t);
+		});
+	}
+
+	auto report = [&](const char* name, clocktype::duration total){
+		const auto us = std::chrono::duration_cast<std::chrono::microseconds>(total).count();
+		cout << Format("{:>16}: {:>10} µs total, {:>8.2f} µs per tick\n", name, us, double(us) / settings.ticks);
+	};
+	report("Sample", sample);
+	report("Blend", blend);
+	report("Local to model", ltm);
+	report("IK", ik);
+	report("Skinning", skinning);
+	report("Total", sample + blend + ltm + ik + skinning);
+
+	size_t animatorBytes = 0;
+	for(auto& [animator, transform] : animators){
+		animatorBytes += animator->GetMemoryUsage();
+	}
+	size_t clipBytes = 0;
+	for(auto& anim : {idle, walk, run, lean}){
+		clipBytes += anim->GetAnim()->size();
+	}
+	cout << Format("Animator pose buffers: {} KB ({} bytes each)\n", animatorBytes / 1024, animatorBytes / std::max<size_t>(animators.size(), 1));
+	cout << Format("Animation clips: {} KB\n", clipBytes / 1024);
+	if (settings.sharePoses){
+		cout << Format("Last tick: {} unique poses, {} shared\n", world.GetAnimationPoseCache().GetNumUniquePoses(), world.GetAnimationPoseCache().GetNumSharedPoses());
+	}
+
+	return 0;
+}
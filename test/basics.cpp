@@ -11,6 +11,41 @@
 #include <RavEngine/Debug.hpp>
 #include <cassert>
 #include <span>
+#include <thread>
+#include <chrono>
+#include <RavEngine/AnimationMath.hpp>
+#include <RavEngine/AnimationAsset.hpp>
+#include <RavEngine/Animation.hpp>
+#include <RavEngine/NavMeshComponent.hpp>
+#include <RavEngine/CrowdSystem.hpp>
+#include <RavEngine/GameObject.hpp>
+#include <RavEngine/Manager.hpp>
+#include <RavEngine/AssetPack.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <RavEngine/MeshAsset.hpp>
+#include <RavEngine/OffsetAllocator.hpp>
+#include <RavEngine/TransientRingAllocator.hpp>
+#include <RavEngine/DynamicBVH.hpp>
+#include <meshoptimizer.h>
+#include <ozz/animation/offline/raw_animation.h>
+#include <ozz/animation/offline/animation_builder.h>
+#include <ozz/animation/offline/raw_track.h>
+#include <ozz/animation/offline/track_builder.h>
+#include <ozz/animation/runtime/animation.h>
+#include <ozz/animation/runtime/track.h>
+#include <ozz/animation/runtime/skeleton.h>
+#include <ozz/animation/offline/raw_skeleton.h>
+#include <ozz/animation/offline/skeleton_builder.h>
+#include <RavEngine/AnimatorComponent.hpp>
+#include <RavEngine/AnimatorSystem.hpp>
+#include <RavEngine/SkeletonAsset.hpp>
+#include <RavEngine/PhysicsBodyComponent.hpp>
+#include <RavEngine/PhysicsCollider.hpp>
+#include <RavEngine/PhysicsMaterial.hpp>
+#include <RavEngine/Constraint.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 using namespace RavEngine;
 using namespace std;
@@ -171,12 +206,1086 @@ int Test_SpawnDestroy(){
     return 0;
 }
 
+int Test_SkinningSIMD(){
+    constexpr int numJoints = 37;   // not a multiple of the SIMD width
+    std::vector<glm::mat4> modelsRef(numJoints), invBindRef(numJoints);
+    std::vector<ozz::math::Float4x4> models(numJoints), invBind(numJoints);
+    for(int i = 0; i < numJoints; i++){
+        const float f = i;
+        auto model = glm::translate(glm::mat4(1), glm::vec3(f, -f * 0.5f, 2));
+        model = glm::rotate(model, f * 0.3f, glm::normalize(glm::vec3(1, f, 0.5)));
+        model = glm::scale(model, glm::vec3(1 + f * 0.01f));
+        auto bind = glm::rotate(glm::translate(glm::mat4(1), glm::vec3(0, f, -f)), -f * 0.2f, glm::vec3(0, 1, 0));
+        modelsRef[i] = model;
+        invBindRef[i] = glm::inverse(bind);
+        models[i] = LoadMatrix(model);
+        invBind[i] = LoadMatrix(invBindRef[i]);
+    }
+    const auto world = glm::rotate(glm::translate(glm::mat4(1), glm::vec3(10, 20, 30)), 1.2f, glm::vec3(0, 0, 1));
+
+    auto near = [](const glm::mat4& a, const glm::mat4& b){
+        for(int c = 0; c < 4; c++){
+            for(int r = 0; r < 4; r++){
+                if (std::abs(a[c][r] - b[c][r]) > 1e-3f * std::max(1.f, std::abs(b[c][r]))){
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    std::vector<glm::mat4> skinning(numJoints);
+    std::vector<matrix4> local(numJoints), worldPose(numJoints);
+    ComputeSkinningMatrices(models, invBind, skinning);
+    ConvertPose(models, local);
+    ConvertPose(models, matrix4(world), worldPose);
+
+    for(int i = 0; i < numJoints; i++){
+        assert(near(skinning[i], modelsRef[i] * invBindRef[i]));
+        assert(near(glm::mat4(local[i]), modelsRef[i]));
+        assert(near(glm::mat4(worldPose[i]), world * modelsRef[i]));
+    }
+    return 0;
+}
+
+int Test_MultiplyJointRotation(){
+    // 6 joints span two SoA groups, rotate one lane in the second group
+    ozz::vector<ozz::math::SoaTransform> pose(2, ozz::math::SoaTransform::identity());
+    const auto rotation = ozz::math::SimdQuaternion::FromAxisAngle(ozz::math::simd_float4::y_axis(), ozz::math::simd_float4::Load1(1.2f));
+    MultiplyJointRotation(pose, 5, rotation);
+    MultiplyJointRotation(pose, 5, rotation);
+
+    float x[4], y[4], z[4], w[4];
+    for(int group = 0; group < 2; group++){
+        ozz::math::StorePtrU(pose[group].rotation.x, x);
+        ozz::math::StorePtrU(pose[group].rotation.y, y);
+        ozz::math::StorePtrU(pose[group].rotation.z, z);
+        ozz::math::StorePtrU(pose[group].rotation.w, w);
+        for(int lane = 0; lane < 4; lane++){
+            const auto expected = group * 4 + lane == 5 ? glm::angleAxis(2.4f, glm::vec3(0, 1, 0)) : glm::quat(1, 0, 0, 0);
+            assert(std::abs(std::abs(glm::dot(glm::quat(w[lane], x[lane], y[lane], z[lane]), expected)) - 1) < 1e-4);
+        }
+    }
+    return 0;
+}
+
+int Test_RootMotion(){
+    using namespace ozz::animation::offline;
+    auto makeAsset = [](float yawDegrees, float distance){
+        RawAnimation raw;
+        raw.duration = 1;
+        raw.tracks.resize(1);
+        auto asset = std::make_shared<AnimationAsset>(AnimationBuilder()(raw), 1.0f);
+        if (distance > 0){
+            // walk forward along z while turning, linearly over the clip
+            RawFloat3Track translation;
+            translation.keyframes.push_back({RawTrackInterpolation::kLinear, 0, {0, 0, 0}});
+            translation.keyframes.push_back({RawTrackInterpolation::kLinear, 1, {0, 0, distance}});
+            RawQuaternionTrack rotation;
+            rotation.keyframes.push_back({RawTrackInterpolation::kLinear, 0, ozz::math::Quaternion::identity()});
+            rotation.keyframes.push_back({RawTrackInterpolation::kLinear, 1, ozz::math::Quaternion::FromAxisAngle(ozz::math::Float3::y_axis(), glm::radians(yawDegrees))});
+            TrackBuilder builder;
+            asset->SetRootMotion(builder(translation), builder(rotation));
+        }
+        return asset;
+    };
+    auto near = [](const vector3& a, const vector3& b){
+        return glm::length(a - b) < 1e-3;
+    };
+    auto walk = makeAsset(0, 2), turn = makeAsset(90, 2), idle = makeAsset(0, 0);
+
+    assert(near(walk->ExtractRootMotion(0.25, 0.75, false).translation, {0, 0, 1}));
+    // looping wraps back to the start of the track, and includes whole loops
+    assert(near(walk->ExtractRootMotion(0.75, 1.25, true).translation, {0, 0, 1}));
+    assert(near(walk->ExtractRootMotion(0.5, 2.5, true).translation, {0, 0, 4}));
+    // non-looping clamps at the end
+    assert(near(walk->ExtractRootMotion(0.75, 1.5, false).translation, {0, 0, 0.5}));
+    // a region of the clip loops on its own
+    assert(near(walk->ExtractRootMotion(0, 1, true, 0.25, 0.75).translation, {0, 0, 1}));
+
+    // the motion is relative to the root at the earlier playhead
+    auto turned = turn->ExtractRootMotion(0, 1, false);
+    assert(near(turned.translation, {0, 0, 2}));
+    assert(std::abs(glm::degrees(glm::angle(turned.rotation)) - 90) < 0.1);
+    auto secondHalf = turn->ExtractRootMotion(0.5, 1, false);
+    auto firstHalf = turn->ExtractRootMotion(0, 0.5, false);
+    auto composed = firstHalf.Then(secondHalf);
+    assert(std::abs(glm::dot(composed.rotation, turned.rotation)) > 0.9999);
+
+    // clips average motion by influence, and animations without root motion stand still
+    AnimationClip clip;
+    clip.SetAnimationInfluence(walk, 1);
+    clip.SetAnimationInfluence(idle, 1);
+    RootMotionDelta blended;
+    assert(clip.SampleRootMotion(0.25, 0.75, 0, 1, true, blended));
+    assert(near(blended.translation, {0, 0, 0.5}));
+    RootMotionDelta none;
+    assert(!idle->SampleRootMotion(0.25, 0.75, 0, 1, true, none));
+    assert(near(none.translation, {0, 0, 0}));
+    return 0;
+}
+
+/**
+ Writes a constant translation to every joint, and counts how often it is sampled
+ */
+struct ConstantPose : public IAnimGraphable{
+    float value;
+    mutable uint32_t samples = 0;
+    ConstantPose(float value) : value(value){}
+
+    bool Sample(float t, float start, float speed, bool looping, ozz::vector<ozz::math::SoaTransform>& output, ozz::animation::SamplingJob::Context& cache, const ozz::animation::Skeleton* skeleton) const final{
+        samples++;
+        for(auto& transform : output){
+            transform = ozz::math::SoaTransform::identity();
+            transform.translation.x = ozz::math::simd_float4::Load1(value);
+        }
+        return false;
+    }
+};
+
+int Test_BlendTree(){
+    using namespace ozz::animation::offline;
+    RawSkeleton raw;
+    raw.roots.resize(1);
+    raw.roots[0].name = "joint_0";
+    raw.roots[0].transform = ozz::math::Transform::identity();
+    auto* parent = &raw.roots[0];
+    for(int i = 1; i < 6; i++){
+        parent->children.resize(1);
+        parent = &parent->children[0];
+        parent->name = Format("joint_{}", i);
+        parent->transform = ozz::math::Transform::identity();
+    }
+    auto skeleton = SkeletonBuilder()(raw);
+    ozz::vector<ozz::math::SoaTransform> output(skeleton->num_soa_joints());
+    ozz::animation::SamplingJob::Context cache(skeleton->num_joints());
+    auto jointX = [&output](int joint){
+        float x[4];
+        ozz::math::StorePtrU(output[joint / 4].translation.x, x);
+        return x[joint % 4];
+    };
+
+    // nodes too far from the blend position are never sampled, and neither is anything under them
+    auto near = std::make_shared<ConstantPose>(1), far = std::make_shared<ConstantPose>(3);
+    auto subtree = std::make_shared<AnimBlendTree>();
+    subtree->InsertNode(0, AnimBlendTree::Node(far, {0, 0}));
+    AnimBlendTree tree;
+    tree.InsertNode(0, AnimBlendTree::Node(near, {0, 0}));
+    tree.InsertNode(1, AnimBlendTree::Node(subtree, {1, 1}));
+    tree.SetBlendPos({0, 0});
+    tree.Sample(0, 0, 1, true, output, cache, skeleton.get());
+    assert(near->samples == 1 && far->samples == 0);
+    assert(std::abs(jointX(5) - 1) < 1e-5);
+    tree.SetBlendPos({0.5, 0.5});
+    tree.Sample(0, 0, 1, true, output, cache, skeleton.get());
+    assert(near->samples == 2 && far->samples == 1);
+
+    // a mask shorter than the skeleton leaves the remaining joints to the other nodes
+    AnimBlendTree masked;
+    AnimBlendTree::Node partial(far, {0, 0});
+    partial.joint_mask = {1, 1};
+    masked.InsertNode(0, AnimBlendTree::Node(near, {0, 0}));
+    masked.InsertNode(1, partial);
+    masked.Sample(0, 0, 1, true, output, cache, skeleton.get());
+    assert(std::abs(jointX(0) - 2) < 1e-5 && std::abs(jointX(1) - 2) < 1e-5);
+    for(int joint = 2; joint < 6; joint++){
+        assert(std::abs(jointX(joint) - 1) < 1e-5);
+    }
+
+    // the layout round-trips through Serialize, and states are resolved by node ID
+    AnimBlendTree::Node additive(near, {-0.5, 0.25}, 0.75, AnimBlendTree::Node::Layer::Additive);
+    additive.joint_mask = {0.5, 0, 1};
+    masked.InsertNode(2, additive);
+    masked.SetBlendThreshold(0.25);
+    const auto data = masked.Serialize();
+    AnimBlendTree copy(data, [&](uint8_t id) -> Ref<IAnimGraphable>{
+        return id == 1 ? far : near;
+    });
+    assert(copy.GetBlendThreshold() == 0.25f);
+    for(uint8_t id = 0; id < 3; id++){
+        const auto& original = masked.GetNode(id);
+        const auto& restored = copy.GetNode(id);
+        assert(restored.state == original.state && restored.layer == original.layer && restored.max_influence == original.max_influence);
+        assert(restored.graph_pos.get_x() == original.graph_pos.get_x() && restored.graph_pos.get_y() == original.graph_pos.get_y());
+        assert(restored.joint_mask == original.joint_mask);
+    }
+    assert(copy.Serialize().size() == data.size());
+
+    // a zero threshold in the data is clamped the same way SetBlendThreshold clamps it
+    SerializedBlendTreeHeader zeroThreshold;
+    AnimBlendTree clamped({reinterpret_cast<const uint8_t*>(&zeroThreshold), sizeof(zeroThreshold)}, [](uint8_t) -> Ref<IAnimGraphable>{
+        return nullptr;
+    });
+    assert(clamped.GetBlendThreshold() > 0);
+    return 0;
+}
+
+int Test_IKGroundProbe(){
+    using namespace ozz::animation::offline;
+    // a leg standing at the origin: hip at y = 1, knee at 0.5, ankle at 0
+    RawSkeleton raw;
+    raw.roots.resize(1);
+    auto* joint = &raw.roots[0];
+    for(int i = 0; i < 3; i++){
+        joint->name = Format("joint_{}", i);
+        joint->transform = ozz::math::Transform::identity();
+        joint->transform.translation = {0, i == 0 ? 1.0f : -0.5f, 0};
+        if (i < 2){
+            joint->children.resize(1);
+            joint = &joint->children[0];
+        }
+    }
+    auto skeleton = std::make_shared<SkeletonAsset>(raw);
+
+    RawAnimation standing;
+    standing.duration = 1;
+    standing.tracks.resize(3);
+    for(int i = 0; i < 3; i++){
+        standing.tracks[i].translations.push_back({0, {0, i == 0 ? 1.0f : -0.5f, 0}});
+    }
+    auto animation = std::make_shared<AnimationAsset>(AnimationBuilder()(standing), 1.0f);
+
+    World world;
+    auto material = std::make_shared<PhysicsMaterial>();
+    // the floor's top is at y = -0.25, below the ankle
+    auto floor = world.Instantiate<GameObject>();
+    floor.EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(5, 0.5, 5), material, vector3(0, -0.75, 0));
+
+    // the animated entity has its own body around the leg, which contains the start of the ground probe
+    auto character = world.Instantiate<GameObject>();
+    character.EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(0.3, 1, 0.3), material, vector3(0, 1, 0));
+    auto& animator = character.EmplaceComponent<AnimatorComponent>(skeleton);
+    animator.InsertState(AnimatorComponent::State{0, animation});
+    animator.Goto(0, true);
+    animator.Play();
+    AnimatorComponent::TwoBoneIK leg;
+    leg.startJoint = 0;
+    leg.midJoint = 1;
+    leg.endJoint = 2;
+    leg.groundProbe.enabled = true;
+    animator.AddTwoBoneIK(leg);
+
+    AnimatorSystem system;
+    system.UpdateBatches(world, 1);
+    system.RunSerial();
+
+    // the probe skips the character and finds the floor
+    auto probes = animator.GetIKProbes();
+    assert(probes.size() == 1 && probes[0].hit);
+    assert(std::abs(probes[0].hitPosition.y - -0.25) < 1e-3);
+    return 0;
+}
+
+int Test_SocketConstraint(){
+    using namespace ozz::animation::offline;
+    // a chain with the root at y = 1 and the tip at y = 0
+    RawSkeleton raw;
+    raw.roots.resize(1);
+    auto* joint = &raw.roots[0];
+    for(int i = 0; i < 3; i++){
+        joint->name = Format("joint_{}", i);
+        joint->transform = ozz::math::Transform::identity();
+        joint->transform.translation = {0, i == 0 ? 1.0f : -0.5f, 0};
+        if (i < 2){
+            joint->children.resize(1);
+            joint = &joint->children[0];
+        }
+    }
+    auto skeleton = std::make_shared<SkeletonAsset>(raw);
+
+    World world;
+    auto character = world.Instantiate<GameObject>();
+    character.GetTransform().SetLocalPosition(vector3(3, 0, 0));
+    auto& animator = character.EmplaceComponent<AnimatorComponent>(skeleton);
+    animator.Play();
+    character.EmplaceComponent<ConstraintTarget>();
+    auto attached = world.Instantiate<GameObject>();
+    auto& socket = attached.EmplaceComponent<SocketConstraint>(ComponentHandle<ConstraintTarget>(character), "joint_2");
+    assert(socket.GetJointIndex() == 2);
+
+    // more animators move the character's animator within the component storage, which the socket does not depend on
+    for(int i = 0; i < 16; i++){
+        world.Instantiate<GameObject>().EmplaceComponent<AnimatorComponent>(skeleton);
+    }
+
+    AnimatorSystem system;
+    system.UpdateBatches(world, 1);
+    system.RunSerial();
+    SocketSystem()(attached.GetComponent<SocketConstraint>(), attached.GetTransform());
+    assert(glm::length(attached.GetTransform().GetWorldPosition() - vector3(3, 0, 0)) < 1e-4);
+
+    // removing the constraint stops updating the joint
+    attached.DestroyComponent<SocketConstraint>();
+    assert(character.GetComponent<AnimatorComponent>().GetSocketPoses()->joints.empty());
+    return 0;
+}
+
+int Test_PoseSharing(){
+    using namespace ozz::animation::offline;
+    RawSkeleton raw;
+    raw.roots.resize(1);
+    raw.roots[0].name = "joint_0";
+    raw.roots[0].transform = ozz::math::Transform::identity();
+    auto skeleton = std::make_shared<SkeletonAsset>(raw);
+    auto pose = std::make_shared<ConstantPose>(1), other = std::make_shared<ConstantPose>(3);
+
+    World world;
+    Vector<GameObject> characters;
+    for(int i = 0; i < 2; i++){
+        auto& character = characters.emplace_back(world.Instantiate<GameObject>());
+        auto& animator = character.EmplaceComponent<AnimatorComponent>(skeleton);
+        animator.InsertState(AnimatorComponent::State{0, pose});
+        animator.InsertState(AnimatorComponent::State{1, other});
+        animator.Goto(0, true);
+        animator.SetPoseSharing(true);
+        animator.Play();
+    }
+
+    AnimatorSystem system;
+    system.UpdateBatches(world, 1);
+    system.RunSerial();
+    auto& cache = system.GetPoseCache();
+    assert(pose->samples == 1 && cache.GetNumUniquePoses() == 1 && cache.GetNumSharedPoses() == 1);
+
+    // ticking by hand evaluates every animator, and does not copy a pose that its producer has since replaced
+    auto& first = characters[0].GetComponent<AnimatorComponent>();
+    auto& second = characters[1].GetComponent<AnimatorComponent>();
+    first.Tick(characters[0].GetTransform());
+    second.Tick(characters[1].GetTransform());
+    first.Goto(1, true);
+    first.Tick(characters[0].GetTransform());
+    second.Tick(characters[1].GetTransform());
+    assert(pose->samples == 4 && other->samples == 1);
+    assert(std::abs(second.GetLocalPose()[0][3].x - 1) < 1e-5);
+    return 0;
+}
+
+/**
+ A 40x40 floor made of 2x2 quads, optionally with a trench along z = 20 that is only open for x > 34
+ */
+static Ref<MeshAsset> MakeNavFloor(bool trench){
+    MeshPart part;
+    constexpr int quads = 20;
+    constexpr float size = 2;
+    for(int z = 0; z <= quads; z++){
+        for(int x = 0; x <= quads; x++){
+            part.vertices.push_back({.position = {x * size, 0, z * size}});
+        }
+    }
+    for(int z = 0; z < quads; z++){
+        for(int x = 0; x < quads; x++){
+            if (trench && (z == 9 || z == 10) && x < 17){
+                continue;
+            }
+            const uint32_t i = z * (quads + 1) + x;
+            for(auto idx : {i, i + quads + 1, i + 1, i + 1, i + quads + 1, i + quads + 2}){
+                part.indices.push_back(idx);
+            }
+        }
+    }
+    return std::make_shared<MeshAsset>(part, MeshAssetOptions{.keepInSystemRAM = true, .uploadToGPU = false});
+}
+
+static decimalType PathLength(const Vector<vector3>& path){
+    decimalType length = 0;
+    for(size_t i = 1; i < path.size(); i++){
+        length += glm::distance(path[i - 1], path[i]);
+    }
+    return length;
+}
+
+struct SlowAsset{
+    static std::atomic<int> constructions;
+    std::string name;
+    SlowAsset(const std::string& name, int milliseconds) : name(name){
+        constructions++;
+        if (name == "broken"){
+            Debug::Fatal("Could not load {}", name);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    }
+    struct Manager : public GenericWeakReadThroughCache<std::string, SlowAsset>{};
+};
+std::atomic<int> SlowAsset::constructions = 0;
+
+int Test_AsyncCache(){
+    // concurrent requests for one key share a single load
+    Vector<std::shared_future<Ref<SlowAsset>>> futures;
+    for(int i = 0; i < 16; i++){
+        futures.push_back(SlowAsset::Manager::GetAsync("a", 50));
+    }
+    auto sync = SlowAsset::Manager::Get("a", 50);
+    for(auto& future : futures){
+        assert(future.get() == sync);
+    }
+    assert(SlowAsset::constructions == 1);
+    assert(SlowAsset::Manager::GetAsync("a", 50).get() == sync);
+
+    // different keys do not wait for each other
+    const auto begin = std::chrono::steady_clock::now();
+    auto b = SlowAsset::Manager::GetAsync("b", 200);
+    auto c = SlowAsset::Manager::GetAsync("c", 200);
+    assert(b.get()->name == "b" && c.get()->name == "c");
+    assert(std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(390));
+    assert(SlowAsset::constructions == 3);
+
+    // errors reach the caller, and the next request tries again
+    for(int attempt = 0; attempt < 2; attempt++){
+        bool threw = false;
+        try{
+            SlowAsset::Manager::GetAsync("broken", 0).get();
+        }
+        catch(const std::exception&){
+            threw = true;
+        }
+        assert(threw);
+    }
+    assert(SlowAsset::constructions == 5);
+
+    // a load that finishes after Clear does not disturb the load that replaced it
+    auto stale = SlowAsset::Manager::GetAsync("d", 100);
+    SlowAsset::Manager::Clear();
+    auto fresh = SlowAsset::Manager::GetAsync("d", 300);
+    stale.get();
+    auto waited = SlowAsset::Manager::Get("d", 0);
+    assert(waited == fresh.get() && waited != stale.get());
+    assert(SlowAsset::Manager::Get("d", 0) == waited);
+    return 0;
+}
+
+int Test_AssetPack(){
+    const auto dir = std::filesystem::temp_directory_path() / "rve_test_pack";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir / "app" / "meshes" / "lods");
+    auto write = [&](const std::filesystem::path& path, std::string_view contents){
+        std::ofstream(dir / path, std::ios::binary).write(contents.data(), contents.size());
+    };
+    write("app/meshes/cube.rvem", "cube data");
+    write("app/meshes/lods/cube_1.rvem", "lod");
+    write("app/meshes.txt", "not in the directory");
+    write("app/empty", "");
+
+    AssetPackBuilder builder;
+    builder.AddDirectory(dir / "app");
+    {
+        std::ofstream out(dir / "app.rvepack", std::ios::binary);
+        builder.Write(out);
+    }
+
+    AssetPack pack(dir / "app.rvepack");
+    assert(pack.NumEntries() == 4);
+    auto cube = pack.Find("app/meshes/cube.rvem");
+    assert(std::string_view(reinterpret_cast<const char*>(cube.data()), cube.size()) == "cube data");
+    // files are read in place, and aligned so that they can be reinterpreted without copying
+    assert(reinterpret_cast<uintptr_t>(cube.data()) % SerializedAssetPackHeader::dataAlignment == 0);
+    assert(pack.Find("/app//meshes/lods/cube_1.rvem").size() == 3);
+    assert(pack.Find("app/empty").data() != nullptr && pack.Find("app/empty").size() == 0);
+    assert(pack.Find("app/meshes/sphere.rvem").data() == nullptr);
+    assert(pack.Exists("app/meshes") && pack.Exists("app/meshes/lods/") && !pack.Exists("app/mesh"));
+
+    Vector<std::string> children;
+    pack.IterateDirectory("app/meshes", [&](std::string_view name){
+        children.emplace_back(name);
+    });
+    assert((children == Vector<std::string>{"cube.rvem", "lods"}));
+    return 0;
+}
+
+struct MeshReader : public MeshAsset{
+    using MeshAsset::DeserializeMesh;
+    using MeshAsset::DeserializeMeshFromMemory;
+};
+
+int Test_MeshDeserialize(){
+    MeshPart part;
+    part.vertices = {{.position = {-1, 0, 2}}, {.position = {3, 1, 0}}, {.position = {0, -4, 0}}};
+    part.indices = {0, 1, 2};
+    SerializedMeshDataHeader header{
+        .numVertices = uint32_t(part.vertices.size()),
+        .numIndicies = uint32_t(part.indices.size()),
+    };
+    CalculateBounds(part.vertices, header.bounds, header.radius);
+    assert(header.bounds.min[1] == -4 && header.bounds.max[0] == 3 && header.radius == 4);
+
+    std::stringstream file;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(part.vertices.data()), part.vertices.size() * sizeof(vertex_t));
+    file.write(reinterpret_cast<const char*>(part.indices.data()), part.indices.size() * sizeof(uint32_t));
+    const auto contents = file.str();
+    assert(contents.size() == header.MeshDataSize());
+
+    // in place, the view points into the data
+    Vector<uint8_t> data(contents.begin(), contents.end());
+    SerializedMeshDataHeader loaded;
+    MeshPart decoded;
+    auto view = MeshReader::DeserializeMeshFromMemory(data, loaded, decoded);
+    assert(loaded.radius == header.radius && loaded.bounds.max[2] == 2);
+    assert(reinterpret_cast<const uint8_t*>(view.vertices.data()) == data.data() + sizeof(header));
+    assert(view.vertices.size() == 3 && view.vertices[1].position.y == 1);
+    assert(view.indices.size() == 3 && view.indices[2] == 2);
+
+    // from a stream
+    auto mesh = MeshReader::DeserializeMesh(file, loaded);
+    assert(loaded.numVertices == 3 && mesh.vertices[2].position.y == -4);
+    assert((mesh.indices == part.indices));
+    return 0;
+}
+
+int Test_MeshCompression(){
+    MeshPart part;
+    constexpr uint32_t quads = 8;
+    for(uint32_t z = 0; z <= quads; z++){
+        for(uint32_t x = 0; x <= quads; x++){
+            part.vertices.push_back({.position = {float(x), 0, float(z)}, .normal = {0, 1, 0}, .tangent = {1, 0, 0}, .bitangent = {0, 0, 1}, .uv = {x / float(quads), z / float(quads)}});
+        }
+    }
+    for(uint32_t z = 0; z < quads; z++){
+        for(uint32_t x = 0; x < quads; x++){
+            const uint32_t i = z * (quads + 1) + x;
+            part.indices.insert(part.indices.end(), {i, i + quads + 1, i + 1, i + 1, i + quads + 1, i + quads + 2});
+        }
+    }
+
+    // encode the way rvemc does
+    Vector<QuantizedVertex> quantized(part.vertices.begin(), part.vertices.end());
+    std::string vertexData(meshopt_encodeVertexBufferBound(quantized.size(), sizeof(QuantizedVertex)), 0);
+    vertexData.resize(meshopt_encodeVertexBuffer(reinterpret_cast<unsigned char*>(vertexData.data()), vertexData.size(), quantized.data(), quantized.size(), sizeof(QuantizedVertex)));
+    std::string indexData(meshopt_encodeIndexBufferBound(part.indices.size(), part.vertices.size()), 0);
+    indexData.resize(meshopt_encodeIndexBuffer(reinterpret_cast<unsigned char*>(indexData.data()), indexData.size(), part.indices.data(), part.indices.size()));
+
+    SerializedMeshDataHeader header{
+        .numVertices = uint32_t(part.vertices.size()),
+        .numIndicies = uint32_t(part.indices.size()),
+        .attributes = SerializedMeshDataHeader::CompressedBit,
+    };
+    header.encodedVertexBytes = uint32_t(vertexData.size());
+    header.encodedIndexBytes = uint32_t(indexData.size());
+    CalculateBounds(part.vertices, header.bounds, header.radius);
+
+    Vector<uint8_t> data(header.MeshDataSize());
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), vertexData.data(), vertexData.size());
+    std::memcpy(data.data() + header.IndexDataOffset(), indexData.data(), indexData.size());
+    assert(data.size() < part.vertices.size() * sizeof(vertex_t) + part.indices.size() * sizeof(uint32_t));
+
+    SerializedMeshDataHeader loaded;
+    MeshPart decoded;
+    auto view = MeshReader::DeserializeMeshFromMemory(data, loaded, decoded);
+    assert(view.vertices.data() == decoded.vertices.data());
+    assert((decoded.indices == part.indices));
+    for(uint32_t i = 0; i < part.vertices.size(); i++){
+        const auto& a = part.vertices[i];
+        const auto& b = decoded.vertices[i];
+        assert(a.position == b.position);
+        assert(glm::distance(a.normal, b.normal) < 1e-4 && glm::distance(a.tangent, b.tangent) < 1e-4);
+        assert(glm::distance(a.uv, b.uv) < 1e-3);
+    }
+
+    // the stream path decodes the same data
+    std::stringstream file(std::string(data.begin(), data.end()));
+    auto streamed = MeshReader::DeserializeMesh(file, loaded);
+    assert(streamed.vertices.size() == part.vertices.size() && (streamed.indices == part.indices));
+    return 0;
+}
+
+int Test_MeshletCulling(){
+    auto makeMeshlet = [](glm::vec3 center, glm::vec3 facing){
+        return Meshlet{
+            .center = {center.x, center.y, center.z},
+            .radius = 1,
+            .coneApex = {center.x, center.y, center.z},
+            .coneAxis = {facing.x, facing.y, facing.z},
+            .coneCutoff = facing == glm::vec3(0) ? 1.f : 0.f,   // flat, or no cone
+        };
+    };
+    const Vector<Meshlet> meshlets{
+        makeMeshlet({0, 0, -10}, {0, 0, 1}),    // in front, facing the camera
+        makeMeshlet({0, 0, -10}, {0, 0, -1}),   // in front, facing away
+        makeMeshlet({0, 0, 10}, {0, 0, 1}),     // behind the camera
+        makeMeshlet({100, 0, -10}, {0, 0, 1}),  // off to the side
+        makeMeshlet({0.5, 0, -10}, {0, 0, 0}),  // no cone
+    };
+    const auto viewProj = RMath::perspectiveProjection<float>(deg_to_rad(60), 1, 0.1, 100) * glm::lookAt(glm::vec3(0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+    Frustum frustum(viewProj);
+
+    Vector<uint32_t> visible;
+    CullMeshlets(meshlets, glm::mat4(1), frustum, glm::vec3(0), visible);
+    assert((visible == Vector<uint32_t>{0, 4}));
+
+    // moving and turning the mesh moves its meshlets and their cones
+    visible.clear();
+    const auto model = glm::rotate(glm::translate(glm::mat4(1), glm::vec3(0, 0, -20)), glm::radians(180.f), glm::vec3(0, 1, 0));
+    CullMeshlets(meshlets, model, frustum, glm::vec3(0), visible);
+    assert((visible == Vector<uint32_t>{1, 4}));
+
+    // the meshlet block round-trips through a mesh
+    MeshPart part;
+    part.vertices = {{.position = {0, 0, 0}}, {.position = {1, 0, 0}}, {.position = {0, 1, 0}}};
+    part.indices = {0, 1, 2};
+    MeshletData data;
+    data.meshlets = {meshlets[0]};
+    data.meshlets[0].vertexCount = 3;
+    data.meshlets[0].triangleCount = 1;
+    data.vertices = {0, 1, 2};
+    data.triangles = {0, 1, 2};
+    std::stringstream file;
+    SerializeMesh(file, part, 0, &data);
+    const auto contents = file.str();
+    Vector<uint8_t> serialized(contents.begin(), contents.end());
+    MeshAsset mesh(std::span<const uint8_t>(serialized), {.uploadToGPU = false});
+    const auto& loaded = mesh.GetMeshlets();
+    assert(loaded.meshlets.size() == 1 && loaded.meshlets[0].triangleCount == 1 && loaded.meshlets[0].coneAxis[2] == 1);
+    assert((loaded.vertices == data.vertices) && (loaded.triangles == data.triangles));
+    return 0;
+}
+
+int Test_MeshLods(){
+    MeshLodChainBuilder builder;
+    for(uint32_t quads : {4, 1}){
+        MeshPart mesh;
+        for(uint32_t i = 0; i < quads; i++){
+            const auto base = uint32_t(mesh.vertices.size());
+            for(auto x : {0, 1, 1}){
+                mesh.vertices.push_back({.position = {float(i + x), float(x), 0}});
+            }
+            mesh.indices.insert(mesh.indices.end(), {base, base + 1, base + 2});
+        }
+        builder.lods.push_back({mesh, quads == 4 ? 10.f : 40.f});
+    }
+    std::stringstream file;
+    builder.Write(file);
+    const auto contents = file.str();
+    Vector<uint8_t> data(contents.begin(), contents.end());
+
+    auto lods = MeshAsset::DeserializeLods(data, {.keepInSystemRAM = true, .uploadToGPU = false});
+    assert(lods.size() == 2);
+    assert(lods[0].minDistance == 10 && lods[1].minDistance == 40);
+    assert(lods[0].mesh->GetSystemCopy().vertices.size() == 12 && lods[1].mesh->GetSystemCopy().indices.size() == 3);
+    assert(lods[0].mesh->GetBounds().max[0] == 4);
+    return 0;
+}
+
+int Test_OffsetAllocator(){
+    // sizes here are exact bin sizes, so that a freed range is never passed over for being slightly too small
+    OffsetAllocator allocator(1024);
+    auto a = allocator.Allocate(128), b = allocator.Allocate(256), c = allocator.Allocate(384);
+    assert(a.offset == 0 && b.offset == 128 && c.offset == 384);
+    assert(allocator.GetStorageReport().totalFree == 256);
+
+    // a freed range is reused, and merges with its free neighbors
+    allocator.Free(b);
+    auto d = allocator.Allocate(256);
+    assert(d.offset == 128);
+    allocator.Free(a);
+    allocator.Free(d);
+    assert(allocator.GetStorageReport().totalFree == 640 && allocator.GetStorageReport().largestFree == 384);
+    assert(allocator.GetFragmentation() > 0);
+
+    // growing extends the free range at the end, and existing allocations keep their offsets
+    assert(!allocator.Allocate(768).IsValid());
+    allocator.Grow(1536);
+    auto e = allocator.Allocate(768);
+    assert(e.offset == 768 && c.offset == 384);
+    // and when the end is allocated, the new space is a separate range
+    allocator.Grow(1600);
+    auto f = allocator.Allocate(64);
+    assert(f.offset == 1536);
+
+    allocator.Free(c);
+    allocator.Free(e);
+    allocator.Free(f);
+    assert(allocator.GetStorageReport().totalFree == 1600 && allocator.GetStorageReport().largestFree == 1600);
+    assert(allocator.GetFragmentation() == 0);
+
+    // growing by the bin-rounded size always makes room, including for sizes that are not exact bin sizes
+    for(const uint32_t request : {5000u, 1000u, 777u, 9u, 65537u}){
+        OffsetAllocator full(1024);
+        full.Allocate(1024);
+        const auto rounded = OffsetAllocator::SizeRoundedUpToBin(request);
+        assert(rounded >= request && rounded < request + request / 8 + 1);
+        full.Grow(1024 + rounded);
+        auto allocation = full.Allocate(request);
+        assert(allocation.IsValid() && allocation.offset == 1024);
+    }
+
+    // random churn never hands out overlapping ranges, and everything merges back once freed
+    constexpr uint32_t size = 1 << 16;
+    OffsetAllocator churn(size);
+    Vector<OffsetAllocator::Allocation> live;
+    Vector<bool> owned(size, false);
+    uint32_t seed = 1;
+    auto random = [&seed]{
+        seed = seed * 1664525 + 1013904223;
+        return seed >> 8;
+    };
+    for(int i = 0; i < 20'000; i++){
+        if (!live.empty() && random() % 3 == 0){
+            const auto index = random() % live.size();
+            const auto allocation = live[index];
+            for(uint32_t j = 0; j < churn.AllocationSize(allocation); j++){
+                owned[allocation.offset + j] = false;
+            }
+            churn.Free(allocation);
+            live[index] = live.back();
+            live.pop_back();
+        }
+        else{
+            const auto allocation = churn.Allocate(1 + random() % 512);
+            if (allocation.IsValid()){
+                for(uint32_t j = 0; j < churn.AllocationSize(allocation); j++){
+                    assert(!owned[allocation.offset + j]);
+                    owned[allocation.offset + j] = true;
+                }
+                live.push_back(allocation);
+            }
+        }
+    }
+    for(const auto& allocation : live){
+        churn.Free(allocation);
+    }
+    assert(churn.GetStorageReport().largestFree == size);
+    return 0;
+}
+
+int Test_TransientRing(){
+    TransientRingAllocator ring(256, 16);
+    auto a = ring.Allocate(10), b = ring.Allocate(20);
+    assert(a.page == TransientRingAllocator::RingPage && a.offset == 0 && b.offset == 16);
+    const auto frame1 = ring.EndFrame();
+
+    // the ring is full of frames in flight, so the rest spills into an overflow page
+    auto c = ring.Allocate(200);
+    assert(c.page == TransientRingAllocator::RingPage && c.offset == 48);
+    auto d = ring.Allocate(16), e = ring.Allocate(16);
+    assert(d.page == 1 && d.offset == 0 && e.page == 1 && e.offset == 16);
+    assert(ring.GetNumPages() == 2 && ring.GetOverflowBytes() == 32);
+    const auto frame2 = ring.EndFrame();
+
+    // completing the first frame frees its space, and allocations wrap around to it
+    ring.CompleteFrame(frame1);
+    auto f = ring.Allocate(32), g = ring.Allocate(16);
+    assert(f.page == TransientRingAllocator::RingPage && f.offset == 0 && g.offset == 32);
+    // the second frame still holds the first overflow page
+    auto h = ring.Allocate(16);
+    assert(h.page == 2);
+    const auto frame3 = ring.EndFrame();
+    assert(frame3 > frame2);
+
+    // once everything completes, the whole ring and the overflow pages are free again
+    ring.CompleteFrame(frame3);
+    assert(ring.GetRingBytesInUse() == 0);
+    auto i = ring.Allocate(256);
+    assert(i.page == TransientRingAllocator::RingPage && i.offset == 0);
+    auto j = ring.Allocate(16);
+    assert(j.page == 1 && j.offset == 0);
+    // allocations larger than the ring get a page of their own
+    auto k = ring.Allocate(1000);
+    assert(k.page == 3 && ring.GetPageSize(k.page) >= 1000 && ring.GetNumPages() == 4);
+    return 0;
+}
+
+int Test_DynamicBVH(){
+    DynamicBVH<uint32_t> bvh(0.5);
+    Vector<uint32_t> proxies;
+    Vector<AABB> boxes;
+    uint32_t seed = 1;
+    auto random = [&seed](float range){
+        seed = seed * 1664525 + 1013904223;
+        return float(seed >> 8) / float(1 << 24) * range;
+    };
+    auto randomBox = [&]{
+        const glm::vec3 center(random(200) - 100, random(200) - 100, random(200) - 100);
+        return AABB::FromSphere(center, 0.5f + random(2));
+    };
+    for (uint32_t i = 0; i < 2000; i++){
+        boxes.push_back(randomBox());
+        proxies.push_back(bvh.Insert(boxes.back(), i));
+    }
+    assert(bvh.GetNumLeaves() == 2000);
+    assert(bvh.GetHeight() < 2 * 11);   // balanced
+
+    const Frustum frustum(RMath::perspectiveProjection<float>(deg_to_rad(60), 1, 0.1, 100) * glm::lookAt(glm::vec3(0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0)));
+    const BoundingSphere sphere{{10, 10, 10}, 30};
+    const BoundingCone cone{.apex = {0, 0, 0}, .axis = {1, 0, 0}, .range = 80, .halfAngle = glm::radians(30.f)};
+
+    // every query must report exactly the leaves whose enlarged boxes pass the volume's test, and every leaf whose box does
+    auto check = [&](const auto& volume){
+        Vector<uint8_t> found(boxes.size(), 0);
+        bvh.Query(volume, [&found](uint32_t i){
+            assert(found[i] == 0);
+            found[i] = 1;
+        });
+        for (uint32_t i = 0; i < boxes.size(); i++){
+            if (proxies[i] == DynamicBVH<uint32_t>::Null){
+                assert(!found[i]);
+                continue;
+            }
+            assert(bool(found[i]) == volume.Intersects(bvh.GetFatBox(proxies[i])));
+            assert(!volume.Intersects(boxes[i]) || found[i]);
+        }
+    };
+    auto checkAll = [&]{
+        check(frustum);
+        check(sphere);
+        check(cone);
+
+        // a batch reports the same leaves as querying each volume alone
+        const Frustum frusta[]{
+            frustum,
+            Frustum(RMath::perspectiveProjection<float>(deg_to_rad(90), 1, 0.1, 50) * glm::lookAt(glm::vec3(0), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0))),
+            Frustum(RMath::orthoProjection<float>(-20, 20, -20, 20, 0.1, 100) * glm::lookAt(glm::vec3(0, 50, 0), glm::vec3(0), glm::vec3(0, 0, 1))),
+        };
+        Vector<uint32_t> masks(boxes.size(), 0);
+        bvh.QueryBatch(std::span<const Frustum>(frusta), [&masks](uint32_t i, uint32_t mask){
+            assert(masks[i] == 0 && mask != 0);
+            masks[i] = mask;
+        });
+        for (uint32_t view = 0; view < std::size(frusta); view++){
+            bvh.Query(frusta[view], [&masks, view](uint32_t i){
+                assert(masks[i] & (1 << view));
+                masks[i] &= ~(1 << view);
+            });
+        }
+        assert(std::all_of(masks.begin(), masks.end(), [](uint32_t mask){ return mask == 0; }));
+    };
+    checkAll();
+
+    // small moves stay inside the enlarged boxes, larger ones are refit, and far ones are reinserted
+    for (uint32_t i = 0; i < boxes.size(); i++){
+        const auto distance = i % 3 == 0 ? 0.1f : i % 3 == 1 ? 1.5f : 150.f;
+        const glm::vec3 offset(distance, 0, 0);
+        boxes[i] = {boxes[i].min + offset, boxes[i].max + offset};
+        const bool changed = bvh.Update(proxies[i], boxes[i]);
+        assert(changed == (i % 3 != 0));
+    }
+    bvh.Refit();
+    checkAll();
+
+    // removed leaves are never reported, and their nodes are reused
+    for (uint32_t i = 0; i < boxes.size(); i += 2){
+        bvh.Remove(proxies[i]);
+        proxies[i] = DynamicBVH<uint32_t>::Null;
+    }
+    assert(bvh.GetNumLeaves() == 1000);
+    checkAll();
+    for (uint32_t i = 0; i < boxes.size(); i += 2){
+        boxes[i] = randomBox();
+        proxies[i] = bvh.Insert(boxes[i], i);
+    }
+    assert(bvh.GetNumLeaves() == 2000);
+    assert(*std::max_element(proxies.begin(), proxies.end()) < 2 * 2000);
+    checkAll();
+
+    // unbounded leaves, for objects that opt out of culling, are always reported
+    const auto unbounded = bvh.Insert(AABB::Unbounded(), uint32_t(boxes.size()));
+    bool found = false;
+    bvh.Query(BoundingSphere{{1000, 1000, 1000}, 1}, [&found](uint32_t i){
+        found |= i == 2000;
+    });
+    assert(found);
+    bvh.Remove(unbounded);
+    return 0;
+}
+
+int Test_TiledNavMesh(){
+    const vector3 start{5, 0, 5}, end{5, 0, 35};
+
+    NavMeshComponent::Options options;
+    options.tileSize = 32;
+    NavMeshComponent navMesh(MakeNavFloor(false), options);
+    assert(!navMesh.IsBuilding());
+    assert(navMesh.GetNumTiles() > 4);
+    const auto direct = PathLength(navMesh.CalculatePath(start, end));
+    assert(direct < 31);
+
+    // a wall across the floor forces the path around its open end
+    auto wall = navMesh.AddBoxObstacle({16, 1, 20}, {16, 2, 0.5});
+    assert(navMesh.UpdateObstacles());
+    const auto around = PathLength(navMesh.CalculatePath(start, end));
+    assert(around > 50);
+
+    // obstacles survive a background rebuild
+    navMesh.UpdateNavMesh(MakeNavFloor(false), options);
+    navMesh.WaitForBuild();
+    assert(navMesh.UpdateObstacles());
+    assert(std::abs(PathLength(navMesh.CalculatePath(start, end)) - around) < 1);
+
+    navMesh.RemoveObstacle(wall);
+    assert(navMesh.UpdateObstacles());
+    assert(std::abs(PathLength(navMesh.CalculatePath(start, end)) - direct) < 1);
+
+    // a geometry change only rebuilds the tiles it touches
+    navMesh.UpdateGeometry(MakeNavFloor(true), Bounds{{0, 0, 18}, {40, 0, 22}});
+    navMesh.WaitForBuild();
+    assert(navMesh.UpdateObstacles());
+    assert(PathLength(navMesh.CalculatePath(start, end)) > 50);
+    return 0;
+}
+
+int Test_NavMeshPaths(){
+    NavMeshComponent::Options options;
+    options.tileSize = 32;
+    NavMeshComponent navMesh(MakeNavFloor(true), options);
+
+    // paths from points along x = 2 to points along x = 38, on both sides of the trench
+    Vector<NavMeshComponent::PathRequest> requests;
+    for(int i = 0; i < 200; i++){
+        const float z = i % 2 == 0 ? 2 + (i % 15) : 24 + (i % 14);
+        requests.push_back({.start = {2, 0, z}, .end = {38, 0, 38 - (i % 7)}});
+    }
+    requests.push_back({.start = {2, 0, 2}, .end = {100, 0, 100}});
+    auto batch = navMesh.RequestPaths(requests);
+    batch->Wait();
+    assert(batch->IsDone());
+    for(size_t i = 0; i + 1 < requests.size(); i++){
+        const auto& result = batch->results[i];
+        assert(result.status == NavMeshComponent::PathResult::Status::Complete);
+        assert(glm::distance(result.points.back(), requests[i].end) < 0.5);
+        // batched paths match paths found one at a time
+        assert(std::abs(PathLength(result.points) - PathLength(navMesh.CalculatePath(requests[i].start, requests[i].end))) < 0.01);
+    }
+    assert(batch->results.back().status == NavMeshComponent::PathResult::Status::NoEnd);
+
+    // a sliced search over several updates finds the way around the trench like a single search.
+    // Detour's A* over polygon edges is not exact, so the corridors may differ slightly
+    const NavMeshComponent::PathRequest around{.start = {5, 0, 5}, .end = {5, 0, 35}};
+    auto sliced = navMesh.BeginSlicedPath(around);
+    int updates = 0;
+    while(!sliced->Update(4)){
+        updates++;
+    }
+    assert(updates > 1);
+    assert(sliced->GetResult().status == NavMeshComponent::PathResult::Status::Complete);
+    auto single = navMesh.RequestPaths({around});
+    single->Wait();
+    assert(glm::distance(sliced->GetResult().points.back(), around.end) < 0.5);
+    assert(std::abs(PathLength(sliced->GetResult().points) - PathLength(single->results[0].points)) < 0.05 * PathLength(single->results[0].points));
+    return 0;
+}
+
+int Test_BakedNavMesh(){
+    const vector3 start{5, 0, 5}, end{5, 0, 35};
+    NavMeshComponent::Options options;
+    options.tileSize = 32;
+    NavMeshComponent built(MakeNavFloor(true), options);
+    const auto builtLength = PathLength(built.CalculatePath(start, end));
+
+    // the baked navmesh loads without its geometry, and its tiles are used as-is
+    const auto baked = built.Bake();
+    NavMeshComponent loaded(std::span<const uint8_t>(baked.data(), baked.size()));
+    assert(loaded.GetNumTiles() == built.GetNumTiles());
+    assert(std::abs(PathLength(loaded.CalculatePath(start, end)) - builtLength) < 0.01);
+
+    // the tile cache is baked too, so obstacles carve loaded navmeshes. This one closes the way around the trench
+    auto block = loaded.AddBoxObstacle({37, 1, 20}, {4, 2, 2});
+    assert(loaded.UpdateObstacles());
+    const auto blocked = loaded.CalculatePath(start, end);
+    assert(glm::distance(blocked.back(), end) > 1);
+
+    // with an obstacle, only the layers are baked, and the loaded tiles are rebuilt without it
+    const auto bakedWithObstacle = loaded.Bake();
+    NavMeshComponent rebuilt(std::span<const uint8_t>(bakedWithObstacle.data(), bakedWithObstacle.size()));
+    assert(std::abs(PathLength(rebuilt.CalculatePath(start, end)) - builtLength) < 0.01);
+    loaded.RemoveObstacle(block);
+
+    // truncated data is rejected, also in release builds
+    for(const auto length : {size_t(8), baked.size() / 2, baked.size() - 1}){
+        bool rejected = false;
+        try{
+            NavMeshComponent truncated(std::span<const uint8_t>(baked.data(), length));
+        }
+        catch(const std::runtime_error&){
+            rejected = true;
+        }
+        assert(rejected);
+    }
+    return 0;
+}
+
+int Test_Crowd(){
+    NavMeshComponent::Options options;
+    options.tileSize = 32;
+    NavMeshComponent navMesh(MakeNavFloor(false), options);
+    CrowdComponent crowd(navMesh, 64);
+
+    // two groups that walk through each other to swap sides
+    Vector<CrowdAgentComponent> agents;
+    Vector<vector3> targets;
+    for(int i = 0; i < 16; i++){
+        const bool left = i % 2 == 0;
+        const float z = 12 + (i / 2) * 2;
+        agents.emplace_back(crowd, vector3(left ? 5 : 35, 0, z));
+        targets.push_back({left ? 35 : 5, 0, z});
+        agents.back().MoveTo(targets.back());
+    }
+
+    constexpr float dt = 1.0 / 60;
+    decimalType closest = std::numeric_limits<decimalType>::max();
+    for(int tick = 0; tick < 1200; tick++){
+        crowd.Update(dt, matrix4(1));
+        for(size_t i = 0; i < agents.size(); i++){
+            for(size_t j = i + 1; j < agents.size(); j++){
+                closest = std::min(closest, glm::distance(agents[i].GetPosition(), agents[j].GetPosition()));
+            }
+        }
+    }
+    assert(crowd.GetNumAgents() == agents.size());
+    for(size_t i = 0; i < agents.size(); i++){
+        assert(glm::distance(agents[i].GetPosition(), targets[i]) < 1);
+    }
+    // local avoidance keeps agents from walking through each other
+    assert(closest > agents[0].GetParams().radius);
+
+    // transforms are written in the world space of the navmesh
+    World world;
+    auto object = world.Instantiate<GameObject>();
+    auto& walker = object.EmplaceComponent<CrowdAgentComponent>(crowd, vector3(20, 0, 5));
+    walker.SetVelocity({0, 0, 2});
+    const auto worldMatrix = glm::translate(matrix4(1), vector3(100, 0, 0));
+    for(int tick = 0; tick < 60; tick++){
+        crowd.Update(dt, worldMatrix);
+    }
+    assert(crowd.GetNumAgents() == agents.size() + 1);
+    CrowdAgentSystem{}(walker, object.GetTransform());
+    assert(glm::distance(object.GetTransform().GetWorldPosition(), walker.GetPosition() + vector3(100, 0, 0)) < 0.001);
+    assert(walker.GetPosition().z > 6);
+    // facing the direction of travel, along +Z
+    assert(glm::distance(object.GetTransform().WorldForward(), vector3(0, 0, 1)) < 0.01);
+
+    // removed agents leave the crowd on the next update
+    object.Destroy();
+    agents.back().Destroy();
+    crowd.Update(dt, worldMatrix);
+    assert(crowd.GetNumAgents() == agents.size() - 1);
+    return 0;
+}
+
 int main(int argc, char** argv) {
     const unordered_map<std::string_view, std::function<int(void)>> tests{
 		{"CTTI",&Test_CTTI},
         {"Test_UUID",&Test_UUID},
         {"Test_AddDel",&Test_AddDel},
         {"Test_SpawnDestroy",&Test_SpawnDestroy},
+        {"Test_SkinningSIMD",&Test_SkinningSIMD},
+        {"Test_RootMotion",&Test_RootMotion},
+        {"Test_BlendTree",&Test_BlendTree},
+        {"Test_IKGroundProbe",&Test_IKGroundProbe},
+        {"Test_SocketConstraint",&Test_SocketConstraint},
+        {"Test_PoseSharing",&Test_PoseSharing},
+        {"Test_MultiplyJointRotation",&Test_MultiplyJointRotation},
+        {"Test_AsyncCache",&Test_AsyncCache},
+        {"Test_AssetPack",&Test_AssetPack},
+        {"Test_MeshDeserialize",&Test_MeshDeserialize},
+        {"Test_MeshCompression",&Test_MeshCompression},
+        {"Test_MeshletCulling",&Test_MeshletCulling},
+        {"Test_MeshLods",&Test_MeshLods},
+        {"Test_OffsetAllocator",&Test_OffsetAllocator},
+        {"Test_TransientRing",&Test_TransientRing},
+        {"Test_DynamicBVH",&Test_DynamicBVH},
+        {"Test_TiledNavMesh",&Test_TiledNavMesh},
+        {"Test_NavMeshPaths",&Test_NavMeshPaths},
+        {"Test_BakedNavMesh",&Test_BakedNavMesh},
+        {"Test_Crowd",&Test_Crowd},
     };
 	    
 	if (argc < 2){
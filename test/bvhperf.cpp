@@ -0,0 +1,164 @@
+#include <RavEngine/DynamicBVH.hpp>
+#include <RavEngine/Debug.hpp>
+#include <RavEngine/Common3D.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <span>
+#include <string_view>
+
+using namespace RavEngine;
+using namespace std;
+
+// needed for linker
+const std::string_view RVE_VFS_get_name(){
+    return "";
+}
+const std::span<const char> cmrc_get_file_data(const std::string_view& path) {
+    return {};
+}
+
+using clocktype = std::chrono::high_resolution_clock;
+
+struct Settings{
+	uint32_t objects = 20'000;		// renderables scattered through the scene
+	uint32_t materials = 200;		// material buckets, each a separate culling dispatch and draw on the GPU
+	uint32_t lights = 500;		// shadow-casting point lights, 6 shadowmaps each
+	uint32_t frames = 5;
+	float moving = 0.1;				// fraction of objects that move each frame
+	float sceneSize = 1000;
+	float lightRange = 30;			// the influence radius of each light, which bounds its shadowmaps
+};
+
+struct Object{
+	glm::vec3 center;
+	float radius;
+	uint32_t material;
+};
+
+static uint32_t seed = 1;
+static float Random(float range){
+	seed = seed * 1664525 + 1013904223;
+	return float(seed >> 8) / float(1 << 24) * range;
+}
+
+/**
+ The 6 faces of a point light's shadow cubemap, as RenderEngine builds them. Reverse-Z projections have no far plane,
+ so the faces are bounded by the light's range.
+ */
+static void PointLightFrusta(const glm::vec3& position, float range, BoundedFrustum (&frusta)[6]){
+	const auto proj = RMath::perspectiveProjection<float>(deg_to_rad(90), 1, 0.1, 100);
+	const glm::vec3 directions[]{{-1,0,0},{1,0,0},{0,-1,0},{0,1,0},{0,0,-1},{0,0,1}};
+	const glm::vec3 ups[]{{0,-1,0},{0,-1,0},{0,0,1},{0,0,-1},{0,-1,0},{0,-1,0}};
+	for(uint32_t i = 0; i < 6; i++){
+		frusta[i] = {Frustum(proj * glm::lookAt(position, position + directions[i], ups[i])), {position, range}};
+	}
+}
+
+int main(int argc, char** argv){
+	Settings settings;
+	for(int i = 1; i < argc; i++){
+		const std::string_view arg = argv[i];
+		auto value = [&]{
+			Debug::Assert(i + 1 < argc, "Missing value for {}", arg);
+			return static_cast<uint32_t>(std::stoul(argv[++i]));
+		};
+		if (arg == "--objects"){
+			settings.objects = value();
+		}
+		else if (arg == "--materials"){
+			settings.materials = value();
+		}
+		else if (arg == "--lights"){
+			settings.lights = value();
+		}
+		else if (arg == "--frames"){
+			settings.frames = value();
+		}
+		else{
+			cerr << "Usage: " << argv[0] << " [--objects N] [--materials N] [--lights N] [--frames N]\n";
+			return -1;
+		}
+	}
+
+	cout << Format("{} objects in {} materials, {} shadow-casting point lights, {} frames\n", settings.objects, settings.materials, settings.lights, settings.frames);
+
+	Vector<Object> objects;
+	Vector<glm::vec3> lights;
+	for(uint32_t i = 0; i < settings.objects; i++){
+		const glm::vec3 center(Random(settings.sceneSize), Random(settings.sceneSize / 10), Random(settings.sceneSize));
+		objects.push_back({center, 0.5f + Random(3), i % settings.materials});
+	}
+	for(uint32_t i = 0; i < settings.lights; i++){
+		lights.emplace_back(Random(settings.sceneSize), Random(settings.sceneSize / 10), Random(settings.sceneSize));
+	}
+
+	auto begin = clocktype::now();
+	DynamicBVH<uint32_t> bvh(0.1);
+	Vector<uint32_t> proxies;
+	for(const auto& object : objects){
+		proxies.push_back(bvh.Insert(AABB::FromSphere(object.center, object.radius), object.material));
+	}
+	const auto buildTime = clocktype::now() - begin;
+
+	clocktype::duration updateTime{0}, bruteTime{0}, queryTime{0};
+	uint64_t bruteDispatches = 0, bvhDispatches = 0, sphereTests = 0;
+	Vector<uint32_t> materialMasks(settings.materials);
+	for(uint32_t frame = 0; frame < settings.frames; frame++){
+		// move some objects, then refit once, as the render data update does
+		begin = clocktype::now();
+		const auto nMoving = uint32_t(settings.objects * settings.moving);
+		for(uint32_t i = 0; i < nMoving; i++){
+			const auto index = (frame * nMoving + i) % objects.size();
+			auto& object = objects[index];
+			object.center += glm::vec3(Random(2) - 1, 0, Random(2) - 1);
+			bvh.Update(proxies[index], AABB::FromSphere(object.center, object.radius));
+		}
+		bvh.Refit();
+		updateTime += clocktype::now() - begin;
+
+		// without the hierarchy, every material is culled for every shadowmap, testing every object
+		begin = clocktype::now();
+		for(const auto& light : lights){
+			BoundedFrustum frusta[6];
+			PointLightFrusta(light, settings.lightRange, frusta);
+			for(const auto& volume : frusta){
+				std::fill(materialMasks.begin(), materialMasks.end(), 0);
+				for(const auto& object : objects){
+					const auto toObject = object.center - volume.bound.center;
+					const auto reach = volume.bound.radius + object.radius;
+					materialMasks[object.material] |= glm::dot(toObject, toObject) <= reach * reach && volume.frustum.IntersectsSphere(object.center, object.radius);
+				}
+				sphereTests += objects.size();
+				bruteDispatches += settings.materials;
+			}
+		}
+		bruteTime += clocktype::now() - begin;
+
+		// with it, one batched query per light finds the materials each shadowmap needs
+		begin = clocktype::now();
+		for(const auto& light : lights){
+			BoundedFrustum frusta[6];
+			PointLightFrusta(light, settings.lightRange, frusta);
+			std::fill(materialMasks.begin(), materialMasks.end(), 0);
+			bvh.QueryBatch(std::span<const BoundedFrustum>(frusta), [&materialMasks](uint32_t material, uint32_t mask){
+				materialMasks[material] |= mask;
+			});
+			for(const auto mask : materialMasks){
+				bvhDispatches += std::popcount(mask);
+			}
+		}
+		queryTime += clocktype::now() - begin;
+	}
+
+	auto ms = [](clocktype::duration duration){
+		return std::chrono::duration<double, std::milli>(duration).count();
+	};
+	cout << Format("Build: {:.2f} ms, height {}\n", ms(buildTime), bvh.GetHeight());
+	cout << Format("Update + refit: {:.3f} ms/frame\n", ms(updateTime) / settings.frames);
+	cout << Format("Per-object tests: {:>10.2f} ms/frame, {:>10} material dispatches/frame, {} sphere tests/frame\n", ms(bruteTime) / settings.frames, bruteDispatches / settings.frames, sphereTests / settings.frames);
+	cout << Format("     BVH queries: {:>10.2f} ms/frame, {:>10} material dispatches/frame\n", ms(queryTime) / settings.frames, bvhDispatches / settings.frames);
+	return 0;
+}
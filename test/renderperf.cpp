@@ -0,0 +1,191 @@
+#include <RavEngine/App.hpp>
+#include <RavEngine/World.hpp>
+#include <RavEngine/GameObject.hpp>
+#include <RavEngine/StaticMesh.hpp>
+#include <RavEngine/MeshCollection.hpp>
+#include <RavEngine/BuiltinMaterials.hpp>
+#include <RavEngine/CameraComponent.hpp>
+#include <RavEngine/Light.hpp>
+#include <RavEngine/Debug.hpp>
+#include <RavEngine/StartApp.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+
+using namespace RavEngine;
+using namespace std;
+
+/**
+ Runs whole frames of a synthetic scene on the Noop RGL backend, so the CPU side of the renderer
+ (render data updates, culling, command encoding) can be timed without a GPU or a display.
+ */
+
+struct Settings{
+	uint32_t objects = 20'000;		// cubes scattered through the scene
+	uint32_t materials = 200;		// material instances, each its own draw bucket
+	uint32_t pointLights = 50;		// shadow-casting, 6 shadowmaps each
+	uint32_t spotLights = 50;		// shadow-casting
+	uint32_t frames = 300;
+	uint32_t warmup = 30;			// frames run before timing starts, while render data settles
+	float moving = 0.1;				// fraction of objects that move each frame
+	float sceneSize = 500;
+};
+
+static uint32_t seed = 1;
+static float RandomFloat(float range){
+	seed = seed * 1664525 + 1013904223;
+	return float(seed >> 8) / float(1 << 24) * range;
+}
+
+using clocktype = std::chrono::high_resolution_clock;
+
+struct RenderPerfWorld : public World{
+	Settings settings;
+	Vector<GameObject> objects;
+	uint32_t frame = 0;
+	uint32_t nextMoving = 0;
+
+	clocktype::time_point tickBegin, tickEnd;
+	clocktype::duration tickTime{0}, outsideTime{0};
+	std::chrono::duration<double, std::micro> drawTime{0};
+
+	RenderPerfWorld(const Settings& settings) : settings(settings){}
+
+	void PreTick(float fpsScale) final{
+		tickBegin = clocktype::now();
+		// the last frame was drawn between the end of the last tick and now, along with the rest of the engine's frame work
+		if (frame > settings.warmup && frame <= settings.warmup + settings.frames){
+			outsideTime += tickBegin - tickEnd;
+			drawTime += GetApp()->GetLastDrawTime();
+		}
+
+		const auto nMoving = uint32_t(objects.size() * settings.moving);
+		for(uint32_t i = 0; i < nMoving; i++){
+			auto& object = objects[nextMoving];
+			object.GetTransform().LocalTranslateDelta(vector3(RandomFloat(2) - 1, 0, RandomFloat(2) - 1));
+			nextMoving = (nextMoving + 1) % objects.size();
+		}
+	}
+
+	void PostTick(float fpsScale) final{
+		tickEnd = clocktype::now();
+		if (frame >= settings.warmup && frame < settings.warmup + settings.frames){
+			tickTime += tickEnd - tickBegin;
+		}
+		if (frame == settings.warmup + settings.frames){
+			GetApp()->Quit();
+		}
+		frame++;
+	}
+};
+
+struct RenderPerfApp : public App{
+	Settings settings;
+	Ref<RenderPerfWorld> world;
+
+	void OnStartup(int argc, char** argv) final;
+	int OnShutdown() final;
+};
+
+void RenderPerfApp::OnStartup(int argc, char** argv){
+	for(int i = 1; i < argc; i++){
+		const std::string_view arg = argv[i];
+		auto value = [&]{
+			Debug::Assert(i + 1 < argc, "Missing value for {}", arg);
+			return static_cast<uint32_t>(std::stoul(argv[++i]));
+		};
+		if (arg == "--objects"){
+			settings.objects = value();
+		}
+		else if (arg == "--materials"){
+			settings.materials = value();
+		}
+		else if (arg == "--point-lights"){
+			settings.pointLights = value();
+		}
+		else if (arg == "--spot-lights"){
+			settings.spotLights = value();
+		}
+		else if (arg == "--frames"){
+			settings.frames = value();
+		}
+		else{
+			cerr << "Usage: " << argv[0] << " [--objects N] [--materials N] [--point-lights N] [--spot-lights N] [--frames N]\n";
+			std::exit(-1);
+		}
+	}
+	Debug::Assert(settings.materials > 0 && settings.frames > 0, "Need at least one material and one frame");
+
+	cout << Format("{} objects in {} materials, {} point lights, {} spot lights, {} frames on the {} backend\n", settings.objects, settings.materials, settings.pointLights, settings.spotLights, settings.frames, RGL::APIToString(RGL::CurrentAPI()));
+
+	world = New<RenderPerfWorld>(settings);
+
+	auto mesh = MeshCollectionStaticManager::Get("cube");
+	auto material = Material::Manager::Get<PBRMaterial>();
+	Vector<Ref<PBRMaterialInstance>> instances;
+	for(uint32_t i = 0; i < settings.materials; i++){
+		auto& instance = instances.emplace_back(New<PBRMaterialInstance>(material));
+		instance->SetAlbedoColor({RandomFloat(1), RandomFloat(1), RandomFloat(1), 1});
+	}
+
+	for(uint32_t i = 0; i < settings.objects; i++){
+		auto object = world->Instantiate<GameObject>();
+		object.EmplaceComponent<StaticMesh>(mesh, instances[i % settings.materials]);
+		object.GetTransform().SetLocalPosition(vector3(RandomFloat(settings.sceneSize), RandomFloat(settings.sceneSize / 10), RandomFloat(settings.sceneSize)));
+		world->objects.push_back(object);
+	}
+
+	auto randomPosition = [this]{
+		return vector3(RandomFloat(settings.sceneSize), settings.sceneSize / 10 + RandomFloat(10), RandomFloat(settings.sceneSize));
+	};
+	for(uint32_t i = 0; i < settings.pointLights; i++){
+		auto light = world->Instantiate<GameObject>();
+		light.EmplaceComponent<PointLight>().SetCastsShadows(true);
+		light.GetTransform().SetLocalPosition(randomPosition());
+	}
+	for(uint32_t i = 0; i < settings.spotLights; i++){
+		auto light = world->Instantiate<GameObject>();
+		light.EmplaceComponent<SpotLight>().SetCastsShadows(true);
+		light.GetTransform().SetLocalPosition(randomPosition());
+	}
+	auto sun = world->Instantiate<GameObject>();
+	sun.EmplaceComponent<DirectionalLight>().SetCastsShadows(true);
+	sun.EmplaceComponent<AmbientLight>().SetIntensity(0.2);
+	sun.GetTransform().SetLocalRotation(quaternion(vector3(deg_to_rad(45), deg_to_rad(45), 0)));
+
+	auto camera = world->Instantiate<GameObject>();
+	camera.EmplaceComponent<CameraComponent>().SetActive(true);
+	camera.GetTransform().SetLocalPosition(vector3(settings.sceneSize / 2, settings.sceneSize / 5, -settings.sceneSize / 4));
+
+	AddWorld(world);
+}
+
+int RenderPerfApp::OnShutdown(){
+	auto ms = [this](auto duration){
+		return std::chrono::duration<double, std::milli>(duration).count() / settings.frames;
+	};
+	cout << Format("               Draw: {:.3f} ms/frame\n", ms(world->drawTime));
+	cout << Format("         World tick: {:.3f} ms/frame\n", ms(world->tickTime));
+	cout << Format(" Outside world tick: {:.3f} ms/frame\n", ms(world->outsideTime));
+	cout << Format("              Total: {:.3f} ms/frame\n", ms(world->tickTime + world->outsideTime));
+	world.reset();
+	return 0;
+}
+
+extern "C" int main(int argc, char** argv){
+	// run on the Noop backend without a display, unless the caller chose otherwise
+#if _WIN32
+	if (!std::getenv("RGL_BACKEND")){
+		_putenv_s("RGL_BACKEND", "noop");
+	}
+	if (!std::getenv("SDL_VIDEO_DRIVER")){
+		_putenv_s("SDL_VIDEO_DRIVER", "offscreen");
+	}
+#else
+	setenv("RGL_BACKEND", "noop", 0);
+	setenv("SDL_VIDEO_DRIVER", "offscreen", 0);
+#endif
+	auto app = std::make_unique<RenderPerfApp>();
+	return app->run(argc, argv);
+}
@@ -1,6 +1,7 @@
 #include <cxxopts.hpp>
 #include <fmt/format.h>
 #include <filesystem>
+#include <algorithm>
 #include <simdjson.h>
 #include <iostream>
 #include <fstream>
@@ -11,6 +12,19 @@
 #include <assimp/material.h>
 #include <assimp/mesh.h>
 #include "Animation.hpp"
+#include <ozz/animation/offline/raw_animation.h>
+#include <ozz/animation/offline/raw_skeleton.h>
+#include <ozz/animation/offline/skeleton_builder.h>
+#include <ozz/animation/offline/animation_builder.h>
+#include <ozz/animation/offline/animation_optimizer.h>
+#include <ozz/animation/offline/raw_track.h>
+#include <ozz/animation/offline/track_builder.h>
+#include <ozz/animation/offline/track_optimizer.h>
+#include <ozz/animation/runtime/animation.h>
+#include <ozz/animation/runtime/track.h>
+#include <ozz/animation/runtime/skeleton.h>
+#include <ozz/base/io/archive.h>
+#include <ozz/base/io/stream.h>
 
 using namespace RavEngine;
 using namespace std;
@@ -18,7 +32,29 @@ using namespace std;
 #define FATAL(reason) {std::cerr << "rveac error: " << reason << std::endl; std::exit(1);}
 #define ASSERT(cond, str) {if (!(cond)) FATAL(str)}
 
-JointAnimation LoadAnimation(const std::filesystem::path& path) {
+struct LoadedAnimation {
+	JointAnimation animation;
+	SkeletonData skeleton;
+};
+
+struct OptimizerSettings {
+	bool optimize = true;
+	float tolerance = 1e-3f;	// maximum error allowed on the joint hierarchy, in scene units
+	float distance = 1e-1f;		// distance from the joint at which the error is measured
+};
+
+struct RootMotionSettings {
+	bool extract = false;
+	std::string bone;		// the joint carrying the motion, empty for the skeleton root
+	bool vertical = false;	// also extract vertical translation, for jumps and climbs
+};
+
+struct RootMotionTracks {
+	ozz::unique_ptr<ozz::animation::Float3Track> translation;
+	ozz::unique_ptr<ozz::animation::QuaternionTrack> rotation;
+};
+
+LoadedAnimation LoadAnimation(const std::filesystem::path& path) {
 	const aiScene* scene = aiImportFile(path.string().c_str(),
 		aiProcess_ImproveCacheLocality |
 		aiProcess_ValidateDataStructure |
@@ -92,54 +128,200 @@ JointAnimation LoadAnimation(const std::filesystem::path& path) {
 	//free afterward
 	aiReleaseImport(scene);
 
-	return raw_animation;
+	return { raw_animation, sk };
 }
 
-void SerializeAnim(const std::filesystem::path& outfile, const JointAnimation& anim) {
-	constexpr auto maxLen = std::numeric_limits<decltype(SerializedJointAnimationHeader::nameLength)>::max();
-	ASSERT(anim.name.size() <= maxLen, "Animation's name is too long!");
+ozz::unique_ptr<ozz::animation::Skeleton> BuildSkeleton(const SkeletonData& skeletonData) {
+	ozz::animation::offline::RawSkeleton raw_skeleton;
+	raw_skeleton.roots.resize(1);
+	auto& root = raw_skeleton.roots[0];
+
+	auto convertBone = [](decltype(root) dest, const SkeletonData::Bone& source, auto&& fn) -> void {
+		dest.name = source.name;
+		dest.transform.translation = { source.transform.translation.x,source.transform.translation.y,source.transform.translation.z };
+		dest.transform.scale = { source.transform.scale.x,source.transform.scale.y,source.transform.scale.z };
+		dest.transform.rotation = { source.transform.rotation.x,source.transform.rotation.y,source.transform.rotation.z, source.transform.rotation.w };
+
+		dest.children.reserve(source.children.size());
+		for (const auto& child : source.children) {
+			auto& newDest = dest.children.emplace_back();
+			fn(newDest, child, fn);
+		}
+	};
+	convertBone(root, skeletonData.root, convertBone);
+
+	ASSERT(raw_skeleton.Validate(), "Skeleton validation failed");
+
+	ozz::animation::offline::SkeletonBuilder skbuilder;
+	return skbuilder(raw_skeleton);
+}
+
+ozz::unique_ptr<ozz::animation::Animation> CompileAnimation(const JointAnimation& anim, const SkeletonData& skeletonData, const OptimizerSettings& settings) {
+	ozz::animation::offline::RawAnimation raw_animation;
+	raw_animation.duration = anim.duration;
+	raw_animation.name = anim.name;
+	raw_animation.tracks.reserve(anim.tracks.size());
+
+	for (const auto& src_track : anim.tracks) {
+		auto& track = raw_animation.tracks.emplace_back();
+		track.translations.reserve(src_track.translations.size());
+		for (const auto& key : src_track.translations) {
+			track.translations.push_back({ key.time, {key.value.x, key.value.y, key.value.z} });
+		}
+
+		track.rotations.reserve(src_track.rotations.size());
+		for (const auto& key : src_track.rotations) {
+			track.rotations.push_back({ key.time, {key.value.x, key.value.y, key.value.z, key.value.w} });
+		}
+
+		track.scales.reserve(src_track.scales.size());
+		for (const auto& key : src_track.scales) {
+			track.scales.push_back({ key.time, {key.value.x, key.value.y, key.value.z} });
+		}
+	}
+	ASSERT(raw_animation.Validate(), fmt::format("Animation {} failed validation", anim.name));
+
+	if (settings.optimize) {
+		auto skeleton = BuildSkeleton(skeletonData);
+		if (skeleton->num_joints() == raw_animation.num_tracks()) {
+			ozz::animation::offline::AnimationOptimizer optimizer;
+			optimizer.setting = { settings.tolerance, settings.distance };
+
+			ozz::animation::offline::RawAnimation optimized;
+			ASSERT(optimizer(raw_animation, *skeleton, &optimized), "Animation optimization failed");
+			raw_animation = std::move(optimized);
+		}
+		else {
+			std::cerr << fmt::format("rveac warning: skeleton has {} joints but animation has {} tracks, skipping keyframe optimization", skeleton->num_joints(), raw_animation.num_tracks()) << std::endl;
+		}
+	}
+
+	ozz::animation::offline::AnimationBuilder builder;
+	auto compiled = builder(raw_animation);
+	ASSERT(compiled, "Animation build failed");
+	return compiled;
+}
+
+/**
+ Move the ground motion of a joint out of its animation track and into motion tracks.
+ The joint keeps its height, pitch, and roll, while the horizontal translation and yaw relative to the first key
+ become the motion. The joint's parent space is treated as model space, so the joint should be the root or a child of
+ unanimated joints.
+ */
+RootMotionTracks ExtractRootMotion(JointAnimation& anim, uint16_t boneIndex, const RootMotionSettings& settings, const OptimizerSettings& optimizerSettings) {
+	auto& track = anim.tracks.at(boneIndex);
+	ASSERT(!track.translations.empty() || !track.rotations.empty(), "The root motion joint is not animated");
+
+	// motion tracks have no duration, keys are placed by ratio
+	auto ratio = [&](float time) {
+		return anim.duration > 0 ? std::clamp(time / anim.duration, 0.f, 1.f) : 0.f;
+	};
+
+	ozz::animation::offline::RawFloat3Track rawTranslation;
+	if (!track.translations.empty()) {
+		const auto origin = track.translations.front().value;
+		for (auto& key : track.translations) {
+			auto motion = key.value - origin;
+			if (!settings.vertical) {
+				motion.y = 0;
+			}
+			key.value -= motion;
+			rawTranslation.keyframes.push_back({ ozz::animation::offline::RawTrackInterpolation::kLinear, ratio(key.time), {motion.x, motion.y, motion.z} });
+		}
+	}
+
+	// swing-twist decomposition: the twist around the vertical axis is the yaw
+	auto yaw = [](const glm::quat& q) {
+		glm::quat twist(q.w, 0, q.y, 0);
+		const auto len = glm::length(twist);
+		return len > 1e-6f ? twist / len : glm::quat(1, 0, 0, 0);
+	};
+	ozz::animation::offline::RawQuaternionTrack rawRotation;
+	if (!track.rotations.empty()) {
+		const auto originYaw = glm::inverse(yaw(track.rotations.front().value));
+		for (auto& key : track.rotations) {
+			const auto motion = glm::normalize(yaw(key.value) * originYaw);
+			// yaw rotations share an axis, so removing the motion on the left leaves the rest of the rotation intact
+			key.value = glm::normalize(glm::inverse(motion) * key.value);
+			rawRotation.keyframes.push_back({ ozz::animation::offline::RawTrackInterpolation::kLinear, ratio(key.time), {motion.x, motion.y, motion.z, motion.w} });
+		}
+	}
+
+	// ratios must be strictly increasing, so drop keys that collapse onto the same ratio
+	auto dedupe = [](auto& keyframes) {
+		auto end = std::unique(keyframes.begin(), keyframes.end(), [](const auto& a, const auto& b) {
+			return a.ratio == b.ratio;
+		});
+		keyframes.erase(end, keyframes.end());
+	};
+	dedupe(rawTranslation.keyframes);
+	dedupe(rawRotation.keyframes);
+	ASSERT(rawTranslation.Validate() && rawRotation.Validate(), "Root motion tracks failed validation");
+
+	if (optimizerSettings.optimize) {
+		ozz::animation::offline::TrackOptimizer optimizer;
+		optimizer.tolerance = optimizerSettings.tolerance;
+		ozz::animation::offline::RawFloat3Track optimizedTranslation;
+		ozz::animation::offline::RawQuaternionTrack optimizedRotation;
+		ASSERT(optimizer(rawTranslation, &optimizedTranslation) && optimizer(rawRotation, &optimizedRotation), "Root motion optimization failed");
+		rawTranslation = std::move(optimizedTranslation);
+		rawRotation = std::move(optimizedRotation);
+	}
+
+	ozz::animation::offline::TrackBuilder builder;
+	RootMotionTracks tracks{ builder(rawTranslation), builder(rawRotation) };
+	ASSERT(tracks.translation && tracks.rotation, "Root motion build failed");
+	return tracks;
+}
+
+void SerializeAnim(const std::filesystem::path& outfile, const ozz::animation::Animation& anim, float ticksPerSecond, const RootMotionTracks& rootMotion) {
+	std::filesystem::create_directories(outfile.parent_path());
 
 	ofstream out(outfile, std::ios::binary);
 	if (!out) {
 		FATAL(fmt::format("Could not open {} for writing", outfile.string()));
 	}
 
-	SerializedJointAnimationHeader header{
-		.duration = anim.duration,
-        .ticksPerSecond = anim.ticksPerSecond,
-		.numTracks = uint32_t(anim.tracks.size()),
-		.nameLength = uint16_t(anim.name.size())
+	// serialize the runtime objects into ozz archives
+	auto makeArchive = [](auto&& write) {
+		ozz::io::MemoryStream stream;
+		{
+			ozz::io::OArchive archive(&stream);
+			write(archive);
+		}
+		std::vector<char> archiveData(stream.Size());
+		stream.Seek(0, ozz::io::Stream::kSet);
+		ASSERT(stream.Read(archiveData.data(), archiveData.size()) == archiveData.size(), "Could not read back archive");
+		return archiveData;
+	};
+	auto archiveData = makeArchive([&](ozz::io::OArchive& archive) {
+		archive << anim;
+	});
+	std::vector<char> rootMotionData;
+	if (rootMotion.translation) {
+		rootMotionData = makeArchive([&](ozz::io::OArchive& archive) {
+			archive << *rootMotion.translation;
+			archive << *rootMotion.rotation;
+		});
+	}
+
+	SerializedCompiledAnimationHeader header{
+		.ticksPerSecond = ticksPerSecond,
+		.archiveSize = uint32_t(archiveData.size()),
+		.rootMotionArchiveSize = uint32_t(rootMotionData.size())
 	};
 
 	// write header
 	out.write(reinterpret_cast<char*>(&header), sizeof(header));
 
-	// write name
-	out.write(anim.name.data(), anim.name.size());
-
-	// write tracks
-	for (const auto& track : anim.tracks) {
-		SerializedJointAnimationTrackHeader header{
-			.numTranslations = uint32_t(track.translations.size()),
-			.numRotations = uint32_t(track.rotations.size()),
-			.numScales = uint32_t(track.scales.size())
-		};
-		// write header for this track
-		out.write(reinterpret_cast<char*>(&header), sizeof(header));
-
-		auto writeBuffer = [&out](auto&& data) {
-			out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(data[0]));
-		};
-		
-		writeBuffer(track.translations);
-		writeBuffer(track.rotations);
-		writeBuffer(track.scales);
-	}
+	// write the archives
+	out.write(archiveData.data(), archiveData.size());
+	out.write(rootMotionData.data(), rootMotionData.size());
 }
 
 int main(int argc, char** argv) {
 
-    cxxopts::Options options("rvemc", "RavEngine Mesh Compiler");
+    cxxopts::Options options("rveac", "RavEngine Animation Compiler");
     options.add_options()
         ("f,file", "Input file path", cxxopts::value<std::filesystem::path>())
         ("o,output", "Ouptut file path", cxxopts::value<std::filesystem::path>())
@@ -177,12 +359,60 @@ int main(int argc, char** argv) {
 
     auto infile = json_dir / std::string_view(doc["file"]);
 
-	auto anim = LoadAnimation(infile);
+	OptimizerSettings optimizerSettings;
+	bool optimize;
+	auto err = doc["optimize"].get(optimize);
+	if (!err) {
+		optimizerSettings.optimize = optimize;
+	}
+	double tolerance;
+	err = doc["tolerance"].get(tolerance);
+	if (!err) {
+		optimizerSettings.tolerance = tolerance;
+	}
+	double distance;
+	err = doc["distance"].get(distance);
+	if (!err) {
+		optimizerSettings.distance = distance;
+	}
+
+	RootMotionSettings rootMotionSettings;
+	bool rootMotion;
+	err = doc["root_motion"].get(rootMotion);
+	if (!err) {
+		rootMotionSettings.extract = rootMotion;
+	}
+	std::string_view rootMotionBone;
+	err = doc["root_motion_bone"].get(rootMotionBone);
+	if (!err) {
+		rootMotionSettings.bone = rootMotionBone;
+	}
+	bool rootMotionVertical;
+	err = doc["root_motion_vertical"].get(rootMotionVertical);
+	if (!err) {
+		rootMotionSettings.vertical = rootMotionVertical;
+	}
+
+	auto loaded = LoadAnimation(infile);
+
+	// extract before compiling, so that the motion is removed from the joint track
+	RootMotionTracks rootMotionTracks;
+	if (rootMotionSettings.extract) {
+		uint16_t boneIndex = 0;
+		if (!rootMotionSettings.bone.empty()) {
+			auto flattened = FlattenSkeleton(loaded.skeleton);
+			boneIndex = flattened.IndexForBoneName(rootMotionSettings.bone);
+			ASSERT(boneIndex < flattened.allBones.size(), fmt::format("No joint named {} for root motion", rootMotionSettings.bone));
+		}
+		rootMotionTracks = ExtractRootMotion(loaded.animation, boneIndex, rootMotionSettings, optimizerSettings);
+	}
+
+	auto compiled = CompileAnimation(loaded.animation, loaded.skeleton, optimizerSettings);
 
 	inputFile.replace_extension("");
 	const auto outfileName = inputFile.filename().string() + ".rvea";
 
-	SerializeAnim(outputDir / outfileName, anim);
+	SerializeAnim(outputDir / outfileName, *compiled, loaded.animation.ticksPerSecond, rootMotionTracks);
 
 	return 0;
 }
@@ -16,6 +16,10 @@
 #include "CaseAnalysis.hpp"
 #include <RavEngine/ImportLib.hpp>
 #include <meshoptimizer.h>
+#include <glm/trigonometric.hpp>
+#include <array>
+#include <cmath>
+#include <cstddef>
 
 using namespace std;
 using namespace RavEngine;
@@ -172,7 +176,159 @@ std::variant<MeshPart, SkinnedMeshPart> LoadMesh(const std::filesystem::path& pa
     return mesh;
 }
 
-void SerializeMeshPart(const std::filesystem::path& outfile, const std::variant<MeshPart,SkinnedMeshPart>& mesh) {
+struct LodConfig {
+    float ratio = 0.5;          // fraction of the base mesh's triangles to keep
+    float maxError = 0.05;      // relative to the mesh extents
+    bool sloppy = false;        // ignore topology, for aggressive reductions of distant LODs
+    std::optional<float> minDistance;
+};
+
+struct LodChainConfig {
+    std::vector<LodConfig> lods;
+    float normalWeight = 0.5;   // attribute weights for simplification, 0 to simplify by position only
+    float uvWeight = 0.5;
+    float pixelError = 1;       // screen-space error at which LODs switch, when no distance is given
+    float screenHeight = 1080;
+    float fov = 60;             // vertical, in degrees
+};
+
+/**
+ Simplify a mesh into a chain of LODs. Each LOD is simplified from the base mesh, so errors do not accumulate down the chain.
+ */
+MeshLodChainBuilder GenerateLods(const MeshPart& base, const LodChainConfig& config) {
+    MeshLodChainBuilder chain;
+    const auto scale = meshopt_simplifyScale(&base.vertices[0].position.x, base.vertices.size(), sizeof(vertex_t));
+
+    // the normal, tangent, bitangent and uv are contiguous after the position
+    static_assert(offsetof(vertex_t, uv) - offsetof(vertex_t, normal) == sizeof(float) * 9);
+    constexpr size_t attributeCount = 11;
+    const std::array<float, attributeCount> attributeWeights{
+        config.normalWeight, config.normalWeight, config.normalWeight,
+        0, 0, 0,
+        0, 0, 0,
+        config.uvWeight, config.uvWeight,
+    };
+    const bool useAttributes = config.normalWeight > 0 || config.uvWeight > 0;
+
+    size_t previousIndexCount = base.indices.size();
+    for (const auto& lod : config.lods) {
+        const auto target = size_t(base.indices.size() * lod.ratio) / 3 * 3;
+        std::vector<uint32_t> indices(base.indices.size());
+        float error = 0;
+        size_t count;
+        if (lod.sloppy) {
+            count = meshopt_simplifySloppy(indices.data(), base.indices.data(), base.indices.size(), &base.vertices[0].position.x, base.vertices.size(), sizeof(vertex_t), target, lod.maxError, &error);
+        }
+        else if (useAttributes) {
+            count = meshopt_simplifyWithAttributes(indices.data(), base.indices.data(), base.indices.size(), &base.vertices[0].position.x, base.vertices.size(), sizeof(vertex_t), &base.vertices[0].normal.x, sizeof(vertex_t), attributeWeights.data(), attributeCount, nullptr, target, lod.maxError, 0, &error);
+        }
+        else {
+            count = meshopt_simplify(indices.data(), base.indices.data(), base.indices.size(), &base.vertices[0].position.x, base.vertices.size(), sizeof(vertex_t), target, lod.maxError, 0, &error);
+        }
+        if (count == 0 || count >= previousIndexCount) {
+            std::cerr << "rvemc warning: cannot simplify to ratio " << lod.ratio << " within error " << lod.maxError << ", the LOD chain stops here" << std::endl;
+            break;
+        }
+        previousIndexCount = count;
+        indices.resize(count);
+        meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), base.vertices.size());
+
+        // keep only the vertices this LOD uses
+        MeshPart mesh;
+        mesh.vertices.resize(base.vertices.size());
+        const auto vertexCount = meshopt_optimizeVertexFetch(mesh.vertices.data(), indices.data(), indices.size(), base.vertices.data(), base.vertices.size(), sizeof(vertex_t));
+        mesh.vertices.resize(vertexCount);
+        mesh.indices.assign(indices.begin(), indices.end());
+
+        // switch when the simplification error projects to pixelError pixels
+        const float worldError = error * scale;
+        const float distance = lod.minDistance.value_or(worldError * config.screenHeight / (2 * std::tan(glm::radians(config.fov) / 2) * config.pixelError));
+        if (!chain.lods.empty() && distance <= chain.lods.back().minDistance) {
+            FATAL(fmt::format("LOD {} has a distance of {}, which is not greater than the previous LOD", chain.lods.size() + 1, distance));
+        }
+        chain.lods.push_back({ std::move(mesh), distance, worldError });
+    }
+    return chain;
+}
+
+struct MeshletConfig {
+    size_t maxVertices = 64;
+    size_t maxTriangles = 124;  // must be a multiple of 4
+    float coneWeight = 0.25;    // favor clusters with tight normal cones, for backface culling
+};
+
+/**
+ Split a mesh into meshlets, with a bounding sphere and normal cone for each
+ */
+MeshletData BuildMeshlets(const MeshPart& mesh, const MeshletConfig& config) {
+    const auto maxMeshlets = meshopt_buildMeshletsBound(mesh.indices.size(), config.maxVertices, config.maxTriangles);
+    std::vector<meshopt_Meshlet> built(maxMeshlets);
+    MeshletData data;
+    data.vertices.resize(maxMeshlets * config.maxVertices);
+    data.triangles.resize(maxMeshlets * config.maxTriangles * 3);
+    built.resize(meshopt_buildMeshlets(built.data(), data.vertices.data(), data.triangles.data(), mesh.indices.data(), mesh.indices.size(), &mesh.vertices[0].position.x, mesh.vertices.size(), sizeof(vertex_t), config.maxVertices, config.maxTriangles, config.coneWeight));
+
+    if (built.empty()) {
+        return {};
+    }
+    const auto& last = built.back();
+    data.vertices.resize(last.vertex_offset + last.vertex_count);
+    data.triangles.resize(last.triangle_offset + last.triangle_count * 3);
+
+    data.meshlets.reserve(built.size());
+    for (const auto& m : built) {
+        meshopt_optimizeMeshlet(&data.vertices[m.vertex_offset], &data.triangles[m.triangle_offset], m.triangle_count, m.vertex_count);
+        const auto bounds = meshopt_computeMeshletBounds(&data.vertices[m.vertex_offset], &data.triangles[m.triangle_offset], m.triangle_count, &mesh.vertices[0].position.x, mesh.vertices.size(), sizeof(vertex_t));
+        Meshlet meshlet{
+            .vertexOffset = m.vertex_offset,
+            .triangleOffset = m.triangle_offset,
+            .vertexCount = m.vertex_count,
+            .triangleCount = m.triangle_count,
+            .center = {bounds.center[0], bounds.center[1], bounds.center[2]},
+            .radius = bounds.radius,
+            .coneApex = {bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2]},
+            .coneAxis = {bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2]},
+            .coneCutoff = bounds.cone_cutoff,
+        };
+        data.meshlets.push_back(meshlet);
+    }
+    return data;
+}
+
+/**
+ Write a mesh with quantized vertices, compressed with meshoptimizer's vertex and index codecs
+ */
+void SerializeCompressedMesh(std::ostream& out, const MeshPart& mesh, uint8_t attributes, const MeshletData* meshlets = nullptr) {
+    std::vector<QuantizedVertex> quantized(mesh.vertices.begin(), mesh.vertices.end());
+    std::vector<unsigned char> vertexData(meshopt_encodeVertexBufferBound(quantized.size(), sizeof(QuantizedVertex)));
+    vertexData.resize(meshopt_encodeVertexBuffer(vertexData.data(), vertexData.size(), quantized.data(), quantized.size(), sizeof(QuantizedVertex)));
+    std::vector<unsigned char> indexData(meshopt_encodeIndexBufferBound(mesh.indices.size(), mesh.vertices.size()));
+    indexData.resize(meshopt_encodeIndexBuffer(indexData.data(), indexData.size(), mesh.indices.data(), mesh.indices.size()));
+
+    SerializedMeshDataHeader header{
+       .numVertices = uint32_t(mesh.vertices.size()),
+       .numIndicies = uint32_t(mesh.indices.size()),
+       .attributes = uint8_t(attributes | SerializedMeshDataHeader::CompressedBit | (meshlets ? SerializedMeshDataHeader::MeshletsBit : 0)),
+    };
+    if (meshlets) {
+        header.meshletBytes = uint32_t(meshlets->SerializedSize());
+    }
+    header.encodedVertexBytes = uint32_t(vertexData.size());
+    header.encodedIndexBytes = uint32_t(indexData.size());
+    CalculateBounds(mesh.vertices, header.bounds, header.radius);
+
+    const char padding[4]{};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(vertexData.data()), vertexData.size());
+    out.write(padding, header.IndexDataOffset() - sizeof(header) - vertexData.size());
+    out.write(reinterpret_cast<const char*>(indexData.data()), indexData.size());
+    out.write(padding, header.MeshletDataOffset() - header.IndexDataOffset() - indexData.size());
+    if (meshlets) {
+        meshlets->Serialize(out);
+    }
+}
+
+void SerializeMeshPart(const std::filesystem::path& outfile, const std::variant<MeshPart,SkinnedMeshPart>& mesh, bool compress, const std::optional<MeshletConfig>& meshletConfig) {
     std::filesystem::create_directories(outfile.parent_path());		// make all the folders necessary
 
     bool isSkinned = false;
@@ -190,22 +346,19 @@ void SerializeMeshPart(const std::filesystem::path& outfile, const std::variant<
         FATAL(fmt::format("Could not open {} for writing", outfile.string()));
     }
 
-    std::visit([&out,&isSkinned](const MeshPart& mesh) {
-        
-        SerializedMeshDataHeader header{
-           .numVertices = uint32_t(mesh.vertices.size()),
-           .numIndicies = uint32_t(mesh.indices.size()),
-           .attributes = uint8_t(isSkinned ? SerializedMeshDataHeader::SkinnedMeshBit : 0)
-        };
-
-        // write header
-        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
-
-        // vertices and indices
-        out.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(mesh.vertices[0]));
-        out.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(mesh.indices[0]));
-
-
+    std::visit([&out,&isSkinned,compress,&meshletConfig](const MeshPart& mesh) {
+        const auto attributes = uint8_t(isSkinned ? SerializedMeshDataHeader::SkinnedMeshBit : 0);
+        std::optional<MeshletData> meshlets;
+        if (meshletConfig) {
+            meshlets = BuildMeshlets(mesh, *meshletConfig);
+        }
+        const auto meshletPtr = meshlets ? &meshlets.value() : nullptr;
+        if (compress) {
+            SerializeCompressedMesh(out, mesh, attributes, meshletPtr);
+        }
+        else {
+            SerializeMesh(out, mesh, attributes, meshletPtr);
+        }
     }, mesh);
    
     // executed only for skinned meshes
@@ -280,7 +433,103 @@ int main(int argc, char** argv){
     inputFile.replace_extension("");
     const auto outfileName = inputFile.filename().string() + ".rvem";
 
-    SerializeMeshPart(outputDir / outfileName, mesh);
+    bool compress = false;
+    err = doc["compress"].get(compress);
+    if (err) {
+        compress = false;
+    }
+
+    // optional meshlets, with bounds for culling clusters of the mesh
+    std::optional<MeshletConfig> meshletConfig;
+    // either true for the defaults, or an object with settings
+    bool meshletsEnabled = false;
+    simdjson::ondemand::object meshletDesc;
+    if (!doc["meshlets"].get(meshletsEnabled)) {
+        if (meshletsEnabled) {
+            meshletConfig.emplace();
+        }
+    }
+    else if (!doc["meshlets"].get(meshletDesc)) {
+        MeshletConfig config;
+        uint64_t value;
+        if (!meshletDesc["max_vertices"].get(value)) {
+            config.maxVertices = value;
+        }
+        if (!meshletDesc["max_triangles"].get(value)) {
+            config.maxTriangles = value;
+        }
+        double weight;
+        if (!meshletDesc["cone_weight"].get(weight)) {
+            config.coneWeight = weight;
+        }
+        ASSERT(config.maxVertices >= 3 && config.maxVertices <= 255, "meshlet max_vertices must be between 3 and 255");
+        ASSERT(config.maxTriangles >= 1 && config.maxTriangles <= 512 && config.maxTriangles % 4 == 0, "meshlet max_triangles must be a multiple of 4 up to 512");
+        meshletConfig = config;
+    }
+    if (meshletConfig && isSkinned) {
+        FATAL("Meshlets are not supported for skinned meshes, because skinning moves them out of their bounds");
+    }
+
+    SerializeMeshPart(outputDir / outfileName, mesh, compress, meshletConfig);
+
+    // optional LOD chain
+    simdjson::ondemand::array lodArray;
+    err = doc["lods"].get(lodArray);
+    if (!err) {
+        if (isSkinned) {
+            FATAL("LODs are not supported for skinned meshes");
+        }
+        LodChainConfig config;
+        for (auto lodDesc : lodArray) {
+            LodConfig lod;
+            double value;
+            if (!lodDesc["ratio"].get(value)) {
+                lod.ratio = value;
+            }
+            if (!lodDesc["error"].get(value)) {
+                lod.maxError = value;
+            }
+            if (!lodDesc["distance"].get(value)) {
+                lod.minDistance = value;
+            }
+            bool sloppy;
+            if (!lodDesc["sloppy"].get(sloppy)) {
+                lod.sloppy = sloppy;
+            }
+            config.lods.push_back(lod);
+        }
+        double value;
+        if (!doc["lod_normal_weight"].get(value)) {
+            config.normalWeight = value;
+        }
+        if (!doc["lod_uv_weight"].get(value)) {
+            config.uvWeight = value;
+        }
+        if (!doc["lod_pixel_error"].get(value)) {
+            config.pixelError = value;
+        }
+        if (!doc["lod_screen_height"].get(value)) {
+            config.screenHeight = value;
+        }
+        if (!doc["lod_fov"].get(value)) {
+            config.fov = value;
+        }
+
+        auto chain = GenerateLods(std::get<MeshPart>(mesh), config);
+        const auto lodFileName = inputFile.filename().string() + ".rvelod";
+        ofstream out(outputDir / lodFileName, std::ios::binary);
+        if (!out) {
+            FATAL(fmt::format("Could not open {} for writing", (outputDir / lodFileName).string()));
+        }
+        if (compress) {
+            chain.Write(out, [](std::ostream& out, const MeshPart& mesh) {
+                SerializeCompressedMesh(out, mesh, 0);
+            });
+        }
+        else {
+            chain.Write(out);
+        }
+    }
 
     return 0;
 }
@@ -0,0 +1,60 @@
+#include <cxxopts.hpp>
+#include <filesystem>
+#include <iostream>
+#include <fstream>
+#include "AssetPack.hpp"
+
+using namespace RavEngine;
+using namespace std;
+
+#define FATAL(reason) {std::cerr << "rvepack error: " << reason << std::endl; std::exit(1);}
+
+int main(int argc, char** argv) {
+
+    cxxopts::Options options("rvepack", "RavEngine Asset Packer");
+    options.add_options()
+        ("f,file", "Input directory path", cxxopts::value<std::filesystem::path>())
+        ("o,output", "Ouptut file path", cxxopts::value<std::filesystem::path>())
+        ("h,help", "Show help menu")
+        ;
+
+    auto args = options.parse(argc, argv);
+
+    if (args["help"].as<bool>()) {
+        cout << options.help() << endl;
+        return 0;
+    }
+
+    std::filesystem::path inputDir;
+    try {
+        inputDir = args["file"].as<decltype(inputDir)>();
+    }
+    catch (exception& e) {
+        FATAL("no input directory")
+    }
+    std::filesystem::path outputFile;
+    try {
+        outputFile = args["output"].as<decltype(outputFile)>();
+    }
+    catch (exception& e) {
+        FATAL("no output file")
+    }
+    if (!std::filesystem::is_directory(inputDir)) {
+        FATAL(inputDir << " is not a directory")
+    }
+
+    AssetPackBuilder builder;
+    builder.AddDirectory(std::filesystem::absolute(inputDir).lexically_normal());
+
+    std::ofstream out(outputFile, std::ios::binary);
+    if (!out) {
+        FATAL("cannot open " << outputFile << " for writing")
+    }
+    try {
+        builder.Write(out);
+    }
+    catch (exception& e) {
+        FATAL(e.what())
+    }
+    return 0;
+}